@@ -0,0 +1,28 @@
+#include "Arena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace cpplox::AST {
+
+auto Arena::allocate(size_t size, size_t alignment) -> void* {
+  auto aligned = [alignment](std::byte* pos) {
+    auto address = reinterpret_cast<uintptr_t>(pos);
+    return pos + ((alignment - address % alignment) % alignment);
+  };
+
+  if (next == nullptr || aligned(next) + size > end) {
+    // Oversized requests get a block of their own.
+    const size_t blockSize = std::max(BLOCK_SIZE, size + alignment);
+    blocks.push_back(std::make_unique_for_overwrite<std::byte[]>(blockSize));
+    next = blocks.back().get();
+    end = next + blockSize;
+    reserved += blockSize;
+  }
+
+  std::byte* result = aligned(next);
+  next = result + size;
+  return result;
+}
+
+}  // namespace cpplox::AST
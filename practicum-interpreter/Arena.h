@@ -0,0 +1,76 @@
+#ifndef CPPLOX_AST_ARENA_H
+#define CPPLOX_AST_ARENA_H
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace cpplox::AST {
+
+// A bump allocator that owns all the nodes of one compilation.
+//
+// Objects are carved out of large blocks and are never destroyed one by one:
+// the arena just drops its blocks when it goes away. Tearing down a program
+// therefore costs a handful of frees however many nodes it has, and can't
+// recurse (and overflow the stack) on a deeply nested tree. In exchange,
+// everything put in an arena has to be trivially destructible.
+class Arena {
+ public:
+  Arena() = default;
+  Arena(const Arena&) = delete;
+  auto operator=(const Arena&) -> Arena& = delete;
+  // Moving an arena doesn't move its blocks, so pointers into it stay valid.
+  Arena(Arena&&) noexcept = default;
+  auto operator=(Arena&&) noexcept -> Arena& = default;
+  ~Arena() = default;
+
+  template <typename T, typename... Args>
+  auto make(Args&&... args) -> T* {
+    static_assert(std::is_trivially_destructible_v<T>,
+                  "Arena memory is released without running destructors");
+    return new (allocate(sizeof(T), alignof(T)))
+        T(std::forward<Args>(args)...);
+  }
+
+  // Copies items (or text) into the arena.
+  template <typename T>
+  auto copy(const std::vector<T>& items) -> std::span<const T> {
+    static_assert(std::is_trivially_destructible_v<T>,
+                  "Arena memory is released without running destructors");
+    if (items.empty()) return {};
+    T* first = static_cast<T*>(allocate(sizeof(T) * items.size(), alignof(T)));
+    std::uninitialized_copy(items.begin(), items.end(), first);
+    return {first, items.size()};
+  }
+
+  auto copy(std::string_view text) -> std::string_view {
+    if (text.empty()) return {};
+    auto* first = static_cast<char*>(allocate(text.size(), 1));
+    std::copy(text.begin(), text.end(), first);
+    return {first, text.size()};
+  }
+
+  // Bytes taken from the system so far, for PERF_DEBUG output.
+  [[nodiscard]] auto bytesReserved() const -> size_t { return reserved; }
+
+ private:
+  static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+  auto allocate(size_t size, size_t alignment) -> void*;
+
+  std::vector<std::unique_ptr<std::byte[]>> blocks;
+  std::byte* next = nullptr;
+  std::byte* end = nullptr;
+  size_t reserved = 0;
+};
+
+}  // namespace cpplox::AST
+
+#endif  // CPPLOX_AST_ARENA_H
@@ -0,0 +1,15 @@
+#include "Backend.h"
+
+#include <iostream>
+
+namespace cpplox::Evaluator {
+
+auto Backend::recoverFromRuntimeError() -> bool {
+  if (++numRunTimeErr > MAX_RUNTIME_ERR) {
+    std::cerr << "Too many errors occurred. Exiting evaluation." << std::endl;
+    return false;
+  }
+  return true;
+}
+
+}  // namespace cpplox::Evaluator
@@ -0,0 +1,33 @@
+#ifndef CPPLOX_EVALUATOR_BACKEND_H
+#define CPPLOX_EVALUATOR_BACKEND_H
+#pragma once
+
+#include "NodeTypes.h"
+#include "Uncopyable.h"
+
+namespace cpplox::Evaluator {
+
+// Runs programs for the InterpreterDriver, once the ConstantFolder and the
+// Resolver have been over them. The Evaluator walks the AST, the other
+// backends compile it first; they all have to behave alike, down to the
+// runtime errors they report and the output printed before one.
+class Backend : public Types::Uncopyable {
+ public:
+  virtual void run(const AST::Program& program) = 0;
+
+ protected:
+  // A statement in a statement list failed with a runtime error. Returns
+  // true if the list should carry on with its next statement; false, after
+  // saying so, once there have been too many errors. The error then
+  // propagates to the enclosing statement list, and from the outermost one
+  // to the driver.
+  auto recoverFromRuntimeError() -> bool;
+
+ private:
+  static const int MAX_RUNTIME_ERR = 20;
+  int numRunTimeErr = 0;
+};
+
+}  // namespace cpplox::Evaluator
+
+#endif  // CPPLOX_EVALUATOR_BACKEND_H
@@ -0,0 +1,403 @@
+#include "Bytecode.h"
+
+#include <algorithm>
+#include <array>
+#include <sstream>
+#include <string_view>
+#include <utility>
+#include <variant>
+
+#include "Environment.h"
+#include "TypeChecker.h"
+
+namespace cpplox::VM {
+
+using Evaluator::DeclaredType;
+using Types::TokenType;
+
+namespace {
+
+struct OpInfo {
+  std::string_view name;
+  std::string_view operands;
+  int stackEffect;
+};
+
+constexpr std::array OP_INFO = {
+#define CPPLOX_OPCODE_INFO(name, operands, effect) \
+  OpInfo{#name, operands, effect},
+    CPPLOX_STACK_OPCODES(CPPLOX_OPCODE_INFO)
+#undef CPPLOX_OPCODE_INFO
+};
+
+auto info(OpCode op) -> const OpInfo& {
+  return OP_INFO[static_cast<size_t>(op)];
+}
+
+auto numOperands(OpCode op) -> size_t {
+  const std::string_view operands = info(op).operands;
+  if (operands.empty()) return 0;
+  return 1 + std::count(operands.begin(), operands.end(), ' ');
+}
+
+// The _INT or _REAL version of a binary operator from ADD to NOT_EQUAL, for
+// operands the TypeChecker proved to be of `type`; `op` if there is none.
+auto typed(OpCode op, AST::StaticType type) -> OpCode {
+  static_assert(static_cast<int>(OpCode::NOT_EQUAL)
+                        - static_cast<int>(OpCode::ADD)
+                    == static_cast<int>(OpCode::NOT_EQUAL_INT)
+                           - static_cast<int>(OpCode::ADD_INT)
+                && static_cast<int>(OpCode::NOT_EQUAL)
+                           - static_cast<int>(OpCode::ADD)
+                       == static_cast<int>(OpCode::NOT_EQUAL_REAL)
+                              - static_cast<int>(OpCode::ADD_REAL),
+                "The typed operators come in the order of the others.");
+  if (op < OpCode::ADD || op > OpCode::NOT_EQUAL) return op;
+  OpCode first = OpCode::ADD;
+  if (type == AST::StaticType::INT)
+    first = OpCode::ADD_INT;
+  else if (type == AST::StaticType::REAL)
+    first = OpCode::ADD_REAL;
+  else
+    return op;
+  return static_cast<OpCode>(static_cast<int>(first)
+                             + (static_cast<int>(op)
+                                - static_cast<int>(OpCode::ADD)));
+}
+
+}  // namespace
+
+// ====================== //
+// class BytecodeCompiler
+// ====================== //
+BytecodeCompiler::BytecodeCompiler(Evaluator::ConstantPool& p_constants)
+    : constants(p_constants) {}
+
+auto BytecodeCompiler::compile(const AST::Program& program) -> Chunk {
+  chunk = Chunk();
+  stackDepth = 0;
+  compileStmts(program.statements);
+  emit(OpCode::HALT);
+  return std::move(chunk);
+}
+
+void BytecodeCompiler::compileStmts(AST::StmtList stmts) {
+  for (const AST::StmtPtrVariant& stmt : stmts) {
+    const uint32_t start = here();
+    compileStmt(stmt);
+    chunk.statements.push_back({start, here()});
+  }
+}
+
+void BytecodeCompiler::compileDeclaration(
+    uint32_t slot, const std::optional<AST::ExprPtrVariant>& initializer,
+    DeclaredType type) {
+  if (initializer.has_value())
+    compileExpr(initializer.value());
+  else
+    emit(OpCode::NIL);
+  emit(OpCode::DEFINE);
+  emitOperand(slot);
+  emitOperand(static_cast<uint32_t>(type));
+}
+
+void BytecodeCompiler::compileWhileStmt(const AST::WhileStmtPtr& stmt) {
+  const uint32_t loopStart = here();
+  compileExpr(stmt->condition);
+  const size_t exitJump = emitJump(OpCode::JUMP_IF_FALSE);
+  breakJumps.emplace_back();
+  compileStmt(stmt->loopBody);
+  patchJump(emitJump(OpCode::JUMP), loopStart);
+  patchJump(exitJump);
+  for (size_t jump : breakJumps.back()) patchJump(jump);
+  breakJumps.pop_back();
+}
+
+void BytecodeCompiler::compileForStmt(const AST::ForStmtPtr& stmt) {
+  if (stmt->initializer.has_value()) compileStmt(stmt->initializer.value());
+  const uint32_t loopStart = here();
+  std::optional<size_t> exitJump;
+  if (stmt->condition.has_value()) {
+    compileExpr(stmt->condition.value());
+    exitJump = emitJump(OpCode::JUMP_IF_FALSE);
+  }
+  breakJumps.emplace_back();
+  compileStmt(stmt->loopBody);
+  if (stmt->increment.has_value()) {
+    compileExpr(stmt->increment.value());
+    emit(OpCode::POP);
+  }
+  patchJump(emitJump(OpCode::JUMP), loopStart);
+  if (exitJump.has_value()) patchJump(exitJump.value());
+  for (size_t jump : breakJumps.back()) patchJump(jump);
+  breakJumps.pop_back();
+}
+
+void BytecodeCompiler::compileStmt(const AST::StmtPtrVariant& stmt) {
+  switch (stmt.index()) {
+    case 0:  // ExprStmtPtr
+      compileExpr(std::get<0>(stmt)->expression);
+      emit(OpCode::POP);
+      break;
+    case 1:  // WriteStmtPtr
+      // Each value is printed as soon as it is known, so the ones before a
+      // failing expression still get printed.
+      for (const AST::ExprPtrVariant& expr : std::get<1>(stmt)->expressions) {
+        compileExpr(expr);
+        emit(OpCode::WRITE);
+      }
+      emit(OpCode::WRITE_END);
+      break;
+    case 2: {  // ReadStmtPtr
+      const AST::ReadStmtPtr& read = std::get<2>(stmt);
+      emit(OpCode::READ);
+      emitOperand(read->slot);
+      emitToken(read->varName);
+      break;
+    }
+    case 3:  // BlockStmtPtr
+      compileStmts(std::get<3>(stmt)->statements);
+      break;
+    case 4:  // IntStmtPtr
+      compileDeclaration(std::get<4>(stmt)->slot,
+                         std::get<4>(stmt)->initializer,
+                         DeclaredType::INT);
+      break;
+    case 5:  // RealStmtPtr
+      compileDeclaration(std::get<5>(stmt)->slot,
+                         std::get<5>(stmt)->initializer,
+                         DeclaredType::REAL);
+      break;
+    case 6:  // StrStmtPtr
+      compileDeclaration(std::get<6>(stmt)->slot,
+                         std::get<6>(stmt)->initializer,
+                         DeclaredType::STRING);
+      break;
+    case 7: {  // IfStmtPtr
+      const AST::IfStmtPtr& ifStmt = std::get<7>(stmt);
+      compileExpr(ifStmt->condition);
+      const size_t elseJump = emitJump(OpCode::JUMP_IF_FALSE);
+      compileStmt(ifStmt->thenBranch);
+      if (ifStmt->elseBranch.has_value()) {
+        const size_t endJump = emitJump(OpCode::JUMP);
+        patchJump(elseJump);
+        compileStmt(ifStmt->elseBranch.value());
+        patchJump(endJump);
+      } else {
+        patchJump(elseJump);
+      }
+      break;
+    }
+    case 8:  // WhileStmtPtr
+      compileWhileStmt(std::get<8>(stmt));
+      break;
+    case 9:  // ForStmtPtr
+      compileForStmt(std::get<9>(stmt));
+      break;
+    case 10:  // BreakStmtPtr
+      if (breakJumps.empty()) {
+        emit(OpCode::STRAY_BREAK);
+        emitToken(std::get<10>(stmt)->name);
+      } else {
+        breakJumps.back().push_back(emitJump(OpCode::JUMP));
+      }
+      break;
+    default:
+      static_assert(std::variant_size_v<AST::StmtPtrVariant> == 11,
+                    "Looks like you forgot to update the cases in "
+                    "BytecodeCompiler::compileStmt()!");
+  }
+}
+
+void BytecodeCompiler::compileBinaryExpr(const AST::BinaryExprPtr& expr) {
+  compileExpr(expr->left);
+  if (expr->op.getType() == TokenType::COMMA) {
+    emit(OpCode::POP);
+    compileExpr(expr->right);
+    return;
+  }
+  compileExpr(expr->right);
+  OpCode op = OpCode::BINARY;
+  switch (expr->op.getType()) {
+    case TokenType::EQUAL_EQUAL: op = OpCode::EQUAL; break;
+    case TokenType::BANG_EQUAL: op = OpCode::NOT_EQUAL; break;
+    case TokenType::PLUS: op = OpCode::ADD; break;
+    case TokenType::MINUS: op = OpCode::SUBTRACT; break;
+    case TokenType::STAR: op = OpCode::MULTIPLY; break;
+    case TokenType::SLASH: op = OpCode::DIVIDE; break;
+    case TokenType::MOD: op = OpCode::MODULO; break;
+    case TokenType::LESS: op = OpCode::LESS; break;
+    case TokenType::LESS_EQUAL: op = OpCode::LESS_EQUAL; break;
+    case TokenType::GREATER: op = OpCode::GREATER; break;
+    case TokenType::GREATER_EQUAL: op = OpCode::GREATER_EQUAL; break;
+    default: break;
+  }
+  op = typed(op, AST::numericOperands(*expr));
+  emit(op);
+  if (numOperands(op) > 0) emitToken(expr->op);
+}
+
+void BytecodeCompiler::compileUnaryExpr(const AST::UnaryExprPtr& expr) {
+  compileExpr(expr->right);
+  switch (expr->op.getType()) {
+    case TokenType::BANG: emit(OpCode::NOT); return;
+    case TokenType::MINUS:
+      if (expr->type == AST::StaticType::INT) {
+        emit(OpCode::NEGATE_INT);
+        return;
+      }
+      if (expr->type == AST::StaticType::REAL) {
+        emit(OpCode::NEGATE_REAL);
+        return;
+      }
+      emit(OpCode::NEGATE);
+      break;
+    default: emit(OpCode::UNARY); break;
+  }
+  emitToken(expr->op);
+}
+
+void BytecodeCompiler::compileExpr(const AST::ExprPtrVariant& expr) {
+  switch (expr.index()) {
+    case 0:  // BinaryExprPtr
+      compileBinaryExpr(std::get<0>(expr));
+      break;
+    case 1:  // GroupingExprPtr
+      compileExpr(std::get<1>(expr)->expression);
+      break;
+    case 2: {  // LiteralExprPtr
+      const AST::LiteralExprPtr& literal = std::get<2>(expr);
+      emit(OpCode::CONSTANT);
+      emitOperand(literal->constant != AST::LiteralExpr::NO_CONSTANT
+                      ? literal->constant
+                      : constants.add(
+                          Evaluator::toLoxObject(literal->literalVal)));
+      break;
+    }
+    case 3:  // UnaryExprPtr
+      compileUnaryExpr(std::get<3>(expr));
+      break;
+    case 4: {  // ConditionalExprPtr
+      const AST::ConditionalExprPtr& conditional = std::get<4>(expr);
+      compileExpr(conditional->condition);
+      const size_t elseJump = emitJump(OpCode::JUMP_IF_FALSE);
+      compileExpr(conditional->thenBranch);
+      const size_t endJump = emitJump(OpCode::JUMP);
+      patchJump(elseJump);
+      --stackDepth;  // only one of the branches pushes its value
+      compileExpr(conditional->elseBranch);
+      patchJump(endJump);
+      break;
+    }
+    case 5: {  // VariableExprPtr
+      const AST::VariableExprPtr& variable = std::get<5>(expr);
+      if (variable->type != AST::StaticType::UNKNOWN) {
+        emit(OpCode::LOAD);
+        emitOperand(variable->slot);
+        break;
+      }
+      emit(OpCode::GET);
+      emitOperand(variable->slot);
+      emitToken(variable->varName);
+      break;
+    }
+    case 6: {  // AssignmentExprPtr
+      const AST::AssignmentExprPtr& assignment = std::get<6>(expr);
+      if (const AST::BinaryExprPtr append = assignment->selfAppend) {
+        compileExpr(append->left);
+        compileExpr(append->right);
+        emit(OpCode::APPEND);
+        emitOperand(assignment->slot);
+        emitToken(append->op);
+        break;
+      }
+      compileExpr(assignment->right);
+      if (assignment->type != AST::StaticType::UNKNOWN
+          && AST::typeOf(assignment->right) == assignment->type) {
+        emit(OpCode::STORE);
+        emitOperand(assignment->slot);
+        break;
+      }
+      emit(OpCode::SET);
+      emitOperand(assignment->slot);
+      emitToken(assignment->varName);
+      break;
+    }
+    case 7: {  // LogicalExprPtr
+      // The parser only makes `and` and `or` LogicalExprs.
+      const AST::LogicalExprPtr& logical = std::get<7>(expr);
+      compileExpr(logical->left);
+      const size_t endJump = emitJump(logical->op.getType() == TokenType::OR
+                                          ? OpCode::JUMP_IF_TRUE_OR_POP
+                                          : OpCode::JUMP_IF_FALSE_OR_POP);
+      compileExpr(logical->right);
+      patchJump(endJump);
+      break;
+    }
+    default:
+      static_assert(std::variant_size_v<AST::ExprPtrVariant> == 8,
+                    "Looks like you forgot to update the cases in "
+                    "BytecodeCompiler::compileExpr()!");
+  }
+}
+
+void BytecodeCompiler::emit(OpCode op) {
+  chunk.code.push_back(static_cast<uint8_t>(op));
+  stackDepth += info(op).stackEffect;
+  chunk.maxStack = std::max(chunk.maxStack, stackDepth);
+}
+
+void BytecodeCompiler::emitOperand(uint32_t operand) {
+  const size_t offset = chunk.code.size();
+  chunk.code.resize(offset + sizeof(operand));
+  std::memcpy(&chunk.code[offset], &operand, sizeof(operand));
+}
+
+void BytecodeCompiler::emitToken(const Types::Token& token) {
+  emitOperand(static_cast<uint32_t>(chunk.tokens.size()));
+  chunk.tokens.push_back(token);
+}
+
+auto BytecodeCompiler::emitJump(OpCode op) -> size_t {
+  emit(op);
+  emitOperand(0);
+  return chunk.code.size() - sizeof(uint32_t);
+}
+
+void BytecodeCompiler::patchJump(size_t jump) { patchJump(jump, here()); }
+
+void BytecodeCompiler::patchJump(size_t jump, size_t target) {
+  const auto operand = static_cast<uint32_t>(target);
+  std::memcpy(&chunk.code[jump], &operand, sizeof(operand));
+}
+
+auto BytecodeCompiler::here() const -> uint32_t {
+  return static_cast<uint32_t>(chunk.code.size());
+}
+
+// =========== //
+// disassemble
+// =========== //
+auto disassemble(const Chunk& chunk) -> std::string {
+  std::ostringstream listing;
+  size_t offset = 0;
+  while (offset < chunk.code.size()) {
+    const auto op = static_cast<OpCode>(chunk.code[offset]);
+    listing << offset << '\t' << info(op).name;
+    std::istringstream operandNames{std::string(info(op).operands)};
+    std::string operandName;
+    offset += 1;
+    for (size_t i = 0; i < numOperands(op); ++i) {
+      operandNames >> operandName;
+      const uint32_t operand = chunk.operand(offset);
+      listing << ' ' << operandName << '=' << operand;
+      if (operandName == "token")
+        listing << " '" << chunk.tokens[operand].getLexeme() << "'";
+      offset += sizeof(uint32_t);
+    }
+    listing << '\n';
+  }
+  return listing.str();
+}
+
+}  // namespace cpplox::VM
@@ -0,0 +1,157 @@
+#ifndef CPPLOX_VM_BYTECODE_H
+#define CPPLOX_VM_BYTECODE_H
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "Environment.h"
+#include "NodeTypes.h"
+#include "Objects.h"
+#include "Token.h"
+
+namespace cpplox::VM {
+
+using Evaluator::LoxObject;
+
+// The instruction set of the StackVM. An instruction is a one byte opcode
+// followed by its operands, each a 4 byte unsigned integer stored in native
+// byte order:
+//   const   an index into the ConstantPool
+//   slot    a variable's slot, as numbered by the Resolver
+//   token   an index into Chunk::tokens: the operator or variable to blame
+//           for a runtime error
+//   target  an offset into Chunk::code
+//   type    the DeclaredType a declaration gives its variable
+//
+// The _INT and _REAL operators are for operands the TypeChecker proved to be
+// two ints or two reals, which they take as such without checking; LOAD and
+// STORE are for variables it proved to hold a value of their type.
+//
+// X(name, operands, stack effect)
+#define CPPLOX_TYPED_STACK_OPCODES(X, T)                                      \
+  X(ADD_##T, "", -1)                /* in the order of ADD..NOT_EQUAL */      \
+  X(SUBTRACT_##T, "", -1)                                                     \
+  X(MULTIPLY_##T, "", -1)                                                     \
+  X(DIVIDE_##T, "token", -1)        /* the token blames a zero divisor */     \
+  X(MODULO_##T, "token", -1)                                                  \
+  X(LESS_##T, "", -1)                                                         \
+  X(LESS_EQUAL_##T, "", -1)                                                   \
+  X(GREATER_##T, "", -1)                                                      \
+  X(GREATER_EQUAL_##T, "", -1)                                                \
+  X(EQUAL_##T, "", -1)                                                        \
+  X(NOT_EQUAL_##T, "", -1)                                                    \
+  X(NEGATE_##T, "", 0)
+
+#define CPPLOX_STACK_OPCODES(X)                                               \
+  X(CONSTANT, "const", 1)           /* push constants[const] */               \
+  X(NIL, "", 1)                     /* push nil */                            \
+  X(POP, "", -1)                                                              \
+  X(GET, "slot token", 1)           /* push the variable's value */           \
+  X(LOAD, "slot", 1)                /* the same, unchecked */                 \
+  X(SET, "slot token", 0)           /* assign top; replace it by the var */   \
+  X(STORE, "slot", 0)               /* assign top of the var's own type */    \
+  X(APPEND, "slot token", -1)       /* x = pop2 + pop1, for x = x + ... */    \
+  X(DEFINE, "slot type", -1)        /* declare the var, initialized to top */ \
+  X(READ, "slot token", 0)          /* read stdin into the variable */        \
+  X(ADD, "token", -1)               /* binary operators: */                   \
+  X(SUBTRACT, "token", -1)          /*   push(pop2 op pop1) */                \
+  X(MULTIPLY, "token", -1)                                                    \
+  X(DIVIDE, "token", -1)                                                      \
+  X(MODULO, "token", -1)                                                      \
+  X(LESS, "token", -1)                                                        \
+  X(LESS_EQUAL, "token", -1)                                                  \
+  X(GREATER, "token", -1)                                                     \
+  X(GREATER_EQUAL, "token", -1)                                               \
+  X(EQUAL, "", -1)                                                            \
+  X(NOT_EQUAL, "", -1)                                                        \
+  X(BINARY, "token", -1)            /* any other binary operator */           \
+  X(NEGATE, "token", 0)             /* unary operators: push(op pop) */       \
+  X(NOT, "", 0)                                                               \
+  X(UNARY, "token", 0)              /* any other unary operator */            \
+  CPPLOX_TYPED_STACK_OPCODES(X, INT)                                          \
+  CPPLOX_TYPED_STACK_OPCODES(X, REAL)                                         \
+  X(WRITE, "", -1)                  /* print pop and a space */               \
+  X(WRITE_END, "", 0)               /* end the line */                        \
+  X(JUMP, "target", 0)                                                        \
+  X(JUMP_IF_FALSE, "target", -1)    /* pops the condition */                  \
+  X(JUMP_IF_FALSE_OR_POP, "target", -1) /* `and`: keeps top if jumping */     \
+  X(JUMP_IF_TRUE_OR_POP, "target", -1)  /* `or`: keeps top if jumping */      \
+  X(STRAY_BREAK, "token", 0)        /* a break outside of any loop */         \
+  X(HALT, "", 0)
+
+enum class OpCode : uint8_t {
+#define CPPLOX_OPCODE_ENUM(name, operands, effect) name,
+  CPPLOX_STACK_OPCODES(CPPLOX_OPCODE_ENUM)
+#undef CPPLOX_OPCODE_ENUM
+};
+
+// A compiled program.
+struct Chunk {
+  std::vector<uint8_t> code;
+  std::vector<Types::Token> tokens;
+  // The code of every statement that sits in a statement list (the program's
+  // or a block's), innermost first. A runtime error abandons the innermost
+  // such statement and carries on after it, as the Evaluator does.
+  struct Statement {
+    uint32_t start;
+    uint32_t end;
+  };
+  std::vector<Statement> statements;
+  // The deepest the operand stack gets.
+  uint32_t maxStack = 0;
+
+  [[nodiscard]] auto operand(size_t offset) const -> uint32_t {
+    uint32_t value;
+    std::memcpy(&value, &code[offset], sizeof(value));
+    return value;
+  }
+};
+
+// Compiles programs that have been through the ConstantFolder and the
+// Resolver.
+class BytecodeCompiler {
+ public:
+  // Literals the ConstantFolder didn't get to are added to `constants`.
+  explicit BytecodeCompiler(Evaluator::ConstantPool& constants);
+
+  auto compile(const AST::Program& program) -> Chunk;
+
+ private:
+  void compileStmts(AST::StmtList stmts);
+  void compileStmt(const AST::StmtPtrVariant& stmt);
+  void compileDeclaration(
+      uint32_t slot, const std::optional<AST::ExprPtrVariant>& initializer,
+      Evaluator::DeclaredType type);
+  void compileWhileStmt(const AST::WhileStmtPtr& stmt);
+  void compileForStmt(const AST::ForStmtPtr& stmt);
+  void compileExpr(const AST::ExprPtrVariant& expr);
+  void compileBinaryExpr(const AST::BinaryExprPtr& expr);
+  void compileUnaryExpr(const AST::UnaryExprPtr& expr);
+
+  void emit(OpCode op);
+  void emitOperand(uint32_t operand);
+  void emitToken(const Types::Token& token);
+  // Emits a forward jump; its target is set by patchJump().
+  auto emitJump(OpCode op) -> size_t;
+  void patchJump(size_t jump);
+  void patchJump(size_t jump, size_t target);
+  [[nodiscard]] auto here() const -> uint32_t;
+
+  Evaluator::ConstantPool& constants;
+  Chunk chunk;
+  uint32_t stackDepth = 0;
+  // For each loop being compiled, the jumps its `break`s left to patch.
+  std::vector<std::vector<size_t>> breakJumps;
+};
+
+// A listing of the chunk's code, one instruction per line.
+auto disassemble(const Chunk& chunk) -> std::string;
+
+}  // namespace cpplox::VM
+
+#endif  // CPPLOX_VM_BYTECODE_H
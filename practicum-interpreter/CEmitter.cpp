@@ -0,0 +1,1347 @@
+#include "CEmitter.h"
+
+#include <bit>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+#include <utility>
+#include <variant>
+
+#include "CRuntime.h"
+
+namespace cpplox::AOT {
+
+using Types::TokenType;
+
+namespace {
+using Kinds = CEmitter::Kinds;
+
+constexpr Kinds STRING = 1U << 0;
+constexpr Kinds NUMBER = 1U << 1;
+constexpr Kinds BOOL = 1U << 2;
+constexpr Kinds NIL = 1U << 3;
+constexpr Kinds INT = 1U << 4;
+// The kinds of value that can be true, and that can be false.
+constexpr Kinds TRUTHY = STRING | NUMBER | BOOL | INT;
+constexpr Kinds FALSY = BOOL | NIL;
+
+auto isSingle(Kinds kinds) -> bool { return std::has_single_bit(kinds); }
+
+// A real or an int, for sure.
+auto isNumeric(Kinds kinds) -> bool { return kinds == NUMBER || kinds == INT; }
+
+auto kindOf(const Evaluator::LoxObject& value) -> Kinds {
+  return static_cast<Kinds>(1U << value.index());
+}
+
+// The runtime's type tag (the LoxObject index) of a single kind.
+auto tagOf(Kinds kind) -> int { return std::countr_zero(kind); }
+
+auto isArithmetic(TokenType op) -> bool {
+  return op == TokenType::PLUS || op == TokenType::MINUS
+         || op == TokenType::STAR || op == TokenType::SLASH
+         || op == TokenType::MOD;
+}
+
+auto isComparison(TokenType op) -> bool {
+  return op == TokenType::LESS || op == TokenType::LESS_EQUAL
+         || op == TokenType::GREATER || op == TokenType::GREATER_EQUAL;
+}
+
+// What applyBinary() can return for operands of these kinds.
+auto binaryKinds(TokenType op, Kinds left, Kinds right) -> Kinds {
+  if (left == 0 || right == 0) return 0;
+  const bool numbers
+      = (left & (NUMBER | INT)) != 0 && (right & (NUMBER | INT)) != 0;
+  // Two ints make an int, and a real with either a real.
+  const auto arithmetic = static_cast<Kinds>(
+      ((left & INT) != 0 && (right & INT) != 0 ? INT : 0)
+      | (numbers && ((left | right) & NUMBER) != 0 ? NUMBER : 0));
+  switch (op) {
+    case TokenType::COMMA: return right;
+    case TokenType::EQUAL_EQUAL:
+    case TokenType::BANG_EQUAL: return BOOL;
+    case TokenType::PLUS:
+      return static_cast<Kinds>(
+          arithmetic | (((left | right) & STRING) != 0 ? STRING : 0));
+    default:
+      if (isArithmetic(op)) return arithmetic;
+      if (isComparison(op)) return numbers ? BOOL : 0;
+      return 0;
+  }
+}
+
+auto unaryKinds(TokenType op, Kinds right) -> Kinds {
+  if (right == 0) return 0;
+  if (op == TokenType::BANG) return BOOL;
+  if (op == TokenType::MINUS) return right & (NUMBER | INT);
+  return 0;
+}
+
+// What storing a value of these kinds in a variable declared as any of
+// `declared` can leave in it: Environment::converted() makes a real an int
+// for an int variable, and an int a real for a real one.
+auto storedKinds(Kinds declared, Kinds kinds) -> Kinds {
+  Kinds stored = kinds;
+  if ((kinds & NUMBER) != 0 && (declared & INT) != 0) {
+    stored |= INT;
+    if (declared == INT) stored &= ~NUMBER;
+  }
+  if ((kinds & INT) != 0 && (declared & NUMBER) != 0) {
+    stored |= NUMBER;
+    if (declared == NUMBER) stored &= ~INT;
+  }
+  return stored;
+}
+
+auto logicalKinds(TokenType op, Kinds left, Kinds right) -> Kinds {
+  if (op == TokenType::OR)
+    return static_cast<Kinds>((left & TRUTHY)
+                              | ((left & FALSY) != 0 ? right : 0));
+  if (op == TokenType::AND)
+    return static_cast<Kinds>((left & FALSY)
+                              | ((left & TRUTHY) != 0 ? right : 0));
+  return 0;
+}
+
+auto conditionalKinds(Kinds condition, Kinds thenBranch, Kinds elseBranch)
+    -> Kinds {
+  return static_cast<Kinds>(((condition & TRUTHY) != 0 ? thenBranch : 0)
+                            | ((condition & FALSY) != 0 ? elseBranch : 0));
+}
+
+// The runtime's generic operator for op, if it has one.
+auto runtimeOp(TokenType op) -> const char* {
+  switch (op) {
+    case TokenType::PLUS: return "LOX_ADD";
+    case TokenType::MINUS: return "LOX_SUBTRACT";
+    case TokenType::STAR: return "LOX_MULTIPLY";
+    case TokenType::SLASH: return "LOX_DIVIDE";
+    case TokenType::MOD: return "LOX_MODULO";
+    case TokenType::LESS: return "LOX_LESS";
+    case TokenType::LESS_EQUAL: return "LOX_LESS_EQUAL";
+    case TokenType::GREATER: return "LOX_GREATER";
+    case TokenType::GREATER_EQUAL: return "LOX_GREATER_EQUAL";
+    default: return nullptr;
+  }
+}
+
+auto cOperator(TokenType op) -> const char* {
+  switch (op) {
+    case TokenType::PLUS: return " + ";
+    case TokenType::MINUS: return " - ";
+    case TokenType::STAR: return " * ";
+    case TokenType::SLASH: return " / ";
+    case TokenType::LESS: return " < ";
+    case TokenType::LESS_EQUAL: return " <= ";
+    case TokenType::GREATER: return " > ";
+    default: return " >= ";
+  }
+}
+
+// Whether evaluating expr can assign to a variable.
+auto mayAssign(const AST::ExprPtrVariant& expr) -> bool {
+  switch (expr.index()) {
+    case 0:  // BinaryExprPtr
+      return mayAssign(std::get<0>(expr)->left)
+             || mayAssign(std::get<0>(expr)->right);
+    case 1:  // GroupingExprPtr
+      return mayAssign(std::get<1>(expr)->expression);
+    case 2:  // LiteralExprPtr
+      return false;
+    case 3:  // UnaryExprPtr
+      return mayAssign(std::get<3>(expr)->right);
+    case 4:  // ConditionalExprPtr
+      return mayAssign(std::get<4>(expr)->condition)
+             || mayAssign(std::get<4>(expr)->thenBranch)
+             || mayAssign(std::get<4>(expr)->elseBranch);
+    case 5:  // VariableExprPtr
+      return false;
+    case 6:  // AssignmentExprPtr
+      return true;
+    case 7:  // LogicalExprPtr
+      return mayAssign(std::get<7>(expr)->left)
+             || mayAssign(std::get<7>(expr)->right);
+    default:
+      static_assert(std::variant_size_v<AST::ExprPtrVariant> == 8,
+                    "Looks like you forgot to update the cases in "
+                    "mayAssign()!");
+      return true;
+  }
+}
+
+// The variables expr always assigns to, when it is evaluated in full.
+void collectAssignments(const AST::ExprPtrVariant& expr,
+                        std::vector<uint32_t>& slots) {
+  switch (expr.index()) {
+    case 0:  // BinaryExprPtr
+      collectAssignments(std::get<0>(expr)->left, slots);
+      return collectAssignments(std::get<0>(expr)->right, slots);
+    case 1:  // GroupingExprPtr
+      return collectAssignments(std::get<1>(expr)->expression, slots);
+    case 3:  // UnaryExprPtr
+      return collectAssignments(std::get<3>(expr)->right, slots);
+    case 4:  // ConditionalExprPtr: only the condition always runs
+      return collectAssignments(std::get<4>(expr)->condition, slots);
+    case 6:  // AssignmentExprPtr
+      slots.push_back(std::get<6>(expr)->slot);
+      return collectAssignments(std::get<6>(expr)->right, slots);
+    case 7:  // LogicalExprPtr: only the left operand always runs
+      return collectAssignments(std::get<7>(expr)->left, slots);
+    default: return;  // LiteralExprPtr, VariableExprPtr
+  }
+}
+
+// A lox_value's payload, when it is known to be of the single kind.
+auto narrowed(const std::string& value, Kinds kind) -> std::string {
+  return value
+         + (kind == STRING   ? ".as.string"
+            : kind == NUMBER ? ".as.number"
+            : kind == INT    ? ".as.integer"
+                             : ".as.boolean");
+}
+
+// What a temporary of these kinds starts out as, before it is assigned.
+auto initialValue(Kinds kinds) -> std::string {
+  switch (kinds) {
+    case STRING: return "NULL";
+    case NUMBER:
+    case INT: return "0";
+    case BOOL: return "false";
+    default: return "lox_nil()";
+  }
+}
+
+auto cStringLiteral(std::string_view chars) -> std::string {
+  std::string literal = "\"";
+  for (const char c : chars) {
+    if (c == '"' || c == '\\' || c == '?') {
+      literal += '\\';
+      literal += c;
+    } else if (c >= ' ' && c <= '~') {
+      literal += c;
+    } else {
+      char escape[8];
+      std::snprintf(escape, sizeof escape, "\\%03o",
+                    static_cast<unsigned char>(c));
+      literal += escape;
+    }
+  }
+  return literal + '"';
+}
+
+auto cNumberLiteral(double number) -> std::string {
+  if (!std::isfinite(number)) {
+    char bits[32];
+    std::snprintf(bits, sizeof bits, "lox_bits(0x%016llxULL)",
+                  static_cast<unsigned long long>(
+                      std::bit_cast<uint64_t>(number)));
+    return bits;
+  }
+  char digits[32];
+  std::snprintf(digits, sizeof digits, "%.17g", number);
+  std::string literal = digits;
+  if (literal.find_first_of(".e") == std::string::npos) literal += ".0";
+  return number < 0 || std::signbit(number) ? "(" + literal + ")" : literal;
+}
+
+auto cIntLiteral(int64_t integer) -> std::string {
+  if (integer == INT64_MIN) return "INT64_MIN";
+  const std::string literal = "INT64_C(" + std::to_string(integer) + ")";
+  return integer < 0 ? "(" + literal + ")" : literal;
+}
+}  // namespace
+
+CEmitter::CEmitter(const Evaluator::ConstantPool& p_constants,
+                   const ErrorsAndDebug::LineIndex& p_lines)
+    : constants(p_constants), lines(p_lines) {}
+
+void CEmitter::emit(const AST::Program& program, std::ostream& out) {
+  inferVariables(program);
+  sureDeclared.assign(variables.size(), false);
+  sureValue.assign(variables.size(), false);
+  failLabel = "lox_abort";
+  emitStmts(program.statements, true);
+
+  out << "/* Compiled from a Model program by langc --emit-c. */\n"
+      << C_RUNTIME << '\n';
+  if (!sites.empty()) {
+    out << "static const char* const lox_sites[] = {\n";
+    for (const std::string& where : sites)
+      out << "    " << cStringLiteral(where) << ",\n";
+    out << "};\n\n";
+  }
+  if (!strings.empty())
+    out << "static lox_str* lox_k[" << strings.size() << "];\n\n";
+
+  out << "int main(void) {\n";
+  // Sites can be left over from code that turned out not to be reachable.
+  if (!sites.empty()) out << "  (void)lox_sites;\n";
+  for (size_t i = 0; i < strings.size(); ++i) {
+    out << "  lox_k[" << i << "] = lox_str_constant("
+        << cStringLiteral(strings[i]) << ", " << strings[i].size() << ");\n";
+  }
+  for (const Variable& var : variables) {
+    if (!var.declared) continue;
+    const std::string& name = var.name;
+    out << "  uint8_t t_" << name << " = LOX_UNDEFINED;\n";
+    out << "  (void)t_" << name << ";\n";
+    if (var.kinds == 0) continue;
+    if (var.kinds == NUMBER || var.kinds == INT || var.kinds == BOOL) {
+      out << "  " << cType(var.kinds) << " v_" << name << " = 0;\n";
+      out << "  bool n_" << name << " = true;\n";
+      out << "  (void)n_" << name << ";\n";
+    } else if (var.kinds == STRING) {
+      out << "  lox_str* v_" << name << " = NULL;\n";
+    } else {
+      out << "  lox_value v_" << name << " = lox_nil();\n";
+    }
+    out << "  (void)v_" << name << ";\n";
+  }
+  out << body.str();
+  out << "  return lox_finish(0);\n";
+  if (usedLabels.contains("lox_abort"))
+    out << "lox_abort:\n  return lox_finish(70);\n";
+  out << "}\n";
+}
+
+// ============== //
+// Kind inference
+// ============== //
+
+// The kinds of value every variable can hold are grown until they settle:
+// what an assignment stores depends on the kinds of the variables its value
+// is computed from.
+void CEmitter::inferVariables(const AST::Program& program) {
+  // Declarations all come first, at the top of the program.
+  for (const AST::StmtPtrVariant& stmt : program.statements) {
+    uint32_t slot = AST::UNRESOLVED_SLOT;
+    Kinds kind = NUMBER;
+    const Types::Token* varName = nullptr;
+    if (std::holds_alternative<AST::IntStmtPtr>(stmt)) {
+      slot = std::get<AST::IntStmtPtr>(stmt)->slot;
+      varName = &std::get<AST::IntStmtPtr>(stmt)->varName;
+      kind = INT;
+    } else if (std::holds_alternative<AST::RealStmtPtr>(stmt)) {
+      slot = std::get<AST::RealStmtPtr>(stmt)->slot;
+      varName = &std::get<AST::RealStmtPtr>(stmt)->varName;
+    } else if (std::holds_alternative<AST::StrStmtPtr>(stmt)) {
+      slot = std::get<AST::StrStmtPtr>(stmt)->slot;
+      varName = &std::get<AST::StrStmtPtr>(stmt)->varName;
+      kind = STRING;
+    } else {
+      continue;
+    }
+    Variable& var = variable(slot);
+    var.name = varName->getLexeme();
+    var.declared = true;
+    var.declaredKinds |= kind;
+  }
+
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (const AST::StmtPtrVariant& stmt : program.statements)
+      changed |= inferStmt(stmt);
+  }
+}
+
+auto CEmitter::inferStmt(const AST::StmtPtrVariant& stmt) -> bool {
+  bool changed = false;
+  switch (stmt.index()) {
+    case 0:  // ExprStmtPtr
+      return inferExpr(std::get<0>(stmt)->expression);
+    case 1:  // WriteStmtPtr
+      for (const AST::ExprPtrVariant& expr : std::get<1>(stmt)->expressions)
+        changed |= inferExpr(expr);
+      return changed;
+    case 2: {  // ReadStmtPtr
+      Variable& var = variable(std::get<2>(stmt)->slot);
+      var.read = true;
+      return var.declared && addKinds(std::get<2>(stmt)->slot, readKinds(var));
+    }
+    case 3:  // BlockStmtPtr
+      for (const AST::StmtPtrVariant& inner : std::get<3>(stmt)->statements)
+        changed |= inferStmt(inner);
+      return changed;
+    case 4:  // IntStmtPtr
+      return inferDeclaration(std::get<4>(stmt)->slot,
+                              std::get<4>(stmt)->initializer, INT);
+    case 5:  // RealStmtPtr
+      return inferDeclaration(std::get<5>(stmt)->slot,
+                              std::get<5>(stmt)->initializer, NUMBER);
+    case 6:  // StrStmtPtr
+      return inferDeclaration(std::get<6>(stmt)->slot,
+                              std::get<6>(stmt)->initializer, STRING);
+    case 7: {  // IfStmtPtr
+      const auto& ifStmt = std::get<7>(stmt);
+      changed |= inferExpr(ifStmt->condition);
+      changed |= inferStmt(ifStmt->thenBranch);
+      if (ifStmt->elseBranch.has_value())
+        changed |= inferStmt(ifStmt->elseBranch.value());
+      return changed;
+    }
+    case 8:  // WhileStmtPtr
+      changed |= inferExpr(std::get<8>(stmt)->condition);
+      return inferStmt(std::get<8>(stmt)->loopBody) || changed;
+    case 9: {  // ForStmtPtr
+      const auto& forStmt = std::get<9>(stmt);
+      if (forStmt->initializer.has_value())
+        changed |= inferStmt(forStmt->initializer.value());
+      if (forStmt->condition.has_value())
+        changed |= inferExpr(forStmt->condition.value());
+      if (forStmt->increment.has_value())
+        changed |= inferExpr(forStmt->increment.value());
+      return inferStmt(forStmt->loopBody) || changed;
+    }
+    case 10:  // BreakStmtPtr
+      return false;
+    default:
+      static_assert(std::variant_size_v<AST::StmtPtrVariant> == 11,
+                    "Looks like you forgot to update the cases in "
+                    "CEmitter::inferStmt()!");
+      return false;
+  }
+}
+
+auto CEmitter::inferDeclaration(
+    uint32_t slot, const std::optional<AST::ExprPtrVariant>& initializer,
+    Kinds /*declaredKind*/) -> bool {
+  if (!initializer.has_value()) return false;
+  bool changed = inferExpr(initializer.value());
+  const Kinds kinds = kindsOf(initializer.value());
+  Variable& var = variable(slot);
+  changed |= addKinds(slot, storedKinds(var.declaredKinds,
+                                        static_cast<Kinds>(kinds & ~NIL)));
+  // A nil initializer counts as assigning nil, so that the variable is
+  // never assumed to hold a value.
+  if ((kinds & NIL) != 0 && !var.assignedNil) {
+    var.assignedNil = true;
+    changed = true;
+  }
+  return changed;
+}
+
+auto CEmitter::inferExpr(const AST::ExprPtrVariant& expr) -> bool {
+  switch (expr.index()) {
+    case 0:  // BinaryExprPtr
+      return inferExpr(std::get<0>(expr)->left)
+             | inferExpr(std::get<0>(expr)->right);
+    case 1:  // GroupingExprPtr
+      return inferExpr(std::get<1>(expr)->expression);
+    case 3:  // UnaryExprPtr
+      return inferExpr(std::get<3>(expr)->right);
+    case 4:  // ConditionalExprPtr
+      return inferExpr(std::get<4>(expr)->condition)
+             | inferExpr(std::get<4>(expr)->thenBranch)
+             | inferExpr(std::get<4>(expr)->elseBranch);
+    case 5:  // VariableExprPtr
+      variable(std::get<5>(expr)->slot).name
+          = std::get<5>(expr)->varName.getLexeme();
+      return false;
+    case 6: {  // AssignmentExprPtr
+      const auto& assignment = std::get<6>(expr);
+      bool changed = inferExpr(assignment->right);
+      Variable& var = variable(assignment->slot);
+      if (!var.declared) return changed;
+      const Kinds kinds = kindsOf(assignment->right);
+      changed |= addKinds(assignment->slot,
+                          storedKinds(var.declaredKinds,
+                                      static_cast<Kinds>(kinds & ~NIL)));
+      if ((kinds & NIL) != 0 && !variable(assignment->slot).assignedNil) {
+        variable(assignment->slot).assignedNil = true;
+        changed = true;
+      }
+      return changed;
+    }
+    case 7:  // LogicalExprPtr
+      return inferExpr(std::get<7>(expr)->left)
+             | inferExpr(std::get<7>(expr)->right);
+    default:  // LiteralExprPtr
+      return false;
+  }
+}
+
+auto CEmitter::addKinds(uint32_t slot, Kinds kinds) -> bool {
+  Variable& var = variable(slot);
+  const auto grown = static_cast<Kinds>(var.kinds | kinds);
+  if (grown == var.kinds) return false;
+  var.kinds = grown;
+  return true;
+}
+
+// Like binaryKinds() and the rest, but for a whole expression.
+auto CEmitter::kindsOf(const AST::ExprPtrVariant& expr) const -> Kinds {
+  switch (expr.index()) {
+    case 0: {  // BinaryExprPtr
+      const auto& binary = std::get<0>(expr);
+      return binaryKinds(binary->op.getType(), kindsOf(binary->left),
+                         kindsOf(binary->right));
+    }
+    case 1:  // GroupingExprPtr
+      return kindsOf(std::get<1>(expr)->expression);
+    case 2: {  // LiteralExprPtr
+      const auto& literal = std::get<2>(expr);
+      if (literal->constant != AST::LiteralExpr::NO_CONSTANT)
+        return kindOf(constants[literal->constant]);
+      return kindOf(Evaluator::toLoxObject(literal->literalVal));
+    }
+    case 3:  // UnaryExprPtr
+      return unaryKinds(std::get<3>(expr)->op.getType(),
+                        kindsOf(std::get<3>(expr)->right));
+    case 4: {  // ConditionalExprPtr
+      const auto& conditional = std::get<4>(expr);
+      return conditionalKinds(kindsOf(conditional->condition),
+                              kindsOf(conditional->thenBranch),
+                              kindsOf(conditional->elseBranch));
+    }
+    case 5: {  // VariableExprPtr
+      const uint32_t slot = std::get<5>(expr)->slot;
+      if (slot >= variables.size() || !variables[slot].declared) return 0;
+      return variables[slot].kinds;
+    }
+    case 6: {  // AssignmentExprPtr
+      const auto& assignment = std::get<6>(expr);
+      if (assignment->slot >= variables.size()
+          || !variables[assignment->slot].declared)
+        return 0;
+      return storedKinds(
+          variables[assignment->slot].declaredKinds,
+          static_cast<Kinds>(kindsOf(assignment->right) & ~NIL));
+    }
+    case 7: {  // LogicalExprPtr
+      const auto& logical = std::get<7>(expr);
+      const Kinds left = kindsOf(logical->left);
+      return left == 0 ? 0
+                       : logicalKinds(logical->op.getType(), left,
+                                      kindsOf(logical->right));
+    }
+    default:
+      static_assert(std::variant_size_v<AST::ExprPtrVariant> == 8,
+                    "Looks like you forgot to update the cases in "
+                    "CEmitter::kindsOf()!");
+      return 0;
+  }
+}
+
+// What read() can store: Environment::read() parses the input as the type
+// the variable was declared with.
+auto CEmitter::readKinds(const Variable& variable) const -> Kinds {
+  return variable.declaredKinds;
+}
+
+auto CEmitter::variable(uint32_t slot) -> Variable& {
+  if (slot >= variables.size()) variables.resize(slot + 1);
+  return variables[slot];
+}
+
+// ============ //
+// Statements
+// ============ //
+
+// Every statement of a list gets a recovery label: a runtime error in the
+// statement jumps there, and carries on with the next statement, unless
+// there have been too many errors. Then it goes on to the recovery of the
+// statement the list is in, or ends the program.
+void CEmitter::emitStmts(AST::StmtList stmts, bool topLevel) {
+  for (const AST::StmtPtrVariant& stmt : stmts) {
+    const std::string recovery = newLabel("f");
+    std::string enclosing = std::exchange(failLabel, recovery);
+    line("{");
+    ++depth;
+    emitStmt(stmt);
+    --depth;
+    line("}");
+    failLabel = std::move(enclosing);
+
+    if (usedLabels.contains(recovery)) {
+      line("if (0) {");
+      line(recovery + ":");
+      ++depth;
+      line("if (!lox_recover()) goto " + failLabel + ";");
+      usedLabels.insert(failLabel);
+      --depth;
+      line("}");
+    } else if (topLevel) {
+      noteSureVariables(stmt);
+    }
+  }
+}
+
+void CEmitter::emitStmt(const AST::StmtPtrVariant& stmt) {
+  switch (stmt.index()) {
+    case 0:  // ExprStmtPtr
+      return release(emitExpr(std::get<0>(stmt)->expression));
+    case 1:  // WriteStmtPtr
+      return emitWrite(std::get<1>(stmt));
+    case 2:  // ReadStmtPtr
+      return emitRead(std::get<2>(stmt));
+    case 3:  // BlockStmtPtr
+      return emitStmts(std::get<3>(stmt)->statements, false);
+    case 4: {  // IntStmtPtr
+      const auto& intStmt = std::get<4>(stmt);
+      return emitDeclaration(intStmt->varName, intStmt->slot,
+                             intStmt->initializer, tagOf(INT));
+    }
+    case 5: {  // RealStmtPtr
+      const auto& realStmt = std::get<5>(stmt);
+      return emitDeclaration(realStmt->varName, realStmt->slot,
+                             realStmt->initializer, tagOf(NUMBER));
+    }
+    case 6: {  // StrStmtPtr
+      const auto& strStmt = std::get<6>(stmt);
+      return emitDeclaration(strStmt->varName, strStmt->slot,
+                             strStmt->initializer, tagOf(STRING));
+    }
+    case 7:  // IfStmtPtr
+      return emitIf(std::get<7>(stmt));
+    case 8:  // WhileStmtPtr
+      return emitWhile(std::get<8>(stmt));
+    case 9:  // ForStmtPtr
+      return emitFor(std::get<9>(stmt));
+    case 10:  // BreakStmtPtr
+      return emitBreak(std::get<10>(stmt));
+    default:
+      static_assert(std::variant_size_v<AST::StmtPtrVariant> == 11,
+                    "Looks like you forgot to update the cases in "
+                    "CEmitter::emitStmt()!");
+      return;
+  }
+}
+
+void CEmitter::emitDeclaration(
+    const Types::Token& /*varName*/, uint32_t slot,
+    const std::optional<AST::ExprPtrVariant>& initializer, int typeTag) {
+  Operand value{.kinds = NIL};
+  if (initializer.has_value()) {
+    value = emitExpr(initializer.value());
+    if (value.kinds == 0) return;
+  }
+  // The type comes first: storing the value converts it to the type.
+  line("t_" + variables[slot].name + " = " + std::to_string(typeTag) + ";");
+  emitStore(slot, value);
+}
+
+void CEmitter::emitWrite(const AST::WriteStmtPtr& stmt) {
+  for (const AST::ExprPtrVariant& expr : stmt->expressions) {
+    const Operand value = emitExpr(expr);
+    switch (value.kinds) {
+      case 0: return;
+      case STRING: line("lox_write_str(" + value.code + ");"); break;
+      case NUMBER: line("lox_write_number(" + value.code + ");"); break;
+      case INT: line("lox_write_int(" + value.code + ");"); break;
+      case BOOL: line("lox_write_bool(" + value.code + ");"); break;
+      case NIL: line("lox_write_nil();"); break;
+      default: line("lox_write_value(" + value.code + ");"); break;
+    }
+    release(value);
+  }
+  line("lox_write_end();");
+}
+
+void CEmitter::emitRead(const AST::ReadStmtPtr& stmt) {
+  const Variable& var = variables[stmt->slot];
+  const std::string where = site(stmt->varName);
+  if (!var.declared) {
+    line("lox_read_undefined(" + where + ");");
+    line("goto " + failLabel + ";");
+    usedLabels.insert(failLabel);
+    return;
+  }
+  const std::string& name = var.name;
+  if (!isSingle(var.kinds)) {
+    emitFailIf("!lox_read(&v_" + name + ", t_" + name + ", " + where + ")");
+    return;
+  }
+  if (!sureDeclared[stmt->slot]) {
+    line("if (LOX_UNLIKELY(t_" + name + " == LOX_UNDEFINED)) {");
+    ++depth;
+    line("lox_read_undefined(" + where + ");");
+    line("goto " + failLabel + ";");
+    usedLabels.insert(failLabel);
+    --depth;
+    line("}");
+  }
+  // A variable of a single kind is only ever declared as that kind.
+  if (var.kinds == NUMBER || var.kinds == INT) {
+    line("v_" + name + " = "
+         + (var.kinds == INT ? "lox_read_int();" : "lox_read_number();"));
+    line("n_" + name + " = false;");
+  } else {
+    const Operand old = temporary(STRING, "v_" + name);
+    line("v_" + name + " = lox_read_word();");
+    line("if (" + old.code + " != NULL) lox_str_release(" + old.code + ");");
+  }
+}
+
+void CEmitter::emitIf(const AST::IfStmtPtr& stmt) {
+  const Operand condition = emitExpr(stmt->condition);
+  if (condition.kinds == 0) return;
+  const Operand isTrue = temporary(BOOL, truth(condition));
+  release(condition);
+  line("if (" + isTrue.code + ") {");
+  ++depth;
+  emitStmt(stmt->thenBranch);
+  --depth;
+  if (stmt->elseBranch.has_value()) {
+    line("} else {");
+    ++depth;
+    emitStmt(stmt->elseBranch.value());
+    --depth;
+  }
+  line("}");
+}
+
+void CEmitter::emitWhile(const AST::WhileStmtPtr& stmt) {
+  const std::string exit = newLabel("b");
+  breakLabels.push_back(exit);
+  line("for (;;) {");
+  ++depth;
+  const Operand condition = emitExpr(stmt->condition);
+  if (condition.kinds != 0) {
+    const Operand isTrue = temporary(BOOL, truth(condition));
+    release(condition);
+    line("if (!" + isTrue.code + ") goto " + exit + ";");
+    usedLabels.insert(exit);
+    emitStmt(stmt->loopBody);
+  }
+  --depth;
+  line("}");
+  breakLabels.pop_back();
+  if (usedLabels.contains(exit)) line(exit + ": ;");
+}
+
+void CEmitter::emitFor(const AST::ForStmtPtr& stmt) {
+  if (stmt->initializer.has_value()) emitStmt(stmt->initializer.value());
+  const std::string exit = newLabel("b");
+  breakLabels.push_back(exit);
+  line("for (;;) {");
+  ++depth;
+  bool reachable = true;
+  if (stmt->condition.has_value()) {
+    const Operand condition = emitExpr(stmt->condition.value());
+    reachable = condition.kinds != 0;
+    if (reachable) {
+      const Operand isTrue = temporary(BOOL, truth(condition));
+      release(condition);
+      line("if (!" + isTrue.code + ") goto " + exit + ";");
+      usedLabels.insert(exit);
+    }
+  }
+  if (reachable) {
+    emitStmt(stmt->loopBody);
+    if (stmt->increment.has_value())
+      release(emitExpr(stmt->increment.value()));
+  }
+  --depth;
+  line("}");
+  breakLabels.pop_back();
+  if (usedLabels.contains(exit)) line(exit + ": ;");
+}
+
+void CEmitter::emitBreak(const AST::BreakStmtPtr& stmt) {
+  if (!breakLabels.empty()) {
+    line("goto " + breakLabels.back() + ";");
+    usedLabels.insert(breakLabels.back());
+    return;
+  }
+  // The interpreter stops running the program at a stray break.
+  line("lox_error(" + site(stmt->name, false)
+       + ", \"Got break statement out of loop\");");
+  line("return lox_finish(0);");
+}
+
+void CEmitter::noteSureVariables(const AST::StmtPtrVariant& stmt) {
+  std::vector<uint32_t> assigned;
+  const auto declare = [&](uint32_t slot,
+                           const std::optional<AST::ExprPtrVariant>& init) {
+    sureDeclared[slot] = true;
+    sureValue[slot] = init.has_value() && !variables[slot].assignedNil;
+    if (init.has_value()) collectAssignments(init.value(), assigned);
+  };
+  switch (stmt.index()) {
+    case 0:  // ExprStmtPtr
+      collectAssignments(std::get<0>(stmt)->expression, assigned);
+      break;
+    case 4:  // IntStmtPtr
+      declare(std::get<4>(stmt)->slot, std::get<4>(stmt)->initializer);
+      break;
+    case 5:  // RealStmtPtr
+      declare(std::get<5>(stmt)->slot, std::get<5>(stmt)->initializer);
+      break;
+    case 6:  // StrStmtPtr
+      declare(std::get<6>(stmt)->slot, std::get<6>(stmt)->initializer);
+      break;
+    default: break;
+  }
+  for (const uint32_t slot : assigned) {
+    if (slot >= variables.size() || !variables[slot].declared) continue;
+    sureDeclared[slot] = true;
+    if (!variables[slot].assignedNil) sureValue[slot] = true;
+  }
+}
+
+// ============ //
+// Expressions
+// ============ //
+auto CEmitter::emitExpr(const AST::ExprPtrVariant& expr) -> Operand {
+  switch (expr.index()) {
+    case 0:  // BinaryExprPtr
+      return emitBinary(std::get<0>(expr));
+    case 1:  // GroupingExprPtr
+      return emitExpr(std::get<1>(expr)->expression);
+    case 2:  // LiteralExprPtr
+      return emitLiteral(std::get<2>(expr));
+    case 3:  // UnaryExprPtr
+      return emitUnary(std::get<3>(expr));
+    case 4:  // ConditionalExprPtr
+      return emitConditional(std::get<4>(expr));
+    case 5:  // VariableExprPtr
+      return emitVariable(std::get<5>(expr));
+    case 6:  // AssignmentExprPtr
+      return emitAssignment(std::get<6>(expr));
+    case 7:  // LogicalExprPtr
+      return emitLogical(std::get<7>(expr));
+    default:
+      static_assert(std::variant_size_v<AST::ExprPtrVariant> == 8,
+                    "Looks like you forgot to update the cases in "
+                    "CEmitter::emitExpr()!");
+      return {};
+  }
+}
+
+auto CEmitter::emitBinary(const AST::BinaryExprPtr& expr) -> Operand {
+  const TokenType op = expr->op.getType();
+  if (op == TokenType::COMMA) {
+    const Operand left = emitExpr(expr->left);
+    if (left.kinds == 0) return {};
+    release(left);
+    return emitExpr(expr->right);
+  }
+
+  Operand left = emitExpr(expr->left);
+  if (left.kinds == 0) return {};
+  // The left operand is read before the right one is evaluated, which may
+  // assign to it.
+  if (left.isVariable && mayAssign(expr->right)) left = snapshot(left);
+  const Operand right = emitExpr(expr->right);
+  if (right.kinds == 0) return {};
+  const Kinds kinds = binaryKinds(op, left.kinds, right.kinds);
+
+  Operand result;
+  if (op == TokenType::EQUAL_EQUAL || op == TokenType::BANG_EQUAL) {
+    std::string equal;
+    if (isSingle(left.kinds) && left.kinds == right.kinds) {
+      switch (left.kinds) {
+        case STRING:
+          equal = "lox_str_equal(" + left.code + ", " + right.code + ")";
+          break;
+        case NIL: equal = "true"; break;
+        default: equal = "(" + left.code + " == " + right.code + ")"; break;
+      }
+    } else if (isNumeric(left.kinds) && isNumeric(right.kinds)) {
+      // An int and a real, compared as reals.
+      equal = "((double)" + left.code + " == (double)" + right.code + ")";
+    } else if (isSingle(left.kinds) && isSingle(right.kinds)) {
+      equal = "false";
+    } else {
+      equal = "lox_equal(" + boxed(left) + ", " + boxed(right) + ")";
+    }
+    result = temporary(BOOL, op == TokenType::EQUAL_EQUAL ? equal
+                                                          : "!" + equal);
+  } else if (isNumeric(left.kinds) && isNumeric(right.kinds)
+             && (isArithmetic(op) || isComparison(op))) {
+    result = emitNumeric(expr, left, right);
+  } else if (op == TokenType::PLUS && left.kinds == STRING
+             && right.kinds == STRING) {
+    result = temporary(
+        STRING, "lox_str_concat(" + left.code + ", " + right.code + ")");
+    result.owned = true;
+  } else if (runtimeOp(op) != nullptr) {
+    const std::string value = "t" + std::to_string(++numTemporaries);
+    line("lox_value " + value + ";");
+    emitFailIf("!lox_binary(" + std::string(runtimeOp(op)) + ", "
+               + boxed(left) + ", " + boxed(right) + ", &" + value + ", "
+               + site(expr->op) + ")");
+    if (kinds == 0) return {};
+    result = {isSingle(kinds) ? narrowed(value, kinds) : value, kinds, true};
+  } else {
+    // Not an operator the parser produces.
+    emitFail(expr->op, "Attempted to apply invalid operator to binary expr: "
+                           + expr->op.getTypeString());
+    return {};
+  }
+  release(left);
+  release(right);
+  return result;
+}
+
+// Operands that are both ints, or reals, or one of each.
+auto CEmitter::emitNumeric(const AST::BinaryExprPtr& expr, const Operand& left,
+                           const Operand& right) -> Operand {
+  const TokenType op = expr->op.getType();
+  // A literal divisor that is known not to be zero.
+  const Evaluator::LoxObject* divisor = nullptr;
+  if (std::holds_alternative<AST::LiteralExprPtr>(expr->right)) {
+    const uint32_t constant
+        = std::get<AST::LiteralExprPtr>(expr->right)->constant;
+    if (constant != AST::LiteralExpr::NO_CONSTANT)
+      divisor = &constants[constant];
+  }
+
+  if (left.kinds == INT && right.kinds == INT) {
+    const std::string operands = "(" + left.code + ", " + right.code + ")";
+    switch (op) {
+      case TokenType::PLUS: return temporary(INT, "lox_int_add" + operands);
+      case TokenType::MINUS:
+        return temporary(INT, "lox_int_subtract" + operands);
+      case TokenType::STAR:
+        return temporary(INT, "lox_int_multiply" + operands);
+      case TokenType::SLASH:
+      case TokenType::MOD:
+        if (divisor == nullptr || !divisor->isInt() || divisor->asInt() == 0)
+          emitFailWhen(right.code + " == 0", expr->op,
+                       "Division by zero is illegal");
+        return temporary(INT, (op == TokenType::SLASH ? "lox_int_divide"
+                                                      : "lox_int_modulo")
+                                  + operands);
+      default:
+        return temporary(BOOL, left.code + cOperator(op) + right.code);
+    }
+  }
+
+  // An int meets a real: both are reals.
+  const std::string lhs
+      = left.kinds == INT ? "(double)" + left.code : left.code;
+  const std::string rhs
+      = right.kinds == INT ? "(double)" + right.code : right.code;
+  if (op == TokenType::MOD) {
+    if (divisor == nullptr
+        || (divisor->isInt() ? divisor->asInt()
+                             : Evaluator::truncateToInt(divisor->asNumber()))
+               == 0)
+      emitFailWhen("lox_truncate(" + rhs + ") == 0", expr->op,
+                   "Division by zero is illegal");
+    return temporary(NUMBER, "lox_real_modulo(" + lhs + ", " + rhs + ")");
+  }
+  if (op == TokenType::SLASH
+      && (divisor == nullptr
+          || (divisor->isInt() ? divisor->asInt() == 0
+                               : divisor->asNumber() == 0.0)))
+    emitFailWhen(rhs + " == 0.0", expr->op, "Division by zero is illegal");
+  return temporary(isComparison(op) ? BOOL : NUMBER,
+                   lhs + cOperator(op) + rhs);
+}
+
+auto CEmitter::emitUnary(const AST::UnaryExprPtr& expr) -> Operand {
+  const Operand right = emitExpr(expr->right);
+  if (right.kinds == 0) return {};
+  Operand result;
+  switch (expr->op.getType()) {
+    case TokenType::BANG:
+      result = temporary(BOOL, "!" + truth(right));
+      break;
+    case TokenType::MINUS:
+      if (right.kinds == NUMBER) {
+        result = temporary(NUMBER, "-" + right.code);
+      } else if (right.kinds == INT) {
+        result = temporary(INT, "lox_int_negate(" + right.code + ")");
+      } else {
+        const Kinds kinds = unaryKinds(TokenType::MINUS, right.kinds);
+        const std::string value = "t" + std::to_string(++numTemporaries);
+        line("lox_value " + value + ";");
+        emitFailIf("!lox_negate(" + boxed(right) + ", &" + value + ", "
+                   + site(expr->op) + ")");
+        if (kinds == 0) return {};
+        result = {isSingle(kinds) ? narrowed(value, kinds) : value, kinds};
+      }
+      break;
+    default:
+      // Not an operator the parser produces.
+      line("lox_error_value(" + site(expr->op) + ", "
+           + cStringLiteral("Illegal unary expression: "
+                            + std::string(expr->op.getLexeme()))
+           + ", " + boxed(right) + ");");
+      line("goto " + failLabel + ";");
+      usedLabels.insert(failLabel);
+      return {};
+  }
+  release(right);
+  return result;
+}
+
+auto CEmitter::emitLiteral(const AST::LiteralExprPtr& expr) -> Operand {
+  if (expr->constant != AST::LiteralExpr::NO_CONSTANT)
+    return constant(constants[expr->constant]);
+  return constant(Evaluator::toLoxObject(expr->literalVal));
+}
+
+auto CEmitter::emitVariable(const AST::VariableExprPtr& expr) -> Operand {
+  if (!emitVariableChecks(expr->slot, expr->varName)) return {};
+  const Variable& var = variables[expr->slot];
+  return {.code = "v_" + var.name, .kinds = var.kinds, .isVariable = true};
+}
+
+auto CEmitter::emitVariableChecks(uint32_t slot, const Types::Token& varName)
+    -> bool {
+  const Variable& var = variables[slot];
+  if (!var.declared) {
+    emitFail(varName, "Attempted to access an undefined variable.");
+    return false;
+  }
+  if (!sureDeclared[slot]) {
+    emitFailWhen("t_" + var.name + " == LOX_UNDEFINED", varName,
+                 "Attempted to access an undefined variable.");
+  }
+  if (var.kinds == 0) {
+    emitFail(varName, "Attempted to access an uninitialized variable.");
+    return false;
+  }
+  if (!sureValue[slot]) {
+    std::string isNil;
+    switch (var.kinds) {
+      case NUMBER:
+      case INT:
+      case BOOL: isNil = "n_" + var.name; break;
+      case STRING: isNil = "v_" + var.name + " == NULL"; break;
+      default: isNil = "v_" + var.name + ".type == LOX_NIL"; break;
+    }
+    emitFailWhen(isNil, varName,
+                 "Attempted to access an uninitialized variable.");
+  }
+  return true;
+}
+
+auto CEmitter::emitAssignment(const AST::AssignmentExprPtr& expr) -> Operand {
+  const Operand value = emitExpr(expr->right);
+  if (value.kinds == 0) return {};
+  const Variable& var = variables[expr->slot];
+  if (!var.declared) {
+    emitFail(expr->varName, "Can't assign to an undefined variable.");
+    return {};
+  }
+  const std::string& name = var.name;
+  if (!sureDeclared[expr->slot]) {
+    emitFailWhen("t_" + name + " == LOX_UNDEFINED", expr->varName,
+                 "Can't assign to an undefined variable.");
+  }
+  emitStore(expr->slot, value);
+
+  // The assignment's value is the variable's, which has to be one.
+  const auto kinds = storedKinds(var.declaredKinds,
+                                 static_cast<Kinds>(value.kinds & ~NIL));
+  if (kinds == 0) {
+    emitFail(expr->varName, "Attempted to access an uninitialized variable.");
+    return {};
+  }
+  if ((value.kinds & NIL) != 0) {
+    emitFailWhen(isSingle(var.kinds) ? (var.kinds == STRING
+                                            ? "v_" + name + " == NULL"
+                                            : "n_" + name)
+                                     : "v_" + name + ".type == LOX_NIL",
+                 expr->varName,
+                 "Attempted to access an uninitialized variable.");
+  }
+  return {.code = !isSingle(var.kinds) && isSingle(kinds)
+                      ? narrowed("v_" + name, kinds)
+                      : "v_" + name,
+          .kinds = kinds,
+          .isVariable = true};
+}
+
+auto CEmitter::emitLogical(const AST::LogicalExprPtr& expr) -> Operand {
+  const TokenType op = expr->op.getType();
+  const Kinds kinds = kindsOf(expr);
+  const Operand left = emitExpr(expr->left);
+  if (left.kinds == 0) return {};
+  if (op != TokenType::OR && op != TokenType::AND) {
+    // Not an operator the parser produces.
+    emitFail(expr->op, "Illegal logical operator: "
+                           + std::string(expr->op.getLexeme()));
+    return {};
+  }
+  // Which kinds of left operand are the result, and which go on to the
+  // right operand.
+  const bool isOr = op == TokenType::OR;
+  const Kinds shortCircuits = left.kinds & (isOr ? TRUTHY : FALSY);
+  const Kinds continues = left.kinds & (isOr ? FALSY : TRUTHY);
+  if (continues == 0) return left;
+  if (shortCircuits == 0) {
+    release(left);
+    return emitExpr(expr->right);
+  }
+
+  const Operand result = temporary(kinds, initialValue(kinds));
+  line(std::string("if (") + (isOr ? "" : "!") + truth(left) + ") {");
+  ++depth;
+  line(result.code + " = " + ownedAs(left, kinds) + ";");
+  --depth;
+  line("} else {");
+  ++depth;
+  release(left);
+  const Operand right = emitExpr(expr->right);
+  if (right.kinds != 0) line(result.code + " = " + ownedAs(right, kinds) + ";");
+  --depth;
+  line("}");
+  return {.code = result.code, .kinds = kinds, .owned = true};
+}
+
+auto CEmitter::emitConditional(const AST::ConditionalExprPtr& expr)
+    -> Operand {
+  const Kinds kinds = kindsOf(expr);
+  const Operand condition = emitExpr(expr->condition);
+  if (condition.kinds == 0) return {};
+  if ((condition.kinds & FALSY) == 0) {
+    release(condition);
+    return emitExpr(expr->thenBranch);
+  }
+  if ((condition.kinds & TRUTHY) == 0) {
+    release(condition);
+    return emitExpr(expr->elseBranch);
+  }
+
+  const Operand isTrue = temporary(BOOL, truth(condition));
+  release(condition);
+  Operand result;
+  if (kinds != 0) {
+    result = temporary(kinds, initialValue(kinds));
+    result.owned = true;
+  }
+  line("if (" + isTrue.code + ") {");
+  ++depth;
+  const Operand thenValue = emitExpr(expr->thenBranch);
+  if (thenValue.kinds != 0)
+    line(result.code + " = " + ownedAs(thenValue, kinds) + ";");
+  --depth;
+  line("} else {");
+  ++depth;
+  const Operand elseValue = emitExpr(expr->elseBranch);
+  if (elseValue.kinds != 0)
+    line(result.code + " = " + ownedAs(elseValue, kinds) + ";");
+  --depth;
+  line("}");
+  return result;
+}
+
+void CEmitter::emitStore(uint32_t slot, const Operand& stored) {
+  const Variable& var = variables[slot];
+  const std::string v = "v_" + var.name;
+  if (var.kinds == 0) return;  // it can only ever be nil
+  const Operand value = converted(var, stored);
+  if (!isSingle(var.kinds)) {
+    const Operand old = temporary(var.kinds, v);
+    line(v + " = " + ownedAs(value, var.kinds) + ";");
+    line("lox_value_release(" + old.code + ");");
+    return;
+  }
+
+  const auto setNil = [&]() {
+    if (var.kinds == STRING) {
+      line("if (" + v + " != NULL) lox_str_release(" + v + ");");
+      line(v + " = NULL;");
+    } else {
+      line("n_" + var.name + " = true;");
+    }
+  };
+  const auto setValue = [&](const Operand& nonNil) {
+    if (var.kinds == STRING) {
+      const Operand old = temporary(STRING, v);
+      line(v + " = " + ownedAs(nonNil, STRING) + ";");
+      line("if (" + old.code + " != NULL) lox_str_release(" + old.code + ");");
+    } else {
+      line(v + " = " + ownedAs(nonNil, var.kinds) + ";");
+      line("n_" + var.name + " = false;");
+    }
+  };
+  if (value.kinds == NIL) {
+    setNil();
+  } else if (value.kinds == var.kinds) {
+    setValue(value);
+  } else {
+    // A value or nil.
+    line("if (" + value.code + ".type == LOX_NIL) {");
+    ++depth;
+    setNil();
+    --depth;
+    line("} else {");
+    ++depth;
+    setValue(value);
+    --depth;
+    line("}");
+  }
+}
+
+// The value as storing it in the variable converts it: per the type the
+// variable is declared with at run time, if it is declared as more than one.
+auto CEmitter::converted(const Variable& var, const Operand& value)
+    -> Operand {
+  if (!((value.kinds & NUMBER) != 0 && (var.declaredKinds & INT) != 0)
+      && !((value.kinds & INT) != 0 && (var.declaredKinds & NUMBER) != 0))
+    return value;
+  const Kinds kinds = storedKinds(var.declaredKinds, value.kinds);
+  Operand result;
+  if (value.kinds == NUMBER && var.declaredKinds == INT) {
+    result = temporary(INT, "lox_truncate(" + value.code + ")");
+  } else if (value.kinds == INT && var.declaredKinds == NUMBER) {
+    result = temporary(NUMBER, "(double)" + value.code);
+  } else {
+    const std::string type = isSingle(var.declaredKinds)
+                                 ? std::to_string(tagOf(var.declaredKinds))
+                                 : "t_" + var.name;
+    const std::string code
+        = "lox_convert(" + type + ", " + boxed(value) + ")";
+    result = temporary(kinds, isSingle(kinds) ? narrowed(code, kinds) : code);
+  }
+  result.owned = value.owned;
+  return result;
+}
+
+// ========= //
+// Operands
+// ========= //
+auto CEmitter::temporary(Kinds kinds, const std::string& code) -> Operand {
+  Operand result{.code = "t" + std::to_string(++numTemporaries),
+                 .kinds = kinds};
+  line(cType(kinds) + " " + result.code + " = " + code + ";");
+  return result;
+}
+
+auto CEmitter::snapshot(const Operand& operand) -> Operand {
+  if (operand.kinds == NUMBER || operand.kinds == INT
+      || operand.kinds == BOOL)
+    return temporary(operand.kinds, operand.code);
+  Operand copy = temporary(operand.kinds, ownedAs(operand, operand.kinds));
+  copy.owned = true;
+  return copy;
+}
+
+auto CEmitter::ownedAs(const Operand& operand, Kinds kinds) -> std::string {
+  std::string code;
+  if (!isSingle(kinds) || kinds == NIL) {
+    code = boxed(operand);
+  } else if (operand.kinds == kinds) {
+    code = operand.code;
+  } else {
+    // Known at run time to be of the one kind.
+    code = narrowed(operand.code, kinds);
+  }
+  if (operand.owned || (operand.kinds & STRING) == 0 || (kinds & STRING) == 0)
+    return code;
+  return (isSingle(kinds) ? "lox_str_retain(" : "lox_value_retain(") + code
+         + ")";
+}
+
+void CEmitter::release(const Operand& operand) {
+  if (!operand.owned || (operand.kinds & STRING) == 0) return;
+  if (operand.kinds == STRING)
+    line("lox_str_release(" + operand.code + ");");
+  else
+    line("lox_value_release(" + operand.code + ");");
+}
+
+auto CEmitter::boxed(const Operand& operand) -> std::string {
+  switch (operand.kinds) {
+    case STRING: return "lox_string(" + operand.code + ")";
+    case NUMBER: return "lox_number(" + operand.code + ")";
+    case INT: return "lox_int(" + operand.code + ")";
+    case BOOL: return "lox_boolean(" + operand.code + ")";
+    case NIL: return "lox_nil()";
+    default: return operand.code;
+  }
+}
+
+auto CEmitter::truth(const Operand& operand) -> std::string {
+  switch (operand.kinds) {
+    case STRING:
+    case NUMBER:
+    case INT: return "true";
+    case BOOL: return operand.code;
+    case NIL: return "false";
+    default: return "lox_is_true(" + operand.code + ")";
+  }
+}
+
+auto CEmitter::cType(Kinds kinds) -> std::string {
+  switch (kinds) {
+    case STRING: return "lox_str*";
+    case NUMBER: return "double";
+    case INT: return "int64_t";
+    case BOOL: return "bool";
+    default: return "lox_value";
+  }
+}
+
+auto CEmitter::constant(const Evaluator::LoxObject& value) -> Operand {
+  switch (value.index()) {
+    case 0:  // string
+      return {.code = stringConstant(std::string(value.asString())),
+              .kinds = STRING};
+    case 1:  // double
+      return {.code = cNumberLiteral(value.asNumber()),
+              .kinds = NUMBER};
+    case 2:  // bool
+      return {.code = value.asBool() ? "true" : "false", .kinds = BOOL};
+    case 3:  // nullptr
+      return {.kinds = NIL};
+    case 4:  // int
+      return {.code = cIntLiteral(value.asInt()), .kinds = INT};
+    default:
+      static_assert(Evaluator::LoxObject::NUM_TYPES == 5,
+                    "Looks like you forgot to update the cases in "
+                    "CEmitter::constant()!");
+      return {};
+  }
+}
+
+auto CEmitter::stringConstant(const std::string& chars) -> std::string {
+  auto [iter, added] = stringIndices.try_emplace(chars, strings.size());
+  if (added) strings.push_back(chars);
+  return "lox_k[" + std::to_string(iter->second) + "]";
+}
+
+// ====== //
+// Output
+// ====== //
+void CEmitter::line(const std::string& code) {
+  body << std::string(static_cast<size_t>(depth) * 2, ' ') << code << '\n';
+}
+
+void CEmitter::emitFail(const Types::Token& token, const std::string& message) {
+  line("lox_error(" + site(token) + ", " + cStringLiteral(message) + ");");
+  line("goto " + failLabel + ";");
+  usedLabels.insert(failLabel);
+}
+
+void CEmitter::emitFailIf(const std::string& failed) {
+  line("if (LOX_UNLIKELY(" + failed + ")) goto " + failLabel + ";");
+  usedLabels.insert(failLabel);
+}
+
+void CEmitter::emitFailWhen(const std::string& condition,
+                            const Types::Token& token,
+                            const std::string& message) {
+  line("if (LOX_UNLIKELY(" + condition + ")) {");
+  ++depth;
+  emitFail(token, message);
+  --depth;
+  line("}");
+}
+
+auto CEmitter::site(const Types::Token& token, bool withLexeme)
+    -> std::string {
+  const ErrorsAndDebug::SourceLocation location
+      = lines.locate(token.getOffset());
+  std::string where = "[Line " + std::to_string(location.line) + ":"
+                      + std::to_string(location.column) + "] Error: ";
+  if (withLexeme) where += std::string(token.getLexeme()) + ": ";
+  auto [iter, added] = siteIndices.try_emplace(where, sites.size());
+  if (added) sites.push_back(where);
+  return "lox_sites[" + std::to_string(iter->second) + "]";
+}
+
+auto CEmitter::newLabel(const char* prefix) -> std::string {
+  return prefix + std::to_string(++numLabels);
+}
+
+}  // namespace cpplox::AOT
@@ -0,0 +1,186 @@
+#ifndef CPPLOX_AOT_CEMITTER_H
+#define CPPLOX_AOT_CEMITTER_H
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "LineIndex.h"
+#include "NodeTypes.h"
+#include "Objects.h"
+#include "Token.h"
+
+namespace cpplox::AOT {
+
+// Compiles a program ahead of time into a self-contained C file, for
+// `langc --emit-c`: the C_RUNTIME followed by a main() that does what the
+// program does, to be built with the system's C compiler.
+//
+// The C program prints what the interpreter would, reads its input the same
+// way, and reports the same runtime errors, recovering from them at the
+// same statements. It is fast where the interpreter has to check: before
+// emitting any code, the kinds of value (string, real, bool, nil, int) each
+// variable can ever hold are worked out. A variable that only ever holds
+// reals is a C double, one that only holds ints an int64_t, one that only
+// holds strings a lox_str*, and only the rest are tagged lox_values.
+// Operators on numbers and strings are then plain C, and only operands that
+// could be anything go through the runtime's generic operators. Variables that are sure to hold a value by
+// the time a statement runs (declared, with an initializer that can't
+// fail, earlier on in the program) are used without checking that.
+//
+// Expressions become C statements assigning temporaries, so that a runtime
+// error can jump (goto) to the statement list that recovers from it.
+class CEmitter {
+ public:
+  // The program has to have been through the ConstantFolder and the
+  // Resolver. `lines` locates its tokens for the error messages.
+  CEmitter(const Evaluator::ConstantPool& constants,
+           const ErrorsAndDebug::LineIndex& lines);
+
+  void emit(const AST::Program& program, std::ostream& out);
+
+  // A set of the kinds of value something can be: 1 << LoxObject::index()
+  // of each. Empty for an expression that always fails.
+  using Kinds = uint8_t;
+
+ private:
+  // A C expression without side effects holding the value of an
+  // expression, in the representation its kinds call for.
+  struct Operand {
+    std::string code;
+    Kinds kinds = 0;
+    // A string reference the code that uses the operand has to release.
+    bool owned = false;
+    // Names a variable, which later code may assign to.
+    bool isVariable = false;
+  };
+
+  struct Variable {
+    std::string name;
+    bool declared = false;
+    // The kinds of value other than nil the variable can hold.
+    Kinds kinds = 0;
+    // What it can be declared as, for read().
+    Kinds declaredKinds = 0;
+    // Whether it can be assigned nil after its declaration.
+    bool assignedNil = false;
+    bool read = false;
+  };
+
+  // ============== //
+  // Kind inference
+  // ============== //
+  void inferVariables(const AST::Program& program);
+  auto inferStmt(const AST::StmtPtrVariant& stmt) -> bool;
+  auto inferDeclaration(uint32_t slot,
+                        const std::optional<AST::ExprPtrVariant>& initializer,
+                        Kinds declaredKind) -> bool;
+  auto inferExpr(const AST::ExprPtrVariant& expr) -> bool;
+  auto addKinds(uint32_t slot, Kinds kinds) -> bool;
+  [[nodiscard]] auto kindsOf(const AST::ExprPtrVariant& expr) const -> Kinds;
+  [[nodiscard]] auto readKinds(const Variable& variable) const -> Kinds;
+  auto variable(uint32_t slot) -> Variable&;
+
+  // ============ //
+  // Statements
+  // ============ //
+  void emitStmts(AST::StmtList stmts, bool topLevel);
+  void emitStmt(const AST::StmtPtrVariant& stmt);
+  void emitDeclaration(const Types::Token& varName, uint32_t slot,
+                       const std::optional<AST::ExprPtrVariant>& initializer,
+                       int typeTag);
+  void emitWrite(const AST::WriteStmtPtr& stmt);
+  void emitRead(const AST::ReadStmtPtr& stmt);
+  void emitIf(const AST::IfStmtPtr& stmt);
+  void emitWhile(const AST::WhileStmtPtr& stmt);
+  void emitFor(const AST::ForStmtPtr& stmt);
+  void emitBreak(const AST::BreakStmtPtr& stmt);
+  // What a statement at the top of the program does for the variables that
+  // are sure to hold a value from then on.
+  void noteSureVariables(const AST::StmtPtrVariant& stmt);
+
+  // ============ //
+  // Expressions
+  // ============ //
+  auto emitExpr(const AST::ExprPtrVariant& expr) -> Operand;
+  auto emitBinary(const AST::BinaryExprPtr& expr) -> Operand;
+  // A binary operator on two operands that are each a real or an int.
+  auto emitNumeric(const AST::BinaryExprPtr& expr, const Operand& left,
+                   const Operand& right) -> Operand;
+  auto emitUnary(const AST::UnaryExprPtr& expr) -> Operand;
+  auto emitLiteral(const AST::LiteralExprPtr& expr) -> Operand;
+  auto emitVariable(const AST::VariableExprPtr& expr) -> Operand;
+  auto emitAssignment(const AST::AssignmentExprPtr& expr) -> Operand;
+  auto emitLogical(const AST::LogicalExprPtr& expr) -> Operand;
+  auto emitConditional(const AST::ConditionalExprPtr& expr) -> Operand;
+  // Emits the checks reading a variable takes, unless it is sure to hold a
+  // value; false if reading it always fails.
+  auto emitVariableChecks(uint32_t slot, const Types::Token& varName) -> bool;
+  void emitStore(uint32_t slot, const Operand& stored);
+  // The value converted to the type of the variable it is stored in.
+  auto converted(const Variable& var, const Operand& value) -> Operand;
+
+  // ========= //
+  // Operands
+  // ========= //
+  auto temporary(Kinds kinds, const std::string& code) -> Operand;
+  // The operand as a value that stays put while later code runs.
+  auto snapshot(const Operand& operand) -> Operand;
+  // The operand in the representation of `kinds`, which it has to fit in,
+  // as a reference of its own.
+  auto ownedAs(const Operand& operand, Kinds kinds) -> std::string;
+  void release(const Operand& operand);
+  [[nodiscard]] static auto boxed(const Operand& operand) -> std::string;
+  [[nodiscard]] static auto truth(const Operand& operand) -> std::string;
+  [[nodiscard]] static auto cType(Kinds kinds) -> std::string;
+  auto constant(const Evaluator::LoxObject& value) -> Operand;
+  auto stringConstant(const std::string& chars) -> std::string;
+
+  // ====== //
+  // Output
+  // ====== //
+  void line(const std::string& code);
+  // Reports a runtime error at `token` and jumps to the enclosing recovery.
+  void emitFail(const Types::Token& token, const std::string& message);
+  // Jumps to the enclosing recovery if `failed` (which reported the error).
+  void emitFailIf(const std::string& failed);
+  // Reports a runtime error at `token` if `condition`, and jumps.
+  void emitFailWhen(const std::string& condition, const Types::Token& token,
+                    const std::string& message);
+  auto site(const Types::Token& token, bool withLexeme = true) -> std::string;
+  auto newLabel(const char* prefix) -> std::string;
+
+  const Evaluator::ConstantPool& constants;
+  const ErrorsAndDebug::LineIndex& lines;
+
+  std::vector<Variable> variables;
+  // Variables sure to be declared, and to hold a value, at the statement
+  // being emitted.
+  std::vector<bool> sureDeclared;
+  std::vector<bool> sureValue;
+
+  std::ostringstream body;
+  int depth = 1;
+  size_t numTemporaries = 0;
+  size_t numLabels = 0;
+  // Where a runtime error goes: the recovery of the statement list
+  // statement it is in.
+  std::string failLabel;
+  std::vector<std::string> breakLabels;
+  std::set<std::string> usedLabels;
+  // Error message prefixes, and the string constants' contents, by index.
+  std::vector<std::string> sites;
+  std::map<std::string, size_t> siteIndices;
+  std::vector<std::string> strings;
+  std::map<std::string, size_t> stringIndices;
+};
+
+}  // namespace cpplox::AOT
+
+#endif  // CPPLOX_AOT_CEMITTER_H
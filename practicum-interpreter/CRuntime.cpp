@@ -0,0 +1,654 @@
+#include "CRuntime.h"
+
+namespace cpplox::AOT {
+
+const std::string_view C_RUNTIME = R"runtime(
+#include <ctype.h>
+#include <float.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__)
+#define LOX_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#else
+#define LOX_UNLIKELY(x) (x)
+#endif
+
+/* ========================================================================
+ * Values: the interpreter's LoxObject. Types are numbered like its index(),
+ * and so are the types variables are declared with; a variable that hasn't
+ * been declared yet has the type LOX_UNDEFINED.
+ * ======================================================================== */
+enum { LOX_STRING = 0, LOX_NUMBER = 1, LOX_BOOL = 2, LOX_NIL = 3, LOX_INT = 4 };
+enum { LOX_UNDEFINED = 255 };
+
+/* Strings are immutable and reference counted. */
+typedef struct lox_str {
+  size_t refs;
+  size_t length;
+  char chars[];
+} lox_str;
+
+typedef struct lox_value {
+  uint8_t type;
+  union {
+    lox_str* string;
+    double number;
+    bool boolean;
+    int64_t integer;
+  } as;
+} lox_value;
+
+static inline void* lox_alloc(size_t size) {
+  void* memory = malloc(size);
+  if (memory == NULL) {
+    fflush(stdout);
+    fputs("Out of memory\n", stderr);
+    exit(70);
+  }
+  return memory;
+}
+
+static inline lox_str* lox_str_alloc(size_t length) {
+  lox_str* str = (lox_str*)lox_alloc(sizeof(lox_str) + length + 1);
+  str->refs = 1;
+  str->length = length;
+  str->chars[length] = '\0';
+  return str;
+}
+
+static inline lox_str* lox_str_new(const char* chars, size_t length) {
+  lox_str* str = lox_str_alloc(length);
+  memcpy(str->chars, chars, length);
+  return str;
+}
+
+/* The program's literals, which are never freed. */
+static inline lox_str* lox_str_constant(const char* chars, size_t length) {
+  lox_str* str = lox_str_new(chars, length);
+  str->refs = SIZE_MAX / 2;
+  return str;
+}
+
+static inline lox_str* lox_str_retain(lox_str* str) {
+  ++str->refs;
+  return str;
+}
+
+static inline void lox_str_release(lox_str* str) {
+  if (--str->refs == 0) free(str);
+}
+
+static inline lox_str* lox_str_concat(const lox_str* left,
+                                      const lox_str* right) {
+  lox_str* str = lox_str_alloc(left->length + right->length);
+  memcpy(str->chars, left->chars, left->length);
+  memcpy(str->chars + left->length, right->chars, right->length);
+  return str;
+}
+
+static inline bool lox_str_equal(const lox_str* left, const lox_str* right) {
+  return left == right
+         || (left->length == right->length
+             && memcmp(left->chars, right->chars, left->length) == 0);
+}
+
+static inline lox_value lox_string(lox_str* str) {
+  lox_value value;
+  value.type = LOX_STRING;
+  value.as.string = str;
+  return value;
+}
+
+static inline lox_value lox_number(double number) {
+  lox_value value;
+  value.type = LOX_NUMBER;
+  value.as.number = number;
+  return value;
+}
+
+static inline lox_value lox_int(int64_t integer) {
+  lox_value value;
+  value.type = LOX_INT;
+  value.as.integer = integer;
+  return value;
+}
+
+static inline lox_value lox_boolean(bool boolean) {
+  lox_value value;
+  value.type = LOX_BOOL;
+  value.as.boolean = boolean;
+  return value;
+}
+
+static inline lox_value lox_nil(void) {
+  lox_value value;
+  value.type = LOX_NIL;
+  value.as.number = 0;
+  return value;
+}
+
+/* A number that can't be written as a C literal: an infinity or a NaN. */
+static inline double lox_bits(uint64_t bits) {
+  double number;
+  memcpy(&number, &bits, sizeof number);
+  return number;
+}
+
+/* The interpreter's int operations: wrapping around on overflow, and
+ * dividing only by a nonzero divisor. */
+static inline int64_t lox_int_add(int64_t left, int64_t right) {
+  return (int64_t)((uint64_t)left + (uint64_t)right);
+}
+
+static inline int64_t lox_int_subtract(int64_t left, int64_t right) {
+  return (int64_t)((uint64_t)left - (uint64_t)right);
+}
+
+static inline int64_t lox_int_multiply(int64_t left, int64_t right) {
+  return (int64_t)((uint64_t)left * (uint64_t)right);
+}
+
+static inline int64_t lox_int_negate(int64_t right) {
+  return (int64_t)(0 - (uint64_t)right);
+}
+
+static inline int64_t lox_int_divide(int64_t left, int64_t right) {
+  return right == -1 ? lox_int_negate(left) : left / right;
+}
+
+static inline int64_t lox_int_modulo(int64_t left, int64_t right) {
+  return right == -1 ? 0 : left % right;
+}
+
+/* truncateToInt(): toward zero, saturating, and 0 for a NaN. */
+static inline int64_t lox_truncate(double real) {
+  if (real != real) return 0;
+  if (real >= 9223372036854775808.0) return INT64_MAX;
+  if (real < -9223372036854775808.0) return INT64_MIN;
+  return (int64_t)real;
+}
+
+/* '%' on reals, for a divisor that doesn't truncate to 0. */
+static inline double lox_real_modulo(double left, double right) {
+  return (double)lox_int_modulo(lox_truncate(left), lox_truncate(right));
+}
+
+static inline double lox_real_of(lox_value value) {
+  return value.type == LOX_INT ? (double)value.as.integer : value.as.number;
+}
+
+/* Environment::converted(): the value as a variable declared as `type`
+ * stores it. */
+static inline lox_value lox_convert(uint8_t type, lox_value value) {
+  if (type == LOX_INT && value.type == LOX_NUMBER)
+    return lox_int(lox_truncate(value.as.number));
+  if (type == LOX_NUMBER && value.type == LOX_INT)
+    return lox_number((double)value.as.integer);
+  return value;
+}
+
+static inline lox_value lox_value_retain(lox_value value) {
+  if (value.type == LOX_STRING) ++value.as.string->refs;
+  return value;
+}
+
+static inline void lox_value_release(lox_value value) {
+  if (value.type == LOX_STRING) lox_str_release(value.as.string);
+}
+
+static inline bool lox_is_true(lox_value value) {
+  if (value.type == LOX_NIL) return false;
+  if (value.type == LOX_BOOL) return value.as.boolean;
+  return true;
+}
+
+static inline bool lox_equal(lox_value left, lox_value right) {
+  if (left.type != right.type) {
+    /* An int and a real are compared as reals. */
+    if ((left.type == LOX_INT && right.type == LOX_NUMBER)
+        || (left.type == LOX_NUMBER && right.type == LOX_INT))
+      return lox_real_of(left) == lox_real_of(right);
+    return false;
+  }
+  switch (left.type) {
+    case LOX_STRING: return lox_str_equal(left.as.string, right.as.string);
+    case LOX_NUMBER: return left.as.number == right.as.number;
+    case LOX_INT: return left.as.integer == right.as.integer;
+    case LOX_BOOL: return left.as.boolean == right.as.boolean;
+    default: return true;
+  }
+}
+
+/* getObjectString(): std::to_string()'s "%f", less its ".000000", or else
+ * less its trailing zeros. Returns the length written to `buffer`. */
+enum { LOX_NUMBER_BUFFER = 512 };
+
+static inline size_t lox_format_number(double number, char* buffer) {
+  if (number != 0 && number > -1e15 && number < 1e15
+      && (double)(int64_t)number == number) {
+    /* An integer: what is left of "%f" is its digits. */
+    int64_t integer = (int64_t)number;
+    uint64_t magnitude = integer < 0 ? -(uint64_t)integer : (uint64_t)integer;
+    char digits[24];
+    size_t count = 0;
+    do {
+      digits[count++] = (char)('0' + magnitude % 10);
+      magnitude /= 10;
+    } while (magnitude != 0);
+    size_t length = 0;
+    if (integer < 0) buffer[length++] = '-';
+    while (count != 0) buffer[length++] = digits[--count];
+    buffer[length] = '\0';
+    return length;
+  }
+  int length = snprintf(buffer, LOX_NUMBER_BUFFER, "%f", number);
+  const char* point = strstr(buffer, ".000000");
+  if (point != NULL) length = (int)(point - buffer);
+  else
+    while (length > 0 && buffer[length - 1] == '0') --length;
+  buffer[length] = '\0';
+  return (size_t)length;
+}
+
+static inline size_t lox_format_int(int64_t integer, char* buffer) {
+  return (size_t)snprintf(buffer, LOX_NUMBER_BUFFER, "%" PRId64, integer);
+}
+
+/* A new string holding getObjectString(value). */
+static inline lox_str* lox_str_of(lox_value value) {
+  char buffer[LOX_NUMBER_BUFFER];
+  switch (value.type) {
+    case LOX_STRING: return lox_str_retain(value.as.string);
+    case LOX_NUMBER:
+      return lox_str_new(buffer, lox_format_number(value.as.number, buffer));
+    case LOX_INT:
+      return lox_str_new(buffer, lox_format_int(value.as.integer, buffer));
+    case LOX_BOOL:
+      return value.as.boolean ? lox_str_new("true", 4)
+                              : lox_str_new("false", 5);
+    default: return lox_str_new("nil", 3);
+  }
+}
+
+/* ========================================================================
+ * write(): each value and a space, then a new line. stdout stays buffered
+ * and is only flushed ahead of anything written to stderr.
+ * ======================================================================== */
+static inline void lox_write_chars(const char* chars, size_t length) {
+  fwrite(chars, 1, length, stdout);
+  putchar(' ');
+}
+
+static inline void lox_write_number(double number) {
+  char buffer[LOX_NUMBER_BUFFER];
+  lox_write_chars(buffer, lox_format_number(number, buffer));
+}
+
+static inline void lox_write_int(int64_t integer) {
+  char buffer[LOX_NUMBER_BUFFER];
+  lox_write_chars(buffer, lox_format_int(integer, buffer));
+}
+
+static inline void lox_write_str(const lox_str* str) {
+  lox_write_chars(str->chars, str->length);
+}
+
+static inline void lox_write_bool(bool boolean) {
+  if (boolean) lox_write_chars("true", 4);
+  else lox_write_chars("false", 5);
+}
+
+static inline void lox_write_nil(void) { lox_write_chars("nil", 3); }
+
+static inline void lox_write_value(lox_value value) {
+  switch (value.type) {
+    case LOX_STRING: lox_write_str(value.as.string); break;
+    case LOX_NUMBER: lox_write_number(value.as.number); break;
+    case LOX_INT: lox_write_int(value.as.integer); break;
+    case LOX_BOOL: lox_write_bool(value.as.boolean); break;
+    default: lox_write_nil(); break;
+  }
+}
+
+static inline void lox_write_end(void) { putchar('\n'); }
+
+/* ========================================================================
+ * Runtime errors. Like the interpreter's ErrorReporter, they are collected
+ * and printed once the program is done; `where` is the "[Line l:c] Error:
+ * lexeme: " the interpreter would start the message with.
+ * ======================================================================== */
+typedef struct lox_buffer {
+  char* chars;
+  size_t length;
+  size_t capacity;
+} lox_buffer;
+
+static inline void lox_buffer_append(lox_buffer* buffer, const char* chars,
+                                     size_t length) {
+  if (buffer->length + length + 1 > buffer->capacity) {
+    size_t capacity = buffer->capacity * 2 + length + 64;
+    char* grown = (char*)lox_alloc(capacity);
+    if (buffer->length != 0) memcpy(grown, buffer->chars, buffer->length);
+    free(buffer->chars);
+    buffer->chars = grown;
+    buffer->capacity = capacity;
+  }
+  memcpy(buffer->chars + buffer->length, chars, length);
+  buffer->length += length;
+  buffer->chars[buffer->length] = '\0';
+}
+
+static inline void lox_buffer_append_value(lox_buffer* buffer,
+                                           lox_value value) {
+  lox_str* str = lox_str_of(value);
+  lox_buffer_append(buffer, str->chars, str->length);
+  lox_str_release(str);
+}
+
+static lox_buffer lox_errors;
+static int lox_num_runtime_errors;
+
+static inline void lox_report(const char* where, const lox_buffer* message) {
+  lox_buffer_append(&lox_errors, where, strlen(where));
+  lox_buffer_append(&lox_errors, message->chars, message->length);
+  lox_buffer_append(&lox_errors, "\n", 1);
+}
+
+static inline void lox_error(const char* where, const char* message) {
+  lox_buffer buffer = {NULL, 0, 0};
+  lox_buffer_append(&buffer, message, strlen(message));
+  lox_report(where, &buffer);
+  free(buffer.chars);
+}
+
+static inline void lox_error_value(const char* where, const char* message,
+                                   lox_value value) {
+  lox_buffer buffer = {NULL, 0, 0};
+  lox_buffer_append(&buffer, message, strlen(message));
+  lox_buffer_append_value(&buffer, value);
+  lox_report(where, &buffer);
+  free(buffer.chars);
+}
+
+/* A statement in a statement list failed: Backend::recoverFromRuntimeError.
+ * Returns whether the list carries on with its next statement. */
+static inline bool lox_recover(void) {
+  if (++lox_num_runtime_errors > 20) {
+    fflush(stdout);
+    fputs("Too many errors occurred. Exiting evaluation.\n", stderr);
+    return false;
+  }
+  return true;
+}
+
+/* Prints the errors; returns the status main() exits with. */
+static inline int lox_finish(int status) {
+  fflush(stdout);
+  if (lox_errors.length != 0) {
+    fwrite(lox_errors.chars, 1, lox_errors.length, stderr);
+    fflush(stderr);
+  }
+  return status;
+}
+
+/* ========================================================================
+ * Operators, for operands whose types aren't known when compiling: the
+ * interpreter's applyBinary() and applyUnary(). The result of a successful
+ * operation is a new reference.
+ * ======================================================================== */
+enum {
+  LOX_ADD,
+  LOX_SUBTRACT,
+  LOX_MULTIPLY,
+  LOX_DIVIDE,
+  LOX_MODULO,
+  LOX_LESS,
+  LOX_LESS_EQUAL,
+  LOX_GREATER,
+  LOX_GREATER_EQUAL
+};
+
+static inline bool lox_is_numeric(lox_value value) {
+  return value.type == LOX_NUMBER || value.type == LOX_INT;
+}
+
+static inline bool lox_check_numeric(lox_value value, const char* where) {
+  if (LOX_UNLIKELY(!lox_is_numeric(value))) {
+    lox_error_value(where,
+                    "Attempted to perform arithmetic operation on "
+                    "non-numeric literal ",
+                    value);
+    return false;
+  }
+  return true;
+}
+
+static inline bool lox_binary(int op, lox_value left, lox_value right,
+                              lox_value* result, const char* where) {
+  if (op == LOX_ADD) {
+    if (left.type == LOX_NUMBER && right.type == LOX_NUMBER) {
+      *result = lox_number(left.as.number + right.as.number);
+      return true;
+    }
+    if (left.type == LOX_STRING || right.type == LOX_STRING) {
+      lox_str* lhsStr = lox_str_of(left);
+      lox_str* rhsStr = lox_str_of(right);
+      *result = lox_string(lox_str_concat(lhsStr, rhsStr));
+      lox_str_release(lhsStr);
+      lox_str_release(rhsStr);
+      return true;
+    }
+    if (!lox_is_numeric(left) || !lox_is_numeric(right)) {
+      lox_buffer buffer = {NULL, 0, 0};
+      static const char message[]
+          = "Operands to 'plus' must be numbers or strings; This is "
+            "invalid: ";
+      lox_buffer_append(&buffer, message, sizeof message - 1);
+      lox_buffer_append_value(&buffer, left);
+      lox_buffer_append(&buffer, " + ", 3);
+      lox_buffer_append_value(&buffer, right);
+      lox_report(where, &buffer);
+      free(buffer.chars);
+      return false;
+    }
+  } else if (op == LOX_DIVIDE) {
+    /* The denominator is checked first. */
+    if (!lox_check_numeric(right, where)) return false;
+    if (LOX_UNLIKELY(right.type == LOX_INT ? right.as.integer == 0
+                                           : right.as.number == 0.0)) {
+      lox_error(where, "Division by zero is illegal");
+      return false;
+    }
+  } else if (op == LOX_MODULO) {
+    if (!lox_check_numeric(left, where) || !lox_check_numeric(right, where))
+      return false;
+    const int64_t lhs = left.type == LOX_INT ? left.as.integer
+                                             : lox_truncate(left.as.number);
+    const int64_t rhs = right.type == LOX_INT ? right.as.integer
+                                              : lox_truncate(right.as.number);
+    if (LOX_UNLIKELY(rhs == 0)) {
+      lox_error(where, "Division by zero is illegal");
+      return false;
+    }
+    if (left.type == LOX_INT && right.type == LOX_INT)
+      *result = lox_int(lox_int_modulo(lhs, rhs));
+    else
+      *result = lox_number((double)lox_int_modulo(lhs, rhs));
+    return true;
+  }
+  if (!lox_check_numeric(left, where) || !lox_check_numeric(right, where))
+    return false;
+  if (left.type == LOX_INT && right.type == LOX_INT) {
+    const int64_t lhs = left.as.integer;
+    const int64_t rhs = right.as.integer;
+    switch (op) {
+      case LOX_ADD: *result = lox_int(lox_int_add(lhs, rhs)); break;
+      case LOX_SUBTRACT: *result = lox_int(lox_int_subtract(lhs, rhs)); break;
+      case LOX_MULTIPLY: *result = lox_int(lox_int_multiply(lhs, rhs)); break;
+      case LOX_DIVIDE: *result = lox_int(lox_int_divide(lhs, rhs)); break;
+      case LOX_LESS: *result = lox_boolean(lhs < rhs); break;
+      case LOX_LESS_EQUAL: *result = lox_boolean(lhs <= rhs); break;
+      case LOX_GREATER: *result = lox_boolean(lhs > rhs); break;
+      default: *result = lox_boolean(lhs >= rhs); break;
+    }
+    return true;
+  }
+  const double lhs = lox_real_of(left);
+  const double rhs = lox_real_of(right);
+  switch (op) {
+    case LOX_ADD: *result = lox_number(lhs + rhs); break;
+    case LOX_SUBTRACT: *result = lox_number(lhs - rhs); break;
+    case LOX_MULTIPLY: *result = lox_number(lhs * rhs); break;
+    case LOX_DIVIDE: *result = lox_number(lhs / rhs); break;
+    case LOX_LESS: *result = lox_boolean(lhs < rhs); break;
+    case LOX_LESS_EQUAL: *result = lox_boolean(lhs <= rhs); break;
+    case LOX_GREATER: *result = lox_boolean(lhs > rhs); break;
+    default: *result = lox_boolean(lhs >= rhs); break;
+  }
+  return true;
+}
+
+static inline bool lox_negate(lox_value right, lox_value* result,
+                              const char* where) {
+  if (!lox_check_numeric(right, where)) return false;
+  if (right.type == LOX_INT)
+    *result = lox_int(lox_int_negate(right.as.integer));
+  else
+    *result = lox_number(-right.as.number);
+  return true;
+}
+
+/* ========================================================================
+ * read(): std::cin's >> for strings, doubles and int64_ts, including that
+ * every read after a failed one fails too.
+ * ======================================================================== */
+static bool lox_input_failed;
+
+static inline int lox_skip_space(void) {
+  int c;
+  do c = getchar();
+  while (c != EOF && isspace(c));
+  return c;
+}
+
+static inline lox_str* lox_read_word(void) {
+  lox_buffer buffer = {NULL, 0, 0};
+  int c = lox_input_failed ? EOF : lox_skip_space();
+  if (c == EOF) {
+    lox_input_failed = true;
+    return lox_str_new("", 0);
+  }
+  for (; c != EOF && !isspace(c); c = getchar()) {
+    const char ch = (char)c;
+    lox_buffer_append(&buffer, &ch, 1);
+  }
+  if (c != EOF) ungetc(c, stdin);
+  lox_str* str = lox_str_new(buffer.chars, buffer.length);
+  free(buffer.chars);
+  return str;
+}
+
+/* Takes the longest prefix that looks like a number, as libstdc++ does, and
+ * fails (reading 0) if it isn't one. */
+static inline double lox_read_number(void) {
+  char text[LOX_NUMBER_BUFFER];
+  size_t length = 0;
+  bool mantissa = false;
+  bool exponent = false;
+  bool exponentDigits = false;
+  bool point = false;
+  int c = lox_input_failed ? EOF : lox_skip_space();
+  if (c == '+' || c == '-') {
+    text[length++] = (char)c;
+    c = getchar();
+  }
+  for (; c != EOF && length + 1 < sizeof text; c = getchar()) {
+    if (isdigit(c)) {
+      if (exponent) exponentDigits = true;
+      else mantissa = true;
+    } else if (c == '.' && !point && !exponent) {
+      point = true;
+    } else if ((c == 'e' || c == 'E') && mantissa && !exponent) {
+      exponent = true;
+    } else if ((c == '+' || c == '-') && exponent && !exponentDigits
+               && (text[length - 1] == 'e' || text[length - 1] == 'E')) {
+      /* the exponent's sign */
+    } else {
+      break;
+    }
+    text[length++] = (char)c;
+  }
+  if (c != EOF) ungetc(c, stdin);
+  text[length] = '\0';
+  if (!mantissa || (exponent && !exponentDigits)) {
+    lox_input_failed = true;
+    return 0;
+  }
+  double number = strtod(text, NULL);
+  if (LOX_UNLIKELY(isinf(number))) {
+    lox_input_failed = true;
+    return number > 0 ? DBL_MAX : -DBL_MAX;
+  }
+  return number;
+}
+
+/* An optional sign and decimal digits; a number out of range reads as the
+ * nearest one there is, and fails. */
+static inline int64_t lox_read_int(void) {
+  int c = lox_input_failed ? EOF : lox_skip_space();
+  bool negative = false;
+  if (c == '+' || c == '-') {
+    negative = c == '-';
+    c = getchar();
+  }
+  uint64_t magnitude = 0;
+  bool digits = false;
+  bool overflow = false;
+  const uint64_t limit = negative ? (uint64_t)INT64_MAX + 1 : INT64_MAX;
+  for (; c != EOF && isdigit(c); c = getchar()) {
+    digits = true;
+    const uint64_t digit = (uint64_t)(c - '0');
+    if (magnitude > (limit - digit) / 10) overflow = true;
+    else magnitude = magnitude * 10 + digit;
+  }
+  if (c != EOF) ungetc(c, stdin);
+  if (!digits) {
+    lox_input_failed = true;
+    return 0;
+  }
+  if (LOX_UNLIKELY(overflow)) {
+    lox_input_failed = true;
+    return negative ? INT64_MIN : INT64_MAX;
+  }
+  return negative ? (int64_t)(0 - magnitude) : (int64_t)magnitude;
+}
+
+/* read() of a variable that hasn't been declared. */
+static inline void lox_read_undefined(const char* where) {
+  lox_error(where, "Attempted to access an undefined variable.");
+}
+
+/* read() of a variable of more than one kind, per its declared type. */
+static inline bool lox_read(lox_value* variable, uint8_t type,
+                            const char* where) {
+  lox_value input;
+  switch (type) {
+    case LOX_UNDEFINED: lox_read_undefined(where); return false;
+    case LOX_INT: input = lox_int(lox_read_int()); break;
+    case LOX_NUMBER: input = lox_number(lox_read_number()); break;
+    default: input = lox_string(lox_read_word()); break;
+  }
+  lox_value_release(*variable);
+  *variable = input;
+  return true;
+}
+)runtime";
+
+}  // namespace cpplox::AOT
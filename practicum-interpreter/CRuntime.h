@@ -0,0 +1,18 @@
+#ifndef CPPLOX_AOT_CRUNTIME_H
+#define CPPLOX_AOT_CRUNTIME_H
+#pragma once
+
+#include <string_view>
+
+namespace cpplox::AOT {
+
+// The C source every file the CEmitter writes starts with: the values,
+// operators, input and output, and runtime errors of the interpreter, in C.
+// It defines nothing that isn't static, and nothing the emitted code can
+// clash with: the emitted names are all t<n>, v_<name> and such, or start
+// with lox_.
+extern const std::string_view C_RUNTIME;
+
+}  // namespace cpplox::AOT
+
+#endif  // CPPLOX_AOT_CRUNTIME_H
@@ -0,0 +1,748 @@
+#include "ClosureEvaluator.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+#include "Arena.h"
+#include "RuntimeError.h"
+#include "Token.h"
+#include "TypeChecker.h"
+
+#define EXPECT_TRUE(x) __builtin_expect(static_cast<int64_t>(x), 1)
+#define EXPECT_FALSE(x) __builtin_expect(static_cast<int64_t>(x), 0)
+
+namespace cpplox::Evaluator {
+
+using ErrorsAndDebug::RuntimeError;
+using Types::Token;
+using Types::TokenType;
+
+// ================ //
+// Compiled nodes
+// ================ //
+
+// A compiled expression: `run` computes its value from the nodes and values
+// bound to it. Which of the fields below it uses depends on the node.
+struct CompiledExpr {
+  using Fn = auto (*)(const CompiledExpr& self, ClosureEvaluator& evaluator)
+      -> LoxObject;
+
+  Fn run = nullptr;
+  // Operands; the condition and branches of a conditional.
+  const CompiledExpr* first = nullptr;
+  const CompiledExpr* second = nullptr;
+  const CompiledExpr* third = nullptr;
+  // The operator or the variable's name, for error messages.
+  const Token* token = nullptr;
+  // The variable's slot, or the constant's index in the ConstantPool.
+  uint32_t index = 0;
+};
+
+// A compiled statement. `run` returns true if a `break` is leaving the
+// innermost loop around it.
+struct CompiledStmt {
+  using Fn = auto (*)(const CompiledStmt& self, ClosureEvaluator& evaluator)
+      -> bool;
+
+  Fn run = nullptr;
+  // The expression, initializer or condition.
+  const CompiledExpr* expr = nullptr;
+  const CompiledExpr* increment = nullptr;
+  // The then branch or the loop body; the else branch or a for's
+  // initializer.
+  const CompiledStmt* body = nullptr;
+  const CompiledStmt* other = nullptr;
+  std::span<const CompiledExpr* const> exprs;
+  std::span<const CompiledStmt* const> stmts;
+  // The variable's name, or the `break`.
+  const Token* token = nullptr;
+  uint32_t slot = 0;
+  DeclaredType type = DeclaredType::ANY;
+};
+
+namespace {
+// How an operand is got at: by evaluating it, or straight from the slot or
+// constant it names.
+enum class Shape : uint8_t { EXPR, VARIABLE, CONSTANT };
+
+// The operators with a fast path for reals and ints. OTHER takes the general
+// one.
+enum class BinaryOp : uint8_t {
+  ADD, SUBTRACT, MULTIPLY, DIVIDE, MODULO, LESS, LESS_EQUAL, GREATER,
+  GREATER_EQUAL, EQUAL, NOT_EQUAL, OTHER
+};
+enum class UnaryOp : uint8_t { NEGATE, NOT, OTHER };
+
+// Variables and constants are used in place, expressions by value.
+template <Shape SHAPE>
+using OperandValue = std::conditional_t<SHAPE == Shape::EXPR, LoxObject,
+                                        const LoxObject&>;
+
+// A value the TypeChecker proved to be a real (T = double) or an int
+// (T = int64_t), as such.
+template <typename T>
+inline auto as(const LoxObject& object) -> T {
+  if constexpr (std::is_same_v<T, double>)
+    return object.asNumber();
+  else
+    return object.asInt();
+}
+
+inline auto isNil(const LoxObject& object) -> bool { return object.isNil(); }
+
+// Evaluator::isTrue(), inline.
+inline auto isTrueInline(const LoxObject& object) -> bool {
+  if (object.isBool()) return object.asBool();
+  return !isNil(object);
+}
+
+// applyBinary() for two reals, with the operator known and the divisor of
+// '/' and '%' checked.
+template <BinaryOp OP>
+inline auto applyNumeric(double lhs, double rhs) -> LoxObject {
+  if constexpr (OP == BinaryOp::ADD) return lhs + rhs;
+  if constexpr (OP == BinaryOp::SUBTRACT) return lhs - rhs;
+  if constexpr (OP == BinaryOp::MULTIPLY) return lhs * rhs;
+  if constexpr (OP == BinaryOp::DIVIDE) return lhs / rhs;
+  if constexpr (OP == BinaryOp::MODULO) return realModulo(lhs, rhs);
+  if constexpr (OP == BinaryOp::LESS) return lhs < rhs;
+  if constexpr (OP == BinaryOp::LESS_EQUAL) return lhs <= rhs;
+  if constexpr (OP == BinaryOp::GREATER) return lhs > rhs;
+  if constexpr (OP == BinaryOp::GREATER_EQUAL) return lhs >= rhs;
+  if constexpr (OP == BinaryOp::EQUAL) return lhs == rhs;
+  if constexpr (OP == BinaryOp::NOT_EQUAL) return lhs != rhs;
+}
+
+// The same for two ints.
+template <BinaryOp OP>
+inline auto applyInteger(int64_t lhs, int64_t rhs) -> LoxObject {
+  if constexpr (OP == BinaryOp::ADD) return wrappingAdd(lhs, rhs);
+  if constexpr (OP == BinaryOp::SUBTRACT) return wrappingSubtract(lhs, rhs);
+  if constexpr (OP == BinaryOp::MULTIPLY) return wrappingMultiply(lhs, rhs);
+  if constexpr (OP == BinaryOp::DIVIDE) return intDivide(lhs, rhs);
+  if constexpr (OP == BinaryOp::MODULO) return intModulo(lhs, rhs);
+  if constexpr (OP == BinaryOp::LESS) return lhs < rhs;
+  if constexpr (OP == BinaryOp::LESS_EQUAL) return lhs <= rhs;
+  if constexpr (OP == BinaryOp::GREATER) return lhs > rhs;
+  if constexpr (OP == BinaryOp::GREATER_EQUAL) return lhs >= rhs;
+  if constexpr (OP == BinaryOp::EQUAL) return lhs == rhs;
+  if constexpr (OP == BinaryOp::NOT_EQUAL) return lhs != rhs;
+}
+}  // namespace
+
+// =================== //
+// struct ClosureRuntime
+// =================== //
+struct ClosureRuntime {
+  template <Shape SHAPE>
+  static auto operand(const CompiledExpr& expr, ClosureEvaluator& evaluator)
+      -> OperandValue<SHAPE> {
+    if constexpr (SHAPE == Shape::VARIABLE)
+      return evaluator.environment.get(expr.index, *expr.token);
+    else if constexpr (SHAPE == Shape::CONSTANT)
+      return evaluator.constants[expr.index];
+    else
+      return expr.run(expr, evaluator);
+  }
+
+  // An operand the TypeChecker proved to be of type T; a variable is then
+  // sure to hold a value.
+  template <typename T, Shape SHAPE>
+  static auto typedOperand(const CompiledExpr& expr,
+                           ClosureEvaluator& evaluator) -> T {
+    if constexpr (SHAPE == Shape::VARIABLE)
+      return as<T>(evaluator.environment.value(expr.index));
+    else if constexpr (SHAPE == Shape::CONSTANT)
+      return as<T>(evaluator.constants[expr.index]);
+    else
+      return as<T>(expr.run(expr, evaluator));
+  }
+
+  // Expressions
+  static auto constant(const CompiledExpr& self, ClosureEvaluator& evaluator)
+      -> LoxObject {
+    return evaluator.constants[self.index];
+  }
+
+  static auto variable(const CompiledExpr& self, ClosureEvaluator& evaluator)
+      -> LoxObject {
+    return evaluator.environment.get(self.index, *self.token);
+  }
+
+  // A variable the TypeChecker proved to hold a value of its type.
+  static auto value(const CompiledExpr& self, ClosureEvaluator& evaluator)
+      -> LoxObject {
+    return evaluator.environment.value(self.index);
+  }
+
+  // An assignment the TypeChecker proved to store a value of the variable's
+  // own type, which it is defined with.
+  static auto store(const CompiledExpr& self, ClosureEvaluator& evaluator)
+      -> LoxObject {
+    return evaluator.environment.value(self.index)
+           = self.first->run(*self.first, evaluator);
+  }
+
+  static auto assignment(const CompiledExpr& self,
+                         ClosureEvaluator& evaluator) -> LoxObject {
+    evaluator.environment.assign(self.index, *self.token,
+                                 self.first->run(*self.first, evaluator));
+    return evaluator.environment.get(self.index, *self.token);
+  }
+
+  // `x = x + ...`: the operands, then the append to the variable.
+  static auto selfAppend(const CompiledExpr& self, ClosureEvaluator& evaluator)
+      -> LoxObject {
+    LoxObject left = self.first->run(*self.first, evaluator);
+    const LoxObject right = self.second->run(*self.second, evaluator);
+    if (!evaluator.environment.append(self.index, left, right))
+      evaluator.environment.assign(self.index, *self.token,
+                                   slowBinary(self, evaluator, left, right));
+    return evaluator.environment.get(self.index, *self.token);
+  }
+
+  // T is LoxObject for operands of any type, or the type the TypeChecker
+  // proved them both to be, which they are then taken as.
+  template <BinaryOp OP, Shape LEFT, Shape RIGHT, typename T = LoxObject>
+  static auto binary(const CompiledExpr& self, ClosureEvaluator& evaluator)
+      -> LoxObject {
+    if constexpr (!std::is_same_v<T, LoxObject> && OP != BinaryOp::OTHER) {
+      const T lhs = typedOperand<T, LEFT>(*self.first, evaluator);
+      const T rhs = typedOperand<T, RIGHT>(*self.second, evaluator);
+      if constexpr (OP == BinaryOp::DIVIDE || OP == BinaryOp::MODULO) {
+        bool zero = rhs == 0;
+        if constexpr (std::is_same_v<T, double> && OP == BinaryOp::MODULO)
+          zero = truncateToInt(rhs) == 0;
+        if (EXPECT_FALSE(zero))
+          return slowBinary(self, evaluator, LoxObject(lhs), LoxObject(rhs));
+      }
+      if constexpr (std::is_same_v<T, double>)
+        return applyNumeric<OP>(lhs, rhs);
+      else
+        return applyInteger<OP>(lhs, rhs);
+    }
+    OperandValue<LEFT> left = operand<LEFT>(*self.first, evaluator);
+    OperandValue<RIGHT> right = operand<RIGHT>(*self.second, evaluator);
+    if constexpr (OP != BinaryOp::OTHER) {
+      if (LoxObject::areSmallInts(left, right)
+          && ((OP != BinaryOp::DIVIDE && OP != BinaryOp::MODULO)
+              || right.asSmallInt() != 0))
+        return applyInteger<OP>(left.asSmallInt(), right.asSmallInt());
+      double lhs;
+      double rhs;
+      if (EXPECT_TRUE(asReals(left, right, lhs, rhs)
+                      && (OP != BinaryOp::DIVIDE || rhs != 0.0)
+                      && (OP != BinaryOp::MODULO || truncateToInt(rhs) != 0)))
+        return applyNumeric<OP>(lhs, rhs);
+    }
+    return slowBinary(self, evaluator, left, right);
+  }
+
+  template <UnaryOp OP, Shape RIGHT, typename T = LoxObject>
+  static auto unary(const CompiledExpr& self, ClosureEvaluator& evaluator)
+      -> LoxObject {
+    if constexpr (!std::is_same_v<T, LoxObject> && OP == UnaryOp::NEGATE) {
+      const T right = typedOperand<T, RIGHT>(*self.first, evaluator);
+      if constexpr (std::is_same_v<T, double>)
+        return -right;
+      else
+        return wrappingNegate(right);
+    }
+    OperandValue<RIGHT> right = operand<RIGHT>(*self.first, evaluator);
+    if constexpr (OP == UnaryOp::NOT) return !isTrueInline(right);
+    if constexpr (OP == UnaryOp::NEGATE) {
+      if (right.isNumber()) return -right.asNumber();
+      if (right.isSmallInt()) return wrappingNegate(right.asSmallInt());
+    }
+    return slowUnary(self, evaluator, right);
+  }
+
+  static auto slowBinary(const CompiledExpr& self, ClosureEvaluator& evaluator,
+                         const LoxObject& left, const LoxObject& right)
+      -> LoxObject {
+    try {
+      return applyBinary(*self.token, left, right);
+    } catch (const OperatorError& e) {
+      throw reportRuntimeError(evaluator.eReporter, *self.token, e.what());
+    }
+  }
+
+  static auto slowUnary(const CompiledExpr& self, ClosureEvaluator& evaluator,
+                        const LoxObject& right) -> LoxObject {
+    try {
+      return applyUnary(*self.token, right);
+    } catch (const OperatorError& e) {
+      throw reportRuntimeError(evaluator.eReporter, *self.token, e.what());
+    }
+  }
+
+  static auto conditional(const CompiledExpr& self,
+                          ClosureEvaluator& evaluator) -> LoxObject {
+    const CompiledExpr& branch
+        = isTrueInline(self.first->run(*self.first, evaluator)) ? *self.second
+                                                                : *self.third;
+    return branch.run(branch, evaluator);
+  }
+
+  // `and` stops at the first false operand, `or` at the first true one.
+  template <bool IS_OR>
+  static auto logical(const CompiledExpr& self, ClosureEvaluator& evaluator)
+      -> LoxObject {
+    LoxObject left = self.first->run(*self.first, evaluator);
+    if (isTrueInline(left) == IS_OR) return left;
+    return self.second->run(*self.second, evaluator);
+  }
+
+  static auto illegalLogical(const CompiledExpr& self,
+                             ClosureEvaluator& evaluator) -> LoxObject {
+    self.first->run(*self.first, evaluator);
+    throw reportRuntimeError(evaluator.eReporter, *self.token,
+                             "Illegal logical operator: "
+                                 + std::string(self.token->getLexeme()));
+  }
+
+  // Statements
+  static auto statements(std::span<const CompiledStmt* const> stmts,
+                         ClosureEvaluator& evaluator) -> bool {
+    for (const CompiledStmt* stmt : stmts) {
+      try {
+        if (stmt->run(*stmt, evaluator)) return true;
+      } catch (const RuntimeError& e) {
+        if (EXPECT_FALSE(!evaluator.recoverFromRuntimeError())) throw e;
+      }
+    }
+    return false;
+  }
+
+  static auto block(const CompiledStmt& self, ClosureEvaluator& evaluator)
+      -> bool {
+    return statements(self.stmts, evaluator);
+  }
+
+  static auto expression(const CompiledStmt& self,
+                         ClosureEvaluator& evaluator) -> bool {
+    self.expr->run(*self.expr, evaluator);
+    return false;
+  }
+
+  static auto write(const CompiledStmt& self, ClosureEvaluator& evaluator)
+      -> bool {
+    for (const CompiledExpr* expr : self.exprs)
+      std::cout << expr->run(*expr, evaluator) << " ";
+    std::cout << std::endl;
+    return false;
+  }
+
+  static auto read(const CompiledStmt& self, ClosureEvaluator& evaluator)
+      -> bool {
+    evaluator.environment.read(self.slot, *self.token);
+    return false;
+  }
+
+  static auto declaration(const CompiledStmt& self,
+                          ClosureEvaluator& evaluator) -> bool {
+    evaluator.environment.define(
+        self.slot,
+        self.expr != nullptr ? self.expr->run(*self.expr, evaluator)
+                             : LoxObject(nullptr),
+        self.type);
+    return false;
+  }
+
+  static auto ifStmt(const CompiledStmt& self, ClosureEvaluator& evaluator)
+      -> bool {
+    if (isTrueInline(self.expr->run(*self.expr, evaluator)))
+      return self.body->run(*self.body, evaluator);
+    if (self.other != nullptr) return self.other->run(*self.other, evaluator);
+    return false;
+  }
+
+  static auto whileStmt(const CompiledStmt& self, ClosureEvaluator& evaluator)
+      -> bool {
+    const CompiledExpr& condition = *self.expr;
+    const CompiledStmt& body = *self.body;
+    while (isTrueInline(condition.run(condition, evaluator))) {
+      if (body.run(body, evaluator)) break;
+    }
+    return false;
+  }
+
+  static auto forStmt(const CompiledStmt& self, ClosureEvaluator& evaluator)
+      -> bool {
+    // A break in the initializer belongs to an enclosing loop.
+    if (self.other != nullptr && self.other->run(*self.other, evaluator))
+      return true;
+    const CompiledStmt& body = *self.body;
+    while (true) {
+      if (self.expr != nullptr
+          && !isTrueInline(self.expr->run(*self.expr, evaluator)))
+        break;
+      if (body.run(body, evaluator)) break;
+      if (self.increment != nullptr)
+        self.increment->run(*self.increment, evaluator);
+    }
+    return false;
+  }
+
+  static auto breakStmt(const CompiledStmt& /*self*/,
+                        ClosureEvaluator& /*evaluator*/) -> bool {
+    return true;
+  }
+
+  // A break outside of any loop goes to the driver, as it does from the
+  // Evaluator.
+  static auto strayBreak(const CompiledStmt& self,
+                         ClosureEvaluator& /*evaluator*/) -> bool {
+    throw BreakException(self.token->getOffset());
+  }
+};
+
+namespace {
+// The binary(), for each shape of the operands, of one operator.
+template <BinaryOp OP, typename T>
+auto binaryFn(Shape left, Shape right) -> CompiledExpr::Fn {
+  using R = ClosureRuntime;
+  using enum Shape;
+  static constexpr std::array<std::array<CompiledExpr::Fn, 3>, 3> fns = {{
+      {&R::binary<OP, EXPR, EXPR, T>, &R::binary<OP, EXPR, VARIABLE, T>,
+       &R::binary<OP, EXPR, CONSTANT, T>},
+      {&R::binary<OP, VARIABLE, EXPR, T>, &R::binary<OP, VARIABLE, VARIABLE, T>,
+       &R::binary<OP, VARIABLE, CONSTANT, T>},
+      {&R::binary<OP, CONSTANT, EXPR, T>, &R::binary<OP, CONSTANT, VARIABLE, T>,
+       &R::binary<OP, CONSTANT, CONSTANT, T>},
+  }};
+  return fns[static_cast<size_t>(left)][static_cast<size_t>(right)];
+}
+
+template <typename T>
+auto binaryFn(TokenType op, Shape left, Shape right) -> CompiledExpr::Fn {
+  switch (op) {
+    case TokenType::PLUS: return binaryFn<BinaryOp::ADD, T>(left, right);
+    case TokenType::MINUS:
+      return binaryFn<BinaryOp::SUBTRACT, T>(left, right);
+    case TokenType::STAR: return binaryFn<BinaryOp::MULTIPLY, T>(left, right);
+    case TokenType::SLASH: return binaryFn<BinaryOp::DIVIDE, T>(left, right);
+    case TokenType::MOD: return binaryFn<BinaryOp::MODULO, T>(left, right);
+    case TokenType::LESS: return binaryFn<BinaryOp::LESS, T>(left, right);
+    case TokenType::LESS_EQUAL:
+      return binaryFn<BinaryOp::LESS_EQUAL, T>(left, right);
+    case TokenType::GREATER:
+      return binaryFn<BinaryOp::GREATER, T>(left, right);
+    case TokenType::GREATER_EQUAL:
+      return binaryFn<BinaryOp::GREATER_EQUAL, T>(left, right);
+    case TokenType::EQUAL_EQUAL:
+      return binaryFn<BinaryOp::EQUAL, T>(left, right);
+    case TokenType::BANG_EQUAL:
+      return binaryFn<BinaryOp::NOT_EQUAL, T>(left, right);
+    default: return binaryFn<BinaryOp::OTHER, LoxObject>(left, right);
+  }
+}
+
+// The binary() of an operator, taking its operands as the type the
+// TypeChecker proved they both have, if it did.
+auto binaryFn(TokenType op, AST::StaticType operands, Shape left, Shape right)
+    -> CompiledExpr::Fn {
+  switch (operands) {
+    case AST::StaticType::REAL: return binaryFn<double>(op, left, right);
+    case AST::StaticType::INT: return binaryFn<int64_t>(op, left, right);
+    default: return binaryFn<LoxObject>(op, left, right);
+  }
+}
+
+template <UnaryOp OP, typename T>
+auto unaryFn(Shape right) -> CompiledExpr::Fn {
+  using R = ClosureRuntime;
+  using enum Shape;
+  static constexpr std::array<CompiledExpr::Fn, 3> fns
+      = {&R::unary<OP, EXPR, T>, &R::unary<OP, VARIABLE, T>,
+         &R::unary<OP, CONSTANT, T>};
+  return fns[static_cast<size_t>(right)];
+}
+
+// The same for a unary operator, given the type of its result.
+auto unaryFn(TokenType op, AST::StaticType type, Shape right)
+    -> CompiledExpr::Fn {
+  switch (op) {
+    case TokenType::MINUS:
+      if (type == AST::StaticType::REAL)
+        return unaryFn<UnaryOp::NEGATE, double>(right);
+      if (type == AST::StaticType::INT)
+        return unaryFn<UnaryOp::NEGATE, int64_t>(right);
+      return unaryFn<UnaryOp::NEGATE, LoxObject>(right);
+    case TokenType::BANG: return unaryFn<UnaryOp::NOT, LoxObject>(right);
+    default: return unaryFn<UnaryOp::OTHER, LoxObject>(right);
+  }
+}
+
+// ====================== //
+// class ClosureCompiler
+// ====================== //
+
+// Builds the compiled nodes of a program in `nodes`. They point into the
+// program's AST for their tokens, so they must not outlive it.
+class ClosureCompiler {
+ public:
+  ClosureCompiler(AST::Arena& p_nodes, ConstantPool& p_constants)
+      : nodes(p_nodes), constants(p_constants) {}
+
+  auto compileStmts(AST::StmtList stmts)
+      -> std::span<const CompiledStmt* const> {
+    std::vector<const CompiledStmt*> compiled;
+    compiled.reserve(stmts.size());
+    for (const AST::StmtPtrVariant& stmt : stmts)
+      compiled.push_back(compileStmt(stmt));
+    return nodes.copy(compiled);
+  }
+
+ private:
+  auto make(const CompiledExpr& node) -> const CompiledExpr* {
+    return nodes.make<CompiledExpr>(node);
+  }
+  auto make(const CompiledStmt& node) -> const CompiledStmt* {
+    return nodes.make<CompiledStmt>(node);
+  }
+
+  static auto shapeOf(const CompiledExpr* expr) -> Shape {
+    if (expr->run == &ClosureRuntime::variable
+        || expr->run == &ClosureRuntime::value)
+      return Shape::VARIABLE;
+    if (expr->run == &ClosureRuntime::constant) return Shape::CONSTANT;
+    return Shape::EXPR;
+  }
+
+  auto compileExpr(const AST::ExprPtrVariant& expr) -> const CompiledExpr* {
+    switch (expr.index()) {
+      case 0:  // BinaryExprPtr
+        return compileBinaryExpr(std::get<0>(expr));
+      case 1:  // GroupingExprPtr
+        return compileExpr(std::get<1>(expr)->expression);
+      case 2:  // LiteralExprPtr
+        return compileLiteralExpr(std::get<2>(expr));
+      case 3:  // UnaryExprPtr
+        return compileUnaryExpr(std::get<3>(expr));
+      case 4:  // ConditionalExprPtr
+        return compileConditionalExpr(std::get<4>(expr));
+      case 5:  // VariableExprPtr
+        return make({.run = std::get<5>(expr)->type != AST::StaticType::UNKNOWN
+                                ? &ClosureRuntime::value
+                                : &ClosureRuntime::variable,
+                     .token = &std::get<5>(expr)->varName,
+                     .index = std::get<5>(expr)->slot});
+      case 6:  // AssignmentExprPtr
+        if (const AST::BinaryExprPtr append = std::get<6>(expr)->selfAppend)
+          // The variable is sure to be defined by the time it is assigned,
+          // so the operator is the only token an error can blame.
+          return make({.run = &ClosureRuntime::selfAppend,
+                       .first = compileExpr(append->left),
+                       .second = compileExpr(append->right),
+                       .token = &append->op,
+                       .index = std::get<6>(expr)->slot});
+        return make({.run = std::get<6>(expr)->type != AST::StaticType::UNKNOWN
+                                    && AST::typeOf(std::get<6>(expr)->right)
+                                           == std::get<6>(expr)->type
+                                ? &ClosureRuntime::store
+                                : &ClosureRuntime::assignment,
+                     .first = compileExpr(std::get<6>(expr)->right),
+                     .token = &std::get<6>(expr)->varName,
+                     .index = std::get<6>(expr)->slot});
+      case 7:  // LogicalExprPtr
+        return compileLogicalExpr(std::get<7>(expr));
+      default:
+        static_assert(std::variant_size_v<AST::ExprPtrVariant> == 8,
+                      "Looks like you forgot to update the cases in "
+                      "ClosureCompiler::compileExpr()!");
+        return nullptr;
+    }
+  }
+
+  auto compileBinaryExpr(const AST::BinaryExprPtr& expr)
+      -> const CompiledExpr* {
+    const CompiledExpr* left = compileExpr(expr->left);
+    const CompiledExpr* right = compileExpr(expr->right);
+    Shape leftShape = shapeOf(left);
+    const Shape rightShape = shapeOf(right);
+    // Evaluating the right operand could assign the left one; its value has
+    // to be taken first.
+    if (leftShape == Shape::VARIABLE && rightShape == Shape::EXPR)
+      leftShape = Shape::EXPR;
+    return make({.run = binaryFn(expr->op.getType(),
+                                 AST::numericOperands(*expr), leftShape,
+                                 rightShape),
+                 .first = left,
+                 .second = right,
+                 .token = &expr->op});
+  }
+
+  auto compileLiteralExpr(const AST::LiteralExprPtr& expr)
+      -> const CompiledExpr* {
+    const uint32_t index = expr->constant != AST::LiteralExpr::NO_CONSTANT
+                               ? expr->constant
+                               : constants.add(toLoxObject(expr->literalVal));
+    return make({.run = &ClosureRuntime::constant, .index = index});
+  }
+
+  auto compileUnaryExpr(const AST::UnaryExprPtr& expr)
+      -> const CompiledExpr* {
+    const CompiledExpr* right = compileExpr(expr->right);
+    return make({.run = unaryFn(expr->op.getType(), expr->type, shapeOf(right)),
+                 .first = right,
+                 .token = &expr->op});
+  }
+
+  auto compileConditionalExpr(const AST::ConditionalExprPtr& expr)
+      -> const CompiledExpr* {
+    return make({.run = &ClosureRuntime::conditional,
+                 .first = compileExpr(expr->condition),
+                 .second = compileExpr(expr->thenBranch),
+                 .third = compileExpr(expr->elseBranch)});
+  }
+
+  auto compileLogicalExpr(const AST::LogicalExprPtr& expr)
+      -> const CompiledExpr* {
+    CompiledExpr::Fn run = &ClosureRuntime::illegalLogical;
+    if (expr->op.getType() == TokenType::OR)
+      run = &ClosureRuntime::logical<true>;
+    else if (expr->op.getType() == TokenType::AND)
+      run = &ClosureRuntime::logical<false>;
+    return make({.run = run,
+                 .first = compileExpr(expr->left),
+                 .second = compileExpr(expr->right),
+                 .token = &expr->op});
+  }
+
+  auto compileStmt(const AST::StmtPtrVariant& stmt) -> const CompiledStmt* {
+    switch (stmt.index()) {
+      case 0:  // ExprStmtPtr
+        return make({.run = &ClosureRuntime::expression,
+                     .expr = compileExpr(std::get<0>(stmt)->expression)});
+      case 1:  // WriteStmtPtr
+        return compileWriteStmt(std::get<1>(stmt));
+      case 2:  // ReadStmtPtr
+        return make({.run = &ClosureRuntime::read,
+                     .token = &std::get<2>(stmt)->varName,
+                     .slot = std::get<2>(stmt)->slot});
+      case 3:  // BlockStmtPtr
+        return make({.run = &ClosureRuntime::block,
+                     .stmts = compileStmts(std::get<3>(stmt)->statements)});
+      case 4:  // IntStmtPtr
+        return compileDeclaration(std::get<4>(stmt)->slot,
+                                  std::get<4>(stmt)->initializer,
+                                  DeclaredType::INT);
+      case 5:  // RealStmtPtr
+        return compileDeclaration(std::get<5>(stmt)->slot,
+                                  std::get<5>(stmt)->initializer,
+                                  DeclaredType::REAL);
+      case 6:  // StrStmtPtr
+        return compileDeclaration(std::get<6>(stmt)->slot,
+                                  std::get<6>(stmt)->initializer,
+                                  DeclaredType::STRING);
+      case 7:  // IfStmtPtr
+        return compileIfStmt(std::get<7>(stmt));
+      case 8:  // WhileStmtPtr
+        return compileWhileStmt(std::get<8>(stmt));
+      case 9:  // ForStmtPtr
+        return compileForStmt(std::get<9>(stmt));
+      case 10:  // BreakStmtPtr
+        return make({.run = loopDepth > 0 ? &ClosureRuntime::breakStmt
+                                          : &ClosureRuntime::strayBreak,
+                     .token = &std::get<10>(stmt)->name});
+      default:
+        static_assert(std::variant_size_v<AST::StmtPtrVariant> == 11,
+                      "Looks like you forgot to update the cases in "
+                      "ClosureCompiler::compileStmt()!");
+        return nullptr;
+    }
+  }
+
+  auto compileWriteStmt(const AST::WriteStmtPtr& stmt)
+      -> const CompiledStmt* {
+    std::vector<const CompiledExpr*> exprs;
+    exprs.reserve(stmt->expressions.size());
+    for (const AST::ExprPtrVariant& expr : stmt->expressions)
+      exprs.push_back(compileExpr(expr));
+    return make({.run = &ClosureRuntime::write, .exprs = nodes.copy(exprs)});
+  }
+
+  auto compileDeclaration(uint32_t slot,
+                          const std::optional<AST::ExprPtrVariant>& initializer,
+                          DeclaredType type) -> const CompiledStmt* {
+    return make({.run = &ClosureRuntime::declaration,
+                 .expr = initializer.has_value()
+                             ? compileExpr(initializer.value())
+                             : nullptr,
+                 .slot = slot,
+                 .type = type});
+  }
+
+  auto compileIfStmt(const AST::IfStmtPtr& stmt) -> const CompiledStmt* {
+    return make({.run = &ClosureRuntime::ifStmt,
+                 .expr = compileExpr(stmt->condition),
+                 .body = compileStmt(stmt->thenBranch),
+                 .other = stmt->elseBranch.has_value()
+                              ? compileStmt(stmt->elseBranch.value())
+                              : nullptr});
+  }
+
+  auto compileWhileStmt(const AST::WhileStmtPtr& stmt)
+      -> const CompiledStmt* {
+    const CompiledExpr* condition = compileExpr(stmt->condition);
+    ++loopDepth;
+    const CompiledStmt* body = compileStmt(stmt->loopBody);
+    --loopDepth;
+    return make({.run = &ClosureRuntime::whileStmt,
+                 .expr = condition,
+                 .body = body});
+  }
+
+  auto compileForStmt(const AST::ForStmtPtr& stmt) -> const CompiledStmt* {
+    const CompiledStmt* initializer
+        = stmt->initializer.has_value()
+              ? compileStmt(stmt->initializer.value())
+              : nullptr;
+    const CompiledExpr* condition
+        = stmt->condition.has_value() ? compileExpr(stmt->condition.value())
+                                      : nullptr;
+    const CompiledExpr* increment
+        = stmt->increment.has_value() ? compileExpr(stmt->increment.value())
+                                      : nullptr;
+    ++loopDepth;
+    const CompiledStmt* body = compileStmt(stmt->loopBody);
+    --loopDepth;
+    return make({.run = &ClosureRuntime::forStmt,
+                 .expr = condition,
+                 .increment = increment,
+                 .body = body,
+                 .other = initializer});
+  }
+
+  AST::Arena& nodes;
+  ConstantPool& constants;
+  // How many loops the statement being compiled is in.
+  unsigned loopDepth = 0;
+};
+}  // namespace
+
+// ======================== //
+// class ClosureEvaluator
+// ======================== //
+ClosureEvaluator::ClosureEvaluator(ErrorReporter& p_eReporter,
+                                   ConstantPool& p_constants)
+    : eReporter(p_eReporter),
+      constants(p_constants),
+      environment(p_eReporter) {}
+
+void ClosureEvaluator::run(const AST::Program& program) {
+  AST::Arena nodes;
+  const std::span<const CompiledStmt* const> statements
+      = ClosureCompiler(nodes, constants).compileStmts(program.statements);
+  ClosureRuntime::statements(statements, *this);
+}
+
+}  // namespace cpplox::Evaluator
@@ -0,0 +1,38 @@
+#ifndef CPPLOX_EVALUATOR_CLOSUREEVALUATOR_H
+#define CPPLOX_EVALUATOR_CLOSUREEVALUATOR_H
+#pragma once
+
+#include "Backend.h"
+#include "Environment.h"
+#include "ErrorReporter.h"
+#include "NodeTypes.h"
+#include "Objects.h"
+
+namespace cpplox::Evaluator {
+
+// The code of the compiled nodes, in ClosureEvaluator.cpp.
+struct ClosureRuntime;
+
+// The closure-compiling backend: walks each program's AST once, turning
+// every node into a function pointer bound to its children, and then runs
+// those. What a node does is settled while compiling it: which operator, and
+// whether its operands are variables (read from their slots in place),
+// constants or expressions. So the variant and operator switches of the
+// Evaluator are gone from the loop that runs the program; the values, the
+// Environment and the runtime errors are all the Evaluator's.
+class ClosureEvaluator final : public Backend {
+ public:
+  ClosureEvaluator(ErrorReporter& eReporter, ConstantPool& constants);
+  void run(const AST::Program& program) override;
+
+ private:
+  friend struct ClosureRuntime;
+
+  ErrorReporter& eReporter;
+  ConstantPool& constants;
+  Environment environment;
+};
+
+}  // namespace cpplox::Evaluator
+
+#endif  // CPPLOX_EVALUATOR_CLOSUREEVALUATOR_H
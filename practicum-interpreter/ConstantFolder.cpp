@@ -0,0 +1,367 @@
+#include "ConstantFolder.h"
+
+#include <optional>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "Environment.h"
+
+namespace cpplox::Evaluator {
+
+using AST::ExprPtrVariant;
+using AST::StmtPtrVariant;
+using Types::TokenType;
+
+namespace {
+// Adds every variable assigned anywhere in expr to `assigned`.
+void collectAssigned(const ExprPtrVariant& expr,
+                     std::unordered_set<std::string_view>& assigned) {
+  switch (expr.index()) {
+    case 0: {  // BinaryExprPtr
+      const auto& binary = std::get<0>(expr);
+      collectAssigned(binary->left, assigned);
+      collectAssigned(binary->right, assigned);
+      return;
+    }
+    case 1:  // GroupingExprPtr
+      return collectAssigned(std::get<1>(expr)->expression, assigned);
+    case 3:  // UnaryExprPtr
+      return collectAssigned(std::get<3>(expr)->right, assigned);
+    case 4: {  // ConditionalExprPtr
+      const auto& conditional = std::get<4>(expr);
+      collectAssigned(conditional->condition, assigned);
+      collectAssigned(conditional->thenBranch, assigned);
+      collectAssigned(conditional->elseBranch, assigned);
+      return;
+    }
+    case 6: {  // AssignmentExprPtr
+      const auto& assignment = std::get<6>(expr);
+      assigned.insert(assignment->varName.getLexeme());
+      collectAssigned(assignment->right, assigned);
+      return;
+    }
+    case 7: {  // LogicalExprPtr
+      const auto& logical = std::get<7>(expr);
+      collectAssigned(logical->left, assigned);
+      collectAssigned(logical->right, assigned);
+      return;
+    }
+    default:  // LiteralExprPtr, VariableExprPtr
+      static_assert(std::variant_size_v<ExprPtrVariant> == 8,
+                    "Looks like you forgot to update the cases in "
+                    "collectAssigned()!");
+      return;
+  }
+}
+
+void collectAssigned(const std::optional<ExprPtrVariant>& expr,
+                     std::unordered_set<std::string_view>& assigned) {
+  if (expr.has_value()) collectAssigned(expr.value(), assigned);
+}
+}  // namespace
+
+ConstantFolder::ConstantFolder(AST::Arena& p_arena, ConstantPool& p_constants)
+    : arena(p_arena), constants(p_constants) {}
+
+void ConstantFolder::fold(AST::Program& program) {
+  findUnfoldableVariables(program.statements);
+  for (const StmtPtrVariant& stmt : program.statements) foldStmt(stmt);
+}
+
+void ConstantFolder::findUnfoldableVariables(AST::StmtList stmts) {
+  std::unordered_set<std::string_view> declared;
+  auto declare = [this, &declared](const Types::Token& varName) {
+    if (!declared.insert(varName.getLexeme()).second)
+      unfoldable.insert(varName.getLexeme());
+  };
+
+  for (const StmtPtrVariant& stmt : stmts) {
+    switch (stmt.index()) {
+      case 0:  // ExprStmtPtr
+        collectAssigned(std::get<0>(stmt)->expression, unfoldable);
+        break;
+      case 1:  // WriteStmtPtr
+        for (const auto& expr : std::get<1>(stmt)->expressions)
+          collectAssigned(expr, unfoldable);
+        break;
+      case 2:  // ReadStmtPtr
+        unfoldable.insert(std::get<2>(stmt)->varName.getLexeme());
+        break;
+      case 3:  // BlockStmtPtr
+        findUnfoldableVariables(std::get<3>(stmt)->statements);
+        break;
+      case 4:  // IntStmtPtr
+        declare(std::get<4>(stmt)->varName);
+        collectAssigned(std::get<4>(stmt)->initializer, unfoldable);
+        break;
+      case 5:  // RealStmtPtr
+        declare(std::get<5>(stmt)->varName);
+        collectAssigned(std::get<5>(stmt)->initializer, unfoldable);
+        break;
+      case 6:  // StrStmtPtr
+        declare(std::get<6>(stmt)->varName);
+        collectAssigned(std::get<6>(stmt)->initializer, unfoldable);
+        break;
+      case 7: {  // IfStmtPtr
+        const auto& ifStmt = std::get<7>(stmt);
+        collectAssigned(ifStmt->condition, unfoldable);
+        findUnfoldableVariables({&ifStmt->thenBranch, 1});
+        if (ifStmt->elseBranch.has_value())
+          findUnfoldableVariables({&ifStmt->elseBranch.value(), 1});
+        break;
+      }
+      case 8: {  // WhileStmtPtr
+        const auto& whileStmt = std::get<8>(stmt);
+        collectAssigned(whileStmt->condition, unfoldable);
+        findUnfoldableVariables({&whileStmt->loopBody, 1});
+        break;
+      }
+      case 9: {  // ForStmtPtr
+        const auto& forStmt = std::get<9>(stmt);
+        if (forStmt->initializer.has_value())
+          findUnfoldableVariables({&forStmt->initializer.value(), 1});
+        collectAssigned(forStmt->condition, unfoldable);
+        collectAssigned(forStmt->increment, unfoldable);
+        findUnfoldableVariables({&forStmt->loopBody, 1});
+        break;
+      }
+      default:  // BreakStmtPtr
+        static_assert(std::variant_size_v<StmtPtrVariant> == 11,
+                      "Looks like you forgot to update the cases in "
+                      "ConstantFolder::findUnfoldableVariables()!");
+        break;
+    }
+  }
+}
+
+// ========== //
+// Statements
+// ========== //
+void ConstantFolder::foldStmt(const StmtPtrVariant& stmt) {
+  switch (stmt.index()) {
+    case 0: {  // ExprStmtPtr
+      const auto& exprStmt = std::get<0>(stmt);
+      exprStmt->expression = foldExpr(exprStmt->expression);
+      return;
+    }
+    case 1: {  // WriteStmtPtr
+      const auto& writeStmt = std::get<1>(stmt);
+      std::vector<ExprPtrVariant> exprs;
+      exprs.reserve(writeStmt->expressions.size());
+      for (const auto& expr : writeStmt->expressions)
+        exprs.push_back(foldExpr(expr));
+      writeStmt->expressions = arena.copy(exprs);
+      return;
+    }
+    case 2:  // ReadStmtPtr
+      return;
+    case 3:  // BlockStmtPtr
+      for (const StmtPtrVariant& inner : std::get<3>(stmt)->statements)
+        foldStmt(inner);
+      return;
+    case 4:  // IntStmtPtr
+      return foldDeclaration(std::get<4>(stmt)->varName,
+                             std::get<4>(stmt)->initializer,
+                             DeclaredType::INT);
+    case 5:  // RealStmtPtr
+      return foldDeclaration(std::get<5>(stmt)->varName,
+                             std::get<5>(stmt)->initializer,
+                             DeclaredType::REAL);
+    case 6:  // StrStmtPtr
+      return foldDeclaration(std::get<6>(stmt)->varName,
+                             std::get<6>(stmt)->initializer,
+                             DeclaredType::STRING);
+    case 7: {  // IfStmtPtr
+      const auto& ifStmt = std::get<7>(stmt);
+      ifStmt->condition = foldExpr(ifStmt->condition);
+      foldStmt(ifStmt->thenBranch);
+      if (ifStmt->elseBranch.has_value()) foldStmt(ifStmt->elseBranch.value());
+      return;
+    }
+    case 8: {  // WhileStmtPtr
+      const auto& whileStmt = std::get<8>(stmt);
+      whileStmt->condition = foldExpr(whileStmt->condition);
+      foldStmt(whileStmt->loopBody);
+      return;
+    }
+    case 9: {  // ForStmtPtr
+      const auto& forStmt = std::get<9>(stmt);
+      if (forStmt->initializer.has_value())
+        foldStmt(forStmt->initializer.value());
+      if (forStmt->condition.has_value())
+        forStmt->condition = foldExpr(forStmt->condition.value());
+      if (forStmt->increment.has_value())
+        forStmt->increment = foldExpr(forStmt->increment.value());
+      foldStmt(forStmt->loopBody);
+      return;
+    }
+    default:  // BreakStmtPtr
+      return;
+  }
+}
+
+// Declarations all come before the other statements and are evaluated in
+// order, so a variable is known from its own declaration onwards.
+void ConstantFolder::foldDeclaration(
+    const Types::Token& varName, std::optional<ExprPtrVariant>& initializer,
+    DeclaredType type) {
+  if (!initializer.has_value()) return;
+  initializer = foldExpr(initializer.value());
+
+  const LoxObject* value = valueOf(initializer.value());
+  // A nil variable can't be read; that error is left for run time.
+  if (value == nullptr || value->isNil())
+    return;
+  if (unfoldable.contains(varName.getLexeme())) return;
+  // The variable holds the value converted to its type.
+  knownVariables.emplace(
+      varName.getLexeme(),
+      Environment::storesAsIs(type, *value)
+          ? std::get<AST::LiteralExprPtr>(initializer.value())->constant
+          : constants.add(Environment::converted(type, *value)));
+}
+
+// =========== //
+// Expressions
+// =========== //
+auto ConstantFolder::foldExpr(const ExprPtrVariant& expr) -> ExprPtrVariant {
+  switch (expr.index()) {
+    case 0:  // BinaryExprPtr
+      return foldBinaryExpr(std::get<0>(expr));
+    case 1:  // GroupingExprPtr
+      return foldExpr(std::get<1>(expr)->expression);
+    case 2: {  // LiteralExprPtr
+      const auto& literal = std::get<2>(expr);
+      if (literal->constant == AST::LiteralExpr::NO_CONSTANT)
+        literal->constant = constants.add(toLoxObject(literal->literalVal));
+      return expr;
+    }
+    case 3:  // UnaryExprPtr
+      return foldUnaryExpr(std::get<3>(expr));
+    case 4:  // ConditionalExprPtr
+      return foldConditionalExpr(std::get<4>(expr));
+    case 5:  // VariableExprPtr
+      return foldVariableExpr(std::get<5>(expr));
+    case 6: {  // AssignmentExprPtr
+      const auto& assignment = std::get<6>(expr);
+      assignment->right = foldExpr(assignment->right);
+      return expr;
+    }
+    case 7:  // LogicalExprPtr
+      return foldLogicalExpr(std::get<7>(expr));
+    default:
+      static_assert(std::variant_size_v<ExprPtrVariant> == 8,
+                    "Looks like you forgot to update the cases in "
+                    "ConstantFolder::foldExpr()!");
+      return expr;
+  }
+}
+
+auto ConstantFolder::foldBinaryExpr(const AST::BinaryExprPtr& expr)
+    -> ExprPtrVariant {
+  expr->left = foldExpr(expr->left);
+  expr->right = foldExpr(expr->right);
+  const LoxObject* left = valueOf(expr->left);
+  if (left == nullptr) return expr;
+  // A known left operand of ',' has no effects; only the right one remains.
+  if (expr->op.getType() == TokenType::COMMA) return expr->right;
+
+  const LoxObject* right = valueOf(expr->right);
+  if (right == nullptr) return expr;
+  try {
+    return makeLiteral(applyBinary(expr->op, *left, *right));
+  } catch (const OperatorError&) {
+    return expr;
+  }
+}
+
+auto ConstantFolder::foldUnaryExpr(const AST::UnaryExprPtr& expr)
+    -> ExprPtrVariant {
+  expr->right = foldExpr(expr->right);
+  const LoxObject* right = valueOf(expr->right);
+  if (right == nullptr) return expr;
+  try {
+    return makeLiteral(applyUnary(expr->op, *right));
+  } catch (const OperatorError&) {
+    return expr;
+  }
+}
+
+auto ConstantFolder::foldConditionalExpr(const AST::ConditionalExprPtr& expr)
+    -> ExprPtrVariant {
+  expr->condition = foldExpr(expr->condition);
+  expr->thenBranch = foldExpr(expr->thenBranch);
+  expr->elseBranch = foldExpr(expr->elseBranch);
+  const LoxObject* condition = valueOf(expr->condition);
+  if (condition == nullptr) return expr;
+  return isTrue(*condition) ? expr->thenBranch : expr->elseBranch;
+}
+
+auto ConstantFolder::foldLogicalExpr(const AST::LogicalExprPtr& expr)
+    -> ExprPtrVariant {
+  expr->left = foldExpr(expr->left);
+  expr->right = foldExpr(expr->right);
+  const LoxObject* left = valueOf(expr->left);
+  if (left == nullptr) return expr;
+  if (expr->op.getType() == TokenType::OR)
+    return isTrue(*left) ? expr->left : expr->right;
+  if (expr->op.getType() == TokenType::AND)
+    return !isTrue(*left) ? expr->left : expr->right;
+  return expr;
+}
+
+auto ConstantFolder::foldVariableExpr(const AST::VariableExprPtr& expr)
+    -> ExprPtrVariant {
+  auto iter = knownVariables.find(expr->varName.getLexeme());
+  if (iter == knownVariables.end()) return expr;
+  return makeLiteral(iter->second);
+}
+
+// ======= //
+// Helpers
+// ======= //
+auto ConstantFolder::valueOf(const ExprPtrVariant& expr) const
+    -> const LoxObject* {
+  if (!std::holds_alternative<AST::LiteralExprPtr>(expr)) return nullptr;
+  uint32_t constant = std::get<AST::LiteralExprPtr>(expr)->constant;
+  if (constant == AST::LiteralExpr::NO_CONSTANT) return nullptr;
+  return &constants[constant];
+}
+
+// The literal is only there for printing the AST; the Evaluator uses the
+// constant.
+auto ConstantFolder::makeLiteral(uint32_t constant) -> ExprPtrVariant {
+  const LoxObject& value = constants[constant];
+  Types::OptionalLiteral literal = std::nullopt;
+  switch (value.index()) {
+    case 0:  // string
+      literal = Types::makeOptionalLiteral(
+          arena.copy(value.asString()));
+      break;
+    case 1:  // double
+      literal = Types::makeOptionalLiteral(value.asNumber());
+      break;
+    case 2:  // bool
+      literal = Types::makeOptionalLiteral(value.asBool());
+      break;
+    case 4:  // int
+      literal = Types::makeOptionalLiteral(value.asInt());
+      break;
+    default:  // nullptr
+      static_assert(LoxObject::NUM_TYPES == 5,
+                    "Looks like you forgot to update the cases in "
+                    "ConstantFolder::makeLiteral()!");
+      break;
+  }
+  ExprPtrVariant expr = AST::createLiteralEPV(arena, literal);
+  std::get<AST::LiteralExprPtr>(expr)->constant = constant;
+  return expr;
+}
+
+auto ConstantFolder::makeLiteral(LoxObject value) -> ExprPtrVariant {
+  return makeLiteral(constants.add(std::move(value)));
+}
+
+}  // namespace cpplox::Evaluator
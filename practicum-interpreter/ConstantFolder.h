@@ -0,0 +1,74 @@
+#ifndef CPPLOX_EVALUATOR_CONSTANTFOLDER_H
+#define CPPLOX_EVALUATOR_CONSTANTFOLDER_H
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "Arena.h"
+#include "Environment.h"
+#include "NodeTypes.h"
+#include "Objects.h"
+
+namespace cpplox::Evaluator {
+
+// An AST pass over a freshly parsed program, run before it is evaluated.
+//
+// - Every literal gets its runtime value in the ConstantPool up front, so the
+//   Evaluator hands out a ready LoxObject instead of converting the literal
+//   each time it is evaluated.
+// - Operators whose operands are all known are applied once, here: arithmetic,
+//   comparisons and concatenation of literals, and of variables that are
+//   declared with a known value and never assigned or read into afterwards.
+//   Logical and conditional operators with a known left hand side / condition
+//   are replaced by the operand they would pick.
+// - GroupingExprs, which only matter to the parser, are dropped.
+//
+// An operation that would fail is left alone, so its runtime error is still
+// reported if and when the program gets there.
+class ConstantFolder {
+ public:
+  // Folded values are allocated in `arena`, the arena of the program that is
+  // folded, and added to `constants`.
+  ConstantFolder(AST::Arena& arena, ConstantPool& constants);
+
+  // Rewrites the program in place.
+  void fold(AST::Program& program);
+
+ private:
+  void findUnfoldableVariables(AST::StmtList stmts);
+  void foldStmt(const AST::StmtPtrVariant& stmt);
+  void foldDeclaration(const Types::Token& varName,
+                       std::optional<AST::ExprPtrVariant>& initializer,
+                       DeclaredType type);
+  auto foldExpr(const AST::ExprPtrVariant& expr) -> AST::ExprPtrVariant;
+  auto foldBinaryExpr(const AST::BinaryExprPtr& expr) -> AST::ExprPtrVariant;
+  auto foldUnaryExpr(const AST::UnaryExprPtr& expr) -> AST::ExprPtrVariant;
+  auto foldConditionalExpr(const AST::ConditionalExprPtr& expr)
+      -> AST::ExprPtrVariant;
+  auto foldLogicalExpr(const AST::LogicalExprPtr& expr)
+      -> AST::ExprPtrVariant;
+  auto foldVariableExpr(const AST::VariableExprPtr& expr)
+      -> AST::ExprPtrVariant;
+
+  // The value of expr if it is a folded literal, otherwise nullptr.
+  auto valueOf(const AST::ExprPtrVariant& expr) const -> const LoxObject*;
+  auto makeLiteral(uint32_t constant) -> AST::ExprPtrVariant;
+  auto makeLiteral(LoxObject value) -> AST::ExprPtrVariant;
+
+  AST::Arena& arena;
+  ConstantPool& constants;
+  // Variables that are assigned, read into, or declared more than once; their
+  // value isn't known at any given use.
+  std::unordered_set<std::string_view> unfoldable;
+  // Variables declared so far whose value is known: the constant they hold.
+  std::unordered_map<std::string_view, uint32_t> knownVariables;
+};
+
+}  // namespace cpplox::Evaluator
+
+#endif  // CPPLOX_EVALUATOR_CONSTANTFOLDER_H
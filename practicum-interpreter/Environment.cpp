@@ -1,12 +1,10 @@
 #include "Environment.h"
 
 #include <cstddef>
-#include <memory>
+#include <iostream>
 #include <string>
 #include <utility>
-#include <variant>
 
-#include "DebugPrint.h"
 #include "RuntimeError.h"
 
 #define EXPECT_TRUE(x) __builtin_expect(static_cast<int64_t>(x), 1)
@@ -14,164 +12,96 @@
 
 namespace cpplox::Evaluator {
 
-namespace {
-class UndefinedVarAccess : public std::exception {};
-class UninitializedVarAccess : public std::exception {};
-}  // namespace
-
-// ================= //
-// class Environment
-// ================= //
-Environment::Environment(EnvironmentPtr parentEnviron)
-    : parentEnviron(std::move(parentEnviron)) {}
-
-auto Environment::assign(size_t hashedVarName, LoxObject object) -> bool {
-  auto iter = objects.find(hashedVarName);
-  if (iter != objects.end()) {
-    objects.insert_or_assign(hashedVarName, object);
-    objects_T.insert_or_assign(hashedVarName, object.index());
-    return true;
-  }
-  if (EXPECT_TRUE(parentEnviron != nullptr))
-    return parentEnviron->assign(hashedVarName, std::move(object));
+Environment::Environment(ErrorReporter& p_eReporter)
+    : eReporter(p_eReporter) {}
 
-  throw UndefinedVarAccess();
+auto Environment::definedSlot(uint32_t slot, const Types::Token& varToken,
+                              const char* message) -> Slot& {
+  if (EXPECT_FALSE(slot >= slots.size()
+                   || slots[slot].type == DeclaredType::UNDEFINED))
+    throw ErrorsAndDebug::reportRuntimeError(eReporter, varToken, message);
+  return slots[slot];
 }
 
-void Environment::define(size_t hashedVarName, LoxObject object, size_t t) {
-  objects.insert_or_assign(hashedVarName, object);
-  objects_T.insert_or_assign(hashedVarName, t);
+void Environment::define(uint32_t slot, LoxObject object,
+                         DeclaredType type) {
+  if (slot >= slots.size()) slots.resize(slot + 1);
+  slots[slot].value = converted(type, std::move(object));
+  slots[slot].type = type;
 }
 
-auto Environment::get(size_t hashedVarName) -> LoxObject {
-  auto iter = objects.find(hashedVarName);
-  if (EXPECT_TRUE(iter != objects.end())) {
-    if (EXPECT_FALSE(std::holds_alternative<std::nullptr_t>(iter->second)))
-      throw UninitializedVarAccess();
-    return iter->second;
-  }
-  if (EXPECT_TRUE(parentEnviron != nullptr))
-    return parentEnviron->get(hashedVarName);
-
-  throw UndefinedVarAccess();  // throws only in the Global Environ
-}
-
-auto Environment::get_T(size_t hashedVarName) -> size_t {
-  auto iter = objects.find(hashedVarName);
-  if (EXPECT_TRUE(iter != objects.end())) {
-    return objects_T.find(hashedVarName)->second;
-  }
-  if (EXPECT_TRUE(parentEnviron != nullptr))
-    return parentEnviron->get_T(hashedVarName);
-
-  throw UndefinedVarAccess();  // throws only in the Global Environ
+void Environment::assign(uint32_t slot, const Types::Token& varToken,
+                         LoxObject object) {
+  Slot& target
+      = definedSlot(slot, varToken, "Can't assign to an undefined variable.");
+  if (EXPECT_TRUE(storesAsIs(target.type, object)))
+    target.value = std::move(object);
+  else
+    target.value = converted(target.type, std::move(object));
 }
 
-auto Environment::isGlobal() -> bool { return (parentEnviron == nullptr); }
-
-auto Environment::getParentEnv() -> EnvironmentPtr { return parentEnviron; }
-
-// ======================== //
-// class EnvironmentManager
-// ======================== //
-EnvironmentManager::EnvironmentManager(ErrorReporter& eReporter)
-    : eReporter(eReporter),
-      currEnviron(std::make_shared<Environment>(nullptr)) {
-#ifdef ENVIRON_DEBUG
-  ErrorsAndDebug::debugPrint(
-      "EnvironmentManager is now alive! Global Envrion = "
-      + std::to_string((uint64_t)currEnviron.get()));
-#endif
+auto Environment::append(uint32_t slot, LoxObject& left,
+                         const LoxObject& right) -> bool {
+  if (!left.isString() || slot >= slots.size()) return false;
+  Slot& target = slots[slot];
+  if (!target.value.isString()
+      || &target.value.asLoxString() != &left.asLoxString())
+    return false;
+  left = nullptr;
+  appendTo(target.value, right);
+  return true;
 }
 
-void EnvironmentManager::createNewEnviron(const std::string& caller) {
-  currEnviron = std::make_shared<Environment>(currEnviron);
-#ifdef ENVIRON_DEBUG
-  ErrorsAndDebug::debugPrint(caller + " requested new environ: "
-                             + std::to_string((uint64_t)currEnviron.get())
-                             + ".");
-#endif
-}
-
-void EnvironmentManager::discardEnvironsTill(
-    const Environment::EnvironmentPtr& environToRestore,
-    const std::string& caller) {
-#ifdef ENVIRON_DEBUG
-  ErrorsAndDebug::debugPrint("discardEnvironsTill( "
-                             + std::to_string((uint64_t)environToRestore.get())
-                             + " ) called by " + caller + ". CurrEnviron: "
-                             + std::to_string((uint64_t)currEnviron.get())
-                             + ".");
-#endif
-  // Global environment should only be destroyed when the Environment Manager
-  // goes away.
-  while (EXPECT_TRUE(!currEnviron->isGlobal()
-                     && currEnviron.get() != environToRestore.get())) {
-#ifdef ENVIRON_DEBUG
-    ErrorsAndDebug::debugPrint("Discarding environ "
-                               + std::to_string((uint64_t)currEnviron.get())
-                               + ".");
-#endif
-    currEnviron = currEnviron->getParentEnv();
-  }
-}
-
-void EnvironmentManager::define(const std::string& tokenStr, LoxObject object, size_t t) {
-  currEnviron->define(hasher(tokenStr), std::move(object), t);
+auto Environment::get(uint32_t slot, const Types::Token& varToken)
+    -> const LoxObject& {
+  const Slot& source = definedSlot(
+      slot, varToken, "Attempted to access an undefined variable.");
+  if (EXPECT_FALSE(source.value.isNil()))
+    throw ErrorsAndDebug::reportRuntimeError(
+        eReporter, varToken, "Attempted to access an uninitialized variable.");
+  return source.value;
 }
 
-void EnvironmentManager::define(const Types::Token& varToken,
-                                LoxObject object, size_t t) {
-  currEnviron->define(hasher(varToken.getLexeme()), std::move(object), t);
+auto Environment::get_T(uint32_t slot, const Types::Token& varToken)
+    -> DeclaredType {
+  return definedSlot(slot, varToken,
+                     "Attempted to access an undefined variable.")
+      .type;
 }
 
-void EnvironmentManager::assign(const Types::Token& varToken,
-                                LoxObject object) {
-  try {
-    currEnviron->assign(hasher(varToken.getLexeme()), std::move(object));
-  } catch (const UndefinedVarAccess& e) {
-    throw ErrorsAndDebug::reportRuntimeError(
-        eReporter, varToken, "Can't assign to an undefined variable.");
-  }
+auto Environment::slotData(size_t count) -> Slot* {
+  if (slots.size() < count) slots.resize(count);
+  return slots.data();
 }
 
-auto EnvironmentManager::get(const Types::Token& varToken) -> LoxObject {
-  try {
-    return currEnviron->get(hasher(varToken.getLexeme()));
-  } catch (const UndefinedVarAccess& e) {
-    throw ErrorsAndDebug::reportRuntimeError(
-        eReporter, varToken, "Attempted to access an undefined variable.");
-  } catch (const UninitializedVarAccess& e) {
-    throw ErrorsAndDebug::reportRuntimeError(
-        eReporter, varToken, "Attempted to access an uninitialized variable.");
-  }
+void Environment::undefineFrom(size_t first) {
+  for (size_t slot = first; slot < slots.size(); ++slot) slots[slot] = Slot();
 }
 
-auto EnvironmentManager::get_T(const Types::Token& varToken) -> size_t {
-  try {
-    return currEnviron->get_T(hasher(varToken.getLexeme()));
-  } catch (const UndefinedVarAccess& e) {
-    throw ErrorsAndDebug::reportRuntimeError(
-        eReporter, varToken, "Attempted to access an undefined variable.");
-  } catch (const UninitializedVarAccess& e) {
-    throw ErrorsAndDebug::reportRuntimeError(
-        eReporter, varToken, "Attempted to access an uninitialized variable.");
+void Environment::read(uint32_t slot, const Types::Token& varToken) {
+  const DeclaredType type = get_T(slot, varToken);
+  if (type == DeclaredType::INT) {
+    int64_t input = 0;  // left as is once std::cin has failed
+    std::cin >> input;
+    assign(slot, varToken, input);
+  } else if (type == DeclaredType::REAL) {
+    double input = 0.0;
+    std::cin >> input;
+    assign(slot, varToken, input);
+  } else {
+    std::string input;
+    std::cin >> input;
+    assign(slot, varToken, input);
   }
 }
 
-auto EnvironmentManager::getCurrEnv() -> Environment::EnvironmentPtr {
-  return currEnviron;
-}
-
-void EnvironmentManager::setCurrEnv(Environment::EnvironmentPtr newCurr,
-                                    const std::string& caller) {
-#ifdef ENVIRON_DEBUG
-  ErrorsAndDebug::debugPrint(
-      caller + " requested setting currEnviron to: "
-      + std::to_string((uint64_t)newCurr.get())
-      + ". CurrEnviron: " + std::to_string((uint64_t)currEnviron.get()) + ".");
-#endif
-  currEnviron = std::move(newCurr);
+auto Environment::converted(DeclaredType type, LoxObject object)
+    -> LoxObject {
+  if (type == DeclaredType::INT && object.isNumber())
+    return truncateToInt(object.asNumber());
+  if (type == DeclaredType::REAL && object.isInt())
+    return static_cast<double>(object.asInt());
+  return object;
 }
 
 }  // namespace cpplox::Evaluator
@@ -3,11 +3,8 @@
 #pragma once
 
 #include <cstddef>
-#include <exception>
-#include <list>
-#include <map>
-#include <memory>
-#include <optional>
+#include <cstdint>
+#include <vector>
 
 #include "ErrorReporter.h"
 #include "Objects.h"
@@ -17,50 +14,101 @@
 namespace cpplox::Evaluator {
 using ErrorsAndDebug::ErrorReporter;
 
-// Do not use the Environment directly. Use the EnvironmentManager class below
-// instead to manage it.
-class Environment : public Types::Uncopyable,
-                    std::enable_shared_from_this<Environment> {
- public:
-  using EnvironmentPtr = std::shared_ptr<Environment>;
+// The types variables are declared with. ANY is for the VMs' constant and
+// temporary slots, which nothing declares: they store every value as is.
+enum class DeclaredType : uint8_t { STRING, REAL, INT, ANY, UNDEFINED };
 
-  explicit Environment(EnvironmentPtr parentEnviron);
+// Declared types against LoxObject::index(). objectIndex() is the index of
+// the values a variable of `type` holds (besides nil), only for STRING, REAL
+// and INT; declaredTypeOf() goes back, and gives ANY for bool and nil.
+constexpr auto objectIndex(DeclaredType type) -> size_t {
+  switch (type) {
+    case DeclaredType::STRING: return 0;
+    case DeclaredType::REAL: return 1;
+    case DeclaredType::INT: return 4;
+    default: return LoxObject::NUM_TYPES;
+  }
+}
+constexpr auto declaredTypeOf(size_t index) -> DeclaredType {
+  switch (index) {
+    case 0: return DeclaredType::STRING;
+    case 1: return DeclaredType::REAL;
+    case 4: return DeclaredType::INT;
+    default: return DeclaredType::ANY;
+  }
+}
+static_assert(declaredTypeOf(objectIndex(DeclaredType::STRING))
+                      == DeclaredType::STRING
+                  && declaredTypeOf(objectIndex(DeclaredType::REAL))
+                         == DeclaredType::REAL
+                  && declaredTypeOf(objectIndex(DeclaredType::INT))
+                         == DeclaredType::INT,
+              "objectIndex() and declaredTypeOf() have to agree");
 
-  auto assign(size_t hashedVarName, LoxObject object) -> bool;
-  void define(size_t hashedVarName, LoxObject object, size_t t = 3);
-  auto get(size_t hashedVarName) -> LoxObject;
-  auto get_T(size_t hashedVarName) -> size_t;
-  auto getParentEnv() -> EnvironmentPtr;
-  auto isGlobal() -> bool;
+// The values of the program's variables, kept in the slots the Resolver
+// numbered them with.
+//
+// Variables are only declared at the top of a program, so there is a single
+// scope and a slot is all it takes to find one. A slot nobody has defined yet
+// is empty; using it is an error, just like using an undeclared name. The
+// tokens passed in are only used to report those errors.
+class Environment : public Types::Uncopyable {
+ public:
+  explicit Environment(ErrorReporter& eReporter);
 
- private:
-  std::map<size_t, LoxObject> objects;
-  std::map<size_t, size_t> objects_T;
-  EnvironmentPtr parentEnviron = nullptr;
-};
+  // A variable keeps the type it is defined with. Whatever is stored in it
+  // goes through converted() for that type, and read() parses input as it.
+  void define(uint32_t slot, LoxObject object, DeclaredType type);
+  void assign(uint32_t slot, const Types::Token& varToken, LoxObject object);
+  // Finishes `x = x + right` for the variable x in `slot`, given `left`,
+  // what its x operand evaluated to: appendTo() on the variable, which is
+  // then the only one holding its string unless it has been copied. Returns
+  // false, leaving it to the caller, unless `left` is a string that the
+  // variable still holds.
+  auto append(uint32_t slot, LoxObject& left, const LoxObject& right) -> bool;
+  auto get(uint32_t slot, const Types::Token& varToken) -> const LoxObject&;
+  auto get_T(uint32_t slot, const Types::Token& varToken) -> DeclaredType;
+  // The value of a variable the TypeChecker proved defined and holding a
+  // value of its type, without checking either. Storing in it is left to
+  // the caller to do only with values of that type.
+  auto value(uint32_t slot) -> LoxObject& { return slots[slot].value; }
+  // Reads the next word of stdin into the variable, parsed as its type.
+  void read(uint32_t slot, const Types::Token& varToken);
 
-class EnvironmentManager : public Types::Uncopyable {
- public:
-  explicit EnvironmentManager(ErrorReporter& eReporter);
+  // What storing `object` in a variable of `type` stores: a real truncated
+  // for an int variable, an int made a real for a real one. Anything else
+  // is stored as it is.
+  static auto converted(DeclaredType type, LoxObject object) -> LoxObject;
+  // Whether converted() leaves `object` as it is, for a backend storing into
+  // a slot itself.
+  static auto storesAsIs(DeclaredType type, const LoxObject& object) -> bool {
+    return type == DeclaredType::INT ? !object.isNumber()
+                                     : type != DeclaredType::REAL
+                                           || !object.isInt();
+  }
+
+  struct Slot {
+    LoxObject value = nullptr;
+    DeclaredType type = DeclaredType::UNDEFINED;
+  };
 
-  void assign(const Types::Token& varToken, LoxObject object);
-  void createNewEnviron(const std::string& caller = __builtin_FUNCTION());
-  void discardEnvironsTill(const Environment::EnvironmentPtr& environToRestore,
-                           const std::string& caller = __builtin_FUNCTION());
-  void define(const std::string& tokenStr, LoxObject object, size_t t = 3);
-  void define(const Types::Token& varToken, LoxObject object, size_t t = 3);
-  auto get(const Types::Token& varToken) -> LoxObject;
-  auto get(const std::string& varToken) -> LoxObject;
-  auto get_T(const Types::Token& varToken) -> size_t;
-  auto get_T(const std::string& varToken) -> size_t; 
-  auto getCurrEnv() -> Environment::EnvironmentPtr;
-  void setCurrEnv(Environment::EnvironmentPtr newCurr,
-                  const std::string& caller = __builtin_FUNCTION());
+  // The slots themselves, at least `count` of them, for a backend that
+  // works on variables in place. Whatever it writes has to follow the rules
+  // above: an undefined slot holds nil. Slots no variable has been given yet
+  // may serve as scratch space, provided they are undefined again by the
+  // time the Resolver hands them out.
+  // The pointer is good until a slot past `count` gets defined.
+  auto slotData(size_t count) -> Slot*;
+  // Empties every slot from `first` on.
+  void undefineFrom(size_t first);
 
  private:
+  // Throws a RuntimeError unless the slot has been defined.
+  auto definedSlot(uint32_t slot, const Types::Token& varToken,
+                   const char* message) -> Slot&;
+
   ErrorReporter& eReporter;
-  Environment::EnvironmentPtr currEnviron;
-  std::hash<std::string> hasher;
+  std::vector<Slot> slots;
 };
 
 }  // namespace cpplox::Evaluator
@@ -5,21 +5,31 @@
 namespace cpplox::ErrorsAndDebug {
 
 void ErrorReporter::clearErrors() {
-  errorMessages.clear();
+  errors.clear();
   status = LoxStatus::OK;
 }
 
 auto ErrorReporter::getStatus() -> LoxStatus { return status; }
 
-void ErrorReporter::printToStdErr() {
-  for (auto& s : errorMessages) {
-    std::cerr << s << std::endl;
+void ErrorReporter::printToStdErr(const LineIndex& lines) {
+  for (auto& error : errors) {
+    SourceLocation location = lines.locate(error.offset);
+    std::cerr << "[Line " << location.line << ":" << location.column
+              << "] Error: " << error.message << std::endl;
   }
 }
 
-void ErrorReporter::setError(int line, const std::string& message) {
-  errorMessages.emplace_back("[Line " + std::to_string(line)
-                             + "] Error: " + message);
+void ErrorReporter::append(const ErrorReporter& other) {
+  errors.insert(errors.end(), other.errors.begin(), other.errors.end());
+  if (other.status != LoxStatus::OK) status = other.status;
+}
+
+auto ErrorReporter::getErrors() const -> const std::vector<Error>& {
+  return errors;
+}
+
+void ErrorReporter::setError(size_t offset, const std::string& message) {
+  errors.push_back({offset, message});
   status = LoxStatus::ERROR;
 }
 
@@ -2,22 +2,36 @@
 #define CPPLOX_ERRORSANDDEBUG_ERRORREPORTER_H
 #pragma once
 
+#include <cstddef>
 #include <string>
 #include <vector>
 
+#include "LineIndex.h"
+
 namespace cpplox::ErrorsAndDebug {
 
 enum struct LoxStatus { OK, ERROR };
 
+// Errors are recorded against the byte offset they occurred at; the offset is
+// only turned into a line and column once the errors are printed.
 class ErrorReporter {
  public:
+  struct Error {
+    size_t offset;
+    std::string message;
+    auto operator==(const Error&) const -> bool = default;
+  };
+
   void clearErrors();
   auto getStatus() -> LoxStatus;
-  void printToStdErr();
-  void setError(int line, const std::string& message);
+  void printToStdErr(const LineIndex& lines);
+  void setError(size_t offset, const std::string& message);
+  // Adds other's errors after the ones reported so far.
+  void append(const ErrorReporter& other);
+  [[nodiscard]] auto getErrors() const -> const std::vector<Error>&;
 
  private:
-  std::vector<std::string> errorMessages;
+  std::vector<Error> errors;
   LoxStatus status = LoxStatus::OK;
 };
 
@@ -17,74 +17,237 @@
 #include "Literal.h"
 #include "Token.h"
 #include "Environment.h"
+#include "TypeChecker.h"
 
 #define EXPECT_TRUE(x) __builtin_expect(static_cast<int64_t>(x), 1)
 #define EXPECT_FALSE(x) __builtin_expect(static_cast<int64_t>(x), 0)
 
 namespace cpplox::Evaluator {
 
-// throws RuntimeError if right isn't a double
-auto Evaluator::getDouble(const Token& token, const LoxObject& right)
-    -> double {
-  if (EXPECT_FALSE(!std::holds_alternative<double>(right)))
-    throw reportRuntimeError(
-        eReporter, token,
-        "Attempted to perform arithmetic operation on non-numeric literal "
-            + getObjectString(right));
-  return std::get<double>(right);
-}
-
-
 //===============================//
 // Expression Evaluation Methods //
 //===============================//
+namespace {
+using AST::BinarySpecialization;
+
+// The specialization for the operands a binary operator has just been
+// applied to, or GENERIC.
+auto specializationFor(TokenType op, const LoxObject& left,
+                       const LoxObject& right) -> BinarySpecialization {
+  if (double lhs, rhs; asReals(left, right, lhs, rhs)) {
+    switch (op) {
+      case TokenType::PLUS: return BinarySpecialization::NUMBER_ADD;
+      case TokenType::MINUS: return BinarySpecialization::NUMBER_SUBTRACT;
+      case TokenType::STAR: return BinarySpecialization::NUMBER_MULTIPLY;
+      case TokenType::SLASH: return BinarySpecialization::NUMBER_DIVIDE;
+      case TokenType::MOD: return BinarySpecialization::NUMBER_MODULO;
+      case TokenType::LESS: return BinarySpecialization::NUMBER_LESS;
+      case TokenType::LESS_EQUAL:
+        return BinarySpecialization::NUMBER_LESS_EQUAL;
+      case TokenType::GREATER: return BinarySpecialization::NUMBER_GREATER;
+      case TokenType::GREATER_EQUAL:
+        return BinarySpecialization::NUMBER_GREATER_EQUAL;
+      case TokenType::EQUAL_EQUAL: return BinarySpecialization::NUMBER_EQUAL;
+      case TokenType::BANG_EQUAL:
+        return BinarySpecialization::NUMBER_NOT_EQUAL;
+      default: return BinarySpecialization::GENERIC;
+    }
+  }
+  if (left.isSmallInt() && right.isSmallInt()) {
+    switch (op) {
+      case TokenType::PLUS: return BinarySpecialization::INT_ADD;
+      case TokenType::MINUS: return BinarySpecialization::INT_SUBTRACT;
+      case TokenType::STAR: return BinarySpecialization::INT_MULTIPLY;
+      case TokenType::SLASH: return BinarySpecialization::INT_DIVIDE;
+      case TokenType::MOD: return BinarySpecialization::INT_MODULO;
+      case TokenType::LESS: return BinarySpecialization::INT_LESS;
+      case TokenType::LESS_EQUAL: return BinarySpecialization::INT_LESS_EQUAL;
+      case TokenType::GREATER: return BinarySpecialization::INT_GREATER;
+      case TokenType::GREATER_EQUAL:
+        return BinarySpecialization::INT_GREATER_EQUAL;
+      case TokenType::EQUAL_EQUAL: return BinarySpecialization::INT_EQUAL;
+      case TokenType::BANG_EQUAL: return BinarySpecialization::INT_NOT_EQUAL;
+      default: return BinarySpecialization::GENERIC;
+    }
+  }
+  if (left.isString() && right.isString()) {
+    switch (op) {
+      case TokenType::PLUS: return BinarySpecialization::STRING_CONCAT;
+      case TokenType::EQUAL_EQUAL: return BinarySpecialization::STRING_EQUAL;
+      case TokenType::BANG_EQUAL:
+        return BinarySpecialization::STRING_NOT_EQUAL;
+      default: return BinarySpecialization::GENERIC;
+    }
+  }
+  return BinarySpecialization::GENERIC;
+}
+
+// The specialization for an operator the TypeChecker proved to have two
+// operands of `type`, a real or an int, or GENERIC.
+auto typedSpecializationFor(TokenType op, AST::StaticType type)
+    -> BinarySpecialization {
+  size_t offset = 0;
+  switch (op) {
+    case TokenType::PLUS: offset = 0; break;
+    case TokenType::MINUS: offset = 1; break;
+    case TokenType::STAR: offset = 2; break;
+    case TokenType::SLASH: offset = 3; break;
+    case TokenType::MOD: offset = 4; break;
+    case TokenType::LESS: offset = 5; break;
+    case TokenType::LESS_EQUAL: offset = 6; break;
+    case TokenType::GREATER: offset = 7; break;
+    case TokenType::GREATER_EQUAL: offset = 8; break;
+    case TokenType::EQUAL_EQUAL: offset = 9; break;
+    case TokenType::BANG_EQUAL: offset = 10; break;
+    default: return BinarySpecialization::GENERIC;
+  }
+  static_assert(static_cast<size_t>(BinarySpecialization::TYPED_INT_ADD)
+                    == static_cast<size_t>(BinarySpecialization::TYPED_REAL_ADD)
+                           + 11,
+                "The TYPED_ specializations come in the same order for each "
+                "type.");
+  const BinarySpecialization first = type == AST::StaticType::REAL
+                                         ? BinarySpecialization::TYPED_REAL_ADD
+                                         : BinarySpecialization::TYPED_INT_ADD;
+  return static_cast<BinarySpecialization>(static_cast<size_t>(first)
+                                           + offset);
+}
+}  // namespace
+
+// Each BinaryExpr starts out generic and, once evaluated, specializes itself
+// to the kind of operands it saw; a specialized node then only checks that
+// the operands are still of that kind. When they aren't, the node goes back
+// to the generic operator for good. Operands the TypeChecker proved to be
+// numbers of one type get a TYPED_ specialization, which checks nothing.
 auto Evaluator::evaluateBinaryExpr(const BinaryExprPtr& expr) -> LoxObject {
   auto left = evaluateExpr(expr->left);
   auto right = evaluateExpr(expr->right);
-  switch (expr->op.getType()) {
-    case TokenType::COMMA: return right;
-    case TokenType::BANG_EQUAL: return !areEqual(left, right);
-    case TokenType::EQUAL_EQUAL: return areEqual(left, right);
-    case TokenType::MINUS:
-      return getDouble(expr->op, left) - getDouble(expr->op, right);
-    case TokenType::SLASH: {
-      double denominator = getDouble(expr->op, right);
-      if (EXPECT_FALSE(denominator == 0.0))
-        throw reportRuntimeError(eReporter, expr->op,
-                                 "Division by zero is illegal");
-      return getDouble(expr->op, left) / denominator;
-    }
-    case TokenType::STAR:
-      return getDouble(expr->op, left) * getDouble(expr->op, right);
-    case TokenType::MOD:
-      return (double)((int)getDouble(expr->op, left) % (int)getDouble(expr->op, right));
-    case TokenType::LESS:
-      return getDouble(expr->op, left) < getDouble(expr->op, right);
-    case TokenType::LESS_EQUAL:
-      return getDouble(expr->op, left) <= getDouble(expr->op, right);
-    case TokenType::GREATER:
-      return getDouble(expr->op, left) > getDouble(expr->op, right);
-    case TokenType::GREATER_EQUAL:
-      return getDouble(expr->op, left) >= getDouble(expr->op, right);
-    case TokenType::PLUS: {
-      if (std::holds_alternative<double>(left)
-          && std::holds_alternative<double>(right)) {
-        return std::get<double>(left) + std::get<double>(right);
-      }
-      if (std::holds_alternative<std::string>(left)
-          || std::holds_alternative<std::string>(right)) {
-        return getObjectString(left) + getObjectString(right);
-      }
-      throw reportRuntimeError(
-          eReporter, expr->op,
-          "Operands to 'plus' must be numbers or strings; This is invalid: "
-              + getObjectString(left) + " + " + getObjectString(right));
+
+#define CPPLOX_SPECIALIZED(name, kind, result)                               \
+  case BinarySpecialization::name: {                                         \
+    if (EXPECT_TRUE(left.is##kind() && right.is##kind())) {                  \
+      [[maybe_unused]] const auto lhs = left.as##kind();                     \
+      [[maybe_unused]] const auto rhs = right.as##kind();                    \
+      return result;                                                         \
+    }                                                                        \
+    break;                                                                   \
+  }
+// Reals, with an int held inline promoted when it is mixed with one.
+#define CPPLOX_REAL_SPECIALIZED(name, result)                                \
+  case BinarySpecialization::name: {                                         \
+    if (double lhs, rhs; EXPECT_TRUE(asReals(left, right, lhs, rhs)))        \
+      return result;                                                         \
+    break;                                                                   \
+  }
+// Operands known to be `type`, taken as such.
+#define CPPLOX_TYPED(name, type, result)                                     \
+  case BinarySpecialization::name: {                                         \
+    [[maybe_unused]] const auto lhs = left.as##type();                       \
+    [[maybe_unused]] const auto rhs = right.as##type();                      \
+    return result;                                                           \
+  }
+  switch (expr->specialization) {
+    CPPLOX_TYPED(TYPED_REAL_ADD, Number, lhs + rhs)
+    CPPLOX_TYPED(TYPED_REAL_SUBTRACT, Number, lhs - rhs)
+    CPPLOX_TYPED(TYPED_REAL_MULTIPLY, Number, lhs * rhs)
+    CPPLOX_TYPED(TYPED_REAL_DIVIDE, Number,
+                 rhs != 0.0 ? lhs / rhs : applyBinaryExpr(expr, left, right))
+    CPPLOX_TYPED(TYPED_REAL_MODULO, Number,
+                 truncateToInt(rhs) != 0 ? realModulo(lhs, rhs)
+                                         : applyBinaryExpr(expr, left, right))
+    CPPLOX_TYPED(TYPED_REAL_LESS, Number, lhs < rhs)
+    CPPLOX_TYPED(TYPED_REAL_LESS_EQUAL, Number, lhs <= rhs)
+    CPPLOX_TYPED(TYPED_REAL_GREATER, Number, lhs > rhs)
+    CPPLOX_TYPED(TYPED_REAL_GREATER_EQUAL, Number, lhs >= rhs)
+    CPPLOX_TYPED(TYPED_REAL_EQUAL, Number, lhs == rhs)
+    CPPLOX_TYPED(TYPED_REAL_NOT_EQUAL, Number, lhs != rhs)
+    CPPLOX_TYPED(TYPED_INT_ADD, Int, wrappingAdd(lhs, rhs))
+    CPPLOX_TYPED(TYPED_INT_SUBTRACT, Int, wrappingSubtract(lhs, rhs))
+    CPPLOX_TYPED(TYPED_INT_MULTIPLY, Int, wrappingMultiply(lhs, rhs))
+    CPPLOX_TYPED(TYPED_INT_DIVIDE, Int,
+                 rhs != 0 ? LoxObject(intDivide(lhs, rhs))
+                          : applyBinaryExpr(expr, left, right))
+    CPPLOX_TYPED(TYPED_INT_MODULO, Int,
+                 rhs != 0 ? LoxObject(intModulo(lhs, rhs))
+                          : applyBinaryExpr(expr, left, right))
+    CPPLOX_TYPED(TYPED_INT_LESS, Int, lhs < rhs)
+    CPPLOX_TYPED(TYPED_INT_LESS_EQUAL, Int, lhs <= rhs)
+    CPPLOX_TYPED(TYPED_INT_GREATER, Int, lhs > rhs)
+    CPPLOX_TYPED(TYPED_INT_GREATER_EQUAL, Int, lhs >= rhs)
+    CPPLOX_TYPED(TYPED_INT_EQUAL, Int, lhs == rhs)
+    CPPLOX_TYPED(TYPED_INT_NOT_EQUAL, Int, lhs != rhs)
+    CPPLOX_REAL_SPECIALIZED(NUMBER_ADD, lhs + rhs)
+    CPPLOX_REAL_SPECIALIZED(NUMBER_SUBTRACT, lhs - rhs)
+    CPPLOX_REAL_SPECIALIZED(NUMBER_MULTIPLY, lhs * rhs)
+    CPPLOX_REAL_SPECIALIZED(NUMBER_DIVIDE,
+                            rhs != 0.0 ? lhs / rhs
+                                       : applyBinaryExpr(expr, left, right))
+    CPPLOX_REAL_SPECIALIZED(NUMBER_MODULO,
+                            truncateToInt(rhs) != 0
+                                ? realModulo(lhs, rhs)
+                                : applyBinaryExpr(expr, left, right))
+    CPPLOX_REAL_SPECIALIZED(NUMBER_LESS, lhs < rhs)
+    CPPLOX_REAL_SPECIALIZED(NUMBER_LESS_EQUAL, lhs <= rhs)
+    CPPLOX_REAL_SPECIALIZED(NUMBER_GREATER, lhs > rhs)
+    CPPLOX_REAL_SPECIALIZED(NUMBER_GREATER_EQUAL, lhs >= rhs)
+    CPPLOX_REAL_SPECIALIZED(NUMBER_EQUAL, lhs == rhs)
+    CPPLOX_REAL_SPECIALIZED(NUMBER_NOT_EQUAL, lhs != rhs)
+    // Only ints held inline: boxed ones are rare enough to leave generic.
+    CPPLOX_SPECIALIZED(INT_ADD, SmallInt, wrappingAdd(lhs, rhs))
+    CPPLOX_SPECIALIZED(INT_SUBTRACT, SmallInt, wrappingSubtract(lhs, rhs))
+    CPPLOX_SPECIALIZED(INT_MULTIPLY, SmallInt, wrappingMultiply(lhs, rhs))
+    CPPLOX_SPECIALIZED(INT_DIVIDE, SmallInt,
+                       rhs != 0 ? LoxObject(intDivide(lhs, rhs))
+                                : applyBinaryExpr(expr, left, right))
+    CPPLOX_SPECIALIZED(INT_MODULO, SmallInt,
+                       rhs != 0 ? LoxObject(intModulo(lhs, rhs))
+                                : applyBinaryExpr(expr, left, right))
+    CPPLOX_SPECIALIZED(INT_LESS, SmallInt, lhs < rhs)
+    CPPLOX_SPECIALIZED(INT_LESS_EQUAL, SmallInt, lhs <= rhs)
+    CPPLOX_SPECIALIZED(INT_GREATER, SmallInt, lhs > rhs)
+    CPPLOX_SPECIALIZED(INT_GREATER_EQUAL, SmallInt, lhs >= rhs)
+    CPPLOX_SPECIALIZED(INT_EQUAL, SmallInt, lhs == rhs)
+    CPPLOX_SPECIALIZED(INT_NOT_EQUAL, SmallInt, lhs != rhs)
+    CPPLOX_SPECIALIZED(STRING_CONCAT, String,
+                       LoxObject(LoxString::concat(left.asLoxString(),
+                                                   right.asLoxString())))
+    CPPLOX_SPECIALIZED(STRING_EQUAL, String,
+                       LoxString::equal(left.asLoxString(),
+                                        right.asLoxString()))
+    CPPLOX_SPECIALIZED(STRING_NOT_EQUAL, String,
+                       !LoxString::equal(left.asLoxString(),
+                                         right.asLoxString()))
+    case BinarySpecialization::UNINITIALIZED: {
+      LoxObject result = applyBinaryExpr(expr, left, right);
+      const AST::StaticType operands = AST::numericOperands(*expr);
+      expr->specialization
+          = operands != AST::StaticType::UNKNOWN
+                ? typedSpecializationFor(expr->op.getType(), operands)
+                : specializationFor(expr->op.getType(), left, right);
+      if (expr->specialization != BinarySpecialization::GENERIC)
+        ++numSpecialized;
+      return result;
     }
-    default:
-      throw reportRuntimeError(
-          eReporter, expr->op,
-          "Attempted to apply invalid operator to binary expr: "
-              + expr->op.getTypeString());
+    case BinarySpecialization::GENERIC:
+      return applyBinaryExpr(expr, left, right);
+  }
+#undef CPPLOX_TYPED
+#undef CPPLOX_REAL_SPECIALIZED
+#undef CPPLOX_SPECIALIZED
+
+  // The operands aren't what the node was specialized for.
+  expr->specialization = BinarySpecialization::GENERIC;
+  ++numDeoptimized;
+  return applyBinaryExpr(expr, left, right);
+}
+
+auto Evaluator::applyBinaryExpr(const BinaryExprPtr& expr,
+                                const LoxObject& left, const LoxObject& right)
+    -> LoxObject {
+  try {
+    return applyBinary(expr->op, left, right);
+  } catch (const OperatorError& e) {
+    throw reportRuntimeError(eReporter, expr->op, e.what());
   }
 }
 
@@ -92,36 +255,22 @@ auto Evaluator::evaluateGroupingExpr(const GroupingExprPtr& expr) -> LoxObject {
   return evaluateExpr(expr->expression);
 }
 
-namespace {
-auto getLoxObjectfromStringLiteral(const Literal& strLiteral) -> LoxObject {
-  const auto& str = std::get<std::string>(strLiteral);
-  if (str == "true") return LoxObject(true);
-  if (str == "false") return LoxObject(false);
-  if (str == "nil") return LoxObject(nullptr);
-  return LoxObject(str);
-};
-}  // namespace
-
 auto Evaluator::evaluateLiteralExpr(const LiteralExprPtr& expr) -> LoxObject {
-  return expr->literalVal.has_value()
-             ? std::holds_alternative<std::string>(expr->literalVal.value())
-                   ? getLoxObjectfromStringLiteral(expr->literalVal.value())
-                   : LoxObject(std::get<double>(expr->literalVal.value()))
-             : LoxObject(nullptr);
+  if (EXPECT_TRUE(expr->constant != AST::LiteralExpr::NO_CONSTANT))
+    return constants[expr->constant];
+  return toLoxObject(expr->literalVal);  // not folded
 }
 
 auto Evaluator::evaluateUnaryExpr(const UnaryExprPtr& expr) -> LoxObject {
   LoxObject right = evaluateExpr(expr->right);
-  switch (expr->op.getType()) {
-    case TokenType::BANG: return !isTrue(right);
-    case TokenType::MINUS: return -getDouble(expr->op, right);
-    case TokenType::PLUS_PLUS: return getDouble(expr->op, right) + 1;
-    case TokenType::MINUS_MINUS: return getDouble(expr->op, right) - 1;
-    default:
-      throw reportRuntimeError(
-          eReporter, expr->op,
-          "Illegal unary expression: " + expr->op.getLexeme()
-              + getObjectString(right));
+  // A `-` the TypeChecker proved to negate a number of the type.
+  if (expr->type == AST::StaticType::INT)
+    return wrappingNegate(right.asInt());
+  if (expr->type == AST::StaticType::REAL) return -right.asNumber();
+  try {
+    return applyUnary(expr->op, right);
+  } catch (const OperatorError& e) {
+    throw reportRuntimeError(eReporter, expr->op, e.what());
   }
 }
 
@@ -133,13 +282,27 @@ auto Evaluator::evaluateConditionalExpr(const ConditionalExprPtr& expr)
 }
 
 auto Evaluator::evaluateVariableExpr(const VariableExprPtr& expr) -> LoxObject {
-  return environManager.get(expr->varName);
+  if (expr->type != AST::StaticType::UNKNOWN)
+    return environment.value(expr->slot);
+  return environment.get(expr->slot, expr->varName);
 }
 
 auto Evaluator::evaluateAssignmentExpr(const AssignmentExprPtr& expr)
     -> LoxObject {
-  environManager.assign(expr->varName, evaluateExpr(expr->right));
-  return environManager.get(expr->varName);
+  if (const BinaryExprPtr append = expr->selfAppend) {
+    LoxObject left = evaluateExpr(append->left);
+    const LoxObject right = evaluateExpr(append->right);
+    if (!environment.append(expr->slot, left, right))
+      environment.assign(expr->slot, expr->varName,
+                         applyBinaryExpr(append, left, right));
+  } else if (expr->type != AST::StaticType::UNKNOWN
+             && AST::typeOf(expr->right) == expr->type) {
+    // A value of the variable's own type, which is stored as it is.
+    return environment.value(expr->slot) = evaluateExpr(expr->right);
+  } else {
+    environment.assign(expr->slot, expr->varName, evaluateExpr(expr->right));
+  }
+  return environment.get(expr->slot, expr->varName);
 }
 
 auto Evaluator::evaluateLogicalExpr(const LogicalExprPtr& expr) -> LoxObject {
@@ -150,7 +313,8 @@ auto Evaluator::evaluateLogicalExpr(const LogicalExprPtr& expr) -> LoxObject {
     return !isTrue(leftVal) ? leftVal : evaluateExpr(expr->right);
 
   throw reportRuntimeError(eReporter, expr->op,
-                           "Illegal logical operator: " + expr->op.getLexeme());
+                           "Illegal logical operator: "
+                               + std::string(expr->op.getLexeme()));
 }
 
 auto Evaluator::evaluateExpr(const ExprPtrVariant& expr) -> LoxObject {
@@ -205,7 +369,7 @@ auto Evaluator::evaluateWriteStmt(const WriteStmtPtr& stmt)
 
   for (const auto &expr : stmt->expressions) {
     LoxObject objectToPrint = evaluateExpr(expr);
-    std::cout << getObjectString(objectToPrint) << " ";
+    std::cout << objectToPrint << " ";
   } std::cout << std::endl;
 
 #ifdef EVAL_DEBUG
@@ -217,51 +381,23 @@ auto Evaluator::evaluateWriteStmt(const WriteStmtPtr& stmt)
 
 auto Evaluator::evaluateReadStmt(const ReadStmtPtr& stmt)
     -> std::optional<LoxObject> {
-  try {
-    auto _id = environManager.get_T(stmt->varName);
-    if (_id == 0) {
-        std::string input;
-        std::cin >> input;
-        environManager.assign(stmt->varName, input);
-    } else if (_id == 1) {
-        double input;
-        std::cin >> input;
-        environManager.assign(stmt->varName, input);
-    } else if (_id == 2) {
-        std::string input;
-        std::cin >> input;
-        environManager.assign(stmt->varName, (input == "true") 
-                                             ? (true) 
-                                             : ((input == "false")
-                                               ? (false)
-                                               : throw reportRuntimeError(eReporter,
-                                                 stmt->varName, "Expected 'true' or 'false'")));
-    }
-  } catch(...) {
-    std::string input;
-    std::cin >> input;
-    environManager.assign(stmt->varName, input);
-  }
-
+  environment.read(stmt->slot, stmt->varName);
   return std::nullopt;
 }
 
 auto Evaluator::evaluateBlockStmt(const BlockStmtPtr& stmt)
     -> std::optional<LoxObject> {
-  auto currEnviron = environManager.getCurrEnv();
-  environManager.createNewEnviron();
-  std::optional<LoxObject> result = evaluateStmts(stmt->statements);
-  environManager.discardEnvironsTill(currEnviron);
-  return result;
+  // Blocks can't declare variables, so they don't need an environment.
+  return evaluateStmts(stmt->statements);
 }
 
 auto Evaluator::evaluateIntStmt(const IntStmtPtr& stmt)
     -> std::optional<LoxObject> {
   if (stmt->initializer.has_value()) {
-    environManager.define(stmt->varName,
-                          evaluateExpr(stmt->initializer.value()), 1);
+    environment.define(stmt->slot, evaluateExpr(stmt->initializer.value()),
+                       DeclaredType::INT);
   } else {
-    environManager.define(stmt->varName, LoxObject(nullptr), 1);
+    environment.define(stmt->slot, LoxObject(nullptr), DeclaredType::INT);
   }
   return std::nullopt;
 }
@@ -269,10 +405,10 @@ auto Evaluator::evaluateIntStmt(const IntStmtPtr& stmt)
 auto Evaluator::evaluateRealStmt(const RealStmtPtr& stmt)
     -> std::optional<LoxObject> {
   if (stmt->initializer.has_value()) {
-    environManager.define(stmt->varName,
-                          evaluateExpr(stmt->initializer.value()), 1);
+    environment.define(stmt->slot, evaluateExpr(stmt->initializer.value()),
+                       DeclaredType::REAL);
   } else {
-    environManager.define(stmt->varName, LoxObject(nullptr), 1);
+    environment.define(stmt->slot, LoxObject(nullptr), DeclaredType::REAL);
   }
   return std::nullopt;
 }
@@ -280,10 +416,10 @@ auto Evaluator::evaluateRealStmt(const RealStmtPtr& stmt)
 auto Evaluator::evaluateStrStmt(const StrStmtPtr& stmt)
     -> std::optional<LoxObject> {
   if (stmt->initializer.has_value()) {
-    environManager.define(stmt->varName,
-                          evaluateExpr(stmt->initializer.value()), 0);
+    environment.define(stmt->slot, evaluateExpr(stmt->initializer.value()),
+                       DeclaredType::STRING);
   } else {
-    environManager.define(stmt->varName, LoxObject(nullptr), 0);
+    environment.define(stmt->slot, LoxObject(nullptr), DeclaredType::STRING);
   }
   return std::nullopt;
 }
@@ -331,7 +467,7 @@ auto Evaluator::evaluateForStmt(const ForStmtPtr& stmt)
 }
 
 auto Evaluator::evaluateBreakStmt(const BreakStmtPtr& stmt) -> std::optional<LoxObject> {
-  throw BreakException(stmt->name.getLine());
+  throw BreakException(stmt->name.getOffset());
 }
 
 auto Evaluator::evaluateStmt(const AST::StmtPtrVariant& stmt)
@@ -368,7 +504,7 @@ auto Evaluator::evaluateStmt(const AST::StmtPtrVariant& stmt)
   }
 }
 
-auto Evaluator::evaluateStmts(const std::vector<AST::StmtPtrVariant>& stmts)
+auto Evaluator::evaluateStmts(AST::StmtList stmts)
     -> std::optional<LoxObject> {
   std::optional<LoxObject> result = std::nullopt;
   for (const AST::StmtPtrVariant& stmt : stmts) {
@@ -378,17 +514,21 @@ auto Evaluator::evaluateStmts(const std::vector<AST::StmtPtrVariant>& stmts)
         break;
     } catch (const ErrorsAndDebug::RuntimeError& e) {
       ErrorsAndDebug::debugPrint("Caught unhandled exception.");
-      if (EXPECT_FALSE(++numRunTimeErr > MAX_RUNTIME_ERR)) {
-        std::cerr << "Too many errors occurred. Exiting evaluation."
-                  << std::endl;
-        throw e;
-      }
+      if (EXPECT_FALSE(!recoverFromRuntimeError())) throw e;
     }
   }
   return result;
 }
 
-Evaluator::Evaluator(ErrorReporter& eReporter)
-    : eReporter(eReporter), environManager(eReporter) {} 
+void Evaluator::run(const AST::Program& program) {
+  evaluateStmts(program.statements);
+#ifdef PERF_DEBUG
+  std::cout << "Binary expressions specialized: " << numSpecialized
+            << ", deoptimized: " << numDeoptimized << std::endl;
+#endif  // PERF_DEBUG
+}
+
+Evaluator::Evaluator(ErrorReporter& eReporter, const ConstantPool& constants)
+    : eReporter(eReporter), environment(eReporter), constants(constants) {}
 
 }  // namespace cpplox::Evaluator
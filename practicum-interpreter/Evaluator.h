@@ -2,11 +2,13 @@
 #define CPPLOX_EVALUATOR_EVALUATOR__H
 #pragma once
 
+#include <cstddef>
 #include <exception>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include "Backend.h"
 #include "NodeTypes.h"
 #include "ErrorReporter.h"
 #include "Environment.h"
@@ -46,20 +48,26 @@ using Types::TokenType;
 
 using ErrorsAndDebug::ErrorReporter;
 
-class Evaluator {
+// The tree-walking backend.
+class Evaluator final : public Backend {
  public:
-  explicit Evaluator(ErrorReporter& eReporter);
+  // `constants` holds the values of the literals the ConstantFolder prepared.
+  Evaluator(ErrorReporter& eReporter, const ConstantPool& constants);
+  void run(const AST::Program& program) override;
   auto evaluateExpr(const ExprPtrVariant& expr) -> LoxObject;
   auto evaluateStmt(const AST::StmtPtrVariant& stmt)
       -> std::optional<LoxObject>;
-  auto evaluateStmts(const std::vector<AST::StmtPtrVariant>& stmts)
+  auto evaluateStmts(AST::StmtList stmts)
       -> std::optional<LoxObject>;
 
  private:
   // evaluation functions for Expr types
   auto evaluateBinaryExpr(const BinaryExprPtr& expr) -> LoxObject;
+  // The operator, unspecialized.
+  auto applyBinaryExpr(const BinaryExprPtr& expr, const LoxObject& left,
+                       const LoxObject& right) -> LoxObject;
   auto evaluateGroupingExpr(const GroupingExprPtr& expr) -> LoxObject;
-  static auto evaluateLiteralExpr(const LiteralExprPtr& expr) -> LoxObject;
+  auto evaluateLiteralExpr(const LiteralExprPtr& expr) -> LoxObject;
   auto evaluateUnaryExpr(const UnaryExprPtr& expr) -> LoxObject;
   auto evaluateConditionalExpr(const ConditionalExprPtr& expr) -> LoxObject;
   auto evaluateVariableExpr(const VariableExprPtr& expr) -> LoxObject;
@@ -79,14 +87,13 @@ class Evaluator {
   auto evaluateForStmt(const ForStmtPtr& stmt) -> std::optional<LoxObject>;
   auto evaluateBreakStmt(const BreakStmtPtr& stmt) -> std::optional<LoxObject>;
 
-  // throws RuntimeError if right isn't a double
-  auto getDouble(const Token& token, const LoxObject& right) -> double;
-
   ErrorReporter& eReporter;
-  EnvironmentManager environManager;
-
-  static const int MAX_RUNTIME_ERR = 20;
-  int numRunTimeErr = 0;
+  Environment environment;
+  const ConstantPool& constants;
+  // How many BinaryExprs have specialized themselves to their operands, and
+  // how many of those have since gone back to the generic operator.
+  size_t numSpecialized = 0;
+  size_t numDeoptimized = 0;
 };
 
 }  // namespace cpplox::Evaluator
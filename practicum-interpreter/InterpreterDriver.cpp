@@ -1,50 +1,74 @@
 #include "InterpreterDriver.h"
 
+#include <fcntl.h>
+#include <unistd.h>
+
 #include <chrono>
 #include <exception>
-#include <fstream>
+#include <functional>
 #include <iostream>
 #include <iterator>
 #include <optional>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <utility>
 
 #include "PrettyPrinter.h"
+#include "CEmitter.h"
+#include "ClosureEvaluator.h"
+#include "ConstantFolder.h"
 #include "DebugPrint.h"
+#include "Evaluator.h"
 #include "RuntimeError.h"
+#include "ParallelScanner.h"
 #include "Parser.h"
+#include "RegisterVM.h"
 #include "Scanner.h"
+#include "StackVM.h"
+#include "StreamingScanner.h"
 #include "Token.h"
+#include "TokenBuffer.h"
+#include "TokenSource.h"
 
 namespace cpplox {
 
 using ErrorsAndDebug::debugPrint;
 using ErrorsAndDebug::ErrorReporter;
+using ErrorsAndDebug::LineIndex;
 using ErrorsAndDebug::LoxStatus;
 using ErrorsAndDebug::RuntimeError;
 using Parser::RDParser;
-using Types::Token;
+using Parser::TokenSource;
+using Types::TokenBuffer;
 using Types::TokenType;
 
 const int EXIT_DATAERR = 65;
 const int EXIT_SOFTWARE = 70;
 
 auto InterpreterDriver::runScript(const char* const scriptFile) -> int {
-  const auto source = ([&]() -> std::string {
-    try {
-      std::ifstream in(scriptFile, std::ios::in);
-      in.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-      return std::string{std::istreambuf_iterator<char>{in},
-                         std::istreambuf_iterator<char>{}};
-    } catch (std::exception& e) {
-      debugPrint("Couldn't open Input source file.");
-      return "";
-    }
-  })();
+  std::optional<SourceBuffer> source = SourceBuffer::fromFile(scriptFile);
+
+  if (!source.has_value() || source->view().empty()) return EXIT_DATAERR;
+
+  this->interpret(std::move(source.value()));
+
+  if (hadError) return EXIT_DATAERR;
+  if (hadRunTimeError) return EXIT_SOFTWARE;
+  return 0;
+}
 
-  if (source.empty()) return EXIT_DATAERR;
+auto InterpreterDriver::runStream(const char* const scriptFile) -> int {
+  const bool fromStdin = std::string_view(scriptFile) == "-";
+  const int fd
+      = fromStdin ? STDIN_FILENO : ::open(scriptFile, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    debugPrint("Couldn't open Input source file.");
+    return EXIT_DATAERR;
+  }
 
-  this->interpret(source);
+  this->interpretStream(fd);
+  if (!fromStdin) ::close(fd);
 
   if (hadError) return EXIT_DATAERR;
   if (hadRunTimeError) return EXIT_SOFTWARE;
@@ -55,7 +79,7 @@ void InterpreterDriver::runREPL() {
   std::string line;
 
   while (std::cout << "> " && std::getline(std::cin, line)) {
-    this->interpret(line);
+    this->interpret(SourceBuffer(std::move(line)));
     hadError = false;
     hadRunTimeError = false;
   }
@@ -65,90 +89,181 @@ namespace {
 
 class InterpreterError : std::exception {};
 
-auto scan(const std::string& source) -> std::vector<Token> {
+#ifdef PERF_DEBUG
+// Prints how long the enclosing scope took.
+class PerfTimer {
+ public:
+  explicit PerfTimer(const char* p_what)
+      : what(p_what), startTime(std::chrono::high_resolution_clock::now()) {}
+  ~PerfTimer() {
+    std::cout << what << " took: "
+              << static_cast<double>(
+                     std::chrono::duration_cast<std::chrono::microseconds>(
+                         std::chrono::high_resolution_clock::now() - startTime)
+                         .count())
+              << " us" << std::endl;
+  }
+  PerfTimer(const PerfTimer&) = delete;
+  auto operator=(const PerfTimer&) -> PerfTimer& = delete;
+
+ private:
+  const char* what;
+  std::chrono::high_resolution_clock::time_point startTime;
+};
+#endif  // PERF_DEBUG
+
+auto scan(std::string_view source, const LineIndex& lines) -> TokenBuffer {
+#ifdef PERF_DEBUG
+  PerfTimer timer("Scanning");
+#endif  // PERF_DEBUG
   ErrorReporter eReporter;
-  Scanner scanner(source, eReporter);
+  ParallelScanner scanner(source, eReporter);
 
-  std::vector<Token> tokensVec = scanner.tokenize();
+  TokenBuffer tokens = scanner.tokenize();
 
   if (eReporter.getStatus() != LoxStatus::OK) {
-    eReporter.printToStdErr();
+    eReporter.printToStdErr(lines);
     throw InterpreterError();
   }
+#ifdef PERF_DEBUG
+  std::cout << "Token buffer: " << tokens.size() << " tokens, "
+            << tokens.memoryUsage() << " bytes" << std::endl;
+#endif  // PERF_DEBUG
 #ifdef SCANNER_DEBUG
   debugPrint("Here are the tokens the scanner recognized:");
-  for (auto& token : tokensVec) debugPrint(token.toString());
+  for (size_t i = 0; i < tokens.size(); ++i)
+    debugPrint(tokens.token(i).toString());
 #endif  // SCANNER_DEBUG
 
-  return tokensVec;
+  return tokens;
 }
 
-auto parse(const std::vector<Token>& tokenVec)
-    -> std::vector<AST::StmtPtrVariant> {
+// Parses whatever `tokens` yields. If scanErrors is given, the tokens are
+// being scanned as the parser pulls them; scanner errors then take precedence
+// over the parse errors they are likely to have caused.
+auto parse(TokenSource& tokens, const LineIndex& lines,
+           ErrorReporter* scanErrors = nullptr) -> AST::Program {
+#ifdef PERF_DEBUG
+  PerfTimer timer(scanErrors != nullptr ? "Scanning and parsing" : "Parsing");
+#endif  // PERF_DEBUG
   ErrorReporter eReporter;
-  RDParser parser(tokenVec, eReporter);
+  AST::Program program;
+  RDParser parser(tokens, program.arena, eReporter);
 
-  std::vector<AST::StmtPtrVariant> statements = parser.parse();
+  program.statements = parser.parse();
+
+  if (scanErrors != nullptr) {
+    // The parser may have given up before the scanner got to the end; finish
+    // scanning so a later scan error is still reported ahead of parse errors.
+    if (eReporter.getStatus() != LoxStatus::OK) {
+      while (tokens.type() != TokenType::LOX_EOF) tokens.advance();
+    }
+    if (scanErrors->getStatus() != LoxStatus::OK) {
+      scanErrors->printToStdErr(lines);
+      throw InterpreterError();
+    }
+  }
 
   if (eReporter.getStatus() != LoxStatus::OK) {
-    eReporter.printToStdErr();
+    eReporter.printToStdErr(lines);
     throw InterpreterError();
   }
 
 #ifdef PARSER_DEBUG
-  if (!statements.empty()) {
+  if (!program.statements.empty()) {
     debugPrint("Here's the AST that was generated:");
-    for (const auto& str : AST::PrettyPrinter::toString(statements))
+    for (const auto& str : AST::PrettyPrinter::toString(program.statements))
       debugPrint(str);
   } else {
     debugPrint("Parser returned no valid statements.");
   }
 #endif  // PARSER_DEBUG
+#ifdef PERF_DEBUG
+  std::cout << "AST arena: " << program.arena.bytesReserved() << " bytes"
+            << std::endl;
+#endif  // PERF_DEBUG
+
+  return program;
+}
+
+// Gets a parsed program ready for evaluation.
+void foldConstants(AST::Program& program, Evaluator::ConstantPool& constants) {
+#ifdef PERF_DEBUG
+  PerfTimer timer("Constant folding");
+#endif  // PERF_DEBUG
+  Evaluator::ConstantFolder(program.arena, constants).fold(program);
+
+#ifdef PARSER_DEBUG
+  debugPrint("Here's the AST after constant folding:");
+  for (const auto& str : AST::PrettyPrinter::toString(program.statements))
+    debugPrint(str);
+#endif  // PARSER_DEBUG
+}
 
-  return statements;
+// Rejects a resolved program with type errors, and annotates it for the
+// backend otherwise.
+void typeCheck(AST::Program& program, AST::TypeChecker& typeChecker,
+               size_t numSlots, const LineIndex& lines) {
+#ifdef PERF_DEBUG
+  PerfTimer timer("Type checking");
+#endif  // PERF_DEBUG
+  ErrorReporter eReporter;
+  if (!typeChecker.check(program, numSlots, eReporter)) {
+    eReporter.printToStdErr(lines);
+    throw InterpreterError();
+  }
 }
 
 }  // namespace
 
-void InterpreterDriver::interpret(const std::string& source) {
+void InterpreterDriver::interpret(SourceBuffer p_source) {
+  const std::string_view source
+      = sources.emplace_back(std::move(p_source)).view();
+  const LineIndex lines(source);
+  interpret(
+      [source, &lines]() {
+        TokenBuffer tokens = scan(source, lines);
+        Parser::BufferTokenSource tokenSource(tokens);
+        return parse(tokenSource, lines);
+      },
+      lines);
+}
+
+void InterpreterDriver::interpretStream(int fd) {
+  LexemeStore& lexemes = streamedLexemes.emplace_back();
+  LineIndex lines;
+  interpret(
+      [fd, &lexemes, &lines]() {
+        // The parser pulls tokens straight from the scanner, so only the
+        // current chunk and the parser's lookahead are ever buffered.
+        ErrorReporter scanErrors;
+        StreamingScanner scanner(fd, lexemes, lines, scanErrors);
+        Parser::ScannerTokenSource tokenSource(scanner);
+        return parse(tokenSource, lines, &scanErrors);
+      },
+      lines);
+}
+
+void InterpreterDriver::interpret(
+    const std::function<AST::Program()>& frontEnd,
+    const LineIndex& sourceLines) {
   try {
     eReporter.clearErrors();
     // Store all syntactically correct statements so we can ensure that
     // references held by the Evaluator (functions, classes) are live.
     // Also permits us reconstruct evaluator state if need be.
+    lines.emplace_back(frontEnd());
+    foldConstants(lines.back(), constants);
+    resolver.resolve(lines.back());
+    typeCheck(lines.back(), typeChecker, resolver.numSlots(), sourceLines);
+    {
 #ifdef PERF_DEBUG
-    auto scanStartTime = std::chrono::high_resolution_clock::now();
-    auto tokens = scan(source);
-    auto parseStartTime = std::chrono::high_resolution_clock::now();
-    lines.emplace_back(parse(tokens));
-    auto evalStartTime = std::chrono::high_resolution_clock::now();
-    evaluator.evaluateStmts(lines.back());
-    auto evalEndTime = std::chrono::high_resolution_clock::now();
-
-    std::cout << "Scanning took: "
-              << static_cast<double>(
-                     std::chrono::duration_cast<std::chrono::microseconds>(
-                         parseStartTime - scanStartTime)
-                         .count())
-              << " us" << std::endl;
-    std::cout << "Parsing took: "
-              << static_cast<double>(
-                     std::chrono::duration_cast<std::chrono::microseconds>(
-                         evalStartTime - parseStartTime)
-                         .count())
-              << " us" << std::endl;
-    std::cout << "Evaluation took: "
-              << static_cast<double>(
-                     std::chrono::duration_cast<std::chrono::microseconds>(
-                         evalEndTime - evalStartTime)
-                         .count())
-              << " us" << std::endl;
-#else
-    lines.emplace_back(parse(scan(source)));
-    evaluator.evaluateStmts(lines.back());
+      PerfTimer timer("Evaluation");
 #endif  // PERF_DEBUG
+      backend->run(lines.back());
+    }
     if (eReporter.getStatus() != LoxStatus::OK) {
-      eReporter.printToStdErr();
+      eReporter.printToStdErr(sourceLines);
     }
 
   } catch (const InterpreterError& e) {
@@ -157,15 +272,58 @@ void InterpreterDriver::interpret(const std::string& source) {
   } catch (const ErrorsAndDebug::RuntimeError& e) {
     hadRunTimeError = true;
     if (eReporter.getStatus() != LoxStatus::OK) {
-      eReporter.printToStdErr();
+      eReporter.printToStdErr(sourceLines);
     }
     return;
   } catch (const BreakException& e) {
-    eReporter.setError(e.line, "Got break statement out of loop");
-    eReporter.printToStdErr();
+    eReporter.setError(e.offset, "Got break statement out of loop");
+    eReporter.printToStdErr(sourceLines);
   }
 }
 
-InterpreterDriver::InterpreterDriver() : eReporter(), evaluator(eReporter) {}
+auto InterpreterDriver::emitC(const char* const scriptFile) -> int {
+  std::optional<SourceBuffer> source = SourceBuffer::fromFile(scriptFile);
+
+  if (!source.has_value() || source->view().empty()) return EXIT_DATAERR;
+
+  const std::string_view view
+      = sources.emplace_back(std::move(source.value())).view();
+  const LineIndex sourceLines(view);
+  try {
+    TokenBuffer tokens = scan(view, sourceLines);
+    Parser::BufferTokenSource tokenSource(tokens);
+    lines.emplace_back(parse(tokenSource, sourceLines));
+    foldConstants(lines.back(), constants);
+    resolver.resolve(lines.back());
+    typeCheck(lines.back(), typeChecker, resolver.numSlots(), sourceLines);
+  } catch (const InterpreterError& e) {
+    return EXIT_DATAERR;
+  }
+  AOT::CEmitter(constants, sourceLines).emit(lines.back(), std::cout);
+  return 0;
+}
+
+namespace {
+auto makeBackend(BackendKind kind, bool useJit, ErrorReporter& eReporter,
+                 Evaluator::ConstantPool& constants)
+    -> std::unique_ptr<Evaluator::Backend> {
+  switch (kind) {
+    case BackendKind::CLOSURES:
+      return std::make_unique<Evaluator::ClosureEvaluator>(eReporter,
+                                                           constants);
+    case BackendKind::STACK_VM:
+      return std::make_unique<VM::StackVM>(eReporter, constants);
+    case BackendKind::REGISTER_VM:
+      return std::make_unique<VM::RegisterVM>(eReporter, constants, useJit);
+    case BackendKind::TREE_WALKER: break;
+  }
+  return std::make_unique<Evaluator::Evaluator>(eReporter, constants);
+}
+}  // namespace
+
+InterpreterDriver::InterpreterDriver(BackendKind backendKind, bool useJit)
+    : eReporter(),
+      backend(makeBackend(backendKind, useJit, eReporter, constants)),
+      typeChecker(constants) {}
 
 }  // namespace cpplox
@@ -2,28 +2,69 @@
 #define CPPLOX_INTERPRETERDRIVER_INTERPRETERDRIVER_H
 #pragma once
 
+#include <deque>
+#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "NodeTypes.h"
 #include "ErrorReporter.h"
-#include "Evaluator.h"
+#include "LineIndex.h"
+#include "Backend.h"
+#include "Objects.h"
+#include "Resolver.h"
+#include "SourceBuffer.h"
+#include "StreamingScanner.h"
+#include "TypeChecker.h"
 
 namespace cpplox {
 
+// What runs the programs: the tree-walking Evaluator, the ClosureEvaluator
+// that compiles the tree into bound function pointers, or one of the VMs
+// that compile it to instructions.
+enum class BackendKind { TREE_WALKER, CLOSURES, STACK_VM, REGISTER_VM };
+
 struct InterpreterDriver {
  public:
-  InterpreterDriver();
+  // useJit lets the register VM compile hot loops to machine code, in a
+  // build that has the JIT.
+  explicit InterpreterDriver(BackendKind backendKind = BackendKind::TREE_WALKER,
+                             bool useJit = false);
   auto runScript(const char* script) -> int;
+  // Scans the script incrementally instead of loading it first; "-" reads
+  // the program from stdin.
+  auto runStream(const char* script) -> int;
   void runREPL();
+  // Compiles the script to a C program on stdout instead of running it.
+  auto emitC(const char* script) -> int;
 
  private:
-  void interpret(const std::string& source);
+  void interpret(SourceBuffer source);
+  void interpretStream(int fd);
+  // Runs frontEnd to scan and parse a program, then evaluates the result.
+  // sourceLines locates the program's errors.
+  void interpret(
+      const std::function<AST::Program()>& frontEnd,
+      const ErrorsAndDebug::LineIndex& sourceLines);
 
   ErrorsAndDebug::ErrorReporter eReporter;
-  Evaluator::Evaluator evaluator;
+  // The values of the literals of every program run, for the backend.
+  Evaluator::ConstantPool constants;
+  std::unique_ptr<Evaluator::Backend> backend;
+  // Numbers the variables of every program run, for the backend.
+  AST::Resolver resolver;
+  // Keeps the types the variables of every program run are declared with.
+  AST::TypeChecker typeChecker;
 
-  std::vector<std::vector<AST::StmtPtrVariant>> lines;
+  // Tokens and AST nodes hold views into the source they were scanned from,
+  // so every source buffer is kept alive alongside the programs in `lines`.
+  // A deque never relocates its elements, which keeps those views valid.
+  std::deque<SourceBuffer> sources;
+  // Streamed programs have no source buffer; their tokens view these instead.
+  std::deque<LexemeStore> streamedLexemes;
+  // Each program's arena owns its nodes; moving it doesn't move them.
+  std::vector<AST::Program> lines;
 
   bool hadError = false;
   bool hadRunTimeError = false;
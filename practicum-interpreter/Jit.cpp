@@ -0,0 +1,713 @@
+#include "Jit.h"
+
+#ifdef CPPLOX_JIT
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <bit>
+#include <cstring>
+#include <initializer_list>
+#include <optional>
+#include <utility>
+#include <variant>
+
+namespace cpplox::VM {
+
+// What a register holds, as far as the machine code knows. Reals are kept
+// as doubles, ints as int64_t and booleans as 0.0 or 1.0, each in 8 bytes.
+enum class JitType : uint8_t {
+  UNSET,  // nothing yet: a temporary, at the head of the loop
+  NUMBER,
+  INT,
+  BOOL,
+  UNKNOWN  // anything else, or different things along different paths
+};
+
+struct LoopJit::CompiledLoop {
+  using Code = auto (*)(double* frame, uint64_t* backEdges) -> uint32_t;
+
+  // Where the machine code hands back to the interpreter, and what the
+  // registers hold by then.
+  struct Exit {
+    uint32_t pc;
+    std::vector<JitType> types;
+  };
+
+  CompiledLoop() = default;
+  CompiledLoop(const CompiledLoop&) = delete;
+  auto operator=(const CompiledLoop&) -> CompiledLoop& = delete;
+  ~CompiledLoop() {
+    if (pages != nullptr) ::munmap(pages, size);
+  }
+
+  void* pages = nullptr;
+  size_t size = 0;
+  Code code = nullptr;
+  // The registers the code uses, each unboxed into frame[i] on entry, with
+  // what they held when the loop was compiled. Those that are `written` are
+  // boxed back into their slots on exit.
+  std::vector<uint32_t> registers;
+  std::vector<JitType> entryTypes;
+  // The types the variables were declared with, which decide what may be
+  // stored in them without converting.
+  std::vector<Evaluator::DeclaredType> declaredTypes;
+  std::vector<bool> written;
+  std::vector<Exit> exits;
+  std::vector<double> frame;
+  // To tell a loop that runs natively from one that exits straight away.
+  uint64_t entries = 0;
+  uint64_t iterations = 0;
+};
+
+namespace {
+constexpr uint32_t MAX_COMPILATIONS = 4;
+// A loop entered this often that didn't average two iterations a time is
+// left to the interpreter.
+constexpr uint64_t TRIAL_ENTRIES = 16;
+constexpr uint32_t NO_FRAME_INDEX = UINT32_MAX;
+
+auto join(JitType left, JitType right) -> JitType {
+  return left == right ? left : JitType::UNKNOWN;
+}
+
+auto isValue(JitType type) -> bool {
+  return type == JitType::NUMBER || type == JitType::INT
+         || type == JitType::BOOL;
+}
+
+auto isNumeric(JitType type) -> bool {
+  return type == JitType::NUMBER || type == JitType::INT;
+}
+
+// Ints that don't fit inline are left to the interpreter.
+auto typeOf(const LoxObject& value) -> JitType {
+  if (value.isNumber()) return JitType::NUMBER;
+  if (value.isSmallInt()) return JitType::INT;
+  if (value.isBool()) return JitType::BOOL;
+  return JitType::UNKNOWN;
+}
+
+// As Environment::storesAsIs(): storing a value of `type` into a variable
+// declared as `declared` takes no converting.
+auto storesAsIs(Evaluator::DeclaredType declared, JitType type) -> bool {
+  using Evaluator::DeclaredType;
+  return declared == DeclaredType::INT    ? type != JitType::NUMBER
+         : declared == DeclaredType::REAL ? type != JitType::INT
+                                          : true;
+}
+
+// The register operands of the instructions the JIT compiles.
+auto registersOf(const Instruction& in) -> std::vector<uint32_t> {
+  switch (in.op) {
+    case RegOp::MOVE:
+    case RegOp::NEGATE:
+    case RegOp::NOT: return {in.a, in.b};
+    case RegOp::ADD:
+    case RegOp::SUBTRACT:
+    case RegOp::MULTIPLY:
+    case RegOp::DIVIDE:
+    case RegOp::MODULO:
+    case RegOp::LESS:
+    case RegOp::LESS_EQUAL:
+    case RegOp::GREATER:
+    case RegOp::GREATER_EQUAL:
+    case RegOp::EQUAL:
+    case RegOp::NOT_EQUAL: return {in.a, in.b, in.c};
+    case RegOp::JUMP_IF_FALSE:
+    case RegOp::JUMP_IF_TRUE: return {in.b};
+    default: return {};
+  }
+}
+
+// ================ //
+// class Assembler
+// ================ //
+
+// x86 condition codes, as used by Jcc and SETcc.
+enum Condition : uint8_t {
+  CC_AE = 0x3,
+  CC_E = 0x4,
+  CC_NE = 0x5,
+  CC_A = 0x7,
+  CC_P = 0xA,
+  CC_NP = 0xB,
+  CC_L = 0xC,
+  CC_GE = 0xD,
+  CC_LE = 0xE,
+  CC_G = 0xF
+};
+
+// General purpose and XMM register numbers.
+constexpr uint8_t RAX = 0;
+constexpr uint8_t RCX = 1;
+constexpr uint8_t RDX = 2;
+constexpr uint8_t XMM0 = 0;
+constexpr uint8_t XMM1 = 1;
+
+// Encodes the few x86-64 instructions the templates are made of. Registers
+// of the loop are operands [rdi + 8 * index] into the frame of 8-byte values
+// the compiled code is passed.
+class Assembler {
+ public:
+  using Label = size_t;
+
+  auto newLabel() -> Label {
+    labels.push_back(UNBOUND);
+    return labels.size() - 1;
+  }
+  void bind(Label label) { labels[label] = bytes.size(); }
+
+  void bytesOf(std::initializer_list<uint8_t> encoded) {
+    bytes.insert(bytes.end(), encoded);
+  }
+
+  // SSE2: movsd load/store, cvtsi2sd, cvttsd2si.
+  void movsdLoad(uint8_t xmm, uint32_t index) {
+    frameOp({0xF2, 0x0F, 0x10}, xmm, index);
+  }
+  void movsdStore(uint32_t index, uint8_t xmm) {
+    frameOp({0xF2, 0x0F, 0x11}, xmm, index);
+  }
+  // xmm = the frame's real, or its int converted to one (cvtsi2sd).
+  void loadReal(uint8_t xmm, uint32_t index, JitType type) {
+    if (type == JitType::INT)
+      frameOp({0xF2, 0x48, 0x0F, 0x2A}, xmm, index);
+    else
+      movsdLoad(xmm, index);
+  }
+  void cvttsd2si(uint8_t reg, uint32_t index) {  // to 64 bits
+    frameOp({0xF2, 0x48, 0x0F, 0x2C}, reg, index);
+  }
+
+  // General purpose registers <-> frame, and the bit patterns of doubles.
+  void movLoad(uint8_t reg, uint32_t index) {
+    frameOp({0x48, 0x8B}, reg, index);
+  }
+  void movStore(uint32_t index, uint8_t reg) {
+    frameOp({0x48, 0x89}, reg, index);
+  }
+  void storeDouble(uint32_t index, double value) {
+    bytesOf({0x48, 0xB8});  // mov rax, imm64
+    immediate(std::bit_cast<uint64_t>(value), 8);
+    movStore(index, RAX);
+  }
+
+  // 64-bit integer add, sub, imul and cmp of rax and the frame.
+  void integer(std::initializer_list<uint8_t> opcode, uint32_t index) {
+    frameOp(opcode, RAX, index);
+  }
+  void cmpZero(uint32_t index) {  // cmp qword [frame], 0
+    frameOp({0x48, 0x83}, 7, index);
+    bytes.push_back(0);
+  }
+
+  // al = condition
+  void setAl(Condition condition) {
+    bytesOf({0x0F, static_cast<uint8_t>(0x90 | condition), 0xC0});
+  }
+  void setCl(Condition condition) {
+    bytesOf({0x0F, static_cast<uint8_t>(0x90 | condition), 0xC1});
+  }
+  // frame = al ? 1.0 : 0.0
+  void storeAl(uint32_t index) {
+    bytesOf({0x0F, 0xB6, 0xC0});        // movzx eax, al
+    bytesOf({0xF2, 0x0F, 0x2A, 0xC0});  // cvtsi2sd xmm0, eax
+    movsdStore(index, XMM0);
+  }
+
+  void jump(Label target) {
+    bytes.push_back(0xE9);
+    fixup(target);
+  }
+  void jumpIf(Condition condition, Label target) {
+    bytesOf({0x0F, static_cast<uint8_t>(0x80 | condition)});
+    fixup(target);
+  }
+  void returnValue(uint32_t value) {
+    bytes.push_back(0xB8);  // mov eax, imm32
+    immediate(value, 4);
+    bytes.push_back(0xC3);
+  }
+
+  // The code, with the jumps patched.
+  auto finish() -> std::vector<uint8_t> {
+    for (const auto& [at, label] : fixups) {
+      const auto rel = static_cast<int32_t>(labels[label] - (at + 4));
+      std::memcpy(&bytes[at], &rel, 4);
+    }
+    return std::move(bytes);
+  }
+
+ private:
+  static constexpr size_t UNBOUND = SIZE_MAX;
+
+  // opcode, then ModRM for [rdi + disp32] with `reg` in the reg field.
+  void frameOp(std::initializer_list<uint8_t> opcode, uint8_t reg,
+               uint32_t index) {
+    bytesOf(opcode);
+    bytes.push_back(static_cast<uint8_t>(0x87 | reg << 3));
+    immediate(8 * index, 4);
+  }
+  void immediate(uint64_t value, int size) {
+    for (int i = 0; i < size; ++i) bytes.push_back((value >> (8 * i)) & 0xFF);
+  }
+  void fixup(Label target) {
+    fixups.emplace_back(bytes.size(), target);
+    immediate(0, 4);
+  }
+
+  std::vector<uint8_t> bytes;
+  std::vector<size_t> labels;
+  std::vector<std::pair<size_t, Label>> fixups;
+};
+}  // namespace
+
+// ============== //
+// class LoopJit
+// ============== //
+LoopJit::LoopJit(const RegisterChunk& p_chunk)
+    : chunk(p_chunk), code(p_chunk.code), loops(p_chunk.code.size()) {
+  for (Instruction& in : code) in.op = untyped(in.op);
+}
+
+LoopJit::~LoopJit() = default;
+
+auto LoopJit::backEdge(uint32_t head, uint32_t jump, Slot* registers)
+    -> uint32_t {
+  LoopState& loop = loops[head];
+  if (loop.givenUp) return head;
+
+  bool matches = loop.compiled != nullptr;
+  if (matches) {
+    // The code is only good for the types it was compiled for.
+    const CompiledLoop& compiled = *loop.compiled;
+    for (size_t i = 0; i < compiled.registers.size() && matches; ++i) {
+      const uint32_t reg = compiled.registers[i];
+      if (chunk.isVariable(reg))
+        matches = registers[reg].type == compiled.declaredTypes[i]
+                  && typeOf(registers[reg].value) == compiled.entryTypes[i];
+    }
+  } else if (++loop.backEdges < HOT_LOOP) {
+    return head;
+  }
+  if (!matches) {
+    if (++loop.compilations > MAX_COMPILATIONS
+        || (loop.compiled = compile(head, jump, registers)) == nullptr) {
+      loop.givenUp = true;
+      loop.compiled.reset();
+      return head;
+    }
+  }
+
+  CompiledLoop& compiled = *loop.compiled;
+  const uint32_t pc = run(compiled, registers);
+  if (compiled.entries >= TRIAL_ENTRIES
+      && compiled.iterations < 2 * compiled.entries)
+    loop.givenUp = true;
+  return pc;
+}
+
+auto LoopJit::run(CompiledLoop& loop, Slot* registers) -> uint32_t {
+  for (size_t i = 0; i < loop.registers.size(); ++i) {
+    const LoxObject& value = registers[loop.registers[i]].value;
+    switch (loop.entryTypes[i]) {
+      case JitType::NUMBER: loop.frame[i] = value.asNumber(); break;
+      case JitType::INT:
+        loop.frame[i] = std::bit_cast<double>(value.asSmallInt());
+        break;
+      case JitType::BOOL: loop.frame[i] = value.asBool() ? 1 : 0; break;
+      default: loop.frame[i] = 0;
+    }
+  }
+  uint64_t backEdges = 0;
+  const CompiledLoop::Exit& exit
+      = loop.exits[loop.code(loop.frame.data(), &backEdges)];
+  for (size_t i = 0; i < loop.registers.size(); ++i) {
+    if (!loop.written[i]) continue;
+    Slot& slot = registers[loop.registers[i]];
+    if (exit.types[i] == JitType::NUMBER)
+      slot.value = loop.frame[i];
+    else if (exit.types[i] == JitType::INT)
+      slot.value = std::bit_cast<int64_t>(loop.frame[i]);
+    else if (exit.types[i] == JitType::BOOL)
+      slot.value = loop.frame[i] != 0;
+  }
+  ++loop.entries;
+  loop.iterations += backEdges;
+  return exit.pc;
+}
+
+auto LoopJit::compile(uint32_t head, uint32_t jump, const Slot* registers)
+    -> std::unique_ptr<CompiledLoop> {
+  const auto inLoop = [head, jump](uint32_t pc) {
+    return head <= pc && pc <= jump;
+  };
+  auto loop = std::make_unique<CompiledLoop>();
+
+  // The frame: every register an instruction of the loop names, typed as
+  // it is now. Temporaries are dead at the head of a loop.
+  std::vector<uint32_t> frameIndex(chunk.numRegisters, NO_FRAME_INDEX);
+  for (uint32_t pc = head; pc <= jump; ++pc) {
+    for (uint32_t reg : registersOf(code[pc])) {
+      if (frameIndex[reg] != NO_FRAME_INDEX) continue;
+      frameIndex[reg] = static_cast<uint32_t>(loop->registers.size());
+      loop->registers.push_back(reg);
+      if (chunk.isVariable(reg)
+          && registers[reg].type == Evaluator::DeclaredType::UNDEFINED)
+        return nullptr;  // using it is an error
+      const bool isTemporary
+          = reg >= chunk.numVariables + chunk.constants.size();
+      loop->entryTypes.push_back(isTemporary ? JitType::UNSET
+                                             : typeOf(registers[reg].value));
+      loop->declaredTypes.push_back(registers[reg].type);
+    }
+  }
+  const size_t frameSize = loop->registers.size();
+  loop->written.assign(frameSize, false);
+  loop->frame.resize(frameSize);
+
+  using State = std::vector<JitType>;
+  // Runs `in` over the types in `state`. False if the JIT doesn't compile
+  // the instruction for those types: it is an exit.
+  // Storing what the variable's declared type would convert is one too.
+  const auto step = [&frameIndex, &loop](const Instruction& in,
+                                         State& state) {
+    const auto type = [&](uint32_t reg) -> JitType& {
+      return state[frameIndex[reg]];
+    };
+    const auto store = [&](uint32_t reg, JitType stored) {
+      if (!storesAsIs(loop->declaredTypes[frameIndex[reg]], stored))
+        return false;
+      type(reg) = stored;
+      return true;
+    };
+    switch (in.op) {
+      case RegOp::MOVE:
+        return isValue(type(in.b)) && store(in.a, type(in.b));
+      case RegOp::ADD:
+      case RegOp::SUBTRACT:
+      case RegOp::MULTIPLY:
+      case RegOp::DIVIDE:
+      case RegOp::MODULO:
+      case RegOp::LESS:
+      case RegOp::LESS_EQUAL:
+      case RegOp::GREATER:
+      case RegOp::GREATER_EQUAL: {
+        // An int mixed with a real is promoted to one.
+        if (!isNumeric(type(in.b)) || !isNumeric(type(in.c))) return false;
+        const bool isArithmetic = in.op <= RegOp::MODULO;
+        return store(in.a, !isArithmetic ? JitType::BOOL
+                           : type(in.b) == JitType::INT ? type(in.c)
+                                                        : JitType::NUMBER);
+      }
+      case RegOp::EQUAL:
+      case RegOp::NOT_EQUAL:
+        if (!isValue(type(in.b)) || !isValue(type(in.c))) return false;
+        type(in.a) = JitType::BOOL;
+        return true;
+      case RegOp::NEGATE:
+        return isNumeric(type(in.b)) && store(in.a, type(in.b));
+      case RegOp::NOT:
+        if (!isValue(type(in.b))) return false;
+        type(in.a) = JitType::BOOL;
+        return true;
+      case RegOp::JUMP: return true;
+      case RegOp::JUMP_IF_FALSE:
+      case RegOp::JUMP_IF_TRUE: return isValue(type(in.b));
+      default: return false;
+    }
+  };
+  // Where control goes after `in` at `pc`. A number is always true.
+  const auto successors = [&](uint32_t pc, const Instruction& in,
+                              const State& state) -> std::vector<uint32_t> {
+    switch (in.op) {
+      case RegOp::JUMP: return {in.a};
+      case RegOp::JUMP_IF_FALSE:
+      case RegOp::JUMP_IF_TRUE:
+        if (isNumeric(state[frameIndex[in.b]]))
+          return {in.op == RegOp::JUMP_IF_TRUE ? in.a : pc + 1};
+        return {pc + 1, in.a};
+      default: return {pc + 1};
+    }
+  };
+
+  // The types before each instruction, where it can be reached at all.
+  std::vector<std::optional<State>> before(jump - head + 1);
+  before[0] = loop->entryTypes;
+  std::vector<uint32_t> worklist{head};
+  while (!worklist.empty()) {
+    const uint32_t pc = worklist.back();
+    worklist.pop_back();
+    const Instruction& in = code[pc];
+    State state = *before[pc - head];
+    if (!step(in, state)) continue;
+    for (uint32_t next : successors(pc, in, state)) {
+      if (!inLoop(next)) continue;
+      std::optional<State>& known = before[next - head];
+      if (!known.has_value()) {
+        known = state;
+        worklist.push_back(next);
+        continue;
+      }
+      bool changed = false;
+      for (size_t i = 0; i < frameSize; ++i) {
+        const JitType joined = join((*known)[i], state[i]);
+        changed = changed || joined != (*known)[i];
+        (*known)[i] = joined;
+      }
+      if (changed) worklist.push_back(next);
+    }
+  }
+  // Every instruction with registers but a jump writes its first.
+  for (uint32_t pc = head; pc <= jump; ++pc) {
+    const Instruction& in = code[pc];
+    State state;
+    if (before[pc - head].has_value()) state = *before[pc - head];
+    if (state.empty() || !step(in, state) || in.op == RegOp::JUMP_IF_FALSE
+        || in.op == RegOp::JUMP_IF_TRUE || in.op == RegOp::JUMP)
+      continue;
+    loop->written[frameIndex[in.a]] = true;
+  }
+
+  // Code generation: one template per instruction.
+  Assembler assembler;
+  std::vector<Assembler::Label> labels(jump - head + 1);
+  for (Assembler::Label& label : labels) label = assembler.newLabel();
+  std::vector<Assembler::Label> exitLabels;
+  bool boxable = true;
+  const auto exitTo = [&](uint32_t pc, const State& state) {
+    // A variable has to be boxed back whatever path was taken to get here.
+    for (size_t i = 0; i < frameSize; ++i) {
+      if (loop->written[i] && chunk.isVariable(loop->registers[i])
+          && !isValue(state[i]))
+        boxable = false;
+    }
+    loop->exits.push_back({pc, state});
+    exitLabels.push_back(assembler.newLabel());
+    return exitLabels.back();
+  };
+  const auto target = [&](uint32_t pc, const State& state) {
+    return inLoop(pc) ? labels[pc - head] : exitTo(pc, state);
+  };
+
+  // A loop whose first instruction exits would never get anywhere.
+  State first = loop->entryTypes;
+  if (!step(code[head], first)) return nullptr;
+  for (uint32_t pc = head; pc <= jump; ++pc) {
+    assembler.bind(labels[pc - head]);
+    if (!before[pc - head].has_value()) continue;
+    const State& state = *before[pc - head];
+    State after = state;
+    const Instruction& in = code[pc];
+    if (!step(in, after)) {
+      assembler.jump(exitTo(pc, state));
+      continue;
+    }
+    const auto frame = [&frameIndex](uint32_t reg) { return frameIndex[reg]; };
+    const auto typeAt = [&](uint32_t reg) { return state[frame(reg)]; };
+    const auto areInts = [&] {
+      return typeAt(in.b) == JitType::INT && typeAt(in.c) == JitType::INT;
+    };
+    // xmm0 and xmm1 = the operands as reals.
+    const auto loadReals = [&](uint32_t first, uint32_t second) {
+      assembler.loadReal(XMM0, frame(first), typeAt(first));
+      assembler.loadReal(XMM1, frame(second), typeAt(second));
+    };
+    switch (in.op) {
+      case RegOp::MOVE:
+        assembler.movLoad(RAX, frame(in.b));
+        assembler.movStore(frame(in.a), RAX);
+        break;
+      case RegOp::ADD:
+      case RegOp::SUBTRACT:
+      case RegOp::MULTIPLY: {
+        if (areInts()) {  // wrapping, as two's complement does
+          assembler.movLoad(RAX, frame(in.b));
+          if (in.op == RegOp::ADD)
+            assembler.integer({0x48, 0x03}, frame(in.c));  // add
+          else if (in.op == RegOp::SUBTRACT)
+            assembler.integer({0x48, 0x2B}, frame(in.c));  // sub
+          else
+            assembler.integer({0x48, 0x0F, 0xAF}, frame(in.c));  // imul
+          assembler.movStore(frame(in.a), RAX);
+          break;
+        }
+        const uint8_t opcode = in.op == RegOp::ADD        ? 0x58   // addsd
+                               : in.op == RegOp::SUBTRACT ? 0x5C   // subsd
+                                                          : 0x59;  // mulsd
+        loadReals(in.b, in.c);
+        assembler.bytesOf({0xF2, 0x0F, opcode, 0xC1});  // op xmm0, xmm1
+        assembler.movsdStore(frame(in.a), XMM0);
+        break;
+      }
+      case RegOp::DIVIDE:
+        if (areInts()) {
+          // Division by zero is reported by the interpreter, which also
+          // handles -1, the divisor idiv can trap on.
+          const Assembler::Label exit = exitTo(pc, state);
+          assembler.movLoad(RCX, frame(in.c));
+          assembler.bytesOf({0x48, 0x85, 0xC9});  // test rcx, rcx
+          assembler.jumpIf(CC_E, exit);
+          assembler.bytesOf({0x48, 0x83, 0xF9, 0xFF});  // cmp rcx, -1
+          assembler.jumpIf(CC_E, exit);
+          assembler.movLoad(RAX, frame(in.b));
+          assembler.bytesOf({0x48, 0x99, 0x48, 0xF7, 0xF9});  // cqo; idiv rcx
+          assembler.movStore(frame(in.a), RAX);
+          break;
+        }
+        // The interpreter reports division by zero (or NaN) itself.
+        loadReals(in.b, in.c);
+        assembler.bytesOf({0x66, 0x0F, 0x57, 0xD2});  // xorpd xmm2, xmm2
+        assembler.bytesOf({0x66, 0x0F, 0x2E, 0xCA});  // ucomisd xmm1, xmm2
+        assembler.jumpIf(CC_E, exitTo(pc, state));
+        assembler.bytesOf({0xF2, 0x0F, 0x5E, 0xC1});  // divsd xmm0, xmm1
+        assembler.movsdStore(frame(in.a), XMM0);
+        break;
+      case RegOp::MODULO: {
+        // Reals are truncated to int64_t first, as applyBinary() does;
+        // cvttsd2si gives INT64_MIN for those out of range, which are left
+        // to the interpreter along with a divisor of 0 or -1.
+        const Assembler::Label exit = exitTo(pc, state);
+        for (const auto& [reg, operand] : {std::pair{RAX, in.b}, {RCX, in.c}}) {
+          if (typeAt(operand) == JitType::INT) {
+            assembler.movLoad(reg, frame(operand));
+            continue;
+          }
+          assembler.cvttsd2si(reg, frame(operand));
+          assembler.bytesOf({0x48, 0xBA});  // mov rdx, INT64_MIN
+          assembler.bytesOf({0, 0, 0, 0, 0, 0, 0, 0x80});
+          // cmp rax, rdx / cmp rcx, rdx
+          assembler.bytesOf({0x48, 0x39, static_cast<uint8_t>(0xD0 | reg)});
+          assembler.jumpIf(CC_E, exit);
+        }
+        assembler.bytesOf({0x48, 0x85, 0xC9});  // test rcx, rcx
+        assembler.jumpIf(CC_E, exit);
+        assembler.bytesOf({0x48, 0x83, 0xF9, 0xFF});  // cmp rcx, -1
+        assembler.jumpIf(CC_E, exit);
+        assembler.bytesOf({0x48, 0x99, 0x48, 0xF7, 0xF9});  // cqo; idiv rcx
+        if (areInts()) {
+          assembler.movStore(frame(in.a), RDX);
+        } else {
+          assembler.bytesOf({0xF2, 0x48, 0x0F, 0x2A, 0xC2});  // cvtsi2sd
+          assembler.movsdStore(frame(in.a), XMM0);
+        }
+        break;
+      }
+      // ucomisd leaves CF and ZF set when either side is NaN, so `above`
+      // and `above or equal` are false then, as in C++; b < c is tested
+      // as c > b. Ints compare signed.
+      case RegOp::LESS:
+      case RegOp::LESS_EQUAL:
+      case RegOp::GREATER:
+      case RegOp::GREATER_EQUAL: {
+        const bool isLess
+            = in.op == RegOp::LESS || in.op == RegOp::LESS_EQUAL;
+        const bool orEqual
+            = in.op == RegOp::LESS_EQUAL || in.op == RegOp::GREATER_EQUAL;
+        if (areInts()) {
+          assembler.movLoad(RAX, frame(in.b));
+          assembler.integer({0x48, 0x3B}, frame(in.c));  // cmp
+          assembler.setAl(isLess ? (orEqual ? CC_LE : CC_L)
+                                 : (orEqual ? CC_GE : CC_G));
+        } else {
+          if (isLess)
+            loadReals(in.c, in.b);
+          else
+            loadReals(in.b, in.c);
+          assembler.bytesOf({0x66, 0x0F, 0x2E, 0xC1});  // ucomisd xmm0, xmm1
+          assembler.setAl(orEqual ? CC_AE : CC_A);
+        }
+        assembler.storeAl(frame(in.a));
+        break;
+      }
+      case RegOp::EQUAL:
+      case RegOp::NOT_EQUAL: {
+        const bool isEqual = in.op == RegOp::EQUAL;
+        const JitType left = typeAt(in.b);
+        const JitType right = typeAt(in.c);
+        if (left != right
+            && (left == JitType::BOOL || right == JitType::BOOL)) {
+          // A number is never equal to a boolean.
+          assembler.storeDouble(frame(in.a), isEqual ? 0 : 1);
+          break;
+        }
+        if (left == right && left != JitType::NUMBER) {  // the same bits
+          assembler.movLoad(RAX, frame(in.b));
+          assembler.integer({0x48, 0x3B}, frame(in.c));  // cmp
+          assembler.setAl(isEqual ? CC_E : CC_NE);
+          assembler.storeAl(frame(in.a));
+          break;
+        }
+        loadReals(in.b, in.c);
+        assembler.bytesOf({0x66, 0x0F, 0x2E, 0xC1});  // ucomisd xmm0, xmm1
+        assembler.setAl(isEqual ? CC_E : CC_NE);
+        assembler.setCl(isEqual ? CC_NP : CC_P);
+        // and al, cl / or al, cl
+        assembler.bytesOf({static_cast<uint8_t>(isEqual ? 0x20 : 0x08), 0xC8});
+        assembler.storeAl(frame(in.a));
+        break;
+      }
+      case RegOp::NEGATE:
+        assembler.movLoad(RAX, frame(in.b));
+        if (typeAt(in.b) == JitType::INT)
+          assembler.bytesOf({0x48, 0xF7, 0xD8});  // neg rax
+        else
+          assembler.bytesOf({0x48, 0x0F, 0xBA, 0xF8, 0x3F});  // btc rax, 63
+        assembler.movStore(frame(in.a), RAX);
+        break;
+      case RegOp::NOT:
+        if (isNumeric(typeAt(in.b))) {
+          assembler.storeDouble(frame(in.a), 0);
+          break;
+        }
+        assembler.cmpZero(frame(in.b));
+        assembler.setAl(CC_E);
+        assembler.storeAl(frame(in.a));
+        break;
+      case RegOp::JUMP:
+        if (pc == jump) {
+          assembler.bytesOf({0x48, 0xFF, 0x06});  // inc qword [rsi]
+          assembler.jump(labels[0]);
+        } else {
+          assembler.jump(target(in.a, state));
+        }
+        break;
+      case RegOp::JUMP_IF_FALSE:
+      case RegOp::JUMP_IF_TRUE: {
+        const bool onTrue = in.op == RegOp::JUMP_IF_TRUE;
+        if (isNumeric(typeAt(in.b))) {
+          if (onTrue) assembler.jump(target(in.a, state));
+          break;
+        }
+        assembler.cmpZero(frame(in.b));
+        assembler.jumpIf(onTrue ? CC_NE : CC_E, target(in.a, state));
+        break;
+      }
+      default: break;
+    }
+  }
+  for (size_t exit = 0; exit < exitLabels.size(); ++exit) {
+    assembler.bind(exitLabels[exit]);
+    assembler.returnValue(static_cast<uint32_t>(exit));
+  }
+  if (!boxable) return nullptr;
+
+  // Into pages of their own, which are made executable once written.
+  const std::vector<uint8_t> machineCode = assembler.finish();
+  const auto pageSize = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+  loop->size = (machineCode.size() + pageSize - 1) / pageSize * pageSize;
+  void* pages = ::mmap(nullptr, loop->size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (pages == MAP_FAILED) return nullptr;
+  loop->pages = pages;
+  std::memcpy(pages, machineCode.data(), machineCode.size());
+  if (::mprotect(pages, loop->size, PROT_READ | PROT_EXEC) != 0)
+    return nullptr;
+  loop->code = reinterpret_cast<CompiledLoop::Code>(pages);
+  return loop;
+}
+
+}  // namespace cpplox::VM
+
+#endif  // CPPLOX_JIT
@@ -0,0 +1,81 @@
+#ifndef CPPLOX_VM_JIT_H
+#define CPPLOX_VM_JIT_H
+#pragma once
+
+// The JIT is optional: `make JIT=1` defines CPPLOX_JIT. It emits x86-64 code
+// for the System V ABI and maps it with mmap(), so it is left out anywhere
+// but x86-64 Linux.
+#if defined(CPPLOX_JIT) && !(defined(__x86_64__) && defined(__linux__))
+#undef CPPLOX_JIT
+#endif
+
+#ifdef CPPLOX_JIT
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Environment.h"
+#include "RegisterCode.h"
+#include "Uncopyable.h"
+
+namespace cpplox::VM {
+
+// A baseline JIT for the RegisterVM's hot loops.
+//
+// The VM reports every backward jump (a loop's back edge). Once a loop has
+// gone round HOT_LOOP times, its instructions are translated one by one into
+// x86-64 machine code working on unboxed reals and ints, for the types its
+// registers hold right then, and the VM runs that code each time it gets to
+// the loop's head from then on.
+//
+// Only arithmetic, comparisons, moves and jumps on numbers and booleans are
+// compiled. Whatever else the loop holds (write, read, strings, operations
+// that would fail, such as division by zero, or storing a value its
+// variable's declared type converts) becomes an exit: the machine code
+// stores the registers back into their slots and the interpreter carries
+// on from that instruction. The next time round it re-enters the
+// compiled loop. A loop that keeps exiting straight away is given up on.
+class LoopJit : public Types::Uncopyable {
+ public:
+  using Slot = Evaluator::Environment::Slot;
+
+  // Back edges taken before a loop is compiled.
+  static constexpr uint32_t HOT_LOOP = 100;
+
+  explicit LoopJit(const RegisterChunk& chunk);
+  ~LoopJit() override;
+
+  // The interpreter is about to take the back edge at `jump` to the loop
+  // starting at `head`. Runs the loop's machine code if there is (or can now
+  // be) some, and returns the instruction the interpreter continues at:
+  // `head` if it didn't run.
+  auto backEdge(uint32_t head, uint32_t jump, Slot* registers) -> uint32_t;
+
+ private:
+  struct CompiledLoop;
+  struct LoopState {
+    uint32_t backEdges = 0;
+    uint32_t compilations = 0;
+    bool givenUp = false;
+    std::unique_ptr<CompiledLoop> compiled;
+  };
+
+  auto compile(uint32_t head, uint32_t jump, const Slot* registers)
+      -> std::unique_ptr<CompiledLoop>;
+  static auto run(CompiledLoop& loop, Slot* registers) -> uint32_t;
+
+  const RegisterChunk& chunk;
+  // The chunk's code with its _INT and _REAL operators made the ones they
+  // are versions of: the JIT works out the types for itself.
+  std::vector<Instruction> code;
+  // By the instruction index of the loop's head.
+  std::vector<LoopState> loops;
+};
+
+}  // namespace cpplox::VM
+
+#endif  // CPPLOX_JIT
+
+#endif  // CPPLOX_VM_JIT_H
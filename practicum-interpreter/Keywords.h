@@ -0,0 +1,123 @@
+#ifndef CPPLOX_SCANNER_KEYWORDS_H
+#define CPPLOX_SCANNER_KEYWORDS_H
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "Token.h"
+
+// Keyword recognition for the Scanner.
+//
+// Every identifier the Scanner sees has to be checked against the reserved
+// words. Instead of a std::map<std::string, TokenType> walk we hash the
+// identifier's length, first two and last byte into a small table whose
+// multiplier is searched for at compile time so that no two keywords share a
+// slot (i.e. the hash is perfect over the keyword set). A lookup is then one
+// table load plus at most one memcmp, and never allocates.
+
+namespace cpplox::Keywords {
+
+using Types::TokenType;
+
+struct Keyword {
+  std::string_view spelling;
+  TokenType type;
+};
+
+inline constexpr std::array<Keyword, 24> keywordList{{
+    {"and", TokenType::AND},       {"class", TokenType::CLASS},
+    {"else", TokenType::ELSE},     {"false", TokenType::LOX_FALSE},
+    {"fun", TokenType::FUN},       {"for", TokenType::FOR},
+    {"if", TokenType::IF},         {"nil", TokenType::NIL},
+    {"or", TokenType::OR},         {"print", TokenType::PRINT},
+    {"return", TokenType::RETURN}, {"super", TokenType::SUPER},
+    {"this", TokenType::THIS},     {"true", TokenType::LOX_TRUE},
+    {"var", TokenType::VAR},       {"while", TokenType::WHILE},
+    {"int", TokenType::INTW},      {"string", TokenType::STRINGW},
+    {"break", TokenType::BREAK},   {"continue", TokenType::CONTINUE},
+    {"real", TokenType::REALW},    {"program", TokenType::PROGRAM},
+    {"write", TokenType::WRITE},   {"read", TokenType::READ},
+}};
+
+inline constexpr size_t TABLE_SIZE = 64;  // must be a power of two
+inline constexpr size_t MIN_KEYWORD_LENGTH = 2;
+inline constexpr size_t MAX_KEYWORD_LENGTH = 8;
+
+namespace detail {
+
+// str.size() >= MIN_KEYWORD_LENGTH. The second byte is needed to tell "while"
+// and "write" apart.
+constexpr auto hash(std::string_view str, uint32_t seed) -> size_t {
+  uint32_t h = static_cast<uint8_t>(str[0]) * seed;
+  h ^= (static_cast<uint32_t>(static_cast<uint8_t>(str[1])) << 8)
+       + (static_cast<uint32_t>(static_cast<uint8_t>(str.back())) << 16)
+       + static_cast<uint32_t>(str.size());
+  h *= seed;
+  return (h >> 16) & (TABLE_SIZE - 1);
+}
+
+constexpr auto isPerfect(uint32_t seed) -> bool {
+  std::array<bool, TABLE_SIZE> used{};
+  for (const Keyword& keyword : keywordList) {
+    size_t slot = hash(keyword.spelling, seed);
+    if (used[slot]) return false;
+    used[slot] = true;
+  }
+  return true;
+}
+
+constexpr auto findSeed() -> uint32_t {
+  for (uint32_t seed = 0x9E3779B1u; seed != 0x9E3779B1u + 4096; seed += 2)
+    if (isPerfect(seed)) return seed;
+  return 0;
+}
+
+inline constexpr uint32_t SEED = findSeed();
+static_assert(SEED != 0,
+              "No perfect hash seed found; widen the search in findSeed() or "
+              "grow TABLE_SIZE.");
+
+constexpr auto buildTable() -> std::array<Keyword, TABLE_SIZE> {
+  std::array<Keyword, TABLE_SIZE> table{};
+  for (auto& entry : table) entry = {std::string_view(), TokenType::IDENTIFIER};
+  for (const Keyword& keyword : keywordList)
+    table[hash(keyword.spelling, SEED)] = keyword;
+  return table;
+}
+
+inline constexpr std::array<Keyword, TABLE_SIZE> table = buildTable();
+
+}  // namespace detail
+
+// Returns the keyword TokenType for str, or TokenType::IDENTIFIER.
+// str must be non-empty.
+constexpr auto reservedOrIdentifier(std::string_view str) -> TokenType {
+  if (str.size() < MIN_KEYWORD_LENGTH || str.size() > MAX_KEYWORD_LENGTH)
+    return TokenType::IDENTIFIER;
+  const Keyword& candidate = detail::table[detail::hash(str, detail::SEED)];
+  // string_view's operator== compares the lengths before doing the memcmp.
+  if (candidate.spelling == str) return candidate.type;
+  return TokenType::IDENTIFIER;
+}
+
+namespace detail {
+constexpr auto everyKeywordResolves() -> bool {
+  for (const Keyword& keyword : keywordList)
+    if (reservedOrIdentifier(keyword.spelling) != keyword.type) return false;
+  return true;
+}
+}  // namespace detail
+
+static_assert(detail::everyKeywordResolves());
+static_assert(reservedOrIdentifier("while") == TokenType::WHILE);
+static_assert(reservedOrIdentifier("for") == TokenType::FOR);
+static_assert(reservedOrIdentifier("fun") == TokenType::FUN);
+static_assert(reservedOrIdentifier("forx") == TokenType::IDENTIFIER);
+static_assert(reservedOrIdentifier("x") == TokenType::IDENTIFIER);
+
+}  // namespace cpplox::Keywords
+
+#endif  // CPPLOX_SCANNER_KEYWORDS_H
@@ -0,0 +1,38 @@
+#include "LineIndex.h"
+
+#include <algorithm>
+
+#include "ScanKernels.h"
+
+namespace cpplox::ErrorsAndDebug {
+
+LineIndex::LineIndex(std::string_view p_source) : unindexed(p_source) {}
+
+void LineIndex::addLine(int line, size_t offset) {
+  sparseLineStarts.push_back({offset, line});
+}
+
+auto LineIndex::locate(size_t offset) const -> SourceLocation {
+  if (!sparseLineStarts.empty()) {
+    auto lineStart = std::upper_bound(
+        sparseLineStarts.begin(), sparseLineStarts.end(), offset,
+        [](size_t at, const LineStart& start) { return at < start.offset; });
+    if (lineStart != sparseLineStarts.begin()) --lineStart;
+    return {lineStart->line,
+            static_cast<int>(offset - std::min(offset, lineStart->offset)) + 1};
+  }
+
+  if (!unindexed.empty()) {
+    ScanKernels::kernels().indexNewlines(
+        unindexed.data(), unindexed.data() + unindexed.size(), 0, lineStarts);
+    unindexed = {};
+  }
+
+  // The last line start at or before offset.
+  auto lineStart
+      = std::upper_bound(lineStarts.begin(), lineStarts.end(), offset) - 1;
+  return {static_cast<int>(lineStart - lineStarts.begin()) + 1,
+          static_cast<int>(offset - *lineStart) + 1};
+}
+
+}  // namespace cpplox::ErrorsAndDebug
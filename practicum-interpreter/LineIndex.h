@@ -0,0 +1,59 @@
+#ifndef CPPLOX_ERRORSANDDEBUG_LINEINDEX_H
+#define CPPLOX_ERRORSANDDEBUG_LINEINDEX_H
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace cpplox::ErrorsAndDebug {
+
+struct SourceLocation {
+  int line;    // 1-based
+  int column;  // 1-based, in bytes
+};
+
+// Maps byte offsets into a source back to line and column.
+//
+// Tokens and AST nodes only carry byte offsets; nothing on the scanning path
+// counts lines. Where a location is needed (printing an error) this index of
+// line starts is binary searched instead. For a resident source the index is
+// only built the first time a location is asked for, so programs that run
+// without errors never build it at all.
+//
+// A streamed source is gone by the time an error is printed, so the streaming
+// scanner counts lines itself and records only the lines something can still
+// be located on (a token or an error) with addLine(). Blank lines, comments
+// and the inside of strings cost nothing.
+class LineIndex {
+ public:
+  // For a streamed source: see addLine().
+  LineIndex() = default;
+  // For a source that is resident as a whole; p_source has to outlive this.
+  explicit LineIndex(std::string_view p_source);
+
+  // Records that line `line` of a streamed source starts at `offset`. Lines
+  // are added in order; locating an offset on a line that was never added
+  // gives the location of the last added line before it.
+  void addLine(int line, size_t offset);
+
+  // Not thread safe: the first call may build the index.
+  [[nodiscard]] auto locate(size_t offset) const -> SourceLocation;
+
+ private:
+  struct LineStart {
+    size_t offset;
+    int line;
+  };
+
+  mutable std::string_view unindexed;
+  // Resident source: offset of the first byte of every line; lineStarts[0] is
+  // always 0.
+  mutable std::vector<size_t> lineStarts{0};
+  // Streamed source: the lines added so far.
+  std::vector<LineStart> sparseLineStarts;
+};
+
+}  // namespace cpplox::ErrorsAndDebug
+
+#endif  // CPPLOX_ERRORSANDDEBUG_LINEINDEX_H
@@ -3,10 +3,10 @@
 namespace cpplox::Types {
 
 auto getLiteralString(const Literal& value) -> std::string {
-  // Literal = std::variant<std::string, double>;
+  // Literal = std::variant<std::string_view, double, int64_t, bool>;
   switch (value.index()) {
     case 0:  // string
-      return std::get<0>(value);
+      return std::string(std::get<0>(value));
     case 1: {  // double
       std::string result = std::to_string(std::get<1>(value));
       auto pos = result.find(".000000");
@@ -16,9 +16,13 @@ auto getLiteralString(const Literal& value) -> std::string {
         result.erase(result.find_last_not_of('0') + 1, std::string::npos);
       return result;
     }
+    case 2:  // int64_t
+      return std::to_string(std::get<2>(value));
+    case 3:  // bool
+      return std::get<3>(value) ? "true" : "false";
     default:
       static_assert(
-          std::variant_size_v<Literal> == 2,
+          std::variant_size_v<Literal> == 4,
           "Looks like you forgot to update the cases in getLiteralString()!");
       return "";
   }
@@ -28,8 +32,16 @@ auto makeOptionalLiteral(double dVal) -> OptionalLiteral {
   return OptionalLiteral(std::in_place, dVal);
 }
 
-auto makeOptionalLiteral(const std::string& lexeme) -> OptionalLiteral {
+auto makeOptionalLiteral(int64_t iVal) -> OptionalLiteral {
+  return OptionalLiteral(std::in_place, iVal);
+}
+
+auto makeOptionalLiteral(std::string_view lexeme) -> OptionalLiteral {
   return OptionalLiteral(std::in_place, lexeme);
 }
 
+auto makeOptionalLiteral(bool bVal) -> OptionalLiteral {
+  return OptionalLiteral(std::in_place, bVal);
+}
+
 }  // namespace cpplox::Types
@@ -2,20 +2,30 @@
 #define CPPLOX_TYPES_LITERAL_H
 #pragma once
 
+#include <cstdint>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <variant>
 
 namespace cpplox::Types {
 
-using Literal = std::variant<std::string, double>;
+// String literals are views into the source buffer (or static storage), just
+// like Token lexemes; they are only copied once they become runtime values.
+// Number literals without a fractional part are kept as exact integers.
+// `true` and `false` are bools; `nil` is the absence of a literal.
+using Literal = std::variant<std::string_view, double, int64_t, bool>;
 using OptionalLiteral = std::optional<Literal>;
 
 auto getLiteralString(const Literal& value) -> std::string;
 
 auto makeOptionalLiteral(double dVal) -> OptionalLiteral;
 
-auto makeOptionalLiteral(const std::string& lexeme) -> OptionalLiteral;
+auto makeOptionalLiteral(int64_t iVal) -> OptionalLiteral;
+
+auto makeOptionalLiteral(std::string_view lexeme) -> OptionalLiteral;
+
+auto makeOptionalLiteral(bool bVal) -> OptionalLiteral;
 
 }  // namespace cpplox::Types
 
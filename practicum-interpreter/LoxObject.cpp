@@ -0,0 +1,156 @@
+#include "LoxObject.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <unordered_set>
+
+namespace cpplox::Evaluator {
+
+namespace {
+// FNV-1a, which can carry on from the hash of a prefix.
+constexpr uint32_t FNV_OFFSET_BASIS = 2166136261U;
+constexpr uint32_t FNV_PRIME = 16777619U;
+
+auto hashChars(std::string_view chars, uint32_t hash = FNV_OFFSET_BASIS)
+    -> uint32_t {
+  for (const char c : chars) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= FNV_PRIME;
+  }
+  return hash;
+}
+
+// Chars being looked up in the intern table, with their hash.
+struct InternKey {
+  std::string_view chars;
+  uint32_t hash;
+};
+
+struct InternHash {
+  using is_transparent = void;
+  auto operator()(const LoxString* string) const -> size_t {
+    return string->hash();
+  }
+  auto operator()(const InternKey& key) const -> size_t { return key.hash; }
+};
+
+struct InternEqual {
+  using is_transparent = void;
+  auto operator()(const LoxString* left, const LoxString* right) const
+      -> bool {
+    return left == right;
+  }
+  auto operator()(const InternKey& key, const LoxString* string) const
+      -> bool {
+    return key.chars == string->view();
+  }
+  auto operator()(const LoxString* string, const InternKey& key) const
+      -> bool {
+    return key.chars == string->view();
+  }
+};
+
+using InternTable = std::unordered_set<LoxString*, InternHash, InternEqual>;
+
+// Never destroyed, as strings can be released while statics are destroyed.
+auto internTable() -> InternTable& {
+  static auto* const table = new InternTable();
+  return *table;
+}
+}  // namespace
+
+auto LoxString::allocate(size_t length, uint32_t hash, size_t capacity)
+    -> LoxString* {
+  void* memory = ::operator new(sizeof(LoxString) + capacity);
+  return new (memory) LoxString(length, capacity, hash);
+}
+
+auto LoxString::internHashed(std::string_view chars, uint32_t hash)
+    -> LoxString* {
+  InternTable& table = internTable();
+  if (const auto found = table.find(InternKey{chars, hash});
+      found != table.end()) {
+    (*found)->retain();
+    return *found;
+  }
+  LoxString* string = allocate(chars.size(), hash, chars.size());
+  if (!chars.empty()) std::memcpy(string->chars(), chars.data(), chars.size());
+  string->interned = true;
+  table.insert(string);
+  return string;
+}
+
+auto LoxString::create(std::string_view chars) -> LoxString* {
+  const uint32_t hash = hashChars(chars);
+  if (chars.size() <= SHORT_LENGTH) return internHashed(chars, hash);
+  LoxString* string = allocate(chars.size(), hash, chars.size());
+  std::memcpy(string->chars(), chars.data(), chars.size());
+  return string;
+}
+
+auto LoxString::intern(std::string_view chars) -> LoxString* {
+  return internHashed(chars, hashChars(chars));
+}
+
+auto LoxString::concat(const LoxString& left, const LoxString& right)
+    -> LoxString* {
+  const size_t length = left.length + right.length;
+  const uint32_t hash = hashChars(right.view(), left.hashValue);
+  if (length <= SHORT_LENGTH) {
+    char buffer[SHORT_LENGTH];
+    if (left.length != 0) std::memcpy(buffer, left.view().data(), left.length);
+    if (right.length != 0)
+      std::memcpy(buffer + left.length, right.view().data(), right.length);
+    return internHashed({buffer, length}, hash);
+  }
+  LoxString* string = allocate(length, hash, length);
+  std::memcpy(string->chars(), left.view().data(), left.length);
+  std::memcpy(string->chars() + left.length, right.view().data(),
+              right.length);
+  return string;
+}
+
+auto LoxString::append(LoxString* left, std::string_view chars)
+    -> LoxString* {
+  const size_t length = left->length + chars.size();
+  const uint32_t hash = hashChars(chars, left->hashValue);
+  LoxString* string = nullptr;
+  if (length <= SHORT_LENGTH) {
+    char buffer[SHORT_LENGTH];
+    if (left->length != 0)
+      std::memcpy(buffer, left->view().data(), left->length);
+    if (!chars.empty())
+      std::memcpy(buffer + left->length, chars.data(), chars.size());
+    string = internHashed({buffer, length}, hash);
+  } else if (left->refs == 1 && !left->interned && length <= left->capacity) {
+    // `chars` may be `left`'s own, which stay where they are.
+    std::memcpy(left->chars() + left->length, chars.data(), chars.size());
+    left->length = length;
+    left->hashValue = hash;
+    return left;
+  } else {
+    string = allocate(length, hash, std::max(length, 2 * left->length));
+    std::memcpy(string->chars(), left->view().data(), left->length);
+    std::memcpy(string->chars() + left->length, chars.data(), chars.size());
+  }
+  // Only now, as `chars` may be `left`'s.
+  left->release();
+  return string;
+}
+
+void LoxString::destroy() {
+  if (interned) internTable().erase(this);
+  this->~LoxString();
+  ::operator delete(this);
+}
+
+auto LoxObject::box(int64_t integer) -> uint64_t {
+  return BOXED_INT_TAG | reinterpret_cast<uintptr_t>(new int64_t(integer));
+}
+
+void LoxObject::unbox(uint64_t bits) {
+  delete reinterpret_cast<int64_t*>(bits & POINTER_MASK);
+}
+
+}  // namespace cpplox::Evaluator
@@ -0,0 +1,247 @@
+#ifndef CPPLOX_EVALUATOR_LOXOBJECT_H
+#define CPPLOX_EVALUATOR_LOXOBJECT_H
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace cpplox::Evaluator {
+
+// The chars of a string value. Every LoxObject holding a LoxString shares
+// it, counting its references to it, so it never changes once created: but
+// for append(), which only grows it in place while a single reference is
+// left, so that nobody can tell. Its hash is worked out as it is created.
+//
+// A string may be interned: then it is the only LoxString with its chars, so
+// two interned strings are equal only if they are the same one. Literals are
+// interned, and so are strings of up to SHORT_LENGTH chars, as those are the
+// ones programs make over and over (words read in, numbers written out). The
+// table of interned strings doesn't keep them alive; a string leaves it when
+// its last reference goes. Reference counts aren't atomic: values only ever
+// live on the thread running the program.
+class LoxString {
+ public:
+  static constexpr size_t SHORT_LENGTH = 32;
+
+  // A new reference, the caller's, to a string holding `chars`: a new one,
+  // or the interned one if `chars` are short.
+  static auto create(std::string_view chars) -> LoxString*;
+  // The same, always interned.
+  static auto intern(std::string_view chars) -> LoxString*;
+  static auto concat(const LoxString& left, const LoxString& right)
+      -> LoxString*;
+  // `left` followed by `chars`, taking over the caller's reference to
+  // `left`. Grows `left` itself if that is the only reference to it, with
+  // room to spare for the appends that tend to follow.
+  static auto append(LoxString* left, std::string_view chars) -> LoxString*;
+
+  [[nodiscard]] auto view() const -> std::string_view {
+    return {reinterpret_cast<const char*>(this + 1), length};
+  }
+  [[nodiscard]] auto hash() const -> uint32_t { return hashValue; }
+
+  static auto equal(const LoxString& left, const LoxString& right) -> bool {
+    if (&left == &right) return true;
+    if (left.interned && right.interned) return false;
+    return left.hashValue == right.hashValue && left.view() == right.view();
+  }
+
+  void retain() { ++refs; }
+  void release() {
+    if (--refs == 0) destroy();
+  }
+
+  LoxString(const LoxString&) = delete;
+  auto operator=(const LoxString&) -> LoxString& = delete;
+
+ private:
+  LoxString(size_t p_length, size_t p_capacity, uint32_t p_hash)
+      : length(p_length), capacity(p_capacity), hashValue(p_hash) {}
+  // The chars follow the header in the same allocation.
+  static auto allocate(size_t length, uint32_t hash, size_t capacity)
+      -> LoxString*;
+  // The interned string holding `chars`, a new reference to it; made and
+  // interned if there is none.
+  static auto internHashed(std::string_view chars, uint32_t hash)
+      -> LoxString*;
+  auto chars() -> char* { return reinterpret_cast<char*>(this + 1); }
+  void destroy();
+
+  size_t length;
+  size_t capacity;
+  uint32_t refs = 1;
+  uint32_t hashValue;
+  bool interned = false;
+};
+
+// A runtime value, NaN-boxed into 8 bytes. A real is kept as its own bits.
+// Everything else is a quiet NaN with the top two mantissa bits set, which no
+// arithmetic produces: nil, false and true are small payloads, and an int that
+// fits in 49 bits is the payload under the next bit up. The rest set the sign
+// bit too, with a pointer in the low 48 bits: to a LoxString, or to an int of
+// more than 49 bits, boxed on the heap. Copying a string value only bumps the
+// LoxString's reference count; a boxed int is copied along.
+//
+// index() numbers the types string 0, real 1, bool 2, nil 3 and int 4; see
+// objectIndex() for how the types variables are declared with map to those.
+class LoxObject {
+ public:
+  static constexpr size_t NUM_TYPES = 5;
+
+  LoxObject() = default;  // nil
+  LoxObject(std::nullptr_t /*nil*/) {}
+  LoxObject(double number) : bits(std::bit_cast<uint64_t>(number)) {
+    // A NaN that could pass for a boxed value becomes a plain one.
+    if ((bits & QNAN) == QNAN) [[unlikely]]
+      bits = (bits & SIGN_BIT) | CANONICAL_NAN;
+  }
+  LoxObject(int64_t integer)
+      : bits(SMALL_INT_TAG
+             | (static_cast<uint64_t>(integer) & SMALL_INT_MASK)) {
+    if (asSmallInt() != integer) [[unlikely]]
+      bits = box(integer);
+  }
+  LoxObject(bool boolean) : bits(boolean ? TRUE_BITS : FALSE_BITS) {}
+  LoxObject(std::string_view chars) : LoxObject(LoxString::create(chars)) {}
+  LoxObject(const std::string& chars)
+      : LoxObject(std::string_view(chars)) {}
+  LoxObject(const char* chars) : LoxObject(std::string_view(chars)) {}
+  // Takes over the caller's reference to `string`.
+  explicit LoxObject(LoxString* string)
+      : bits(STRING_TAG | reinterpret_cast<uintptr_t>(string)) {}
+
+  LoxObject(const LoxObject& other) : bits(other.bits) {
+    if (isHeap()) [[unlikely]]
+      bits = other.copyHeap();
+  }
+  LoxObject(LoxObject&& other) noexcept
+      : bits(std::exchange(other.bits, NIL_BITS)) {}
+  auto operator=(const LoxObject& other) -> LoxObject& {
+    const uint64_t copied = other.isHeap() ? other.copyHeap() : other.bits;
+    if (isHeap()) releaseHeap();
+    bits = copied;
+    return *this;
+  }
+  auto operator=(LoxObject&& other) noexcept -> LoxObject& {
+    if (this != &other) {
+      if (isHeap()) releaseHeap();
+      bits = std::exchange(other.bits, NIL_BITS);
+    }
+    return *this;
+  }
+  ~LoxObject() {
+    if (isHeap()) releaseHeap();
+  }
+
+  // A real, that is: ints are a type of their own.
+  [[nodiscard]] auto isNumber() const -> bool { return (bits & QNAN) != QNAN; }
+  [[nodiscard]] auto isInt() const -> bool {
+    return isSmallInt() || (bits & HEAP_MASK) == BOXED_INT_TAG;
+  }
+  // An int held inline, which is what arithmetic mostly sees.
+  [[nodiscard]] auto isSmallInt() const -> bool {
+    return (bits & SMALL_INT_TAG_MASK) == SMALL_INT_TAG;
+  }
+  // Whether both are ints held inline, in a single test: the bits the two
+  // have in common only match the tag of one when they both do.
+  static auto areSmallInts(const LoxObject& left, const LoxObject& right)
+      -> bool {
+    return ((left.bits & right.bits) & SMALL_INT_TAG_MASK) == SMALL_INT_TAG;
+  }
+  [[nodiscard]] auto isString() const -> bool {
+    return (bits & HEAP_MASK) == STRING_TAG;
+  }
+  [[nodiscard]] auto isBool() const -> bool { return (bits | 1) == TRUE_BITS; }
+  [[nodiscard]] auto isNil() const -> bool { return bits == NIL_BITS; }
+  [[nodiscard]] auto index() const -> size_t {
+    if (isNumber()) return 1;
+    if (isInt()) return 4;
+    if (isString()) return 0;
+    return bits == NIL_BITS ? 3 : 2;
+  }
+
+  // Only for a value of that type.
+  [[nodiscard]] auto asNumber() const -> double {
+    return std::bit_cast<double>(bits);
+  }
+  [[nodiscard]] auto asInt() const -> int64_t {
+    if (isSmallInt()) [[likely]]
+      return asSmallInt();
+    return *reinterpret_cast<const int64_t*>(bits & POINTER_MASK);
+  }
+  [[nodiscard]] auto asSmallInt() const -> int64_t {
+    // Shifts the payload's sign bit up to the top and back down again.
+    return static_cast<int64_t>(bits << (64 - SMALL_INT_BITS))
+           >> (64 - SMALL_INT_BITS);
+  }
+  [[nodiscard]] auto asBool() const -> bool { return bits == TRUE_BITS; }
+  [[nodiscard]] auto asString() const -> std::string_view {
+    return string()->view();
+  }
+  [[nodiscard]] auto asLoxString() const -> const LoxString& {
+    return *string();
+  }
+  // Hands the value's reference to its string over to the caller, leaving
+  // the value nil.
+  [[nodiscard]] auto takeString() -> LoxString* {
+    LoxString* const taken = string();
+    bits = NIL_BITS;
+    return taken;
+  }
+
+ private:
+  static constexpr uint64_t SIGN_BIT = 0x8000'0000'0000'0000;
+  static constexpr uint64_t QNAN = 0x7ffc'0000'0000'0000;
+  static constexpr uint64_t CANONICAL_NAN = 0x7ff8'0000'0000'0000;
+  static constexpr uint64_t NIL_BITS = QNAN | 1;
+  static constexpr uint64_t FALSE_BITS = QNAN | 2;
+  static constexpr uint64_t TRUE_BITS = QNAN | 3;
+  static constexpr int SMALL_INT_BITS = 49;
+  static constexpr uint64_t SMALL_INT_TAG = QNAN | (uint64_t{1} << 49);
+  static constexpr uint64_t SMALL_INT_TAG_MASK = SIGN_BIT | SMALL_INT_TAG;
+  static constexpr uint64_t SMALL_INT_MASK
+      = (uint64_t{1} << SMALL_INT_BITS) - 1;
+  // Values pointing to the heap; the two bits above the pointer tell which.
+  static constexpr uint64_t HEAP_TAG = SIGN_BIT | QNAN;
+  static constexpr uint64_t HEAP_MASK = 0xffff'0000'0000'0000;
+  static constexpr uint64_t STRING_TAG = HEAP_TAG;
+  static constexpr uint64_t BOXED_INT_TAG = HEAP_TAG | (uint64_t{1} << 48);
+  static constexpr uint64_t POINTER_MASK = 0x0000'ffff'ffff'ffff;
+
+  [[nodiscard]] auto isHeap() const -> bool {
+    return (bits & HEAP_TAG) == HEAP_TAG;
+  }
+  [[nodiscard]] auto string() const -> LoxString* {
+    return reinterpret_cast<LoxString*>(bits & POINTER_MASK);
+  }
+  // Boxed ints are left out of line, keeping the copies and destructors
+  // that are everywhere small.
+  static auto box(int64_t integer) -> uint64_t;
+  static void unbox(uint64_t bits);
+  // The bits of a copy of this heap value.
+  [[nodiscard]] auto copyHeap() const -> uint64_t {
+    if (isString()) [[likely]] {
+      string()->retain();
+      return bits;
+    }
+    return box(asInt());
+  }
+  void releaseHeap() {
+    if (isString()) [[likely]]
+      string()->release();
+    else
+      unbox(bits);
+  }
+
+  uint64_t bits = NIL_BITS;
+};
+
+static_assert(sizeof(LoxObject) == 8);
+
+}  // namespace cpplox::Evaluator
+
+#endif  // CPPLOX_EVALUATOR_LOXOBJECT_H
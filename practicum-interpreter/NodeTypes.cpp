@@ -2,7 +2,6 @@
 
 #include <initializer_list>
 #include <iterator>
-#include <memory>
 #include <optional>
 #include <string>
 #include <utility>
@@ -42,40 +41,43 @@ LogicalExpr::LogicalExpr(ExprPtrVariant left, Token op, ExprPtrVariant right)
 // ==============================//
 // EPV creation helper functions //
 // ==============================//
-auto createBinaryEPV(ExprPtrVariant left, Token op, ExprPtrVariant right)
-    -> ExprPtrVariant {
-  return std::make_unique<BinaryExpr>(std::move(left), op, std::move(right));
+auto createBinaryEPV(Arena& arena, ExprPtrVariant left, Token op,
+                     ExprPtrVariant right) -> ExprPtrVariant {
+  return arena.make<BinaryExpr>(std::move(left), op, std::move(right));
 }
 
-auto createUnaryEPV(Token op, ExprPtrVariant right) -> ExprPtrVariant {
-  return std::make_unique<UnaryExpr>(op, std::move(right));
+auto createUnaryEPV(Arena& arena, Token op, ExprPtrVariant right)
+    -> ExprPtrVariant {
+  return arena.make<UnaryExpr>(op, std::move(right));
 }
 
-auto createGroupingEPV(ExprPtrVariant right) -> ExprPtrVariant {
-  return std::make_unique<GroupingExpr>(std::move(right));
+auto createGroupingEPV(Arena& arena, ExprPtrVariant right) -> ExprPtrVariant {
+  return arena.make<GroupingExpr>(std::move(right));
 }
 
-auto createLiteralEPV(OptionalLiteral literal) -> ExprPtrVariant {
-  return std::make_unique<LiteralExpr>(std::move(literal));
+auto createLiteralEPV(Arena& arena, OptionalLiteral literal) -> ExprPtrVariant {
+  return arena.make<LiteralExpr>(std::move(literal));
 }
 
-auto createConditionalEPV(ExprPtrVariant condition, ExprPtrVariant then,
-                          ExprPtrVariant elseBranch) -> ExprPtrVariant {
-  return std::make_unique<ConditionalExpr>(
+auto createConditionalEPV(Arena& arena, ExprPtrVariant condition,
+                          ExprPtrVariant then, ExprPtrVariant elseBranch)
+    -> ExprPtrVariant {
+  return arena.make<ConditionalExpr>(
       std::move(condition), std::move(then), std::move(elseBranch));
 }
 
-auto createVariableEPV(Token varName) -> ExprPtrVariant {
-  return std::make_unique<VariableExpr>(varName);
+auto createVariableEPV(Arena& arena, Token varName) -> ExprPtrVariant {
+  return arena.make<VariableExpr>(varName);
 }
 
-auto createAssignmentEPV(Token varName, ExprPtrVariant expr) -> ExprPtrVariant {
-  return std::make_unique<AssignmentExpr>(varName, std::move(expr));
+auto createAssignmentEPV(Arena& arena, Token varName, ExprPtrVariant expr)
+    -> ExprPtrVariant {
+  return arena.make<AssignmentExpr>(varName, std::move(expr));
 }
 
-auto createLogicalEPV(ExprPtrVariant left, Token op, ExprPtrVariant right)
-    -> ExprPtrVariant {
-  return std::make_unique<LogicalExpr>(std::move(left), op, std::move(right));
+auto createLogicalEPV(Arena& arena, ExprPtrVariant left, Token op,
+                      ExprPtrVariant right) -> ExprPtrVariant {
+  return arena.make<LogicalExpr>(std::move(left), op, std::move(right));
 }
 
 // =================== //
@@ -85,7 +87,7 @@ ExprStmt::ExprStmt(ExprPtrVariant expr) : expression(std::move(expr)) {}
 
 // WriteStmt::WriteStmt(ExprPtrVariant expr) : expression(std::move(expr)) {}
 
-WriteStmt::WriteStmt(std::vector<ExprPtrVariant> exprs) : expressions(std::move(exprs)) {}
+WriteStmt::WriteStmt(ExprList exprs) : expressions(exprs) {}
 
 ReadStmt::ReadStmt(Token name) : varName(name) {}
 
@@ -98,8 +100,7 @@ RealStmt::RealStmt(Token varName, std::optional<ExprPtrVariant> initializer)
 StrStmt::StrStmt(Token varName, std::optional<ExprPtrVariant> initializer)
     : varName(std::move(varName)), initializer(std::move(initializer)) {}
 
-BlockStmt::BlockStmt(std::vector<StmtPtrVariant> statements)
-    : statements(std::move(statements)) {}
+BlockStmt::BlockStmt(StmtList statements) : statements(statements) {}
 
 IfStmt::IfStmt(ExprPtrVariant condition, StmtPtrVariant thenBranch,
                std::optional<StmtPtrVariant> elseBranch)
@@ -124,8 +125,8 @@ BreakStmt::BreakStmt(Token n) : name(n) {}
 // ============================================================= //
 // Helper functions to create StmtPtrVariants for each Stmt type //
 // ============================================================= //
-auto createExprSPV(ExprPtrVariant expr) -> StmtPtrVariant {
-  return std::make_unique<ExprStmt>(std::move(expr));
+auto createExprSPV(Arena& arena, ExprPtrVariant expr) -> StmtPtrVariant {
+  return arena.make<ExprStmt>(std::move(expr));
 }
 
 /*
@@ -134,54 +135,61 @@ auto createWriteSPV(ExprPtrVariant expr) -> StmtPtrVariant {
 }
 */
 
-auto createWriteSPV(std::vector<ExprPtrVariant> exprs) -> StmtPtrVariant {
-  return std::make_unique<WriteStmt>(std::move(exprs));
+auto createWriteSPV(Arena& arena, const std::vector<ExprPtrVariant>& exprs)
+    -> StmtPtrVariant {
+  return arena.make<WriteStmt>(arena.copy(exprs));
 }
 
-auto createReadSPV(Token varName) -> StmtPtrVariant {
-  return std::make_unique<ReadStmt>(varName);
+auto createReadSPV(Arena& arena, Token varName) -> StmtPtrVariant {
+  return arena.make<ReadStmt>(varName);
 }
 
-auto createIntSPV(Token varName, std::optional<ExprPtrVariant> initializer)
+auto createIntSPV(Arena& arena, Token varName,
+                  std::optional<ExprPtrVariant> initializer)
     -> StmtPtrVariant {
-  return std::make_unique<IntStmt>(varName, std::move(initializer));
+  return arena.make<IntStmt>(varName, std::move(initializer));
 }
 
-auto createRealSPV(Token varName, std::optional<ExprPtrVariant> initializer)
+auto createRealSPV(Arena& arena, Token varName,
+                   std::optional<ExprPtrVariant> initializer)
     -> StmtPtrVariant {
-  return std::make_unique<RealStmt>(varName, std::move(initializer));
+  return arena.make<RealStmt>(varName, std::move(initializer));
 }
 
-auto createStrSPV(Token varName, std::optional<ExprPtrVariant> initializer)
+auto createStrSPV(Arena& arena, Token varName,
+                  std::optional<ExprPtrVariant> initializer)
     -> StmtPtrVariant {
-  return std::make_unique<StrStmt>(varName, std::move(initializer));
+  return arena.make<StrStmt>(varName, std::move(initializer));
 }
 
-auto createBlockSPV(std::vector<StmtPtrVariant> statements) -> StmtPtrVariant {
-  return std::make_unique<BlockStmt>(std::move(statements));
+auto createBlockSPV(Arena& arena,
+                    const std::vector<StmtPtrVariant>& statements)
+    -> StmtPtrVariant {
+  return arena.make<BlockStmt>(arena.copy(statements));
 }
 
-auto createIfSPV(ExprPtrVariant condition, StmtPtrVariant thenBranch,
+auto createIfSPV(Arena& arena, ExprPtrVariant condition,
+                 StmtPtrVariant thenBranch,
                  std::optional<StmtPtrVariant> elseBranch) -> StmtPtrVariant {
-  return std::make_unique<IfStmt>(std::move(condition), std::move(thenBranch),
-                                  std::move(elseBranch));
+  return arena.make<IfStmt>(std::move(condition), std::move(thenBranch),
+                            std::move(elseBranch));
 }
 
-auto createWhileSPV(ExprPtrVariant condition, StmtPtrVariant loopBody)
-    -> StmtPtrVariant {
-  return std::make_unique<WhileStmt>(std::move(condition), std::move(loopBody));
+auto createWhileSPV(Arena& arena, ExprPtrVariant condition,
+                    StmtPtrVariant loopBody) -> StmtPtrVariant {
+  return arena.make<WhileStmt>(std::move(condition), std::move(loopBody));
 }
 
-auto createForSPV(std::optional<StmtPtrVariant> initializer,
+auto createForSPV(Arena& arena, std::optional<StmtPtrVariant> initializer,
                   std::optional<ExprPtrVariant> condition,
                   std::optional<ExprPtrVariant> increment,
                   StmtPtrVariant loopBody) -> StmtPtrVariant {
-  return std::make_unique<ForStmt>(std::move(initializer), std::move(condition),
-                                   std::move(increment), std::move(loopBody));
+  return arena.make<ForStmt>(std::move(initializer), std::move(condition),
+                             std::move(increment), std::move(loopBody));
 }
 
-auto createBreakSPV(Token name) -> StmtPtrVariant {
-  return std::make_unique<BreakStmt>(name);
+auto createBreakSPV(Arena& arena, Token name) -> StmtPtrVariant {
+  return arena.make<BreakStmt>(name);
 }
 
 }  // namespace cpplox::AST
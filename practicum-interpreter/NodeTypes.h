@@ -3,22 +3,35 @@
 #pragma once
 
 // This header file describes AST node Types for both Expressions and Statements
-#include <memory>
+#include <cstdint>
 #include <optional>
+#include <span>
 #include <string>
 #include <variant>
 #include <vector>
 
+#include "Arena.h"
 #include "Literal.h"
 #include "Token.h"
-#include "Uncopyable.h"
 
 namespace cpplox::AST {
 using Types::Literal;
 using Types::OptionalLiteral;
 using Types::Token;
 using Types::TokenType;
-using Types::Uncopyable;
+
+// Every node is allocated in the Arena of the program it belongs to, and
+// points to its children with plain pointers into that same arena. The arena
+// frees the nodes wholesale without destroying them, so nodes (and all their
+// members) have to be trivially destructible; that is why this isn't
+// Types::Uncopyable, whose destructor is virtual.
+struct ArenaNode {
+  ArenaNode() = default;
+  ArenaNode(const ArenaNode&) = delete;
+  auto operator=(const ArenaNode&) -> ArenaNode& = delete;
+  ArenaNode(ArenaNode&&) = delete;
+  auto operator=(ArenaNode&&) -> ArenaNode& = delete;
+};
 
 // Forward declare all the Expression Types so we can define their pointers
 struct BinaryExpr;
@@ -30,15 +43,15 @@ struct VariableExpr;
 struct AssignmentExpr;
 struct LogicalExpr;
 
-// Unique_pointer sugar for Exprs.
-using BinaryExprPtr = std::unique_ptr<BinaryExpr>;
-using GroupingExprPtr = std::unique_ptr<GroupingExpr>;
-using LiteralExprPtr = std::unique_ptr<LiteralExpr>;
-using UnaryExprPtr = std::unique_ptr<UnaryExpr>;
-using ConditionalExprPtr = std::unique_ptr<ConditionalExpr>;
-using VariableExprPtr = std::unique_ptr<VariableExpr>;
-using AssignmentExprPtr = std::unique_ptr<AssignmentExpr>;
-using LogicalExprPtr = std::unique_ptr<LogicalExpr>;
+// Pointer sugar for Exprs; the nodes are owned by an Arena.
+using BinaryExprPtr = BinaryExpr*;
+using GroupingExprPtr = GroupingExpr*;
+using LiteralExprPtr = LiteralExpr*;
+using UnaryExprPtr = UnaryExpr*;
+using ConditionalExprPtr = ConditionalExpr*;
+using VariableExprPtr = VariableExpr*;
+using AssignmentExprPtr = AssignmentExpr*;
+using LogicalExprPtr = LogicalExpr*;
 
 // The variant that we will use to pass around pointers to each of these
 // expression types. I'm exploring this so we don't have to rely on vTables
@@ -61,18 +74,18 @@ struct WhileStmt;
 struct ForStmt;
 struct BreakStmt;
 
-// Unique pointer sugar for Stmts
-using ExprStmtPtr = std::unique_ptr<ExprStmt>;
-using WriteStmtPtr = std::unique_ptr<WriteStmt>;
-using ReadStmtPtr = std::unique_ptr<ReadStmt>;
-using BlockStmtPtr = std::unique_ptr<BlockStmt>;
-using IntStmtPtr = std::unique_ptr<IntStmt>;
-using RealStmtPtr = std::unique_ptr<RealStmt>;
-using StrStmtPtr = std::unique_ptr<StrStmt>;
-using IfStmtPtr = std::unique_ptr<IfStmt>;
-using WhileStmtPtr = std::unique_ptr<WhileStmt>;
-using ForStmtPtr = std::unique_ptr<ForStmt>;
-using BreakStmtPtr = std::unique_ptr<BreakStmt>;
+// Pointer sugar for Stmts; the nodes are owned by an Arena.
+using ExprStmtPtr = ExprStmt*;
+using WriteStmtPtr = WriteStmt*;
+using ReadStmtPtr = ReadStmt*;
+using BlockStmtPtr = BlockStmt*;
+using IntStmtPtr = IntStmt*;
+using RealStmtPtr = RealStmt*;
+using StrStmtPtr = StrStmt*;
+using IfStmtPtr = IfStmt*;
+using WhileStmtPtr = WhileStmt*;
+using ForStmtPtr = ForStmt*;
+using BreakStmtPtr = BreakStmt*;
 
 // We use this variant to pass around pointers to each of these Stmt types,
 // without having to resort to virtual functions and dynamic dispatch
@@ -80,135 +93,245 @@ using StmtPtrVariant
     = std::variant<ExprStmtPtr, WriteStmtPtr, ReadStmtPtr, BlockStmtPtr, IntStmtPtr, RealStmtPtr,
                    StrStmtPtr, IfStmtPtr, WhileStmtPtr, ForStmtPtr, BreakStmtPtr>;
 
+// Where a variable lives at run time; the Resolver fills in the slot of every
+// node that names a variable.
+inline constexpr uint32_t UNRESOLVED_SLOT = UINT32_MAX;
+
+// Lists of children, copied into the arena once the parser has them all.
+using ExprList = std::span<const ExprPtrVariant>;
+using StmtList = std::span<const StmtPtrVariant>;
+
+// A parsed program: its top level statements, and the arena that owns every
+// node reachable from them.
+struct Program {
+  Arena arena;
+  StmtList statements;
+};
+
 // Helper functions to create ExprPtrVariants for each Expr type
-auto createBinaryEPV(ExprPtrVariant left, Token op, ExprPtrVariant right)
+auto createBinaryEPV(Arena& arena, ExprPtrVariant left, Token op,
+                     ExprPtrVariant right) -> ExprPtrVariant;
+auto createUnaryEPV(Arena& arena, Token op, ExprPtrVariant right)
+    -> ExprPtrVariant;
+auto createGroupingEPV(Arena& arena, ExprPtrVariant right) -> ExprPtrVariant;
+auto createLiteralEPV(Arena& arena, OptionalLiteral literal) -> ExprPtrVariant;
+auto createConditionalEPV(Arena& arena, ExprPtrVariant condition,
+                          ExprPtrVariant then, ExprPtrVariant elseBranch)
     -> ExprPtrVariant;
-auto createUnaryEPV(Token op, ExprPtrVariant right) -> ExprPtrVariant;
-auto createGroupingEPV(ExprPtrVariant right) -> ExprPtrVariant;
-auto createLiteralEPV(OptionalLiteral literal) -> ExprPtrVariant;
-auto createConditionalEPV(ExprPtrVariant condition, ExprPtrVariant then,
-                          ExprPtrVariant elseBranch) -> ExprPtrVariant;
-auto createVariableEPV(Token varName) -> ExprPtrVariant;
-auto createAssignmentEPV(Token varName, ExprPtrVariant expr) -> ExprPtrVariant;
-auto createLogicalEPV(ExprPtrVariant left, Token op, ExprPtrVariant right)
+auto createVariableEPV(Arena& arena, Token varName) -> ExprPtrVariant;
+auto createAssignmentEPV(Arena& arena, Token varName, ExprPtrVariant expr)
     -> ExprPtrVariant;
+auto createLogicalEPV(Arena& arena, ExprPtrVariant left, Token op,
+                      ExprPtrVariant right) -> ExprPtrVariant;
 
 // Helper functions to create StmtPtrVariants for each Stmt type
-auto createExprSPV(ExprPtrVariant expr) -> StmtPtrVariant;
+auto createExprSPV(Arena& arena, ExprPtrVariant expr) -> StmtPtrVariant;
 //auto createWriteSPV(ExprPtrVariant expr) -> StmtPtrVariant;
-auto createWriteSPV(std::vector<ExprPtrVariant> exprs) -> StmtPtrVariant;
-auto createReadSPV(Token varName) -> StmtPtrVariant;
-auto createBlockSPV(std::vector<StmtPtrVariant> statements) -> StmtPtrVariant;
-auto createIntSPV(Token varName, std::optional<ExprPtrVariant> initializer)
+auto createWriteSPV(Arena& arena, const std::vector<ExprPtrVariant>& exprs)
     -> StmtPtrVariant;
-auto createRealSPV(Token varName, std::optional<ExprPtrVariant> initializer)
+auto createReadSPV(Arena& arena, Token varName) -> StmtPtrVariant;
+auto createBlockSPV(Arena& arena,
+                    const std::vector<StmtPtrVariant>& statements)
     -> StmtPtrVariant;
-auto createStrSPV(Token varName, std::optional<ExprPtrVariant> initializer)
+auto createIntSPV(Arena& arena, Token varName,
+                  std::optional<ExprPtrVariant> initializer)
     -> StmtPtrVariant;
-auto createIfSPV(ExprPtrVariant condition, StmtPtrVariant thenBranch,
-                 std::optional<StmtPtrVariant> elseBranch) -> StmtPtrVariant;
-auto createWhileSPV(ExprPtrVariant condition, StmtPtrVariant loopBody)
+auto createRealSPV(Arena& arena, Token varName,
+                   std::optional<ExprPtrVariant> initializer)
+    -> StmtPtrVariant;
+auto createStrSPV(Arena& arena, Token varName,
+                  std::optional<ExprPtrVariant> initializer)
     -> StmtPtrVariant;
-auto createForSPV(std::optional<StmtPtrVariant> initializer,
+auto createIfSPV(Arena& arena, ExprPtrVariant condition,
+                 StmtPtrVariant thenBranch,
+                 std::optional<StmtPtrVariant> elseBranch) -> StmtPtrVariant;
+auto createWhileSPV(Arena& arena, ExprPtrVariant condition,
+                    StmtPtrVariant loopBody) -> StmtPtrVariant;
+auto createForSPV(Arena& arena, std::optional<StmtPtrVariant> initializer,
                   std::optional<ExprPtrVariant> condition,
                   std::optional<ExprPtrVariant> increment,
                   StmtPtrVariant loopBody) -> StmtPtrVariant;
-auto createBreakSPV(Token name) -> StmtPtrVariant;
+auto createBreakSPV(Arena& arena, Token name) -> StmtPtrVariant;
 
 // Expression AST Types:
 
-struct BinaryExpr final : public Uncopyable {
+// The type of value an expression is sure to evaluate to (if it doesn't
+// fail), numbered like LoxObject::index(). The TypeChecker fills in every
+// expression's; UNKNOWN is for those it can't vouch for.
+enum class StaticType : uint8_t { STRING, REAL, BOOL, NIL, INT, UNKNOWN };
+
+// The versions of its operator a BinaryExpr can be specialized to, by the
+// Evaluator, after it has seen what the operands are or been told by the
+// TypeChecker.
+enum class BinarySpecialization : uint8_t {
+  UNINITIALIZED,  // not evaluated yet
+  NUMBER_ADD,
+  NUMBER_SUBTRACT,
+  NUMBER_MULTIPLY,
+  NUMBER_DIVIDE,
+  NUMBER_MODULO,
+  NUMBER_LESS,
+  NUMBER_LESS_EQUAL,
+  NUMBER_GREATER,
+  NUMBER_GREATER_EQUAL,
+  NUMBER_EQUAL,
+  NUMBER_NOT_EQUAL,
+  INT_ADD,
+  INT_SUBTRACT,
+  INT_MULTIPLY,
+  INT_DIVIDE,
+  INT_MODULO,
+  INT_LESS,
+  INT_LESS_EQUAL,
+  INT_GREATER,
+  INT_GREATER_EQUAL,
+  INT_EQUAL,
+  INT_NOT_EQUAL,
+  STRING_CONCAT,
+  STRING_EQUAL,
+  STRING_NOT_EQUAL,
+  // Operands the TypeChecker proved to be two reals, or two ints (held
+  // inline or not), which are taken as such without being checked.
+  TYPED_REAL_ADD,
+  TYPED_REAL_SUBTRACT,
+  TYPED_REAL_MULTIPLY,
+  TYPED_REAL_DIVIDE,
+  TYPED_REAL_MODULO,
+  TYPED_REAL_LESS,
+  TYPED_REAL_LESS_EQUAL,
+  TYPED_REAL_GREATER,
+  TYPED_REAL_GREATER_EQUAL,
+  TYPED_REAL_EQUAL,
+  TYPED_REAL_NOT_EQUAL,
+  TYPED_INT_ADD,
+  TYPED_INT_SUBTRACT,
+  TYPED_INT_MULTIPLY,
+  TYPED_INT_DIVIDE,
+  TYPED_INT_MODULO,
+  TYPED_INT_LESS,
+  TYPED_INT_LESS_EQUAL,
+  TYPED_INT_GREATER,
+  TYPED_INT_GREATER_EQUAL,
+  TYPED_INT_EQUAL,
+  TYPED_INT_NOT_EQUAL,
+  GENERIC  // any operands; also where a failed specialization ends up
+};
+
+struct BinaryExpr final : public ArenaNode {
   ExprPtrVariant left;
   Token op;
   ExprPtrVariant right;
+  BinarySpecialization specialization = BinarySpecialization::UNINITIALIZED;
+  StaticType type = StaticType::UNKNOWN;
   BinaryExpr(ExprPtrVariant left, Token op, ExprPtrVariant right);
 };
 
-struct GroupingExpr final : public Uncopyable {
+struct GroupingExpr final : public ArenaNode {
   ExprPtrVariant expression;
+  StaticType type = StaticType::UNKNOWN;
   explicit GroupingExpr(ExprPtrVariant expression);
 };
 
-struct LiteralExpr final : public Uncopyable {
+struct LiteralExpr final : public ArenaNode {
+  static constexpr uint32_t NO_CONSTANT = UINT32_MAX;
+
   OptionalLiteral literalVal;
+  // The literal's runtime value in the Evaluator's ConstantPool, once the
+  // ConstantFolder has put it there.
+  uint32_t constant = NO_CONSTANT;
+  StaticType type = StaticType::UNKNOWN;
   explicit LiteralExpr(OptionalLiteral value);
 };
 
-struct UnaryExpr final : public Uncopyable {
+struct UnaryExpr final : public ArenaNode {
   Token op;
   ExprPtrVariant right;
+  StaticType type = StaticType::UNKNOWN;
   UnaryExpr(Token op, ExprPtrVariant right);
 };
 
-struct ConditionalExpr final : public Uncopyable {
+struct ConditionalExpr final : public ArenaNode {
   ExprPtrVariant condition;
   ExprPtrVariant thenBranch;
   ExprPtrVariant elseBranch;
+  StaticType type = StaticType::UNKNOWN;
   ConditionalExpr(ExprPtrVariant condition, ExprPtrVariant thenBranch,
                   ExprPtrVariant elseBranch);
 };
 
-struct VariableExpr final : public Uncopyable {
+struct VariableExpr final : public ArenaNode {
   Token varName;
+  uint32_t slot = UNRESOLVED_SLOT;
+  StaticType type = StaticType::UNKNOWN;
   explicit VariableExpr(Token varName);
 };
 
-struct AssignmentExpr final : public Uncopyable {
+struct AssignmentExpr final : public ArenaNode {
   Token varName;
+  uint32_t slot = UNRESOLVED_SLOT;
   ExprPtrVariant right;
+  // The `x + ...` of an `x = x + ...` to a variable declared a string, which
+  // a backend may append to x in place; set by the Resolver.
+  BinaryExprPtr selfAppend = nullptr;
+  StaticType type = StaticType::UNKNOWN;
   AssignmentExpr(Token varName, ExprPtrVariant right);
 };
 
-struct LogicalExpr final : public Uncopyable {
+struct LogicalExpr final : public ArenaNode {
   ExprPtrVariant left;
   Token op;
   ExprPtrVariant right;
+  StaticType type = StaticType::UNKNOWN;
   LogicalExpr(ExprPtrVariant left, Token op, ExprPtrVariant right);
 };
 
 
 // Statment AST types;
-struct ExprStmt final : public Uncopyable {
+struct ExprStmt final : public ArenaNode {
   ExprPtrVariant expression;
   explicit ExprStmt(ExprPtrVariant expr);
 };
 
-struct WriteStmt final : public Uncopyable {
+struct WriteStmt final : public ArenaNode {
   //ExprPtrVariant expression;
-  std::vector<ExprPtrVariant> expressions;
+  ExprList expressions;
   //explicit WriteStmt(ExprPtrVariant expression);
-  explicit WriteStmt(std::vector<ExprPtrVariant> expressions);
+  explicit WriteStmt(ExprList expressions);
 };
 
-struct ReadStmt final : public Uncopyable {
+struct ReadStmt final : public ArenaNode {
   Token varName;
+  uint32_t slot = UNRESOLVED_SLOT;
   explicit ReadStmt(Token varName);
 };
 
-struct BlockStmt final : public Uncopyable {
-  std::vector<StmtPtrVariant> statements;
-  explicit BlockStmt(std::vector<StmtPtrVariant> statements);
+struct BlockStmt final : public ArenaNode {
+  StmtList statements;
+  explicit BlockStmt(StmtList statements);
 };
 
-struct IntStmt final : public Uncopyable {
+struct IntStmt final : public ArenaNode {
   Token varName;
+  uint32_t slot = UNRESOLVED_SLOT;
   std::optional<ExprPtrVariant> initializer;
   explicit IntStmt(Token varName, std::optional<ExprPtrVariant> initializer);
 };
 
-struct StrStmt final : public Uncopyable {
+struct StrStmt final : public ArenaNode {
   Token varName;
+  uint32_t slot = UNRESOLVED_SLOT;
   std::optional<ExprPtrVariant> initializer;
   explicit StrStmt(Token varName, std::optional<ExprPtrVariant> initializer);
 };
 
-struct RealStmt final : public Uncopyable {
+struct RealStmt final : public ArenaNode {
   Token varName;
+  uint32_t slot = UNRESOLVED_SLOT;
   std::optional<ExprPtrVariant> initializer;
   explicit RealStmt(Token varName, std::optional<ExprPtrVariant> initializer);
 };
 
-struct IfStmt final : public Uncopyable {
+struct IfStmt final : public ArenaNode {
   ExprPtrVariant condition;
   StmtPtrVariant thenBranch;
   std::optional<StmtPtrVariant> elseBranch;
@@ -216,13 +339,13 @@ struct IfStmt final : public Uncopyable {
                   std::optional<StmtPtrVariant> elseBranch);
 };
 
-struct WhileStmt final : public Uncopyable {
+struct WhileStmt final : public ArenaNode {
   ExprPtrVariant condition;
   StmtPtrVariant loopBody;
   explicit WhileStmt(ExprPtrVariant condition, StmtPtrVariant loopBody);
 };
 
-struct ForStmt final : public Uncopyable {
+struct ForStmt final : public ArenaNode {
   std::optional<StmtPtrVariant> initializer;
   std::optional<ExprPtrVariant> condition;
   std::optional<ExprPtrVariant> increment;
@@ -234,7 +357,7 @@ struct ForStmt final : public Uncopyable {
 };
 
 
-struct BreakStmt : public Uncopyable {
+struct BreakStmt : public ArenaNode {
   Token name;
   explicit BreakStmt(Token name);
 };
@@ -8,24 +8,31 @@
 
 #include "RuntimeError.h"
 
+#define EXPECT_FALSE(x) __builtin_expect(static_cast<int64_t>(x), 0)
+
 namespace cpplox::Evaluator {
 
 // LoxObject Functions
 auto areEqual(const LoxObject& left, const LoxObject& right) -> bool {
+  // An int and a real are compared as reals.
+  if ((left.isInt() && right.isNumber()) || (left.isNumber() && right.isInt()))
+    return toReal(left) == toReal(right);
   if (left.index() == right.index()) {
     switch (left.index()) {
       case 0:  // string
-        return std::get<std::string>(left) == std::get<std::string>(right);
+        return LoxString::equal(left.asLoxString(), right.asLoxString());
       case 1:  // double
-        return std::get<double>(left) == std::get<double>(right);
+        return left.asNumber() == right.asNumber();
       case 2:  // bool
-        return std::get<bool>(left) == std::get<bool>(right);
+        return left.asBool() == right.asBool();
       case 3:  // std::nullptr_t
         // The case where one is null and the other isn't is handled by the
         // outer condition;
         return true;
+      case 4:  // int
+        return left.asInt() == right.asInt();
       default:
-        static_assert(std::variant_size_v<LoxObject> == 4,
+        static_assert(LoxObject::NUM_TYPES == 5,
                       "Looks like you forgot to update the cases in "
                       "ExprEvaluator::areEqual(const LoxObject&, const "
                       "LoxObject&)!");
@@ -37,9 +44,9 @@ auto areEqual(const LoxObject& left, const LoxObject& right) -> bool {
 auto getObjectString(const LoxObject& object) -> std::string {
   switch (object.index()) {
     case 0:  // string
-      return std::get<0>(object);
+      return std::string(object.asString());
     case 1: {  // double
-      std::string result = std::to_string(std::get<1>(object));
+      std::string result = std::to_string(object.asNumber());
       auto pos = result.find(".000000");
       if (pos != std::string::npos)
         result.erase(pos, std::string::npos);
@@ -48,21 +55,187 @@ auto getObjectString(const LoxObject& object) -> std::string {
       return result;
     }
     case 2:  // bool
-      return std::get<2>(object) == true ? "true" : "false";
+      return object.asBool() == true ? "true" : "false";
     case 3:  // nullptr
       return "nil";
+    case 4:  // int
+      return std::to_string(object.asInt());
     default:
-      static_assert(std::variant_size_v<LoxObject> == 4,
+      static_assert(LoxObject::NUM_TYPES == 5,
                     "Looks like you forgot to update the cases in "
                     "getLiteralString()!");
       return "";
   }
 }
 
+auto operator<<(std::ostream& out, const LoxObject& object) -> std::ostream& {
+  if (object.isString()) return out << object.asString();
+  return out << getObjectString(object);
+}
+
 auto isTrue(const LoxObject& object) -> bool {
-  if (std::holds_alternative<std::nullptr_t>(object)) return false;
-  if (std::holds_alternative<bool>(object)) return std::get<bool>(object);
+  if (object.isNil()) return false;
+  if (object.isBool()) return object.asBool();
   return true;  // for all else we go to true
 }
 
+auto toLoxObject(const Types::OptionalLiteral& literal) -> LoxObject {
+  if (!literal.has_value()) return LoxObject(nullptr);
+  switch (literal->index()) {
+    case 0:  // string_view
+      return LoxObject(LoxString::intern(std::get<0>(literal.value())));
+    case 1:  // double
+      return LoxObject(std::get<1>(literal.value()));
+    case 2:  // int64_t
+      return LoxObject(std::get<2>(literal.value()));
+    case 3:  // bool
+      return LoxObject(std::get<3>(literal.value()));
+    default:
+      static_assert(std::variant_size_v<Types::Literal> == 4,
+                    "Looks like you forgot to update the cases in "
+                    "toLoxObject()!");
+      return LoxObject(nullptr);
+  }
+}
+
+// ========= //
+// Operators
+// ========= //
+OperatorError::OperatorError(std::string p_message)
+    : message(std::move(p_message)) {}
+
+auto OperatorError::what() const noexcept -> const char* {
+  return message.c_str();
+}
+
+namespace {
+void checkNumeric(const LoxObject& object) {
+  if (EXPECT_FALSE(!object.isNumber() && !object.isInt()))
+    throw OperatorError(
+        "Attempted to perform arithmetic operation on non-numeric literal "
+        + getObjectString(object));
+}
+
+auto getDouble(const LoxObject& object) -> double {
+  checkNumeric(object);
+  return toReal(object);
+}
+
+auto getInt(const LoxObject& object) -> int64_t {
+  checkNumeric(object);
+  return object.isInt() ? object.asInt() : truncateToInt(object.asNumber());
+}
+}  // namespace
+
+auto applyBinary(const Types::Token& op, const LoxObject& left,
+                 const LoxObject& right) -> LoxObject {
+  using Types::TokenType;
+  switch (op.getType()) {
+    case TokenType::COMMA: return right;
+    case TokenType::BANG_EQUAL: return !areEqual(left, right);
+    case TokenType::EQUAL_EQUAL: return areEqual(left, right);
+    case TokenType::PLUS: {
+      if (left.isString() && right.isString())
+        return LoxObject(
+            LoxString::concat(left.asLoxString(), right.asLoxString()));
+      if (left.isString() || right.isString())
+        return getObjectString(left) + getObjectString(right);
+      if (!(left.isNumber() || left.isInt())
+          || !(right.isNumber() || right.isInt()))
+        throw OperatorError(
+            "Operands to 'plus' must be numbers or strings; This is invalid: "
+            + getObjectString(left) + " + " + getObjectString(right));
+      break;
+    }
+    case TokenType::SLASH: {
+      // The denominator is checked first.
+      checkNumeric(right);
+      if (EXPECT_FALSE(right.isInt() ? right.asInt() == 0
+                                     : right.asNumber() == 0.0))
+        throw OperatorError("Division by zero is illegal");
+      break;
+    }
+    case TokenType::MOD: {
+      const int64_t lhs = getInt(left);
+      const int64_t rhs = getInt(right);
+      if (EXPECT_FALSE(rhs == 0))
+        throw OperatorError("Division by zero is illegal");
+      if (left.isInt() && right.isInt()) return intModulo(lhs, rhs);
+      return static_cast<double>(intModulo(lhs, rhs));
+    }
+    default: break;
+  }
+
+  // The rest only apply to numbers.
+  if (left.isInt() && right.isInt()) {
+    const int64_t lhs = left.asInt();
+    const int64_t rhs = right.asInt();
+    switch (op.getType()) {
+      case TokenType::PLUS: return wrappingAdd(lhs, rhs);
+      case TokenType::MINUS: return wrappingSubtract(lhs, rhs);
+      case TokenType::STAR: return wrappingMultiply(lhs, rhs);
+      case TokenType::SLASH: return intDivide(lhs, rhs);
+      case TokenType::LESS: return lhs < rhs;
+      case TokenType::LESS_EQUAL: return lhs <= rhs;
+      case TokenType::GREATER: return lhs > rhs;
+      case TokenType::GREATER_EQUAL: return lhs >= rhs;
+      default: break;
+    }
+  }
+  double lhs = getDouble(left);
+  double rhs = getDouble(right);
+  switch (op.getType()) {
+    case TokenType::PLUS: return lhs + rhs;
+    case TokenType::MINUS: return lhs - rhs;
+    case TokenType::STAR: return lhs * rhs;
+    case TokenType::SLASH: return lhs / rhs;
+    case TokenType::LESS: return lhs < rhs;
+    case TokenType::LESS_EQUAL: return lhs <= rhs;
+    case TokenType::GREATER: return lhs > rhs;
+    case TokenType::GREATER_EQUAL: return lhs >= rhs;
+    default:
+      throw OperatorError("Attempted to apply invalid operator to binary expr: "
+                          + op.getTypeString());
+  }
+}
+
+auto applyUnary(const Types::Token& op, const LoxObject& right) -> LoxObject {
+  using Types::TokenType;
+  if (right.isInt()) {
+    switch (op.getType()) {
+      case TokenType::MINUS: return wrappingNegate(right.asInt());
+      case TokenType::PLUS_PLUS: return wrappingAdd(right.asInt(), 1);
+      case TokenType::MINUS_MINUS: return wrappingSubtract(right.asInt(), 1);
+      default: break;
+    }
+  }
+  switch (op.getType()) {
+    case TokenType::BANG: return !isTrue(right);
+    case TokenType::MINUS: return -getDouble(right);
+    case TokenType::PLUS_PLUS: return getDouble(right) + 1;
+    case TokenType::MINUS_MINUS: return getDouble(right) - 1;
+    default:
+      throw OperatorError("Illegal unary expression: "
+                          + std::string(op.getLexeme())
+                          + getObjectString(right));
+  }
+}
+void appendTo(LoxObject& target, const LoxObject& right) {
+  if (right.isString()) {
+    const std::string_view chars = right.asString();
+    target = LoxObject(LoxString::append(target.takeString(), chars));
+  } else {
+    const std::string chars = getObjectString(right);
+    target = LoxObject(LoxString::append(target.takeString(), chars));
+  }
+}
+
+// ================== //
+// class ConstantPool
+// ================== //
+auto ConstantPool::add(LoxObject object) -> uint32_t {
+  constants.push_back(std::move(object));
+  return static_cast<uint32_t>(constants.size() - 1);
+}
+
 }  // namespace cpplox::Evaluator
@@ -3,27 +3,136 @@
 #include <optional>
 #pragma once
 
+#include <cstdint>
+#include <exception>
 #include <map>
 #include <memory>
+#include <ostream>
 #include <string>
 #include <variant>
+#include <vector>
 
+#include "Literal.h"
+#include "LoxObject.h"
 #include "NodeTypes.h"
 #include "Token.h"
 #include "Uncopyable.h"
 
 namespace cpplox::Evaluator {
 
-using LoxObject
-    = std::variant<std::string, double, bool, std::nullptr_t>;
-
 auto areEqual(const LoxObject& left, const LoxObject& right) -> bool;
 
 auto getObjectString(const LoxObject& object) -> std::string;
 
+// Writes what getObjectString() gives, without copying a string's chars.
+auto operator<<(std::ostream& out, const LoxObject& object) -> std::ostream&;
+
 auto isTrue(const LoxObject& object) -> bool;
 
-class Environment;
+// The runtime value of a literal as the parser produced it.
+auto toLoxObject(const Types::OptionalLiteral& literal) -> LoxObject;
+
+// The operators, shared by the Evaluator and the ConstantFolder so the two
+// can't disagree on what an expression evaluates to. Operands are checked
+// left to right; an operator that can't be applied throws an OperatorError,
+// which the caller reports (or, when folding, leaves for run time).
+class OperatorError : public std::exception {
+ public:
+  explicit OperatorError(std::string p_message);
+  [[nodiscard]] auto what() const noexcept -> const char* override;
+
+ private:
+  std::string message;
+};
+
+// Two ints make an int: division truncates toward zero, and the rest wrap
+// around on overflow the way the machine's do. An int meeting a real is
+// promoted to a real, except by '%', which truncates both operands to ints
+// and makes a real of the result. Dividing by zero is an error either way.
+auto applyBinary(const Types::Token& op, const LoxObject& left,
+                 const LoxObject& right) -> LoxObject;
+auto applyUnary(const Types::Token& op, const LoxObject& right) -> LoxObject;
+// What applyBinary() does for `target + right` when `target` is a string,
+// stored back into `target`: its string grows in place if `target` holds the
+// only reference to it. `right` may be `target` itself.
+void appendTo(LoxObject& target, const LoxObject& right);
+
+// The int operations applyBinary() and applyUnary() use, for the backends
+// doing ints themselves. Division and modulo only take a nonzero divisor.
+inline auto wrappingAdd(int64_t left, int64_t right) -> int64_t {
+  return static_cast<int64_t>(static_cast<uint64_t>(left)
+                              + static_cast<uint64_t>(right));
+}
+inline auto wrappingSubtract(int64_t left, int64_t right) -> int64_t {
+  return static_cast<int64_t>(static_cast<uint64_t>(left)
+                              - static_cast<uint64_t>(right));
+}
+inline auto wrappingMultiply(int64_t left, int64_t right) -> int64_t {
+  return static_cast<int64_t>(static_cast<uint64_t>(left)
+                              * static_cast<uint64_t>(right));
+}
+inline auto wrappingNegate(int64_t right) -> int64_t {
+  return static_cast<int64_t>(-static_cast<uint64_t>(right));
+}
+inline auto intDivide(int64_t left, int64_t right) -> int64_t {
+  return right == -1 ? wrappingNegate(left) : left / right;
+}
+inline auto intModulo(int64_t left, int64_t right) -> int64_t {
+  return right == -1 ? 0 : left % right;
+}
+// The int a real truncates to, saturating at the ends of the range; NaN
+// truncates to 0.
+inline auto truncateToInt(double real) -> int64_t {
+  // 2^63, the first real past the end of the range.
+  constexpr double LIMIT = 9223372036854775808.0;
+  if (real != real) return 0;
+  if (real >= LIMIT) return INT64_MAX;
+  if (real < -LIMIT) return INT64_MIN;
+  return static_cast<int64_t>(real);
+}
+// '%' on reals, for a divisor that doesn't truncate to 0.
+inline auto realModulo(double left, double right) -> double {
+  return static_cast<double>(
+      intModulo(truncateToInt(left), truncateToInt(right)));
+}
+// The value as a real, for an int or a real.
+inline auto toReal(const LoxObject& number) -> double {
+  return number.isNumber() ? number.asNumber()
+                           : static_cast<double>(number.asInt());
+}
+// Two reals, or a real and an int held inline, as reals: the fast paths of
+// the backends promote mixed operands as applyBinary() does. False for
+// anything else, leaving `lhs` and `rhs` unspecified.
+inline auto asReals(const LoxObject& left, const LoxObject& right,
+                    double& lhs, double& rhs) -> bool {
+  if (left.isNumber()) {
+    lhs = left.asNumber();
+    if (right.isNumber()) {
+      rhs = right.asNumber();
+      return true;
+    }
+    if (!right.isSmallInt()) return false;
+    rhs = static_cast<double>(right.asSmallInt());
+    return true;
+  }
+  if (!left.isSmallInt() || !right.isNumber()) return false;
+  lhs = static_cast<double>(left.asSmallInt());
+  rhs = right.asNumber();
+  return true;
+}
+
+// Values known before the program runs: its literals, and whatever the
+// ConstantFolder computed from them. LiteralExprs refer to them by index.
+class ConstantPool {
+ public:
+  auto add(LoxObject object) -> uint32_t;
+  auto operator[](uint32_t index) const -> const LoxObject& {
+    return constants[index];
+  }
+
+ private:
+  std::vector<LoxObject> constants;
+};
 
 class LoxBreak : public Types::Uncopyable {
  public:
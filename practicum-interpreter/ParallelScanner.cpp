@@ -0,0 +1,104 @@
+#include "ParallelScanner.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <optional>
+#include <thread>
+
+namespace cpplox {
+
+using Types::TokenBuffer;
+
+namespace {
+
+// Runs work(0) ... work(count - 1) on up to `threads` threads.
+void runOnWorkers(size_t count, unsigned threads,
+                  const std::function<void(size_t)>& work) {
+  std::atomic<size_t> next = 0;
+  auto worker = [&]() {
+    for (size_t i = next++; i < count; i = next++) work(i);
+  };
+
+  std::vector<std::thread> workers;
+  for (size_t t = 1; t < std::min<size_t>(threads, count); ++t)
+    workers.emplace_back(worker);
+  worker();
+  for (auto& thread : workers) thread.join();
+}
+
+struct ChunkResult {
+  ErrorReporter errors;
+  TokenBuffer tokens;
+  Scanner::Carry carryOut;
+};
+
+}  // namespace
+
+ParallelScanner::ParallelScanner(std::string_view p_source,
+                                 ErrorReporter& p_eReporter,
+                                 unsigned p_threads, size_t p_minChunkSize)
+    : source(p_source),
+      eReporter(p_eReporter),
+      threads(p_threads != 0
+                  ? p_threads
+                  : std::max(1U, std::thread::hardware_concurrency())),
+      minChunkSize(std::max<size_t>(p_minChunkSize, 1)) {}
+
+// Returns the chunk boundaries: 0, the offsets just past the '\n' nearest to
+// each even split point, and source.size().
+auto ParallelScanner::splitIntoChunks() const -> std::vector<size_t> {
+  const size_t chunks
+      = std::clamp<size_t>(source.size() / minChunkSize, 1, threads);
+
+  std::vector<size_t> bounds{0};
+  for (size_t k = 1; k < chunks; ++k) {
+    const size_t from = std::max(k * (source.size() / chunks), bounds.back());
+    const void* newline
+        = std::memchr(source.data() + from, '\n', source.size() - from);
+    if (newline == nullptr) break;
+    const size_t bound = static_cast<const char*>(newline) - source.data() + 1;
+    if (bound < source.size()) bounds.push_back(bound);
+  }
+  bounds.push_back(source.size());
+  return bounds;
+}
+
+auto ParallelScanner::tokenize() -> TokenBuffer {
+  const std::vector<size_t> bounds = splitIntoChunks();
+  const size_t chunks = bounds.size() - 1;
+  if (chunks == 1 || source.size() > TokenBuffer::MAX_SOURCE_SIZE)
+    return Scanner(source, eReporter).tokenize();
+
+  std::vector<std::optional<ChunkResult>> results(chunks);
+  auto scanChunk = [&](size_t i, Scanner::Carry carryIn) {
+    ChunkResult& result = results[i].emplace(
+        ChunkResult{ErrorReporter(), TokenBuffer(source), {}});
+    Scanner scanner(source, bounds[i], bounds[i + 1], carryIn, result.errors);
+    result.tokens = scanner.tokenize();
+    result.carryOut = scanner.carryOut();
+  };
+
+  // Pass 1: scan every chunk as if it started outside strings and comments.
+  runOnWorkers(chunks, threads, [&](size_t i) { scanChunk(i, {}); });
+
+  // Pass 2: redo the chunks that were guessed wrong, in order, since a redo
+  // can change what the next chunk starts in.
+  for (size_t i = 1; i < chunks; ++i) {
+    const Scanner::Carry carry = results[i - 1]->carryOut;
+    if (carry.kind != Scanner::Carry::Kind::NONE) scanChunk(i, carry);
+  }
+
+  size_t tokenCount = 0;
+  for (const auto& result : results) tokenCount += result->tokens.size();
+  TokenBuffer tokens(source);
+  tokens.reserve(tokenCount);
+  for (const auto& result : results) {
+    tokens.append(result->tokens);
+    eReporter.append(result->errors);
+  }
+  return tokens;
+}
+
+}  // namespace cpplox
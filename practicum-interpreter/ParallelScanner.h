@@ -0,0 +1,53 @@
+#ifndef CPPLOX_SCANNER_PARALLELSCANNER_H
+#define CPPLOX_SCANNER_PARALLELSCANNER_H
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+#include "ErrorReporter.h"
+#include "Scanner.h"
+#include "TokenBuffer.h"
+
+namespace cpplox {
+
+// Scans a large source on several threads.
+//
+// The source is cut into one chunk per worker, each ending right after a
+// '\n'. Tokens only carry byte offsets, so a chunk can be scanned without
+// knowing what came before it, except for one thing: whether it starts inside
+// a string or block comment. Scanning therefore takes two passes:
+//   1. the workers scan their chunks speculatively, assuming no string or
+//      block comment is open where the chunk starts;
+//   2. walking the chunks in order, any chunk whose predecessor did end
+//      inside a string or block comment is scanned again with that state.
+// Generated programs rarely have strings or comments across a line break, so
+// pass 2 almost never has anything to do.
+//
+// The tokens and errors are exactly those Scanner::tokenize() produces for the
+// same source. Sources too small to be worth the threads are scanned by a
+// single Scanner.
+class ParallelScanner {
+ public:
+  static const size_t MIN_CHUNK_SIZE = 1024 * 1024;
+
+  // p_threads == 0 uses one thread per hardware thread.
+  ParallelScanner(std::string_view p_source, ErrorReporter &p_eReporter,
+                  unsigned p_threads = 0,
+                  size_t p_minChunkSize = MIN_CHUNK_SIZE);
+
+  auto tokenize() -> Types::TokenBuffer;
+
+ private:
+  [[nodiscard]] auto splitIntoChunks() const -> std::vector<size_t>;
+
+  const std::string_view source;
+  ErrorReporter &eReporter;
+  const unsigned threads;
+  const size_t minChunkSize;
+};
+
+}  // namespace cpplox
+
+#endif  // CPPLOX_SCANNER_PARALLELSCANNER_H
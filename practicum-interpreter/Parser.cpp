@@ -1,5 +1,6 @@
 #include "Parser.h"
 
+#include <array>
 #include <exception>
 #include <functional>
 #include <initializer_list>
@@ -16,15 +17,17 @@ namespace cpplox::Parser {
 using Types::Token;
 using Types::TokenType;
 
-RDParser::RDParser(const std::vector<Token>& p_tokens,
-                   ErrorsAndDebug::ErrorReporter& eReporter)
-    : tokens(p_tokens), eReporter(eReporter) {
-  this->currentIter = this->tokens.begin();
-}
+RDParser::RDParser(TokenSource& p_tokens, AST::Arena& p_arena,
+                   ErrorsAndDebug::ErrorReporter& eReporter,
+                   ExprParser p_exprParser)
+    : tokens(p_tokens),
+      arena(p_arena),
+      eReporter(eReporter),
+      exprParser(p_exprParser) {}
 
 // Helper functions; Sorted by name
 void RDParser::advance() {
-  if (!isAtEnd()) ++currentIter;
+  if (!isAtEnd()) tokens.advance();
 }
 
 auto RDParser::consumeAnyBinaryExprs(
@@ -32,7 +35,8 @@ auto RDParser::consumeAnyBinaryExprs(
     const parserFn& f) -> ExprPtrVariant {
   while (match(types)) {
     Token op = getTokenAndAdvance();
-    expr = AST::createBinaryEPV(std::move(expr), op, std::invoke(f, this));
+    expr = AST::createBinaryEPV(arena, std::move(expr), op,
+                                std::invoke(f, this));
   }
   return expr;
 }
@@ -40,34 +44,39 @@ auto RDParser::consumeAnyBinaryExprs(
 void RDParser::consumeOrError(TokenType tType,
                               const std::string& errorMessage) {
   if (getCurrentTokenType() == tType) return advance();
-  throw error(errorMessage + " Got: " + peek().toString());
+  throw error(errorMessage + " Got: " + peek().getTypeString() + " "
+              + std::string(tokens.lexeme()));
 }
 
-auto RDParser::consumeOneLiteral(const std::string& str) -> ExprPtrVariant {
+auto RDParser::consumeOneLiteral(Types::OptionalLiteral literal)
+    -> ExprPtrVariant {
   advance();
-  return AST::createLiteralEPV(Types::makeOptionalLiteral(str));
+  return AST::createLiteralEPV(arena, literal);
 }
 
 auto RDParser::consumeOneLiteral() -> ExprPtrVariant {
-  return AST::createLiteralEPV(getTokenAndAdvance().getOptionalLiteral());
+  return AST::createLiteralEPV(arena,
+                               getTokenAndAdvance().getOptionalLiteral());
 }
 
 auto RDParser::consumeGroupingExpr() -> ExprPtrVariant {
   advance();
   ExprPtrVariant expr = expression();
   consumeOrError(TokenType::RIGHT_PAREN,
-                 std::to_string(peek().getLine())
-                     + " Expected a closing paren after expression.");
-  return AST::createGroupingEPV(std::move(expr));
+                 "Expected a closing paren after expression.");
+  return AST::createGroupingEPV(arena, std::move(expr));
 }
 
 auto RDParser::consumeUnaryExpr() -> ExprPtrVariant {
-  return AST::createUnaryEPV(getTokenAndAdvance(), unary());
+  // The operator has to be consumed before the operand is parsed; function
+  // arguments are not guaranteed to be evaluated left to right.
+  Token op = getTokenAndAdvance();
+  return AST::createUnaryEPV(arena, op, unary());
 }
 
 auto RDParser::consumeVarExpr() -> ExprPtrVariant {
   Token varName = getTokenAndAdvance();
-  return AST::createVariableEPV(varName);
+  return AST::createVariableEPV(arena, varName);
 }
 
 void RDParser::consumeSemicolonOrError() {
@@ -80,17 +89,17 @@ auto RDParser::error(const std::string& eMessage) -> RDParser::RDParseError {
 }
 
 auto RDParser::getCurrentTokenType() const -> TokenType {
-  return currentIter->getType();
+  return tokens.type();
 }
 
 auto RDParser::getTokenAndAdvance() -> Token {
-  Token token = peek();
+  Token token = tokens.token();
   advance();
   return token;
 }
 
 auto RDParser::isAtEnd() const -> bool {
-  return peek().getType() == TokenType::LOX_EOF;
+  return getCurrentTokenType() == TokenType::LOX_EOF;
 }
 
 auto RDParser::match(Types::TokenType type) const -> bool {
@@ -106,22 +115,20 @@ auto RDParser::match(const std::initializer_list<Types::TokenType>& types) const
 }
 
 auto RDParser::matchNext(Types::TokenType type) -> bool {
-  advance();
-  bool result = match(type);
-  --currentIter;
-  return result;
+  if (isAtEnd()) return false;
+  TokenType nextType = tokens.type(1);
+  return nextType != TokenType::LOX_EOF && nextType == type;
 }
 
-auto RDParser::peek() const -> Token { return *currentIter; }
+auto RDParser::peek() const -> Token { return tokens.token(); }
 
 void RDParser::reportError(const std::string& message) {
-  const Token& token = peek();
   std::string error = message;
-  if (token.getType() == TokenType::LOX_EOF)
+  if (getCurrentTokenType() == TokenType::LOX_EOF)
     error = " at end: " + error;
   else
-    error = " at '" + token.getLexeme() + "': " + error;
-  eReporter.setError(token.getLine(), error);
+    error = " at '" + std::string(tokens.lexeme()) + "': " + error;
+  eReporter.setError(tokens.offset(), error);
 }
 
 void RDParser::synchronize() {
@@ -138,7 +145,7 @@ void RDParser::synchronize() {
       case TokenType::READ: return;
       default:
         ErrorsAndDebug::debugPrint("Discarding extranuous token:"
-                                   + peek().getLexeme());
+                                   + std::string(tokens.lexeme()));
         advance();
     }
   }
@@ -190,10 +197,10 @@ void RDParser::program() {
   } catch (const std::exception& e) {
     std::string errorMessage = "Caught unhandled exception: ";
     errorMessage += e.what();
-    eReporter.setError(peek().getLine(), errorMessage);
+    eReporter.setError(tokens.offset(), errorMessage);
   } catch (const RDParseError& e) {
     std::string errorMessage = "Caught unhandled parse error: ";
-    eReporter.setError(peek().getLine(), errorMessage);
+    eReporter.setError(tokens.offset(), errorMessage);
   }
 }
 // declaration → intDecl | strDecl | realDecl ;
@@ -236,7 +243,8 @@ auto RDParser::strDecl() -> void {
         advance();
         intializer = assignment();
       }
-      statements.push_back(AST::createStrSPV(varName, std::move(intializer)));
+      statements.push_back(
+          AST::createStrSPV(arena, varName, std::move(intializer)));
     } else
       throw error("Expected a variable name after the str keyword");
   } while (match(TokenType::COMMA));
@@ -255,7 +263,8 @@ auto RDParser::intDecl() -> void {
         advance();
         intializer = assignment();
       }
-      statements.push_back(AST::createIntSPV(varName, std::move(intializer)));
+      statements.push_back(
+          AST::createIntSPV(arena, varName, std::move(intializer)));
     } else 
       throw error("Expected a variable name after the int keyword");
   } while (match(TokenType::COMMA));
@@ -274,7 +283,8 @@ auto RDParser::realDecl() -> void {
         advance();
         intializer = assignment();
       }
-      statements.push_back(AST::createRealSPV(varName, std::move(intializer)));
+      statements.push_back(
+          AST::createRealSPV(arena, varName, std::move(intializer)));
     } else
       throw error("Expected a variable name after the real keyword");
   } while (match(TokenType::COMMA));
@@ -298,7 +308,7 @@ auto RDParser::statement() -> StmtPtrVariant {
 auto RDParser::exprStmt() -> StmtPtrVariant {
   auto expr = expression();
   consumeSemicolonOrError();
-  return AST::createExprSPV(std::move(expr));
+  return AST::createExprSPV(arena, std::move(expr));
 }
 
 // writeStmt   → "write(<expression>, ...);" ;
@@ -315,19 +325,18 @@ auto RDParser::writeStmt() -> StmtPtrVariant {
   }
   consumeOrError(TokenType::RIGHT_PAREN, "Expected \')\'");
   consumeSemicolonOrError();
-  return AST::createWriteSPV(std::move(exprs));
+  return AST::createWriteSPV(arena, std::move(exprs));
 }
 
 // readStmt   → "read(<identifier>);" ;
 auto RDParser::readStmt() -> StmtPtrVariant {
   advance();
   consumeOrError(TokenType::LEFT_PAREN, "Expected \'(\'");
+  Token name = peek();
   consumeOrError(TokenType::IDENTIFIER, "Expected a variable name");
-  --currentIter;
-  Token name = getTokenAndAdvance();
   consumeOrError(TokenType::RIGHT_PAREN, "Expected \')\'");
   consumeSemicolonOrError();
-  return AST::createReadSPV(name);
+  return AST::createReadSPV(arena, name);
 }
 
 // blockStmt   → "{" declaration "}"
@@ -340,7 +349,7 @@ auto RDParser::blockStmt() -> StmtPtrVariant {
     statements.push_back(std::move(optStmnt));
   }
   consumeOrError(TokenType::RIGHT_BRACE, "Expect '}' after block");
-  return AST::createBlockSPV(std::move(statements));
+  return AST::createBlockSPV(arena, std::move(statements));
 }
 
 // ifStmt      → "if" "(" expression ")" statement ("else" statement)? ;
@@ -358,7 +367,7 @@ auto RDParser::ifStmt() -> StmtPtrVariant {
     elseBranch = std::make_optional(statement());
   }
 
-  return AST::createIfSPV(std::move(condition), std::move(thenBranch),
+  return AST::createIfSPV(arena, std::move(condition), std::move(thenBranch),
                           std::move(elseBranch));
 }
 
@@ -368,7 +377,7 @@ auto RDParser::whileStmt() -> StmtPtrVariant {
   consumeOrError(TokenType::LEFT_PAREN, "Expecte '(' after while.");
   ExprPtrVariant condition = expression();
   consumeOrError(TokenType::RIGHT_PAREN, "Expecte ')' after while condition.");
-  return AST::createWhileSPV(std::move(condition), statement());
+  return AST::createWhileSPV(arena, std::move(condition), statement());
 }
 
 // forStmt     → "for" "("
@@ -402,7 +411,7 @@ auto RDParser::forStmt() -> StmtPtrVariant {
 
   StmtPtrVariant loopBody = statement();
 
-  return AST::createForSPV(std::move(initializer), std::move(condition),
+  return AST::createForSPV(arena, std::move(initializer), std::move(condition),
                            std::move(increment), std::move(loopBody));
 }
 
@@ -411,14 +420,18 @@ auto RDParser::breakStmt() -> StmtPtrVariant {
   Token name = peek();
   advance();
   consumeSemicolonOrError();
-  return AST::createBreakSPV(name);
+  return AST::createBreakSPV(arena, name);
 }
 
 //=============//
 // Expressions //
 //=============//
 // expression → comma;
-auto RDParser::expression() -> ExprPtrVariant { return comma(); }
+auto RDParser::expression() -> ExprPtrVariant {
+  if (exprParser == ExprParser::PRATT)
+    return parsePrecedence(Precedence::COMMA);
+  return comma();
+}
 
 // !This is going to cause some grief when we are looking at function
 // arguments; !fun(1,2) will be treated as fun((1,2)) <- a single argument
@@ -432,13 +445,16 @@ auto RDParser::comma() -> ExprPtrVariant {
 
 // assignment  → IDENTIFIER "=" assignment | condititional;
 auto RDParser::assignment() -> ExprPtrVariant {
+  if (exprParser == ExprParser::PRATT)
+    return parsePrecedence(Precedence::ASSIGNMENT);
+
   ExprPtrVariant expr = conditional();
 
   if (match(TokenType::EQUAL)) {
     advance();
     if (std::holds_alternative<AST::VariableExprPtr>(expr)) {
       Token varName = std::get<AST::VariableExprPtr>(expr)->varName;
-      return AST::createAssignmentEPV(varName, assignment());
+      return AST::createAssignmentEPV(arena, varName, assignment());
     }
     throw error("Invalid assignment target");
   }
@@ -454,8 +470,8 @@ auto RDParser::conditional() -> ExprPtrVariant {
     Token op = getTokenAndAdvance();
     ExprPtrVariant thenBranch = expression();
     consumeOrError(TokenType::COLON, "Expected a colon after ternary operator");
-    return AST::createConditionalEPV(std::move(expr), std::move(thenBranch),
-                                     conditional());
+    return AST::createConditionalEPV(arena, std::move(expr),
+                                     std::move(thenBranch), conditional());
   }
   return expr;
 }
@@ -465,7 +481,7 @@ auto RDParser::logical_or() -> ExprPtrVariant {
   ExprPtrVariant expr = logical_and();
   while (match(TokenType::OR)) {
     Token op = getTokenAndAdvance();
-    expr = AST::createLogicalEPV(std::move(expr), op, logical_and());
+    expr = AST::createLogicalEPV(arena, std::move(expr), op, logical_and());
   }
   return expr;
 }
@@ -475,7 +491,7 @@ auto RDParser::logical_and() -> ExprPtrVariant {
   ExprPtrVariant expr = equality();
   while (match(TokenType::AND)) {
     Token op = getTokenAndAdvance();
-    expr = AST::createLogicalEPV(std::move(expr), op, equality());
+    expr = AST::createLogicalEPV(arena, std::move(expr), op, equality());
   }
   return expr;
 }
@@ -523,9 +539,11 @@ auto RDParser::unary() -> ExprPtrVariant {
 // primary    → ("+")addition
 // primary → ("/" | "*" | "%") multiplication;
 auto RDParser::primary() -> ExprPtrVariant {
-  if (match(TokenType::LOX_FALSE)) return consumeOneLiteral("false");
-  if (match(TokenType::LOX_TRUE)) return consumeOneLiteral("true");
-  if (match(TokenType::NIL)) return consumeOneLiteral("nil");
+  if (match(TokenType::LOX_FALSE))
+    return consumeOneLiteral(Types::makeOptionalLiteral(false));
+  if (match(TokenType::LOX_TRUE))
+    return consumeOneLiteral(Types::makeOptionalLiteral(true));
+  if (match(TokenType::NIL)) return consumeOneLiteral(std::nullopt);
   if (match(TokenType::NUMBER)) return consumeOneLiteral();
   if (match(TokenType::STRING)) return consumeOneLiteral();
   if (match(TokenType::LEFT_PAREN)) return consumeGroupingExpr();
@@ -539,11 +557,143 @@ auto RDParser::primary() -> ExprPtrVariant {
   throw error("Expected an expression; Got something else.");
 }
 
+//=====================//
+// Pratt expressions   //
+//=====================//
+// The same grammar as the chain above, folded into one loop: parse a prefix
+// (an operand, or a unary operator and its operand), then keep extending it
+// with infix operators for as long as they bind at least as tightly as
+// minPrecedence. Left associative operators parse their right operand one
+// level tighter than themselves; right associative ones (=, ?:) at their own
+// level. A single literal is one table lookup for the prefix and one for the
+// token after it, instead of a call per precedence level.
+namespace {
+constexpr size_t NUM_TOKEN_TYPES = static_cast<size_t>(TokenType::LOX_EOF) + 1;
+}  // namespace
+
+auto RDParser::rule(TokenType type) -> const ParseRule& {
+  static constexpr std::array<ParseRule, NUM_TOKEN_TYPES> rules = [] {
+    std::array<ParseRule, NUM_TOKEN_TYPES> table{};
+    auto set = [&table](TokenType type, ParseRule rule) {
+      table[static_cast<size_t>(type)] = rule;
+    };
+    // Operands.
+    set(TokenType::NUMBER, {&RDParser::consumeOneLiteral});
+    set(TokenType::STRING, {&RDParser::consumeOneLiteral});
+    set(TokenType::LOX_FALSE, {&RDParser::prefixKeywordLiteral});
+    set(TokenType::LOX_TRUE, {&RDParser::prefixKeywordLiteral});
+    set(TokenType::NIL, {&RDParser::prefixKeywordLiteral});
+    set(TokenType::IDENTIFIER, {&RDParser::consumeVarExpr});
+    set(TokenType::LEFT_PAREN, {&RDParser::consumeGroupingExpr});
+    // Operators. The binary operators that can't start an expression get
+    // prefixMissingOperand: those are the error productions.
+    set(TokenType::COMMA,
+        {nullptr, &RDParser::infixBinary, Precedence::COMMA});
+    set(TokenType::EQUAL,
+        {nullptr, &RDParser::infixAssignment, Precedence::ASSIGNMENT});
+    set(TokenType::QUESTION,
+        {nullptr, &RDParser::infixConditional, Precedence::CONDITIONAL});
+    set(TokenType::OR, {nullptr, &RDParser::infixLogical, Precedence::OR});
+    set(TokenType::AND, {nullptr, &RDParser::infixLogical, Precedence::AND});
+    for (TokenType type : {TokenType::BANG_EQUAL, TokenType::EQUAL_EQUAL})
+      set(type, {&RDParser::prefixMissingOperand, &RDParser::infixBinary,
+                 Precedence::EQUALITY});
+    for (TokenType type : {TokenType::GREATER, TokenType::GREATER_EQUAL,
+                           TokenType::LESS, TokenType::LESS_EQUAL})
+      set(type, {&RDParser::prefixMissingOperand, &RDParser::infixBinary,
+                 Precedence::COMPARISON});
+    set(TokenType::PLUS, {&RDParser::prefixMissingOperand,
+                          &RDParser::infixBinary, Precedence::TERM});
+    set(TokenType::MINUS,
+        {&RDParser::prefixUnary, &RDParser::infixBinary, Precedence::TERM});
+    for (TokenType type : {TokenType::STAR, TokenType::SLASH, TokenType::MOD})
+      set(type, {&RDParser::prefixMissingOperand, &RDParser::infixBinary,
+                 Precedence::FACTOR});
+    set(TokenType::BANG, {&RDParser::prefixUnary});
+    return table;
+  }();
+  return rules[static_cast<size_t>(type)];
+}
+
+auto RDParser::parsePrecedence(Precedence minPrecedence) -> ExprPtrVariant {
+  prefixFn prefix = rule(getCurrentTokenType()).prefix;
+  if (prefix == nullptr)
+    throw error("Expected an expression; Got something else.");
+  ExprPtrVariant expr = std::invoke(prefix, this);
+
+  while (true) {
+    const ParseRule& infix = rule(getCurrentTokenType());
+    if (infix.infix == nullptr || infix.precedence < minPrecedence) break;
+    expr = std::invoke(infix.infix, this, std::move(expr));
+  }
+  return expr;
+}
+
+auto RDParser::prefixKeywordLiteral() -> ExprPtrVariant {
+  switch (getCurrentTokenType()) {
+    case TokenType::LOX_FALSE:
+      return consumeOneLiteral(Types::makeOptionalLiteral(false));
+    case TokenType::LOX_TRUE:
+      return consumeOneLiteral(Types::makeOptionalLiteral(true));
+    default: return consumeOneLiteral(std::nullopt);
+  }
+}
+
+// The error productions: a binary operator with its left operand missing.
+// The right operand is still parsed, for any errors of its own.
+auto RDParser::prefixMissingOperand() -> ExprPtrVariant {
+  Precedence precedence = rule(getCurrentTokenType()).precedence;
+  auto errObj = error("Missing left hand operand");
+  advance();
+  parsePrecedence(precedence);
+  throw errObj;
+}
+
+auto RDParser::prefixUnary() -> ExprPtrVariant {
+  Token op = getTokenAndAdvance();
+  return AST::createUnaryEPV(arena, op, parsePrecedence(Precedence::UNARY));
+}
+
+auto RDParser::infixAssignment(ExprPtrVariant left) -> ExprPtrVariant {
+  advance();
+  if (std::holds_alternative<AST::VariableExprPtr>(left)) {
+    Token varName = std::get<AST::VariableExprPtr>(left)->varName;
+    return AST::createAssignmentEPV(arena, varName,
+                                    parsePrecedence(Precedence::ASSIGNMENT));
+  }
+  throw error("Invalid assignment target");
+}
+
+auto RDParser::infixBinary(ExprPtrVariant left) -> ExprPtrVariant {
+  auto tighter = static_cast<Precedence>(
+      static_cast<uint8_t>(rule(getCurrentTokenType()).precedence) + 1);
+  Token op = getTokenAndAdvance();
+  return AST::createBinaryEPV(arena, std::move(left), op,
+                              parsePrecedence(tighter));
+}
+
+auto RDParser::infixConditional(ExprPtrVariant left) -> ExprPtrVariant {
+  advance();
+  ExprPtrVariant thenBranch = parsePrecedence(Precedence::COMMA);
+  consumeOrError(TokenType::COLON, "Expected a colon after ternary operator");
+  return AST::createConditionalEPV(arena, std::move(left),
+                                   std::move(thenBranch),
+                                   parsePrecedence(Precedence::CONDITIONAL));
+}
+
+auto RDParser::infixLogical(ExprPtrVariant left) -> ExprPtrVariant {
+  auto tighter = static_cast<Precedence>(
+      static_cast<uint8_t>(rule(getCurrentTokenType()).precedence) + 1);
+  Token op = getTokenAndAdvance();
+  return AST::createLogicalEPV(arena, std::move(left), op,
+                               parsePrecedence(tighter));
+}
+
 // _________
 
-auto RDParser::parse() -> std::vector<StmtPtrVariant> {
+auto RDParser::parse() -> AST::StmtList {
   program();
-  return std::move(this->statements);
+  return arena.copy(statements);
 }
 
 }  // namespace cpplox::Parser
@@ -2,17 +2,20 @@
 #define CPPLOX_PARSER_PARSER_H
 #pragma once
 
+#include <cstdint>
 #include <exception>
 #include <functional>
 #include <iterator>
+#include <string_view>
 #include <vector>
 
 #include "NodeTypes.h"
 #include "ErrorReporter.h"
 #include "Token.h"
+#include "TokenSource.h"
 
-// This is a recursive descent parser for the lox language.
-// Currently it only parses expressions.
+// This is a recursive descent parser for the lox language. Statements are
+// parsed top-down; expressions by precedence climbing (see ExprParser).
 
 // clang-format off
 // Grammar production rules:
@@ -44,8 +47,17 @@ using AST::StmtPtrVariant;
 
 class RDParser {
  public:
-  explicit RDParser(const std::vector<Types::Token>& tokens,
-                    ErrorsAndDebug::ErrorReporter& eReporter);
+  // How expressions are parsed. PRATT climbs precedences off a table indexed
+  // by TokenType; DESCENT is the original chain of one function per
+  // precedence level, kept as the reference PRATT has to agree with. Both
+  // build the same AST and report the same errors.
+  enum class ExprParser { PRATT, DESCENT };
+
+  // Tokens are pulled from `tokens` one at a time as parsing proceeds; the
+  // nodes built from them are allocated in `arena`.
+  RDParser(TokenSource& tokens, AST::Arena& arena,
+           ErrorsAndDebug::ErrorReporter& eReporter,
+           ExprParser exprParser = ExprParser::PRATT);
 
   class RDParseError : std::exception {};  // Exception types
 
@@ -53,7 +65,8 @@ class RDParser {
   // Stands in for "program" in the grammar
   // Currently it's mainly used to catch any exceptions that may be produced
   // (e.g., RDParseError) and deal with them.
-  auto parse() -> std::vector<StmtPtrVariant>;
+  // The statements live in the arena passed to the constructor.
+  auto parse() -> AST::StmtList;
 
  private:
   // Grammar parsing functions
@@ -87,6 +100,39 @@ class RDParser {
   auto unary() -> ExprPtrVariant;
   auto primary() -> ExprPtrVariant;
 
+  // Pratt expression parsing. Each TokenType has a ParseRule: what to do with
+  // it at the start of an expression (prefix), what to do with it after an
+  // operand (infix), and how tightly it binds as an infix operator.
+  enum class Precedence : uint8_t {
+    NONE,
+    COMMA,        // ,
+    ASSIGNMENT,   // =
+    CONDITIONAL,  // ?:
+    OR,           // or
+    AND,          // and
+    EQUALITY,     // == !=
+    COMPARISON,   // > >= < <=
+    TERM,         // + -
+    FACTOR,       // * / %
+    UNARY         // ! -
+  };
+  using prefixFn = ExprPtrVariant (RDParser::*)();
+  using infixFn = ExprPtrVariant (RDParser::*)(ExprPtrVariant left);
+  struct ParseRule {
+    prefixFn prefix = nullptr;
+    infixFn infix = nullptr;
+    Precedence precedence = Precedence::NONE;
+  };
+  static auto rule(Types::TokenType type) -> const ParseRule&;
+  auto parsePrecedence(Precedence minPrecedence) -> ExprPtrVariant;
+  auto prefixKeywordLiteral() -> ExprPtrVariant;
+  auto prefixMissingOperand() -> ExprPtrVariant;
+  auto prefixUnary() -> ExprPtrVariant;
+  auto infixAssignment(ExprPtrVariant left) -> ExprPtrVariant;
+  auto infixBinary(ExprPtrVariant left) -> ExprPtrVariant;
+  auto infixConditional(ExprPtrVariant left) -> ExprPtrVariant;
+  auto infixLogical(ExprPtrVariant left) -> ExprPtrVariant;
+
   // Helper functions to implement the parser
   void advance();
   void consumeOrError(Types::TokenType tType, const std::string& errorMessage);
@@ -95,7 +141,7 @@ class RDParser {
       const std::initializer_list<Types::TokenType>& types, ExprPtrVariant expr,
       const parserFn& f) -> ExprPtrVariant;
   auto consumeOneLiteral() -> ExprPtrVariant;
-  auto consumeOneLiteral(const std::string& str) -> ExprPtrVariant;
+  auto consumeOneLiteral(Types::OptionalLiteral literal) -> ExprPtrVariant;
   auto consumeGroupingExpr() -> ExprPtrVariant;
   void consumeSemicolonOrError();
   auto consumeSuper() -> ExprPtrVariant;
@@ -109,6 +155,7 @@ class RDParser {
       const std::initializer_list<Types::TokenType>& types) const -> bool;
   [[nodiscard]] auto match(Types::TokenType type) const -> bool;
   [[nodiscard]] auto matchNext(Types::TokenType type) -> bool;
+  // Materializes the current token; prefer getCurrentTokenType().
   [[nodiscard]] auto peek() const -> Types::Token;
   void reportError(const std::string& message);
   void synchronize();
@@ -117,11 +164,10 @@ class RDParser {
   void throwOnErrorProductions();
 
   // The data the parser operates on.
-  const std::vector<Types::Token>& tokens;
-  std::vector<cpplox::Types::Token>::const_iterator currentIter;
-  // std::__wrap_iter<std::vector<cpplox::Types::Token>::const_pointer>
-  // currentIter;
+  TokenSource& tokens;
+  AST::Arena& arena;
   ErrorsAndDebug::ErrorReporter& eReporter;
+  const ExprParser exprParser;
   std::vector<StmtPtrVariant> statements;
 
   static const int MAX_ARGS = 255;
@@ -23,7 +23,7 @@ auto parenthesize(const std::string& name, const ExprPtrVariant& expr1,
          + PrettyPrinter::toString(expr2) + ")";
 }
 
-auto parenthesize(const std::string& name, const std::vector<ExprPtrVariant>& exprs)
+auto parenthesize(const std::string& name, ExprList exprs)
     -> std::string {
   std::string retValue = "(" + name + " ";
   for (const auto& e : exprs)
@@ -32,7 +32,8 @@ auto parenthesize(const std::string& name, const std::vector<ExprPtrVariant>& ex
 }
 
 auto printBinaryExpr(const BinaryExprPtr& expr) -> std::string {
-  return parenthesize(expr->op.getLexeme(), expr->left, expr->right);
+  return parenthesize(std::string(expr->op.getLexeme()), expr->left,
+                     expr->right);
 }
 auto printGroupingExpr(const GroupingExprPtr& expr) -> std::string {
   std::string name = "group";
@@ -46,7 +47,7 @@ auto printLiteralExpr(const LiteralExprPtr& expr) -> std::string {
 }
 
 auto printUnaryExpr(const UnaryExprPtr& expr) -> std::string {
-  return parenthesize(expr->op.getLexeme(), expr->right);
+  return parenthesize(std::string(expr->op.getLexeme()), expr->right);
 }
 
 auto printConditionalExpr(const ConditionalExprPtr& expr) -> std::string {
@@ -55,15 +56,18 @@ auto printConditionalExpr(const ConditionalExprPtr& expr) -> std::string {
 }
 
 auto printVariableExpr(const VariableExprPtr& expr) -> std::string {
-  return "(" + expr->varName.getLexeme() + ")";
+  return "(" + std::string(expr->varName.getLexeme()) + ")";
 }
 
 auto printAssignmentExpr(const AssignmentExprPtr& expr) -> std::string {
-  return parenthesize("= " + expr->varName.getLexeme(), expr->right) + ";";
+  return parenthesize("= " + std::string(expr->varName.getLexeme()),
+                     expr->right)
+         + ";";
 }
 
 auto printLogicalExpr(const LogicalExprPtr& expr) -> std::string {
-  return parenthesize(expr->op.getLexeme(), expr->left, expr->right);
+  return parenthesize(std::string(expr->op.getLexeme()), expr->left,
+                     expr->right);
 }
 // myGloriousFn(arg1, expr1+expr2)
 // ( ((arg1), (+ expr1 expr2)) myGloriousFn )
@@ -106,7 +110,7 @@ auto printWriteStmt(const WriteStmtPtr& stmt) -> std::string {
 }
 
 auto printReadStmt(const ReadStmtPtr& stmt) -> std::string {
-  return "read(" + stmt->varName.getLexeme() + ");";
+  return "read(" + std::string(stmt->varName.getLexeme()) + ");";
 }
 
 auto printBlockStmt(const BlockStmtPtr& blkStmts) -> std::vector<std::string> {
@@ -123,7 +127,7 @@ auto printBlockStmt(const BlockStmtPtr& blkStmts) -> std::vector<std::string> {
 }
 
 auto printIntStmt(const IntStmtPtr& stmt) -> std::string {
-  std::string str = "var " + stmt->varName.getLexeme();
+  std::string str = "var " + std::string(stmt->varName.getLexeme());
   if (stmt->initializer.has_value()) {
     str = "( = ( " + str + " ) "
           + PrettyPrinter::toString(stmt->initializer.value()) + " )";
@@ -132,7 +136,7 @@ auto printIntStmt(const IntStmtPtr& stmt) -> std::string {
 }
 
 auto printRealStmt(const RealStmtPtr& stmt) -> std::string {
-  std::string str = "var " + stmt->varName.getLexeme();
+  std::string str = "var " + std::string(stmt->varName.getLexeme());
   if (stmt->initializer.has_value()) {
     str = "( = ( " + str + " ) "
           + PrettyPrinter::toString(stmt->initializer.value()) + " )";
@@ -141,7 +145,7 @@ auto printRealStmt(const RealStmtPtr& stmt) -> std::string {
 }
 
 auto printStrStmt(const StrStmtPtr& stmt) -> std::string {
-  std::string str = "var " + stmt->varName.getLexeme();
+  std::string str = "var " + std::string(stmt->varName.getLexeme());
   if (stmt->initializer.has_value()) {
     str = "( = ( " + str + " ) "
           + PrettyPrinter::toString(stmt->initializer.value()) + " )";
@@ -243,7 +247,7 @@ auto PrettyPrinter::toString(const StmtPtrVariant& statement)
   }
 }
 
-auto PrettyPrinter::toString(const std::vector<AST::StmtPtrVariant>& statements)
+auto PrettyPrinter::toString(AST::StmtList statements)
     -> std::vector<std::string> {
   std::vector<std::string> stmtStrsVec;
   for (const auto& stmt : statements) {
@@ -8,7 +8,7 @@
 
 namespace cpplox::AST::PrettyPrinter {
 
-[[nodiscard]] auto toString(const std::vector<AST::StmtPtrVariant>& statements)
+[[nodiscard]] auto toString(AST::StmtList statements)
     -> std::vector<std::string>;
 [[nodiscard]] auto toString(const ExprPtrVariant& expression) -> std::string;
 [[nodiscard]] auto toString(const StmtPtrVariant& statement)
@@ -29,7 +29,7 @@ namespace {
 auto printBinaryExpr(const PrettyPrinterRPN& printer, const BinaryExprPtr& expr)
     -> std::string {
   return printer.toString(expr->left) + " " + printer.toString(expr->right)
-         + " " + expr->op.getLexeme();
+         + " " + std::string(expr->op.getLexeme());
 }
 
 auto printGroupingExpr(const PrettyPrinterRPN& printer,
@@ -46,7 +46,7 @@ auto printLiteralExpr(const PrettyPrinterRPN& printer,
 
 auto printUnaryExpr(const PrettyPrinterRPN& printer, const UnaryExprPtr& expr)
     -> std::string {
-  std::string op = expr->op.getLexeme();
+  std::string op(expr->op.getLexeme());
   if (expr->op.getType() == TokenType::MINUS) op = "~";
   return printer.toString(expr->right) + " " + op;
 }
@@ -0,0 +1,498 @@
+#include "RegisterCode.h"
+
+#include <algorithm>
+#include <array>
+#include <sstream>
+#include <string_view>
+#include <utility>
+#include <variant>
+
+#include "Environment.h"
+#include "TypeChecker.h"
+
+namespace cpplox::VM {
+
+using Evaluator::DeclaredType;
+using Types::TokenType;
+
+namespace {
+
+struct RegOpInfo {
+  std::string_view name;
+  // Whether a, b and c are registers.
+  std::array<bool, 3> isRegister;
+};
+
+constexpr auto makeInfo(std::string_view name, std::string_view operands)
+    -> RegOpInfo {
+  RegOpInfo info{name, {}};
+  for (size_t i = 0; i < 3; ++i) {
+    info.isRegister[i] = operands.substr(0, 3) == "reg";
+    operands.remove_prefix(std::min(operands.size(), operands.find(' ') + 1));
+  }
+  return info;
+}
+
+constexpr std::array REGOP_INFO = {
+#define CPPLOX_REGOP_INFO(name, operands) makeInfo(#name, operands),
+    CPPLOX_REGISTER_OPCODES(CPPLOX_REGOP_INFO)
+#undef CPPLOX_REGOP_INFO
+};
+
+auto info(RegOp op) -> const RegOpInfo& {
+  return REGOP_INFO[static_cast<size_t>(op)];
+}
+
+// Expressions whose value is ready without running any code.
+auto isSimple(const AST::ExprPtrVariant& expr) -> bool {
+  if (std::holds_alternative<AST::GroupingExprPtr>(expr))
+    return isSimple(std::get<AST::GroupingExprPtr>(expr)->expression);
+  return std::holds_alternative<AST::LiteralExprPtr>(expr)
+         || std::holds_alternative<AST::VariableExprPtr>(expr);
+}
+
+// Expressions whose code writes its destination once, after everything else
+// it does. Only those can be compiled straight into a variable: no part of
+// them sees the variable half assigned.
+auto writesOnce(const AST::ExprPtrVariant& expr) -> bool {
+  switch (expr.index()) {
+    case 0:  // BinaryExprPtr
+      return std::get<0>(expr)->op.getType() != TokenType::COMMA;
+    case 1:  // GroupingExprPtr
+      return writesOnce(std::get<1>(expr)->expression);
+    case 2:  // LiteralExprPtr
+    case 3:  // UnaryExprPtr
+    case 5:  // VariableExprPtr
+      return true;
+    default: return false;
+  }
+}
+
+// The _INT or _REAL version of an operator from ADD to NOT_EQUAL or of
+// NEGATE, for operands of `type`; `op` if there is none.
+auto typed(RegOp op, AST::StaticType type) -> RegOp {
+  RegOp first = RegOp::ADD;
+  if (type == AST::StaticType::INT)
+    first = RegOp::ADD_INT;
+  else if (type == AST::StaticType::REAL)
+    first = RegOp::ADD_REAL;
+  else
+    return op;
+  if (op == RegOp::NEGATE)
+    return static_cast<RegOp>(static_cast<int>(first)
+                              + static_cast<int>(RegOp::NOT_EQUAL)
+                              - static_cast<int>(RegOp::ADD) + 1);
+  if (op < RegOp::ADD || op > RegOp::NOT_EQUAL) return op;
+  return static_cast<RegOp>(static_cast<int>(first) + static_cast<int>(op)
+                            - static_cast<int>(RegOp::ADD));
+}
+
+}  // namespace
+
+// ====================== //
+// class RegisterCompiler
+// ====================== //
+RegisterCompiler::RegisterCompiler(Evaluator::ConstantPool& p_constants,
+                                   uint32_t numVariables)
+    : constants(p_constants), minVariables(numVariables) {}
+
+auto RegisterCompiler::compile(const AST::Program& program) -> RegisterChunk {
+  chunk = RegisterChunk();
+  chunk.numVariables = minVariables;
+  constantRegisters.clear();
+  nilPoolIndex.reset();
+  numTemporaries = maxTemporaries = 0;
+  compileStmts(program.statements);
+  emit({RegOp::HALT});
+  relocate();
+  return std::move(chunk);
+}
+
+void RegisterCompiler::compileStmts(AST::StmtList stmts) {
+  for (const AST::StmtPtrVariant& stmt : stmts) {
+    const uint32_t start = here();
+    compileStmt(stmt);
+    chunk.statements.push_back({start, here()});
+  }
+}
+
+void RegisterCompiler::compileDeclaration(
+    const Types::Token& varName, uint32_t slot,
+    const std::optional<AST::ExprPtrVariant>& initializer, DeclaredType type) {
+  const uint32_t mark = numTemporaries;
+  const Operand value
+      = initializer.has_value() ? compileOperand(initializer.value()) : nil();
+  const Operand target = variable(varName, slot);
+  emit({RegOp::DEFINE, target.reg, value.reg, static_cast<uint32_t>(type)},
+       {.a = target.site, .b = value.site});
+  numTemporaries = mark;
+}
+
+void RegisterCompiler::compileWhileStmt(const AST::WhileStmtPtr& stmt) {
+  const uint32_t loopStart = here();
+  const uint32_t mark = numTemporaries;
+  const size_t exitJump
+      = emitJump(RegOp::JUMP_IF_FALSE, compileOperand(stmt->condition));
+  numTemporaries = mark;
+  breakJumps.emplace_back();
+  compileStmt(stmt->loopBody);
+  emit({RegOp::JUMP, loopStart});
+  patchJump(exitJump);
+  for (size_t jump : breakJumps.back()) patchJump(jump);
+  breakJumps.pop_back();
+}
+
+void RegisterCompiler::compileForStmt(const AST::ForStmtPtr& stmt) {
+  if (stmt->initializer.has_value()) compileStmt(stmt->initializer.value());
+  const uint32_t loopStart = here();
+  std::optional<size_t> exitJump;
+  if (stmt->condition.has_value()) {
+    const uint32_t mark = numTemporaries;
+    exitJump = emitJump(RegOp::JUMP_IF_FALSE,
+                        compileOperand(stmt->condition.value()));
+    numTemporaries = mark;
+  }
+  breakJumps.emplace_back();
+  compileStmt(stmt->loopBody);
+  if (stmt->increment.has_value()) compileEffect(stmt->increment.value());
+  emit({RegOp::JUMP, loopStart});
+  if (exitJump.has_value()) patchJump(exitJump.value());
+  for (size_t jump : breakJumps.back()) patchJump(jump);
+  breakJumps.pop_back();
+}
+
+void RegisterCompiler::compileStmt(const AST::StmtPtrVariant& stmt) {
+  switch (stmt.index()) {
+    case 0:  // ExprStmtPtr
+      compileEffect(std::get<0>(stmt)->expression);
+      break;
+    case 1:  // WriteStmtPtr
+      for (const AST::ExprPtrVariant& expr : std::get<1>(stmt)->expressions) {
+        const uint32_t mark = numTemporaries;
+        const Operand value = compileOperand(expr);
+        emit({RegOp::WRITE, value.reg}, {.a = value.site});
+        numTemporaries = mark;
+      }
+      emit({RegOp::WRITE_END});
+      break;
+    case 2: {  // ReadStmtPtr
+      const AST::ReadStmtPtr& read = std::get<2>(stmt);
+      const Operand target = variable(read->varName, read->slot);
+      emit({RegOp::READ, target.reg}, {.a = target.site});
+      break;
+    }
+    case 3:  // BlockStmtPtr
+      compileStmts(std::get<3>(stmt)->statements);
+      break;
+    case 4:  // IntStmtPtr
+      compileDeclaration(std::get<4>(stmt)->varName, std::get<4>(stmt)->slot,
+                         std::get<4>(stmt)->initializer,
+                         DeclaredType::INT);
+      break;
+    case 5:  // RealStmtPtr
+      compileDeclaration(std::get<5>(stmt)->varName, std::get<5>(stmt)->slot,
+                         std::get<5>(stmt)->initializer,
+                         DeclaredType::REAL);
+      break;
+    case 6:  // StrStmtPtr
+      compileDeclaration(std::get<6>(stmt)->varName, std::get<6>(stmt)->slot,
+                         std::get<6>(stmt)->initializer,
+                         DeclaredType::STRING);
+      break;
+    case 7: {  // IfStmtPtr
+      const AST::IfStmtPtr& ifStmt = std::get<7>(stmt);
+      const uint32_t mark = numTemporaries;
+      const size_t elseJump
+          = emitJump(RegOp::JUMP_IF_FALSE, compileOperand(ifStmt->condition));
+      numTemporaries = mark;
+      compileStmt(ifStmt->thenBranch);
+      if (ifStmt->elseBranch.has_value()) {
+        const size_t endJump = emitJump(RegOp::JUMP);
+        patchJump(elseJump);
+        compileStmt(ifStmt->elseBranch.value());
+        patchJump(endJump);
+      } else {
+        patchJump(elseJump);
+      }
+      break;
+    }
+    case 8:  // WhileStmtPtr
+      compileWhileStmt(std::get<8>(stmt));
+      break;
+    case 9:  // ForStmtPtr
+      compileForStmt(std::get<9>(stmt));
+      break;
+    case 10:  // BreakStmtPtr
+      if (breakJumps.empty())
+        emit({RegOp::STRAY_BREAK}, {.op = addToken(std::get<10>(stmt)->name)});
+      else
+        breakJumps.back().push_back(emitJump(RegOp::JUMP));
+      break;
+    default:
+      static_assert(std::variant_size_v<AST::StmtPtrVariant> == 11,
+                    "Looks like you forgot to update the cases in "
+                    "RegisterCompiler::compileStmt()!");
+  }
+}
+
+auto RegisterCompiler::compileOperand(const AST::ExprPtrVariant& expr)
+    -> Operand {
+  switch (expr.index()) {
+    case 1:  // GroupingExprPtr
+      return compileOperand(std::get<1>(expr)->expression);
+    case 2: {  // LiteralExprPtr
+      const AST::LiteralExprPtr& literal = std::get<2>(expr);
+      return constant(literal->constant != AST::LiteralExpr::NO_CONSTANT
+                          ? literal->constant
+                          : constants.add(
+                              Evaluator::toLoxObject(literal->literalVal)));
+    }
+    case 5:  // VariableExprPtr
+      return variable(std::get<5>(expr)->varName, std::get<5>(expr)->slot);
+    case 6:  // AssignmentExprPtr
+      return compileAssignment(std::get<6>(expr));
+    default: {
+      const Operand result = newTemporary();
+      compileInto(expr, result);
+      return result;
+    }
+  }
+}
+
+void RegisterCompiler::compileInto(const AST::ExprPtrVariant& expr,
+                                   Operand dst) {
+  switch (expr.index()) {
+    case 0:  // BinaryExprPtr
+      compileBinaryInto(std::get<0>(expr), dst);
+      break;
+    case 1:  // GroupingExprPtr
+      compileInto(std::get<1>(expr)->expression, dst);
+      break;
+    case 2:  // LiteralExprPtr
+    case 5:  // VariableExprPtr
+    case 6:  // AssignmentExprPtr
+      emitMove(dst, compileOperand(expr));
+      break;
+    case 3:  // UnaryExprPtr
+      compileUnaryInto(std::get<3>(expr), dst);
+      break;
+    case 4: {  // ConditionalExprPtr
+      const AST::ConditionalExprPtr& conditional = std::get<4>(expr);
+      const uint32_t mark = numTemporaries;
+      const size_t elseJump = emitJump(
+          RegOp::JUMP_IF_FALSE, compileOperand(conditional->condition));
+      numTemporaries = mark;
+      compileInto(conditional->thenBranch, dst);
+      const size_t endJump = emitJump(RegOp::JUMP);
+      patchJump(elseJump);
+      compileInto(conditional->elseBranch, dst);
+      patchJump(endJump);
+      break;
+    }
+    case 7: {  // LogicalExprPtr
+      // The parser only makes `and` and `or` LogicalExprs.
+      const AST::LogicalExprPtr& logical = std::get<7>(expr);
+      compileInto(logical->left, dst);
+      const size_t endJump
+          = emitJump(logical->op.getType() == TokenType::OR
+                         ? RegOp::JUMP_IF_TRUE
+                         : RegOp::JUMP_IF_FALSE,
+                     dst);
+      compileInto(logical->right, dst);
+      patchJump(endJump);
+      break;
+    }
+    default:
+      static_assert(std::variant_size_v<AST::ExprPtrVariant> == 8,
+                    "Looks like you forgot to update the cases in "
+                    "RegisterCompiler::compileInto()!");
+  }
+}
+
+void RegisterCompiler::compileEffect(const AST::ExprPtrVariant& expr) {
+  const uint32_t mark = numTemporaries;
+  if (std::holds_alternative<AST::AssignmentExprPtr>(expr))
+    compileAssignment(std::get<AST::AssignmentExprPtr>(expr));
+  else if (!std::holds_alternative<AST::LiteralExprPtr>(expr))
+    compileInto(expr, newTemporary());
+  numTemporaries = mark;
+}
+
+auto RegisterCompiler::compileAssignment(const AST::AssignmentExprPtr& expr)
+    -> Operand {
+  Operand target = variable(expr->varName, expr->slot);
+  target.proven = expr->type != AST::StaticType::UNKNOWN
+                  && AST::typeOf(expr->right) == expr->type;
+  const uint32_t mark = numTemporaries;
+  if (writesOnce(expr->right))
+    compileInto(expr->right, target);
+  else
+    emitMove(target, compileOperand(expr->right));
+  numTemporaries = mark;
+  return target;
+}
+
+void RegisterCompiler::compileBinaryInto(const AST::BinaryExprPtr& expr,
+                                         Operand dst) {
+  if (expr->op.getType() == TokenType::COMMA) {
+    compileEffect(expr->left);
+    compileInto(expr->right, dst);
+    return;
+  }
+  const uint32_t mark = numTemporaries;
+  Operand left = compileOperand(expr->left);
+  // The Evaluator reads the left operand before it evaluates the right one,
+  // which might assign to the variable or fail first.
+  if (isVariable(left) && !isSimple(expr->right)) {
+    const Operand copy = newTemporary();
+    emitMove(copy, left);
+    left = copy;
+  }
+  const Operand right = compileOperand(expr->right);
+  RegOp op = RegOp::BINARY;
+  switch (expr->op.getType()) {
+    case TokenType::EQUAL_EQUAL: op = RegOp::EQUAL; break;
+    case TokenType::BANG_EQUAL: op = RegOp::NOT_EQUAL; break;
+    case TokenType::PLUS: op = RegOp::ADD; break;
+    case TokenType::MINUS: op = RegOp::SUBTRACT; break;
+    case TokenType::STAR: op = RegOp::MULTIPLY; break;
+    case TokenType::SLASH: op = RegOp::DIVIDE; break;
+    case TokenType::MOD: op = RegOp::MODULO; break;
+    case TokenType::LESS: op = RegOp::LESS; break;
+    case TokenType::LESS_EQUAL: op = RegOp::LESS_EQUAL; break;
+    case TokenType::GREATER: op = RegOp::GREATER; break;
+    case TokenType::GREATER_EQUAL: op = RegOp::GREATER_EQUAL; break;
+    default: break;
+  }
+  if (!isVariable(dst) || dst.proven)
+    op = typed(op, AST::numericOperands(*expr));
+  emit({op, dst.reg, left.reg, right.reg},
+       {addToken(expr->op), dst.site, left.site, right.site});
+  numTemporaries = mark;
+}
+
+void RegisterCompiler::compileUnaryInto(const AST::UnaryExprPtr& expr,
+                                        Operand dst) {
+  const uint32_t mark = numTemporaries;
+  const Operand right = compileOperand(expr->right);
+  RegOp op = RegOp::UNARY;
+  switch (expr->op.getType()) {
+    case TokenType::BANG: op = RegOp::NOT; break;
+    case TokenType::MINUS: op = RegOp::NEGATE; break;
+    default: break;
+  }
+  if (!isVariable(dst) || dst.proven) op = typed(op, expr->type);
+  emit({op, dst.reg, right.reg},
+       {.op = addToken(expr->op), .a = dst.site, .b = right.site});
+  numTemporaries = mark;
+}
+
+auto RegisterCompiler::constant(uint32_t poolIndex) -> Operand {
+  auto [iter, added] = constantRegisters.try_emplace(
+      poolIndex, static_cast<uint32_t>(chunk.constants.size()));
+  if (added) chunk.constants.push_back(constants[poolIndex]);
+  return {CONSTANT_TAG | iter->second};
+}
+
+auto RegisterCompiler::nil() -> Operand {
+  if (!nilPoolIndex.has_value()) nilPoolIndex = constants.add(nullptr);
+  return constant(nilPoolIndex.value());
+}
+
+auto RegisterCompiler::newTemporary() -> Operand {
+  maxTemporaries = std::max(maxTemporaries, numTemporaries + 1);
+  return {TEMPORARY_TAG | numTemporaries++};
+}
+
+auto RegisterCompiler::variable(const Types::Token& varName, uint32_t slot)
+    -> Operand {
+  chunk.numVariables = std::max(chunk.numVariables, slot + 1);
+  return {slot, addToken(varName)};
+}
+
+auto RegisterCompiler::isVariable(Operand operand) -> bool {
+  return (operand.reg & (CONSTANT_TAG | TEMPORARY_TAG)) == 0;
+}
+
+void RegisterCompiler::emit(Instruction instruction,
+                            RegisterChunk::Sites sites) {
+  chunk.code.push_back(instruction);
+  chunk.sites.push_back(sites);
+}
+
+void RegisterCompiler::emitMove(Operand dst, Operand src) {
+  emit({RegOp::MOVE, dst.reg, src.reg}, {.a = dst.site, .b = src.site});
+}
+
+auto RegisterCompiler::emitJump(RegOp op) -> size_t {
+  return emitJump(op, Operand{0});
+}
+
+auto RegisterCompiler::emitJump(RegOp op, Operand condition) -> size_t {
+  emit({op, 0, condition.reg}, {.b = condition.site});
+  return chunk.code.size() - 1;
+}
+
+void RegisterCompiler::patchJump(size_t jump) { chunk.code[jump].a = here(); }
+
+auto RegisterCompiler::here() const -> uint32_t {
+  return static_cast<uint32_t>(chunk.code.size());
+}
+
+auto RegisterCompiler::addToken(const Types::Token& token) -> uint32_t {
+  chunk.tokens.push_back(token);
+  return static_cast<uint32_t>(chunk.tokens.size() - 1);
+}
+
+void RegisterCompiler::relocate() {
+  const auto numConstants = static_cast<uint32_t>(chunk.constants.size());
+  auto relocated = [&](uint32_t reg) -> uint32_t {
+    if ((reg & CONSTANT_TAG) != 0)
+      return chunk.numVariables + (reg & ~CONSTANT_TAG);
+    if ((reg & TEMPORARY_TAG) != 0)
+      return chunk.numVariables + numConstants + (reg & ~TEMPORARY_TAG);
+    return reg;
+  };
+  for (Instruction& instruction : chunk.code) {
+    const RegOpInfo& opInfo = info(instruction.op);
+    if (opInfo.isRegister[0]) instruction.a = relocated(instruction.a);
+    if (opInfo.isRegister[1]) instruction.b = relocated(instruction.b);
+    if (opInfo.isRegister[2]) instruction.c = relocated(instruction.c);
+  }
+  chunk.numRegisters = chunk.numVariables + numConstants + maxTemporaries;
+}
+
+// =========== //
+// disassemble
+// =========== //
+auto disassemble(const RegisterChunk& chunk) -> std::string {
+  std::ostringstream listing;
+  auto registerName = [&chunk](uint32_t reg) -> std::string {
+    if (chunk.isVariable(reg)) return "v" + std::to_string(reg);
+    const size_t constant = reg - chunk.numVariables;
+    if (constant < chunk.constants.size())
+      return "k(" + Evaluator::getObjectString(chunk.constants[constant])
+             + ")";
+    return "t" + std::to_string(constant - chunk.constants.size());
+  };
+  for (size_t pc = 0; pc < chunk.code.size(); ++pc) {
+    const Instruction& instruction = chunk.code[pc];
+    const RegOpInfo& opInfo = info(instruction.op);
+    listing << pc << '\t' << opInfo.name;
+    const std::array<uint32_t, 3> operands
+        = {instruction.a, instruction.b, instruction.c};
+    for (size_t i = 0; i < 3; ++i) {
+      if (opInfo.isRegister[i])
+        listing << ' ' << registerName(operands[i]);
+      else if (i == 0 && instruction.op >= RegOp::JUMP
+               && instruction.op <= RegOp::JUMP_IF_TRUE)
+        listing << " ->" << operands[i];
+      else if (instruction.op == RegOp::DEFINE && i == 2)
+        listing << " type=" << operands[i];
+    }
+    listing << '\n';
+  }
+  return listing.str();
+}
+
+}  // namespace cpplox::VM
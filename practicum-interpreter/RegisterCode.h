@@ -0,0 +1,220 @@
+#ifndef CPPLOX_VM_REGISTERCODE_H
+#define CPPLOX_VM_REGISTERCODE_H
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Bytecode.h"
+#include "NodeTypes.h"
+#include "Objects.h"
+#include "Token.h"
+
+namespace cpplox::VM {
+
+// The instruction set of the RegisterVM. Each instruction names the
+// registers it reads and writes: `c = a + b` is a single ADD c, a, b.
+//
+// Registers are the Environment's slots. The program's variables keep the
+// slots the Resolver gave them (declarations come first, so that is their
+// order of declaration); the constants the program uses and the
+// temporaries its expressions need get the slots after those.
+//
+// Reading a variable register checks that it holds a value and writing one
+// that it has been declared, with the Evaluator's error messages; the
+// tokens those name live in RegisterChunk::sites, off the fast path.
+//
+// The _INT and _REAL operators are for operands the TypeChecker proved to be
+// two ints or two reals, and a destination that is a temporary or a
+// variable it proved to be assigned a value of its type; they check none of
+// that.
+//
+// X(name, operands a b c): `reg` a register, `target` an index into
+// RegisterChunk::code, `type` a declaration's type tag, `-` unused.
+#define CPPLOX_TYPED_REGISTER_OPCODES(X, T)                                 \
+  X(ADD_##T, "reg reg reg")         /* in the order of ADD..NOT_EQUAL */    \
+  X(SUBTRACT_##T, "reg reg reg")                                            \
+  X(MULTIPLY_##T, "reg reg reg")                                            \
+  X(DIVIDE_##T, "reg reg reg")                                              \
+  X(MODULO_##T, "reg reg reg")                                              \
+  X(LESS_##T, "reg reg reg")                                                \
+  X(LESS_EQUAL_##T, "reg reg reg")                                          \
+  X(GREATER_##T, "reg reg reg")                                             \
+  X(GREATER_EQUAL_##T, "reg reg reg")                                       \
+  X(EQUAL_##T, "reg reg reg")                                               \
+  X(NOT_EQUAL_##T, "reg reg reg")                                           \
+  X(NEGATE_##T, "reg reg -")
+
+#define CPPLOX_REGISTER_OPCODES(X)                                          \
+  X(MOVE, "reg reg -")              /* a = b */                             \
+  X(DEFINE, "reg reg type")         /* declare variable a = b */            \
+  X(READ, "reg - -")                /* read stdin into variable a */        \
+  X(ADD, "reg reg reg")             /* binary operators: a = b op c */      \
+  X(SUBTRACT, "reg reg reg")                                                \
+  X(MULTIPLY, "reg reg reg")                                                \
+  X(DIVIDE, "reg reg reg")                                                  \
+  X(MODULO, "reg reg reg")                                                  \
+  X(LESS, "reg reg reg")                                                    \
+  X(LESS_EQUAL, "reg reg reg")                                              \
+  X(GREATER, "reg reg reg")                                                 \
+  X(GREATER_EQUAL, "reg reg reg")                                           \
+  X(EQUAL, "reg reg reg")                                                   \
+  X(NOT_EQUAL, "reg reg reg")                                               \
+  X(BINARY, "reg reg reg")          /* any other binary operator */         \
+  X(NEGATE, "reg reg -")            /* unary operators: a = op b */         \
+  X(NOT, "reg reg -")                                                       \
+  X(UNARY, "reg reg -")             /* any other unary operator */          \
+  CPPLOX_TYPED_REGISTER_OPCODES(X, INT)                                     \
+  CPPLOX_TYPED_REGISTER_OPCODES(X, REAL)                                    \
+  X(WRITE, "reg - -")               /* print a and a space */               \
+  X(WRITE_END, "- - -")             /* end the line */                      \
+  X(JUMP, "target - -")                                                     \
+  X(JUMP_IF_FALSE, "target reg -")  /* jump to a unless b is true */        \
+  X(JUMP_IF_TRUE, "target reg -")                                           \
+  X(STRAY_BREAK, "- - -")           /* a break outside of any loop */       \
+  X(HALT, "- - -")
+
+enum class RegOp : uint8_t {
+#define CPPLOX_REGOP_ENUM(name, operands) name,
+  CPPLOX_REGISTER_OPCODES(CPPLOX_REGOP_ENUM)
+#undef CPPLOX_REGOP_ENUM
+};
+
+// The operator an _INT or _REAL one is a version of; any other as it is.
+constexpr auto untyped(RegOp op) -> RegOp {
+  constexpr int BINARY_OPS
+      = static_cast<int>(RegOp::NOT_EQUAL) - static_cast<int>(RegOp::ADD) + 1;
+  static_assert(static_cast<int>(RegOp::NEGATE_INT)
+                        - static_cast<int>(RegOp::ADD_INT)
+                    == BINARY_OPS
+                && static_cast<int>(RegOp::ADD_REAL)
+                       == static_cast<int>(RegOp::NEGATE_INT) + 1,
+                "Each type's operators are ADD..NOT_EQUAL's, then NEGATE.");
+  if (op < RegOp::ADD_INT || op > RegOp::NEGATE_REAL) return op;
+  const int index
+      = (static_cast<int>(op) - static_cast<int>(RegOp::ADD_INT))
+        % (BINARY_OPS + 1);
+  if (index == BINARY_OPS) return RegOp::NEGATE;
+  return static_cast<RegOp>(static_cast<int>(RegOp::ADD) + index);
+}
+
+struct Instruction {
+  RegOp op;
+  uint32_t a = 0;
+  uint32_t b = 0;
+  uint32_t c = 0;
+};
+
+// A compiled program.
+struct RegisterChunk {
+  static constexpr uint32_t NO_TOKEN = UINT32_MAX;
+  // Indices into `tokens` for each instruction: the operator, and the
+  // variable behind each of a, b and c that is a variable register.
+  struct Sites {
+    uint32_t op = NO_TOKEN;
+    uint32_t a = NO_TOKEN;
+    uint32_t b = NO_TOKEN;
+    uint32_t c = NO_TOKEN;
+  };
+
+  std::vector<Instruction> code;
+  std::vector<Sites> sites;
+  std::vector<Types::Token> tokens;
+  // As in Chunk, with instruction indices.
+  std::vector<Chunk::Statement> statements;
+  // Registers [0, numVariables) are variables. The next constants.size()
+  // start out as constants[i], and the rest up to numRegisters are
+  // temporaries.
+  uint32_t numVariables = 0;
+  std::vector<LoxObject> constants;
+  uint32_t numRegisters = 0;
+
+  [[nodiscard]] auto isVariable(uint32_t reg) const -> bool {
+    return reg < numVariables;
+  }
+};
+
+class RegisterCompiler {
+ public:
+  // Literals the ConstantFolder didn't get to are added to `constants`.
+  // The first `numVariables` slots are taken by variables, whether or not
+  // the program uses them.
+  RegisterCompiler(Evaluator::ConstantPool& constants, uint32_t numVariables);
+
+  auto compile(const AST::Program& program) -> RegisterChunk;
+
+ private:
+  // Until compile() is done, constant and temporary registers are numbered
+  // separately and tagged; relocate() then gives them their final numbers.
+  static constexpr uint32_t CONSTANT_TAG = 1U << 31;
+  static constexpr uint32_t TEMPORARY_TAG = 1U << 30;
+
+  // A register, and if it is a variable's, the token that named it.
+  // `proven` for a variable being assigned a value the TypeChecker proved
+  // to be of its type.
+  struct Operand {
+    uint32_t reg;
+    uint32_t site = RegisterChunk::NO_TOKEN;
+    bool proven = false;
+  };
+
+  void compileStmts(AST::StmtList stmts);
+  void compileStmt(const AST::StmtPtrVariant& stmt);
+  void compileDeclaration(
+      const Types::Token& varName, uint32_t slot,
+      const std::optional<AST::ExprPtrVariant>& initializer,
+      Evaluator::DeclaredType type);
+  void compileWhileStmt(const AST::WhileStmtPtr& stmt);
+  void compileForStmt(const AST::ForStmtPtr& stmt);
+
+  // A register holding the value of expr: a variable's or a constant's own
+  // register when it is one, otherwise a new temporary.
+  auto compileOperand(const AST::ExprPtrVariant& expr) -> Operand;
+  // Emits code leaving expr's value in `dst`.
+  void compileInto(const AST::ExprPtrVariant& expr, Operand dst);
+  // Evaluates expr for its side effects (and errors) only.
+  void compileEffect(const AST::ExprPtrVariant& expr);
+  auto compileAssignment(const AST::AssignmentExprPtr& expr) -> Operand;
+  void compileBinaryInto(const AST::BinaryExprPtr& expr, Operand dst);
+  void compileUnaryInto(const AST::UnaryExprPtr& expr, Operand dst);
+
+  auto constant(uint32_t poolIndex) -> Operand;
+  auto nil() -> Operand;
+  auto newTemporary() -> Operand;
+  auto variable(const Types::Token& varName, uint32_t slot) -> Operand;
+  [[nodiscard]] static auto isVariable(Operand operand) -> bool;
+
+  void emit(Instruction instruction, RegisterChunk::Sites sites = {});
+  void emitMove(Operand dst, Operand src);
+  // Emits a forward jump; its target is set by patchJump().
+  auto emitJump(RegOp op) -> size_t;
+  auto emitJump(RegOp op, Operand condition) -> size_t;
+  void patchJump(size_t jump);
+  [[nodiscard]] auto here() const -> uint32_t;
+  auto addToken(const Types::Token& token) -> uint32_t;
+  void relocate();
+
+  Evaluator::ConstantPool& constants;
+  const uint32_t minVariables;
+  RegisterChunk chunk;
+  // Constant registers, by their index in the ConstantPool.
+  std::unordered_map<uint32_t, uint32_t> constantRegisters;
+  std::optional<uint32_t> nilPoolIndex;
+  // Temporaries are allocated like a stack: those an operator's operands
+  // took are free again once the operator is emitted.
+  uint32_t numTemporaries = 0;
+  uint32_t maxTemporaries = 0;
+  // For each loop being compiled, the jumps its `break`s left to patch.
+  std::vector<std::vector<size_t>> breakJumps;
+};
+
+// A listing of the chunk's code, one instruction per line.
+auto disassemble(const RegisterChunk& chunk) -> std::string;
+
+}  // namespace cpplox::VM
+
+#endif  // CPPLOX_VM_REGISTERCODE_H
@@ -0,0 +1,367 @@
+#include "RegisterVM.h"
+
+#include <cstdint>
+#include <iostream>
+#include <utility>
+#include <variant>
+
+#include "DebugPrint.h"
+
+#define EXPECT_TRUE(x) __builtin_expect(static_cast<int64_t>(x), 1)
+#define EXPECT_FALSE(x) __builtin_expect(static_cast<int64_t>(x), 0)
+
+// Computed goto with GCC and Clang, a switch elsewhere; see StackVM.cpp.
+#if defined(__GNUC__) || defined(__clang__)
+#define CPPLOX_THREADED_DISPATCH
+#endif
+
+namespace cpplox::VM {
+
+using ErrorsAndDebug::RuntimeError;
+using Evaluator::DeclaredType;
+using Evaluator::Environment;
+using Evaluator::OperatorError;
+using Evaluator::intDivide;
+using Evaluator::intModulo;
+using Evaluator::realModulo;
+using Evaluator::truncateToInt;
+using Evaluator::wrappingAdd;
+using Evaluator::wrappingMultiply;
+using Evaluator::wrappingNegate;
+using Evaluator::wrappingSubtract;
+
+namespace {
+inline auto isNil(const LoxObject& object) -> bool { return object.isNil(); }
+
+// Evaluator::isTrue(), inline.
+inline auto isTrueInline(const LoxObject& object) -> bool {
+  if (object.isBool()) return object.asBool();
+  return !isNil(object);
+}
+}  // namespace
+
+RegisterVM::RegisterVM(ErrorsAndDebug::ErrorReporter& p_eReporter,
+                       Evaluator::ConstantPool& p_constants, bool p_useJit)
+    : eReporter(p_eReporter),
+      constants(p_constants),
+      environment(p_eReporter),
+      useJit(p_useJit) {}
+
+void RegisterVM::run(const AST::Program& program) {
+  // The last program's scratch slots may be this one's new variables.
+  environment.undefineFrom(scratchStart);
+  const RegisterChunk chunk
+      = RegisterCompiler(constants, scratchStart).compile(program);
+#ifdef VM_DEBUG
+  ErrorsAndDebug::debugPrint(disassemble(chunk));
+#endif  // VM_DEBUG
+  scratchStart = chunk.numVariables;
+  registers = environment.slotData(chunk.numRegisters);
+  Slot* scratch = registers + chunk.numVariables;
+  for (const LoxObject& constant : chunk.constants)
+    *scratch++ = Slot{constant, Evaluator::declaredTypeOf(constant.index())};
+  // Temporaries are never undefined; the type only matters to variables.
+  for (; scratch != registers + chunk.numRegisters; ++scratch)
+    *scratch = Slot{nullptr, DeclaredType::ANY};
+#ifdef CPPLOX_JIT
+  jit = useJit ? std::make_unique<LoopJit>(chunk) : nullptr;
+#endif  // CPPLOX_JIT
+  execute(chunk);
+}
+
+auto RegisterVM::read(const RegisterChunk& chunk, uint32_t reg, uint32_t site)
+    -> const LoxObject& {
+  if (chunk.isVariable(reg)) return environment.get(reg, chunk.tokens[site]);
+  return registers[reg].value;
+}
+
+void RegisterVM::write(const RegisterChunk& chunk, uint32_t reg,
+                       uint32_t site, LoxObject value) {
+  if (chunk.isVariable(reg)) {
+    // An assignment is worth the variable's value, which has to be set.
+    environment.assign(reg, chunk.tokens[site], std::move(value));
+    environment.get(reg, chunk.tokens[site]);
+  } else {
+    registers[reg].value = std::move(value);
+  }
+}
+
+void RegisterVM::binary(const RegisterChunk& chunk, size_t pc) {
+  const Instruction& instruction = chunk.code[pc];
+  const RegisterChunk::Sites& sites = chunk.sites[pc];
+  const LoxObject& left = read(chunk, instruction.b, sites.b);
+  const LoxObject& right = read(chunk, instruction.c, sites.c);
+  const Types::Token& op = chunk.tokens[sites.op];
+  // `x = x + ...` appends to a string in x in place.
+  if (instruction.a == instruction.b && chunk.isVariable(instruction.a)
+      && op.getType() == Types::TokenType::PLUS && left.isString()) {
+    Evaluator::appendTo(registers[instruction.a].value, right);
+    return;
+  }
+  LoxObject result;
+  try {
+    result = Evaluator::applyBinary(op, left, right);
+  } catch (const OperatorError& error) {
+    throw ErrorsAndDebug::reportRuntimeError(eReporter, op, error.what());
+  }
+  write(chunk, instruction.a, sites.a, std::move(result));
+}
+
+void RegisterVM::unary(const RegisterChunk& chunk, size_t pc) {
+  const Instruction& instruction = chunk.code[pc];
+  const RegisterChunk::Sites& sites = chunk.sites[pc];
+  const LoxObject& right = read(chunk, instruction.b, sites.b);
+  const Types::Token& op = chunk.tokens[sites.op];
+  LoxObject result;
+  try {
+    result = Evaluator::applyUnary(op, right);
+  } catch (const OperatorError& error) {
+    throw ErrorsAndDebug::reportRuntimeError(eReporter, op, error.what());
+  }
+  write(chunk, instruction.a, sites.a, std::move(result));
+}
+
+auto RegisterVM::recover(const RegisterChunk& chunk, size_t pc,
+                         const RuntimeError& error) -> size_t {
+  // Like the Evaluator's nested evaluateStmts() calls, each statement list
+  // the error propagates through gets a say, innermost first.
+  for (const Chunk::Statement& statement : chunk.statements) {
+    if (statement.start <= pc && pc < statement.end
+        && recoverFromRuntimeError())
+      return statement.end;
+  }
+  throw error;
+}
+
+void RegisterVM::execute(const RegisterChunk& chunk) {
+  const Instruction* const code = chunk.code.data();
+  const Instruction* ip = code;
+  // The instruction being run.
+  const Instruction* in = code;
+  Slot* const regs = registers;
+
+#ifdef CPPLOX_THREADED_DISPATCH
+  static const void* const dispatchTable[] = {
+#define CPPLOX_REGOP_LABEL(name, operands) &&op_##name,
+      CPPLOX_REGISTER_OPCODES(CPPLOX_REGOP_LABEL)
+#undef CPPLOX_REGOP_LABEL
+  };
+#define VM_CASE(name) op_##name
+#define VM_DISPATCH()                                   \
+  do {                                                  \
+    in = ip++;                                          \
+    goto* dispatchTable[static_cast<size_t>(in->op)];   \
+  } while (false)
+#else
+#define VM_CASE(name) case RegOp::name
+#define VM_DISPATCH() continue
+#endif  // CPPLOX_THREADED_DISPATCH
+
+// Pairs of ints held inline, reals, and an int held inline mixed with a
+// real (promoted) are handled inline, given the condition for each, as long
+// as the destination may be written without further ado: it is defined, and
+// not declared with the type that would convert the result, if a number.
+// Anything else goes through binary().
+#define VM_BINARY(name, realCondition, realResult, intCondition, intResult) \
+  VM_CASE(name) : {                                                         \
+    Slot& dst = regs[in->a];                                                \
+    const LoxObject& left = regs[in->b].value;                              \
+    const LoxObject& right = regs[in->c].value;                             \
+    if (LoxObject::areSmallInts(left, right)) {                             \
+      const int64_t lhs = left.asSmallInt();                                \
+      const int64_t rhs = right.asSmallInt();                               \
+      if (EXPECT_TRUE((intCondition)                                        \
+                      && dst.type != DeclaredType::UNDEFINED                \
+                      && dst.type != DeclaredType::REAL)) {                 \
+        dst.value = (intResult);                                            \
+        VM_DISPATCH();                                                      \
+      }                                                                     \
+    } else if (double lhs, rhs;                                             \
+               EXPECT_TRUE(Evaluator::asReals(left, right, lhs, rhs))) {    \
+      if (EXPECT_TRUE((realCondition)                                       \
+                      && dst.type != DeclaredType::UNDEFINED                \
+                      && dst.type != DeclaredType::INT)) {                  \
+        dst.value = (realResult);                                           \
+        VM_DISPATCH();                                                      \
+      }                                                                     \
+    }                                                                       \
+    binary(chunk, in - code);                                               \
+    VM_DISPATCH();                                                          \
+  }
+
+// Operands and destination the TypeChecker vouched for (see RegisterCode.h),
+// taken `as` they are. Only '/' and '%' check anything: a zero divisor
+// goes through binary() for its error.
+#define VM_TYPED(name, as, condition, result)                               \
+  VM_CASE(name) : {                                                         \
+    const auto lhs = regs[in->b].value.as();                                \
+    const auto rhs = regs[in->c].value.as();                                \
+    if (EXPECT_TRUE(condition))                                             \
+      regs[in->a].value = (result);                                         \
+    else                                                                    \
+      binary(chunk, in - code);                                             \
+    VM_DISPATCH();                                                          \
+  }
+
+  for (;;) {
+    try {
+#ifdef CPPLOX_THREADED_DISPATCH
+      VM_DISPATCH();
+#else
+      for (;;) switch ((in = ip++)->op) {
+#endif  // CPPLOX_THREADED_DISPATCH
+        VM_CASE(MOVE) : {
+          Slot& dst = regs[in->a];
+          const Slot& src = regs[in->b];
+          if (EXPECT_TRUE(!isNil(src.value)
+                          && dst.type != DeclaredType::UNDEFINED
+                          && Environment::storesAsIs(dst.type, src.value))) {
+            dst.value = src.value;
+          } else {
+            const RegisterChunk::Sites& sites = chunk.sites[in - code];
+            write(chunk, in->a, sites.a, read(chunk, in->b, sites.b));
+          }
+          VM_DISPATCH();
+        }
+        VM_CASE(DEFINE) : {
+          environment.define(in->a,
+                             read(chunk, in->b, chunk.sites[in - code].b),
+                             static_cast<DeclaredType>(in->c));
+          VM_DISPATCH();
+        }
+        VM_CASE(READ) : {
+          environment.read(in->a, chunk.tokens[chunk.sites[in - code].a]);
+          VM_DISPATCH();
+        }
+        VM_BINARY(ADD, true, lhs + rhs, true, wrappingAdd(lhs, rhs))
+        VM_BINARY(SUBTRACT, true, lhs - rhs, true, wrappingSubtract(lhs, rhs))
+        VM_BINARY(MULTIPLY, true, lhs * rhs, true, wrappingMultiply(lhs, rhs))
+        VM_BINARY(DIVIDE, rhs != 0.0, lhs / rhs, rhs != 0, intDivide(lhs, rhs))
+        VM_BINARY(MODULO, truncateToInt(rhs) != 0, realModulo(lhs, rhs),
+                  rhs != 0, intModulo(lhs, rhs))
+        VM_BINARY(LESS, true, lhs < rhs, true, lhs < rhs)
+        VM_BINARY(LESS_EQUAL, true, lhs <= rhs, true, lhs <= rhs)
+        VM_BINARY(GREATER, true, lhs > rhs, true, lhs > rhs)
+        VM_BINARY(GREATER_EQUAL, true, lhs >= rhs, true, lhs >= rhs)
+        VM_BINARY(EQUAL, true, lhs == rhs, true, lhs == rhs)
+        VM_BINARY(NOT_EQUAL, true, lhs != rhs, true, lhs != rhs)
+        VM_CASE(BINARY) : {
+          binary(chunk, in - code);
+          VM_DISPATCH();
+        }
+        VM_CASE(NEGATE) : {
+          Slot& dst = regs[in->a];
+          const LoxObject& value = regs[in->b].value;
+          if (EXPECT_TRUE(value.isNumber()
+                          && dst.type != DeclaredType::UNDEFINED
+                          && dst.type != DeclaredType::INT)) {
+            dst.value = -value.asNumber();
+          } else if (value.isSmallInt() && dst.type != DeclaredType::UNDEFINED
+                     && dst.type != DeclaredType::REAL) {
+            dst.value = wrappingNegate(value.asSmallInt());
+          } else {
+            unary(chunk, in - code);
+          }
+          VM_DISPATCH();
+        }
+        VM_CASE(NOT) : {
+          Slot& dst = regs[in->a];
+          const LoxObject& value = regs[in->b].value;
+          if (EXPECT_TRUE(!isNil(value)
+                          && dst.type != DeclaredType::UNDEFINED)) {
+            dst.value = !isTrueInline(value);
+          } else {
+            unary(chunk, in - code);
+          }
+          VM_DISPATCH();
+        }
+        VM_CASE(UNARY) : {
+          unary(chunk, in - code);
+          VM_DISPATCH();
+        }
+        VM_TYPED(ADD_INT, asInt, true, wrappingAdd(lhs, rhs))
+        VM_TYPED(SUBTRACT_INT, asInt, true, wrappingSubtract(lhs, rhs))
+        VM_TYPED(MULTIPLY_INT, asInt, true, wrappingMultiply(lhs, rhs))
+        VM_TYPED(DIVIDE_INT, asInt, rhs != 0, intDivide(lhs, rhs))
+        VM_TYPED(MODULO_INT, asInt, rhs != 0, intModulo(lhs, rhs))
+        VM_TYPED(LESS_INT, asInt, true, lhs < rhs)
+        VM_TYPED(LESS_EQUAL_INT, asInt, true, lhs <= rhs)
+        VM_TYPED(GREATER_INT, asInt, true, lhs > rhs)
+        VM_TYPED(GREATER_EQUAL_INT, asInt, true, lhs >= rhs)
+        VM_TYPED(EQUAL_INT, asInt, true, lhs == rhs)
+        VM_TYPED(NOT_EQUAL_INT, asInt, true, lhs != rhs)
+        VM_CASE(NEGATE_INT) : {
+          regs[in->a].value = wrappingNegate(regs[in->b].value.asInt());
+          VM_DISPATCH();
+        }
+        VM_TYPED(ADD_REAL, asNumber, true, lhs + rhs)
+        VM_TYPED(SUBTRACT_REAL, asNumber, true, lhs - rhs)
+        VM_TYPED(MULTIPLY_REAL, asNumber, true, lhs * rhs)
+        VM_TYPED(DIVIDE_REAL, asNumber, rhs != 0.0, lhs / rhs)
+        VM_TYPED(MODULO_REAL, asNumber, truncateToInt(rhs) != 0,
+                 realModulo(lhs, rhs))
+        VM_TYPED(LESS_REAL, asNumber, true, lhs < rhs)
+        VM_TYPED(LESS_EQUAL_REAL, asNumber, true, lhs <= rhs)
+        VM_TYPED(GREATER_REAL, asNumber, true, lhs > rhs)
+        VM_TYPED(GREATER_EQUAL_REAL, asNumber, true, lhs >= rhs)
+        VM_TYPED(EQUAL_REAL, asNumber, true, lhs == rhs)
+        VM_TYPED(NOT_EQUAL_REAL, asNumber, true, lhs != rhs)
+        VM_CASE(NEGATE_REAL) : {
+          regs[in->a].value = -regs[in->b].value.asNumber();
+          VM_DISPATCH();
+        }
+        VM_CASE(WRITE) : {
+          std::cout << read(chunk, in->a, chunk.sites[in - code].a) << " ";
+          VM_DISPATCH();
+        }
+        VM_CASE(WRITE_END) : {
+          std::cout << std::endl;
+          VM_DISPATCH();
+        }
+        VM_CASE(JUMP) : {
+#ifdef CPPLOX_JIT
+          // A loop's back edge.
+          if (jit != nullptr && in->a < static_cast<uint32_t>(in - code)) {
+            ip = code
+                 + jit->backEdge(in->a, static_cast<uint32_t>(in - code),
+                                 regs);
+            VM_DISPATCH();
+          }
+#endif  // CPPLOX_JIT
+          ip = code + in->a;
+          VM_DISPATCH();
+        }
+        VM_CASE(JUMP_IF_FALSE) : {
+          const LoxObject& condition = regs[in->b].value;
+          if (EXPECT_FALSE(isNil(condition)) && chunk.isVariable(in->b))
+            read(chunk, in->b, chunk.sites[in - code].b);  // throws
+          if (!isTrueInline(condition)) ip = code + in->a;
+          VM_DISPATCH();
+        }
+        VM_CASE(JUMP_IF_TRUE) : {
+          const LoxObject& condition = regs[in->b].value;
+          if (EXPECT_FALSE(isNil(condition)) && chunk.isVariable(in->b))
+            read(chunk, in->b, chunk.sites[in - code].b);  // throws
+          if (isTrueInline(condition)) ip = code + in->a;
+          VM_DISPATCH();
+        }
+        VM_CASE(STRAY_BREAK) : {
+          throw BreakException(
+              chunk.tokens[chunk.sites[in - code].op].getOffset());
+        }
+        VM_CASE(HALT) : { return; }
+#ifndef CPPLOX_THREADED_DISPATCH
+      }
+#endif  // CPPLOX_THREADED_DISPATCH
+    } catch (const RuntimeError& error) {
+      ip = code + recover(chunk, in - code, error);
+    }
+  }
+
+#undef VM_TYPED
+#undef VM_BINARY
+#undef VM_DISPATCH
+#undef VM_CASE
+}
+
+}  // namespace cpplox::VM
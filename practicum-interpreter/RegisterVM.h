@@ -0,0 +1,66 @@
+#ifndef CPPLOX_VM_REGISTERVM_H
+#define CPPLOX_VM_REGISTERVM_H
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "Backend.h"
+#include "Environment.h"
+#include "ErrorReporter.h"
+#include "Jit.h"
+#include "NodeTypes.h"
+#include "Objects.h"
+#include "RegisterCode.h"
+#include "RuntimeError.h"
+
+namespace cpplox::VM {
+
+// The register backend: compiles each program into a RegisterChunk and runs
+// it with the Environment's slots as its register file. Numbers are added,
+// compared and moved inline; everything else, and every case that could
+// fail, goes through the same operators and Environment methods as the
+// Evaluator.
+//
+// Built with CPPLOX_JIT, it can hand hot loops to the LoopJit as well.
+class RegisterVM final : public Evaluator::Backend {
+ public:
+  RegisterVM(ErrorsAndDebug::ErrorReporter& eReporter,
+             Evaluator::ConstantPool& constants, bool useJit = false);
+  void run(const AST::Program& program) override;
+
+ private:
+  using Slot = Evaluator::Environment::Slot;
+
+  void execute(const RegisterChunk& chunk);
+  // Where to carry on after a runtime error in the instruction at `pc`: past
+  // the statement it abandons. Rethrows the error if there is none.
+  auto recover(const RegisterChunk& chunk, size_t pc,
+               const ErrorsAndDebug::RuntimeError& error) -> size_t;
+
+  // The general case of each kind of instruction.
+  auto read(const RegisterChunk& chunk, uint32_t reg, uint32_t site)
+      -> const LoxObject&;
+  void write(const RegisterChunk& chunk, uint32_t reg, uint32_t site,
+             LoxObject value);
+  void binary(const RegisterChunk& chunk, size_t pc);
+  void unary(const RegisterChunk& chunk, size_t pc);
+
+  ErrorsAndDebug::ErrorReporter& eReporter;
+  Evaluator::ConstantPool& constants;
+  Evaluator::Environment environment;
+  // The slots past the variables, where the last program run kept its
+  // constants and temporaries.
+  uint32_t scratchStart = 0;
+  Slot* registers = nullptr;
+  [[maybe_unused]] const bool useJit;
+#ifdef CPPLOX_JIT
+  // For the chunk being run, if useJit.
+  std::unique_ptr<LoopJit> jit;
+#endif  // CPPLOX_JIT
+};
+
+}  // namespace cpplox::VM
+
+#endif  // CPPLOX_VM_REGISTERVM_H
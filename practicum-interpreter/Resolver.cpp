@@ -0,0 +1,149 @@
+#include "Resolver.h"
+
+#include <optional>
+#include <variant>
+
+namespace cpplox::AST {
+
+void Resolver::resolve(const Program& program) {
+  for (const StmtPtrVariant& stmt : program.statements) resolveStmt(stmt);
+}
+
+auto Resolver::numSlots() const -> size_t { return slots.size(); }
+
+void Resolver::declare(uint32_t slot, bool isString) {
+  if (slot >= declaredString.size()) declaredString.resize(slot + 1);
+  declaredString[slot] = isString;
+}
+
+auto Resolver::selfAppend(const AssignmentExprPtr& assignment)
+    -> BinaryExprPtr {
+  if (!std::holds_alternative<BinaryExprPtr>(assignment->right))
+    return nullptr;
+  const BinaryExprPtr binary = std::get<BinaryExprPtr>(assignment->right);
+  if (binary->op.getType() != Types::TokenType::PLUS
+      || !std::holds_alternative<VariableExprPtr>(binary->left)
+      || std::get<VariableExprPtr>(binary->left)->slot != assignment->slot)
+    return nullptr;
+  return binary;
+}
+
+auto Resolver::slotOf(const Types::Token& varName) -> uint32_t {
+  auto iter = slots.find(varName.getLexeme());
+  if (iter == slots.end())
+    iter = slots
+               .emplace(std::string(varName.getLexeme()),
+                        static_cast<uint32_t>(slots.size()))
+               .first;
+  return iter->second;
+}
+
+void Resolver::resolveStmt(const StmtPtrVariant& stmt) {
+  switch (stmt.index()) {
+    case 0:  // ExprStmtPtr
+      return resolveExpr(std::get<0>(stmt)->expression);
+    case 1:  // WriteStmtPtr
+      for (const ExprPtrVariant& expr : std::get<1>(stmt)->expressions)
+        resolveExpr(expr);
+      return;
+    case 2:  // ReadStmtPtr
+      std::get<2>(stmt)->slot = slotOf(std::get<2>(stmt)->varName);
+      return;
+    case 3:  // BlockStmtPtr
+      for (const StmtPtrVariant& inner : std::get<3>(stmt)->statements)
+        resolveStmt(inner);
+      return;
+    case 4: {  // IntStmtPtr
+      const auto& intStmt = std::get<4>(stmt);
+      if (intStmt->initializer.has_value())
+        resolveExpr(intStmt->initializer.value());
+      intStmt->slot = slotOf(intStmt->varName);
+      declare(intStmt->slot, false);
+      return;
+    }
+    case 5: {  // RealStmtPtr
+      const auto& realStmt = std::get<5>(stmt);
+      if (realStmt->initializer.has_value())
+        resolveExpr(realStmt->initializer.value());
+      realStmt->slot = slotOf(realStmt->varName);
+      declare(realStmt->slot, false);
+      return;
+    }
+    case 6: {  // StrStmtPtr
+      const auto& strStmt = std::get<6>(stmt);
+      if (strStmt->initializer.has_value())
+        resolveExpr(strStmt->initializer.value());
+      strStmt->slot = slotOf(strStmt->varName);
+      declare(strStmt->slot, true);
+      return;
+    }
+    case 7: {  // IfStmtPtr
+      const auto& ifStmt = std::get<7>(stmt);
+      resolveExpr(ifStmt->condition);
+      resolveStmt(ifStmt->thenBranch);
+      if (ifStmt->elseBranch.has_value())
+        resolveStmt(ifStmt->elseBranch.value());
+      return;
+    }
+    case 8:  // WhileStmtPtr
+      resolveExpr(std::get<8>(stmt)->condition);
+      return resolveStmt(std::get<8>(stmt)->loopBody);
+    case 9: {  // ForStmtPtr
+      const auto& forStmt = std::get<9>(stmt);
+      if (forStmt->initializer.has_value())
+        resolveStmt(forStmt->initializer.value());
+      if (forStmt->condition.has_value())
+        resolveExpr(forStmt->condition.value());
+      if (forStmt->increment.has_value())
+        resolveExpr(forStmt->increment.value());
+      return resolveStmt(forStmt->loopBody);
+    }
+    default:  // BreakStmtPtr
+      static_assert(std::variant_size_v<StmtPtrVariant> == 11,
+                    "Looks like you forgot to update the cases in "
+                    "Resolver::resolveStmt()!");
+      return;
+  }
+}
+
+void Resolver::resolveExpr(const ExprPtrVariant& expr) {
+  switch (expr.index()) {
+    case 0:  // BinaryExprPtr
+      resolveExpr(std::get<0>(expr)->left);
+      return resolveExpr(std::get<0>(expr)->right);
+    case 1:  // GroupingExprPtr
+      return resolveExpr(std::get<1>(expr)->expression);
+    case 2:  // LiteralExprPtr
+      return;
+    case 3:  // UnaryExprPtr
+      return resolveExpr(std::get<3>(expr)->right);
+    case 4: {  // ConditionalExprPtr
+      const auto& conditional = std::get<4>(expr);
+      resolveExpr(conditional->condition);
+      resolveExpr(conditional->thenBranch);
+      return resolveExpr(conditional->elseBranch);
+    }
+    case 5:  // VariableExprPtr
+      std::get<5>(expr)->slot = slotOf(std::get<5>(expr)->varName);
+      return;
+    case 6: {  // AssignmentExprPtr
+      const auto& assignment = std::get<6>(expr);
+      resolveExpr(assignment->right);
+      assignment->slot = slotOf(assignment->varName);
+      if (assignment->slot < declaredString.size()
+          && declaredString[assignment->slot])
+        assignment->selfAppend = selfAppend(assignment);
+      return;
+    }
+    case 7:  // LogicalExprPtr
+      resolveExpr(std::get<7>(expr)->left);
+      return resolveExpr(std::get<7>(expr)->right);
+    default:
+      static_assert(std::variant_size_v<ExprPtrVariant> == 8,
+                    "Looks like you forgot to update the cases in "
+                    "Resolver::resolveExpr()!");
+      return;
+  }
+}
+
+}  // namespace cpplox::AST
@@ -0,0 +1,58 @@
+#ifndef CPPLOX_AST_RESOLVER_H
+#define CPPLOX_AST_RESOLVER_H
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "NodeTypes.h"
+#include "Token.h"
+
+namespace cpplox::AST {
+
+// An AST pass that numbers the variables of a program and stores each
+// variable's slot in every node that names it, so the Evaluator finds
+// variables by index rather than by name.
+//
+// There is only one scope (declarations all sit at the top of a program), so
+// a name maps to one slot. Slots are handed out for the lifetime of the
+// Resolver: in a REPL session a variable declared by one program keeps its
+// slot in the programs that follow. Names that are never declared get a slot
+// too; it just stays empty, and using it is a runtime error as before.
+//
+// On the way it marks the `x = x + ...` assignments to variables declared a
+// string (AssignmentExpr::selfAppend), which the backends append in place.
+class Resolver {
+ public:
+  void resolve(const Program& program);
+  [[nodiscard]] auto numSlots() const -> size_t;
+
+ private:
+  void resolveStmt(const StmtPtrVariant& stmt);
+  void resolveExpr(const ExprPtrVariant& expr);
+  auto slotOf(const Types::Token& varName) -> uint32_t;
+  void declare(uint32_t slot, bool isString);
+  // The binary expression of an `x = x + ...`, or nullptr.
+  static auto selfAppend(const AssignmentExprPtr& assignment)
+      -> BinaryExprPtr;
+
+  struct Hash {
+    using is_transparent = void;
+    auto operator()(std::string_view str) const -> size_t {
+      return std::hash<std::string_view>{}(str);
+    }
+  };
+  // Compared by name, not by hash: distinct names never share a slot.
+  std::unordered_map<std::string, uint32_t, Hash, std::equal_to<>> slots;
+  // Whether each slot's variable was last declared a string.
+  std::vector<bool> declaredString;
+};
+
+}  // namespace cpplox::AST
+
+#endif  // CPPLOX_AST_RESOLVER_H
@@ -4,7 +4,8 @@ namespace cpplox::ErrorsAndDebug {
 
 auto reportRuntimeError(ErrorReporter& eReporter, const Token& token,
                         const std::string& message) -> RuntimeError {
-  eReporter.setError(token.getLine(), token.getLexeme() + ": " + message);
+  eReporter.setError(token.getOffset(),
+                     std::string(token.getLexeme()) + ": " + message);
   return RuntimeError();
 }
 
@@ -2,6 +2,7 @@
 #define CPPLOX_ERRORSANDDEBUG_RUNTIMEERROR_H
 #pragma once
 
+#include <cstddef>
 #include <exception>
 #include <stdexcept>
 #include <string>
@@ -10,8 +11,8 @@
 #include "Token.h"
 
 struct BreakException : std::exception {
-    int line;
-    explicit BreakException(int l) : line(l) {};
+    size_t offset;
+    explicit BreakException(size_t o) : offset(o) {};
 };
 
 namespace cpplox::ErrorsAndDebug {
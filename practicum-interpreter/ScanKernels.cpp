@@ -0,0 +1,283 @@
+#include "ScanKernels.h"
+
+#include <cstdint>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CPPLOX_SCAN_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+namespace cpplox::ScanKernels {
+
+namespace {
+
+// ================ //
+// Scalar fallbacks //
+// ================ //
+auto isIdentifierChar(char c) -> bool { return isAlpha(c) || isDigit(c); }
+
+auto skipWhitespaceScalar(const char* pos, const char* end) -> const char* {
+  for (; pos < end; ++pos) {
+    switch (*pos) {
+      case '\n':
+      case ' ':
+      case '\t':
+      case '\r': break;
+      default: return pos;
+    }
+  }
+  return pos;
+}
+
+auto skipIdentifierScalar(const char* pos, const char* end) -> const char* {
+  while (pos < end && isIdentifierChar(*pos)) ++pos;
+  return pos;
+}
+
+auto skipLineCommentScalar(const char* pos, const char* end) -> const char* {
+  while (pos < end && *pos != '\n') ++pos;
+  return pos;
+}
+
+auto skipStringBodyScalar(const char* pos, const char* end) -> const char* {
+  while (pos < end && *pos != '"') ++pos;
+  return pos;
+}
+
+auto skipBlockCommentBodyScalar(const char* pos, const char* end)
+    -> const char* {
+  while (pos < end && *pos != '/' && *pos != '*') ++pos;
+  return pos;
+}
+
+void indexNewlinesScalar(const char* pos, const char* end, size_t offset,
+                         std::vector<size_t>& lineStarts) {
+  for (const char* begin = pos; pos < end; ++pos)
+    if (*pos == '\n') lineStarts.push_back(offset + (pos - begin) + 1);
+}
+
+const Kernels scalar{skipWhitespaceScalar,       skipIdentifierScalar,
+                     skipLineCommentScalar,      skipStringBodyScalar,
+                     skipBlockCommentBodyScalar, indexNewlinesScalar,
+                     "scalar"};
+
+#ifdef CPPLOX_SCAN_KERNELS_X86
+// Records a line start after every '\n' whose bit is set in `newlines`;
+// `at` is the offset of the block's first byte.
+inline void pushLineStarts(uint32_t newlines, size_t at,
+                           std::vector<size_t>& lineStarts) {
+  for (; newlines != 0; newlines &= newlines - 1)
+    lineStarts.push_back(at + __builtin_ctz(newlines) + 1);
+}
+
+// ============ //
+// SSE2 kernels //
+// ============ //
+// Every mask below has bit i set if byte i of the 16 byte block matches.
+__attribute__((target("sse2"))) inline auto load16(const char* pos)
+    -> __m128i {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+}
+
+__attribute__((target("sse2"))) inline auto eq16(__m128i v, char c)
+    -> uint32_t {
+  return static_cast<uint32_t>(
+      _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(c))));
+}
+
+__attribute__((target("sse2"))) inline auto inRange16(__m128i v, char lo,
+                                                      char hi) -> __m128i {
+  return _mm_and_si128(
+      _mm_cmpgt_epi8(v, _mm_set1_epi8(static_cast<char>(lo - 1))),
+      _mm_cmplt_epi8(v, _mm_set1_epi8(static_cast<char>(hi + 1))));
+}
+
+__attribute__((target("sse2"))) auto skipWhitespaceSSE2(const char* pos,
+                                                        const char* end)
+    -> const char* {
+  for (; end - pos >= 16; pos += 16) {
+    __m128i v = load16(pos);
+    uint32_t ws = eq16(v, '\n') | eq16(v, ' ') | eq16(v, '\t') | eq16(v, '\r');
+    uint32_t stop = ~ws & 0xFFFFu;
+    if (stop != 0) return pos + __builtin_ctz(stop);
+  }
+  return skipWhitespaceScalar(pos, end);
+}
+
+__attribute__((target("sse2"))) auto skipIdentifierSSE2(const char* pos,
+                                                        const char* end)
+    -> const char* {
+  for (; end - pos >= 16; pos += 16) {
+    __m128i v = load16(pos);
+    __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+    __m128i ident = _mm_or_si128(inRange16(lower, 'a', 'z'),
+                                 inRange16(v, '0', '9'));
+    uint32_t mask =
+        static_cast<uint32_t>(_mm_movemask_epi8(ident)) | eq16(v, '_');
+    uint32_t stop = ~mask & 0xFFFFu;
+    if (stop != 0) return pos + __builtin_ctz(stop);
+  }
+  return skipIdentifierScalar(pos, end);
+}
+
+__attribute__((target("sse2"))) auto skipLineCommentSSE2(const char* pos,
+                                                         const char* end)
+    -> const char* {
+  for (; end - pos >= 16; pos += 16) {
+    uint32_t stop = eq16(load16(pos), '\n');
+    if (stop != 0) return pos + __builtin_ctz(stop);
+  }
+  return skipLineCommentScalar(pos, end);
+}
+
+__attribute__((target("sse2"))) auto skipStringBodySSE2(const char* pos,
+                                                        const char* end)
+    -> const char* {
+  for (; end - pos >= 16; pos += 16) {
+    uint32_t stop = eq16(load16(pos), '"');
+    if (stop != 0) return pos + __builtin_ctz(stop);
+  }
+  return skipStringBodyScalar(pos, end);
+}
+
+__attribute__((target("sse2"))) auto skipBlockCommentBodySSE2(const char* pos,
+                                                              const char* end)
+    -> const char* {
+  for (; end - pos >= 16; pos += 16) {
+    __m128i v = load16(pos);
+    uint32_t stop = eq16(v, '/') | eq16(v, '*');
+    if (stop != 0) return pos + __builtin_ctz(stop);
+  }
+  return skipBlockCommentBodyScalar(pos, end);
+}
+
+__attribute__((target("sse2"))) void indexNewlinesSSE2(
+    const char* pos, const char* end, size_t offset,
+    std::vector<size_t>& lineStarts) {
+  const char* begin = pos;
+  for (; end - pos >= 16; pos += 16)
+    pushLineStarts(eq16(load16(pos), '\n'), offset + (pos - begin), lineStarts);
+  indexNewlinesScalar(pos, end, offset + (pos - begin), lineStarts);
+}
+
+const Kernels sse2{skipWhitespaceSSE2,       skipIdentifierSSE2,
+                   skipLineCommentSSE2,      skipStringBodySSE2,
+                   skipBlockCommentBodySSE2, indexNewlinesSSE2,
+                   "sse2"};
+
+// ============ //
+// AVX2 kernels //
+// ============ //
+// Same as the SSE2 kernels, 32 bytes at a time.
+__attribute__((target("avx2"))) inline auto load32(const char* pos)
+    -> __m256i {
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos));
+}
+
+__attribute__((target("avx2"))) inline auto eq32(__m256i v, char c)
+    -> uint32_t {
+  return static_cast<uint32_t>(
+      _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(c))));
+}
+
+__attribute__((target("avx2"))) inline auto inRange32(__m256i v, char lo,
+                                                      char hi) -> __m256i {
+  return _mm256_and_si256(
+      _mm256_cmpgt_epi8(v, _mm256_set1_epi8(static_cast<char>(lo - 1))),
+      _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(hi + 1)), v));
+}
+
+__attribute__((target("avx2"))) auto skipWhitespaceAVX2(const char* pos,
+                                                        const char* end)
+    -> const char* {
+  for (; end - pos >= 32; pos += 32) {
+    __m256i v = load32(pos);
+    uint32_t ws = eq32(v, '\n') | eq32(v, ' ') | eq32(v, '\t') | eq32(v, '\r');
+    uint32_t stop = ~ws;
+    if (stop != 0) return pos + __builtin_ctz(stop);
+  }
+  return skipWhitespaceSSE2(pos, end);
+}
+
+__attribute__((target("avx2"))) auto skipIdentifierAVX2(const char* pos,
+                                                        const char* end)
+    -> const char* {
+  for (; end - pos >= 32; pos += 32) {
+    __m256i v = load32(pos);
+    __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+    __m256i ident = _mm256_or_si256(inRange32(lower, 'a', 'z'),
+                                    inRange32(v, '0', '9'));
+    uint32_t mask =
+        static_cast<uint32_t>(_mm256_movemask_epi8(ident)) | eq32(v, '_');
+    uint32_t stop = ~mask;
+    if (stop != 0) return pos + __builtin_ctz(stop);
+  }
+  return skipIdentifierSSE2(pos, end);
+}
+
+__attribute__((target("avx2"))) auto skipLineCommentAVX2(const char* pos,
+                                                         const char* end)
+    -> const char* {
+  for (; end - pos >= 32; pos += 32) {
+    uint32_t stop = eq32(load32(pos), '\n');
+    if (stop != 0) return pos + __builtin_ctz(stop);
+  }
+  return skipLineCommentSSE2(pos, end);
+}
+
+__attribute__((target("avx2"))) auto skipStringBodyAVX2(const char* pos,
+                                                        const char* end)
+    -> const char* {
+  for (; end - pos >= 32; pos += 32) {
+    uint32_t stop = eq32(load32(pos), '"');
+    if (stop != 0) return pos + __builtin_ctz(stop);
+  }
+  return skipStringBodySSE2(pos, end);
+}
+
+__attribute__((target("avx2"))) auto skipBlockCommentBodyAVX2(const char* pos,
+                                                              const char* end)
+    -> const char* {
+  for (; end - pos >= 32; pos += 32) {
+    __m256i v = load32(pos);
+    uint32_t stop = eq32(v, '/') | eq32(v, '*');
+    if (stop != 0) return pos + __builtin_ctz(stop);
+  }
+  return skipBlockCommentBodySSE2(pos, end);
+}
+
+__attribute__((target("avx2"))) void indexNewlinesAVX2(
+    const char* pos, const char* end, size_t offset,
+    std::vector<size_t>& lineStarts) {
+  const char* begin = pos;
+  for (; end - pos >= 32; pos += 32)
+    pushLineStarts(eq32(load32(pos), '\n'), offset + (pos - begin), lineStarts);
+  indexNewlinesSSE2(pos, end, offset + (pos - begin), lineStarts);
+}
+
+const Kernels avx2{skipWhitespaceAVX2,       skipIdentifierAVX2,
+                   skipLineCommentAVX2,      skipStringBodyAVX2,
+                   skipBlockCommentBodyAVX2, indexNewlinesAVX2,
+                   "avx2"};
+
+auto selectKernels() -> const Kernels& {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return avx2;
+  if (__builtin_cpu_supports("sse2")) return sse2;
+  return scalar;
+}
+#else
+auto selectKernels() -> const Kernels& { return scalar; }
+#endif  // CPPLOX_SCAN_KERNELS_X86
+
+}  // namespace
+
+auto kernels() -> const Kernels& {
+  static const Kernels& selected = selectKernels();
+  return selected;
+}
+
+auto scalarKernels() -> const Kernels& { return scalar; }
+
+}  // namespace cpplox::ScanKernels
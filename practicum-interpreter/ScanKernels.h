@@ -0,0 +1,56 @@
+#ifndef CPPLOX_SCANNER_SCANKERNELS_H
+#define CPPLOX_SCANNER_SCANKERNELS_H
+#pragma once
+
+// Run-skipping kernels for the Scanner.
+//
+// Each kernel starts at `pos` and returns a pointer to the first byte in
+// [pos, end) that does not belong to the run (or `end`). They never read at or
+// past `end`, so they are safe on mmap'ed buffers. The Scanners don't track
+// lines; indexNewlines() is what a LineIndex is built with.
+//
+// On x86 an SSE2 or AVX2 implementation is selected once at startup, based on
+// what the CPU supports; everywhere else (and for the tails of the buffers)
+// the scalar loops are used.
+
+#include <cstddef>
+#include <vector>
+
+namespace cpplox::ScanKernels {
+
+// The character classes the kernels (and the Scanners) agree on.
+inline auto isAlpha(char c) -> bool {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c == '_');
+}
+
+inline auto isDigit(char c) -> bool { return c >= '0' && c <= '9'; }
+
+struct Kernels {
+  // ' ', '\t', '\r', '\n'
+  auto (*skipWhitespace)(const char* pos, const char* end) -> const char*;
+  // [A-Za-z0-9_]
+  auto (*skipIdentifier)(const char* pos, const char* end) -> const char*;
+  // Everything up to (not including) the next '\n'.
+  auto (*skipLineComment)(const char* pos, const char* end) -> const char*;
+  // Everything up to (not including) the next '"'.
+  auto (*skipStringBody)(const char* pos, const char* end) -> const char*;
+  // Everything up to (not including) the next '/' or '*'.
+  auto (*skipBlockCommentBody)(const char* pos, const char* end)
+      -> const char*;
+  // Appends offset + (p - pos) + 1 to lineStarts for every '\n' at p in
+  // [pos, end); i.e. where each following line starts, if pos is at offset.
+  void (*indexNewlines)(const char* pos, const char* end, size_t offset,
+                        std::vector<size_t>& lineStarts);
+  const char* name;
+};
+
+// The kernels best suited for the CPU we are running on.
+auto kernels() -> const Kernels&;
+
+// The portable byte-at-a-time implementation; the reference the vector
+// kernels have to agree with.
+auto scalarKernels() -> const Kernels&;
+
+}  // namespace cpplox::ScanKernels
+
+#endif  // CPPLOX_SCANNER_SCANKERNELS_H
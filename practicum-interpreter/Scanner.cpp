@@ -1,8 +1,10 @@
 #include "Scanner.h"
 
-#include <map>
+#include <string>
+#include <utility>
 
 #include "ErrorReporter.h"
+#include "Keywords.h"
 #include "Token.h"
 
 namespace cpplox {
@@ -15,70 +17,60 @@ using Types::TokenType;
 
 namespace {
 
-auto isAlpha(char c) -> bool {
-  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c == '_');
-}
-
-auto isDigit(char c) -> bool { return c >= '0' && c <= '9'; }
-
-auto isAlphaNumeric(char c) -> bool { return isAlpha(c) || isDigit(c); }
-
-auto ReservedOrIdentifier(const std::string& str) -> TokenType {
-  static const std::map<std::string, TokenType> lookUpTable{
-      {"and", TokenType::AND},       {"class", TokenType::CLASS},
-      {"else", TokenType::ELSE},     {"false", TokenType::LOX_FALSE},
-      {"fun", TokenType::FUN},       {"for", TokenType::FOR},
-      {"if", TokenType::IF},         {"nil", TokenType::NIL},
-      {"or", TokenType::OR},         {"print", TokenType::PRINT},
-      {"return", TokenType::RETURN}, {"super", TokenType::SUPER},
-      {"this", TokenType::THIS},     {"true", TokenType::LOX_TRUE},
-      {"var", TokenType::VAR},       {"while", TokenType::WHILE},
-      {"int", TokenType::INTW},      {"string", TokenType::STRINGW},
-      {"break", TokenType::BREAK},   {"continue", TokenType::CONTINUE},
-      {"real", TokenType::REALW},    {"program", TokenType::PROGRAM},
-      {"write", TokenType::WRITE},   {"read", TokenType::READ}
-  };
-
-  auto iter = lookUpTable.find(str);
-  if (iter == lookUpTable.end()) {
-    return TokenType::IDENTIFIER;
-  }
-  return iter->second;
-}
+using ScanKernels::isAlpha;
+using ScanKernels::isDigit;
 
-auto getLexeme(const std::string& source, size_t start, size_t end)
-    -> std::string {
+auto getLexeme(std::string_view source, size_t start, size_t end)
+    -> std::string_view {
   return source.substr(start, end);
 }
 
-auto makeOptionalLiteral(TokenType t, const std::string& lexeme)
-    -> OptionalLiteral {
-  switch (t) {
-    case TokenType::NUMBER:
-      return Types::makeOptionalLiteral(std::stod(lexeme));
-    case TokenType::STRING:
-      return Types::makeOptionalLiteral(lexeme.substr(1, lexeme.size() - 2));
-    default: return std::nullopt;
-  }
-}
-
 }  // namespace
 
-Scanner::Scanner(const std::string& p_source, ErrorReporter& p_eReporter)
-    : source(p_source), eReporter(p_eReporter) {}
+Scanner::Scanner(std::string_view p_source, ErrorReporter& p_eReporter)
+    : source(p_source),
+      end(p_source.size()),
+      eReporter(p_eReporter),
+      kernels(ScanKernels::kernels()),
+      tokens(p_source) {}
+
+Scanner::Scanner(std::string_view p_source, size_t p_begin, size_t p_end,
+                 Carry p_carry, ErrorReporter& p_eReporter)
+    : source(p_source),
+      end(p_end),
+      eReporter(p_eReporter),
+      kernels(ScanKernels::kernels()),
+      tokens(p_source),
+      start(p_begin),
+      current(p_begin),
+      carry(p_carry) {}
 
 void Scanner::addToken(TokenType t) {
-  const std::string lexeme = getLexeme(source, start, current - start);
-  tokens.emplace_back(t, lexeme, makeOptionalLiteral(t, lexeme), line);
+  const std::string_view lexeme = getLexeme(source, start, current - start);
+  tokens.push(t, start, current - start, Types::makeOptionalLiteral(t, lexeme));
 }
 
 void Scanner::advance() { ++current; }
 
-void Scanner::skipBlockComment() {
-  int nesting = 1;
+auto Scanner::currentPtr() const -> const char* {
+  return source.data() + current;
+}
+
+auto Scanner::endPtr() const -> const char* {
+  return source.data() + end;
+}
+
+void Scanner::seek(const char* pos) { current = pos - source.data(); }
+
+void Scanner::skipBlockComment(int nesting) {
   while (nesting > 0) {
-    if (peek() == '\0') {
-      eReporter.setError(line, "Block comment not closed?");
+    // Jump to the next '/' or '*'; only those can open or close a comment.
+    seek(kernels.skipBlockCommentBody(currentPtr(), endPtr()));
+    if (isAtEnd()) {
+      if (end < source.size())
+        carry = {Carry::Kind::BLOCK_COMMENT, 0, nesting};
+      else
+        eReporter.setError(current, "Block comment not closed?");
       return;
     }
 
@@ -88,8 +80,6 @@ void Scanner::skipBlockComment() {
     } else if (peek() == '*' && peekNext() == '/') {
       advance();
       --nesting;
-    } else if (peek() == '\n') {
-      ++line;
     }
 
     advance();
@@ -97,13 +87,15 @@ void Scanner::skipBlockComment() {
 }
 
 void Scanner::skipComment() {
-  while (!isAtEnd() && peek() != '\n') {
-    advance();
-  }
+  seek(kernels.skipLineComment(currentPtr(), endPtr()));
+}
+
+void Scanner::skipWhitespace() {
+  seek(kernels.skipWhitespace(currentPtr(), endPtr()));
 }
 
 void Scanner::eatIdentifier() {
-  while (isAlphaNumeric(peek())) advance();
+  seek(kernels.skipIdentifier(currentPtr(), endPtr()));
 }
 
 void Scanner::eatNumber() {
@@ -115,20 +107,24 @@ void Scanner::eatNumber() {
   }
 }
 
-void Scanner::eatString() {
-  while (!isAtEnd() && peek() != '"') {
-    if (peek() == '\n') ++line;
-    advance();
-  }
+// Returns false if the string runs past the end of the chunk; it is then
+// finished by the Scanner of the next chunk.
+auto Scanner::eatString() -> bool {
+  seek(kernels.skipStringBody(currentPtr(), endPtr()));
 
   if (isAtEnd()) {
-    eReporter.setError(line, "Unterminated String!");
+    if (end < source.size()) {
+      carry = {Carry::Kind::STRING, start, 0};
+      return false;
+    }
+    eReporter.setError(current, "Unterminated String!");
   } else {
     advance();  // consume the closing quote '"'
   }
+  return true;
 }
 
-auto Scanner::isAtEnd() -> bool { return current >= source.size(); }
+auto Scanner::isAtEnd() -> bool { return current >= end; }
 
 auto Scanner::matchNext(char expected) -> bool {
   bool nextMatches = (peek() == expected);
@@ -142,7 +138,7 @@ auto Scanner::peek() -> char {
 }
 
 auto Scanner::peekNext() -> char {
-  if ((current + 1) >= source.size()) return '\0';
+  if ((current + 1) >= end) return '\0';
   return source[current + 1];
 }
 
@@ -189,11 +185,13 @@ void Scanner::tokenizeOne() {
       break;
     case ' ':
     case '\t':
-    case '\r': break;  // whitespace
-    case '\n': ++line; break;
+    case '\r':
+    case '\n':  // whitespace; skip the whole run at once
+      current = start;
+      skipWhitespace();
+      break;
     case '"':
-      eatString();
-      addToken(TokenType::STRING);
+      if (eatString()) addToken(TokenType::STRING);
       break;
     default:
       if (isDigit(c)) {
@@ -201,27 +199,42 @@ void Scanner::tokenizeOne() {
         addToken(TokenType::NUMBER);
       } else if (isAlpha(c)) {
         eatIdentifier();
-        const std::string identifier
+        const std::string_view identifier
             = getLexeme(source, start, current - start);
-        addToken(ReservedOrIdentifier(identifier));
+        addToken(Keywords::reservedOrIdentifier(identifier));
       } else {
         std::string message = "Unexpected character: ";
         message.append(1, static_cast<char>(c));
-        eReporter.setError(line, message);
+        eReporter.setError(start, message);
       }
       break;
   }
 }
 
-auto Scanner::tokenize() -> std::vector<Token> {
+auto Scanner::tokenize() -> Types::TokenBuffer {
+  if (source.size() > Types::TokenBuffer::MAX_SOURCE_SIZE) {
+    eReporter.setError(0, "Program is too large to scan.");
+    current = end;
+  }
+
+  // Finish whatever the previous chunk left open.
+  const Carry carryIn = std::exchange(carry, Carry());
+  if (carryIn.kind == Carry::Kind::STRING) {
+    start = carryIn.tokenStart;
+    if (eatString()) addToken(TokenType::STRING);
+  } else if (carryIn.kind == Carry::Kind::BLOCK_COMMENT) {
+    skipBlockComment(carryIn.nesting);
+  }
+
   while (!isAtEnd()) {
     start = current;
     tokenizeOne();
   }
-  tokens.emplace_back(TokenType::LOX_EOF, "", std::nullopt, line);
-  std::vector<Token> tokensVec;
-  std::move(tokens.begin(), tokens.end(), std::back_inserter(tokensVec));
-  return tokensVec;
+  if (end == source.size())
+    tokens.push(TokenType::LOX_EOF, current, 0, std::nullopt);
+  return std::move(tokens);
 }
 
+auto Scanner::carryOut() const -> Carry { return carry; }
+
 }  // namespace cpplox
@@ -2,12 +2,14 @@
 #define CPPLOX_SCANNER_SCANNER_H
 #pragma once
 
-#include <list>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "ErrorReporter.h"
+#include "ScanKernels.h"
 #include "Token.h"
+#include "TokenBuffer.h"
 
 namespace cpplox {
 
@@ -15,11 +17,31 @@ using ErrorsAndDebug::ErrorReporter;
 using Types::Token;
 using Types::TokenType;
 
+// The Scanner never copies lexemes out of the source: the TokenBuffer it
+// produces refers to p_source by offset, so p_source has to outlive the tokens
+// and any AST built from them.
 class Scanner {
  public:
-  Scanner(const std::string &p_source, ErrorReporter &p_eReporter);
+  // What is still open at the end of a chunk. Chunks end right after a '\n',
+  // so only a string or a block comment can straddle a chunk boundary.
+  struct Carry {
+    enum class Kind { NONE, STRING, BLOCK_COMMENT };
+    Kind kind = Kind::NONE;
+    size_t tokenStart = 0;  // STRING: offset of the opening quote
+    int nesting = 0;        // BLOCK_COMMENT: how many comments are open
+  };
 
-  auto tokenize() -> std::vector<Token>;
+  Scanner(std::string_view p_source, ErrorReporter &p_eReporter);
+
+  // Scans only p_source[p_begin, p_end), starting in the state p_carry left
+  // by the previous chunk; see ParallelScanner. Unless p_end is the end of the
+  // source, no LOX_EOF token is added, and an open string or block comment is
+  // left in carryOut() instead of being reported.
+  Scanner(std::string_view p_source, size_t p_begin, size_t p_end,
+          Carry p_carry, ErrorReporter &p_eReporter);
+
+  auto tokenize() -> Types::TokenBuffer;
+  [[nodiscard]] auto carryOut() const -> Carry;
 
  private:
   auto isAtEnd() -> bool;
@@ -28,20 +50,28 @@ class Scanner {
   auto matchNext(char expected) -> bool;
   auto peek() -> char;
   auto peekNext() -> char;
+  void skipWhitespace();
   void skipComment();
-  void skipBlockComment();
+  void skipBlockComment(int nesting = 1);
   void eatIdentifier();
   void eatNumber();
-  void eatString();
+  auto eatString() -> bool;
   void addToken(TokenType t);
 
-  const std::string &source;
+  [[nodiscard]] auto currentPtr() const -> const char *;
+  [[nodiscard]] auto endPtr() const -> const char *;
+  void seek(const char *pos);
+
+  const std::string_view source;
+  const size_t end;  // where this Scanner stops; source.size() unless chunked
   ErrorReporter &eReporter;
+  // Vectorized run skippers (whitespace, identifiers, comments, strings).
+  const ScanKernels::Kernels &kernels;
 
-  std::list<Token> tokens;
+  Types::TokenBuffer tokens;
   size_t start = 0;
   size_t current = 0;
-  int line = 1;
+  Carry carry;
 };
 
 }  // namespace cpplox
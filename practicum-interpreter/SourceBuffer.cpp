@@ -0,0 +1,120 @@
+#include "SourceBuffer.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "DebugPrint.h"
+
+namespace cpplox {
+
+namespace {
+
+// Closes the descriptor on every path out of fromFile().
+struct FileDescriptor {
+  int fd;
+  explicit FileDescriptor(int p_fd) : fd(p_fd) {}
+  ~FileDescriptor() {
+    if (fd >= 0) ::close(fd);
+  }
+  FileDescriptor(const FileDescriptor&) = delete;
+  auto operator=(const FileDescriptor&) -> FileDescriptor& = delete;
+};
+
+// Reads everything left in fd. sizeHint is the expected size (0 if unknown);
+// when it is right, the file lands in the buffer with a single read() and no
+// reallocation (the extra byte leaves room for the read() that sees EOF).
+auto readAll(int fd, size_t sizeHint) -> std::optional<std::string> {
+  const size_t MIN_CHUNK = 64 * 1024;
+  std::string text(sizeHint > 0 ? sizeHint + 1 : MIN_CHUNK, '\0');
+  size_t filled = 0;
+  while (true) {
+    if (filled == text.size()) text.resize(text.size() * 2);
+    ssize_t got = ::read(fd, text.data() + filled, text.size() - filled);
+    if (got < 0) {
+      if (errno == EINTR) continue;
+      return std::nullopt;
+    }
+    if (got == 0) break;
+    filled += static_cast<size_t>(got);
+  }
+  text.resize(filled);
+  return text;
+}
+
+}  // namespace
+
+SourceBuffer::SourceBuffer(std::string p_text) : text(std::move(p_text)) {}
+
+SourceBuffer::SourceBuffer(const char* p_mappedData, size_t p_mappedSize)
+    : mappedData(p_mappedData), mappedSize(p_mappedSize) {}
+
+SourceBuffer::~SourceBuffer() { unmap(); }
+
+SourceBuffer::SourceBuffer(SourceBuffer&& other) noexcept
+    : mappedData(std::exchange(other.mappedData, nullptr)),
+      mappedSize(std::exchange(other.mappedSize, 0)),
+      text(std::move(other.text)) {}
+
+auto SourceBuffer::operator=(SourceBuffer&& other) noexcept -> SourceBuffer& {
+  if (this != &other) {
+    unmap();
+    mappedData = std::exchange(other.mappedData, nullptr);
+    mappedSize = std::exchange(other.mappedSize, 0);
+    text = std::move(other.text);
+  }
+  return *this;
+}
+
+void SourceBuffer::unmap() {
+  if (mappedData != nullptr)
+    ::munmap(const_cast<char*>(mappedData), mappedSize);
+  mappedData = nullptr;
+  mappedSize = 0;
+}
+
+auto SourceBuffer::fromFile(const char* path) -> std::optional<SourceBuffer> {
+  FileDescriptor file(::open(path, O_RDONLY | O_CLOEXEC));
+  if (file.fd < 0) {
+    ErrorsAndDebug::debugPrint("Couldn't open Input source file.");
+    return std::nullopt;
+  }
+
+  struct stat info {};
+  if (::fstat(file.fd, &info) < 0) return std::nullopt;
+
+  if (S_ISREG(info.st_mode) && info.st_size > 0) {
+    const auto size = static_cast<size_t>(info.st_size);
+    void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file.fd, 0);
+    if (mapped != MAP_FAILED) {
+      // The Scanner reads the file front to back exactly once.
+      ::madvise(mapped, size, MADV_SEQUENTIAL);
+      return SourceBuffer(static_cast<const char*>(mapped), size);
+    }
+    ErrorsAndDebug::debugPrint("mmap failed; falling back to read().");
+  }
+
+  const size_t sizeHint
+      = S_ISREG(info.st_mode) ? static_cast<size_t>(info.st_size) : 0;
+  auto text = readAll(file.fd, sizeHint);
+  if (!text.has_value()) {
+    ErrorsAndDebug::debugPrint("Couldn't read Input source file.");
+    return std::nullopt;
+  }
+  return SourceBuffer(std::move(text.value()));
+}
+
+auto SourceBuffer::view() const -> std::string_view {
+  if (mappedData != nullptr) return {mappedData, mappedSize};
+  return text;
+}
+
+auto SourceBuffer::isMapped() const -> bool { return mappedData != nullptr; }
+
+}  // namespace cpplox
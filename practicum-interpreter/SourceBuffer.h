@@ -0,0 +1,48 @@
+#ifndef CPPLOX_INTERPRETERDRIVER_SOURCEBUFFER_H
+#define CPPLOX_INTERPRETERDRIVER_SOURCEBUFFER_H
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace cpplox {
+
+// Owns the text of one compilation unit.
+//
+// Scripts are mmap'ed read-only and scanned in place. When a file can't be
+// mapped (pipes, character devices, empty files) it is read with read() into
+// a heap buffer instead; REPL lines simply hand over their std::string.
+//
+// Tokens and AST nodes point into view(), so a SourceBuffer has to outlive
+// everything built from it. Moving a SourceBuffer may relocate the text of a
+// heap-backed buffer, so only take views once it has reached its final home.
+class SourceBuffer {
+ public:
+  explicit SourceBuffer(std::string p_text);
+  ~SourceBuffer();
+
+  SourceBuffer(SourceBuffer&& other) noexcept;
+  auto operator=(SourceBuffer&& other) noexcept -> SourceBuffer&;
+  SourceBuffer(const SourceBuffer&) = delete;
+  auto operator=(const SourceBuffer&) -> SourceBuffer& = delete;
+
+  // Returns std::nullopt if the file can't be opened or read.
+  static auto fromFile(const char* path) -> std::optional<SourceBuffer>;
+
+  [[nodiscard]] auto view() const -> std::string_view;
+  [[nodiscard]] auto isMapped() const -> bool;
+
+ private:
+  SourceBuffer(const char* p_mappedData, size_t p_mappedSize);
+  void unmap();
+
+  const char* mappedData = nullptr;
+  size_t mappedSize = 0;
+  std::string text;
+};
+
+}  // namespace cpplox
+
+#endif  // CPPLOX_INTERPRETERDRIVER_SOURCEBUFFER_H
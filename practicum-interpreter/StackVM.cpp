@@ -0,0 +1,369 @@
+#include "StackVM.h"
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <utility>
+#include <variant>
+
+#include "DebugPrint.h"
+
+#define EXPECT_TRUE(x) __builtin_expect(static_cast<int64_t>(x), 1)
+#define EXPECT_FALSE(x) __builtin_expect(static_cast<int64_t>(x), 0)
+
+// With GCC and Clang each instruction jumps straight to the next one's
+// handler through a table of label addresses ("computed goto"), instead of
+// going back through a single switch. The switch is the portable fallback.
+#if defined(__GNUC__) || defined(__clang__)
+#define CPPLOX_THREADED_DISPATCH
+#endif
+
+namespace cpplox::VM {
+
+using ErrorsAndDebug::RuntimeError;
+using Evaluator::OperatorError;
+using Evaluator::intDivide;
+using Evaluator::intModulo;
+using Evaluator::realModulo;
+using Evaluator::truncateToInt;
+using Evaluator::wrappingAdd;
+using Evaluator::wrappingMultiply;
+using Evaluator::wrappingNegate;
+using Evaluator::wrappingSubtract;
+
+namespace {
+inline auto readOperand(const uint8_t*& ip) -> uint32_t {
+  uint32_t operand;
+  std::memcpy(&operand, ip, sizeof(operand));
+  ip += sizeof(operand);
+  return operand;
+}
+}  // namespace
+
+StackVM::StackVM(ErrorsAndDebug::ErrorReporter& p_eReporter,
+                 Evaluator::ConstantPool& p_constants)
+    : eReporter(p_eReporter),
+      constants(p_constants),
+      environment(p_eReporter) {}
+
+void StackVM::run(const AST::Program& program) {
+  const Chunk chunk = BytecodeCompiler(constants).compile(program);
+#ifdef VM_DEBUG
+  ErrorsAndDebug::debugPrint(disassemble(chunk));
+#endif  // VM_DEBUG
+  execute(chunk);
+}
+
+void StackVM::operatorError(const Types::Token& op,
+                            const OperatorError& error) {
+  throw ErrorsAndDebug::reportRuntimeError(eReporter, op, error.what());
+}
+
+auto StackVM::recover(const Chunk& chunk, size_t pc,
+                      const RuntimeError& error) -> size_t {
+  // Like the Evaluator's nested evaluateStmts() calls, each statement list
+  // the error propagates through gets a say, innermost first.
+  for (const Chunk::Statement& statement : chunk.statements) {
+    if (statement.start <= pc && pc < statement.end
+        && recoverFromRuntimeError())
+      return statement.end;
+  }
+  throw error;
+}
+
+void StackVM::execute(const Chunk& chunk) {
+  const uint8_t* const code = chunk.code.data();
+  const uint8_t* ip = code;
+  if (stack.size() < chunk.maxStack) stack.resize(chunk.maxStack);
+  LoxObject* const stackBase = stack.data();
+  // One past the top of the stack.
+  LoxObject* sp = stackBase;
+
+#ifdef CPPLOX_THREADED_DISPATCH
+  static const void* const dispatchTable[] = {
+#define CPPLOX_OPCODE_LABEL(name, operands, effect) &&op_##name,
+      CPPLOX_STACK_OPCODES(CPPLOX_OPCODE_LABEL)
+#undef CPPLOX_OPCODE_LABEL
+  };
+#define VM_CASE(name) op_##name
+#define VM_DISPATCH() goto* dispatchTable[*ip++]
+#else
+#define VM_CASE(name) case OpCode::name
+#define VM_DISPATCH() continue
+#endif  // CPPLOX_THREADED_DISPATCH
+
+// Pairs of ints held inline, reals, and an int held inline mixed with a
+// real (promoted) are handled inline, given the condition for each; anything
+// else goes through applyBinary(), which works out the result or the error.
+#define VM_BINARY(name, realCondition, realResult, intCondition, intResult) \
+  VM_CASE(name) : {                                                       \
+    const Types::Token& op = chunk.tokens[readOperand(ip)];               \
+    LoxObject& left = sp[-2];                                             \
+    const LoxObject& right = sp[-1];                                      \
+    if (LoxObject::areSmallInts(left, right)) {                           \
+      const int64_t lhs = left.asSmallInt();                              \
+      const int64_t rhs = right.asSmallInt();                             \
+      if (EXPECT_TRUE(intCondition)) {                                    \
+        left = (intResult);                                               \
+        --sp;                                                             \
+        VM_DISPATCH();                                                    \
+      }                                                                   \
+    } else if (double lhs, rhs;                                           \
+               EXPECT_TRUE(Evaluator::asReals(left, right, lhs, rhs))) {  \
+      if (EXPECT_TRUE(realCondition)) {                                   \
+        left = (realResult);                                              \
+        --sp;                                                             \
+        VM_DISPATCH();                                                    \
+      }                                                                   \
+    }                                                                     \
+    try {                                                                 \
+      left = Evaluator::applyBinary(op, left, right);                     \
+    } catch (const OperatorError& error) {                                \
+      operatorError(op, error);                                           \
+    }                                                                     \
+    --sp;                                                                 \
+    VM_DISPATCH();                                                        \
+  }
+
+// Operands the TypeChecker proved to be two ints or two reals, taken `as`
+// such.
+#define VM_TYPED(name, as, result)                                           \
+  VM_CASE(name) : {                                                         \
+    [[maybe_unused]] const auto lhs = sp[-2].as();                          \
+    [[maybe_unused]] const auto rhs = sp[-1].as();                          \
+    sp[-2] = (result);                                                      \
+    --sp;                                                                   \
+    VM_DISPATCH();                                                          \
+  }
+// The same for '/' and '%', which leave a zero divisor to applyBinary().
+#define VM_TYPED_DIVISION(name, as, condition, result)                       \
+  VM_CASE(name) : {                                                         \
+    const Types::Token& op = chunk.tokens[readOperand(ip)];                 \
+    const auto lhs = sp[-2].as();                                           \
+    const auto rhs = sp[-1].as();                                           \
+    if (EXPECT_TRUE(condition)) {                                           \
+      sp[-2] = (result);                                                    \
+    } else {                                                                \
+      try {                                                                 \
+        sp[-2] = Evaluator::applyBinary(op, sp[-2], sp[-1]);                \
+      } catch (const OperatorError& error) {                                \
+        operatorError(op, error);                                           \
+      }                                                                     \
+    }                                                                       \
+    --sp;                                                                   \
+    VM_DISPATCH();                                                          \
+  }
+
+  for (;;) {
+    try {
+#ifdef CPPLOX_THREADED_DISPATCH
+      VM_DISPATCH();
+#else
+      for (;;) switch (static_cast<OpCode>(*ip++)) {
+#endif  // CPPLOX_THREADED_DISPATCH
+        VM_CASE(CONSTANT) : {
+          *sp++ = constants[readOperand(ip)];
+          VM_DISPATCH();
+        }
+        VM_CASE(NIL) : {
+          *sp++ = nullptr;
+          VM_DISPATCH();
+        }
+        VM_CASE(POP) : {
+          --sp;
+          VM_DISPATCH();
+        }
+        VM_CASE(GET) : {
+          const uint32_t slot = readOperand(ip);
+          *sp++ = environment.get(slot, chunk.tokens[readOperand(ip)]);
+          VM_DISPATCH();
+        }
+        VM_CASE(LOAD) : {
+          *sp++ = environment.value(readOperand(ip));
+          VM_DISPATCH();
+        }
+        VM_CASE(STORE) : {
+          environment.value(readOperand(ip)) = sp[-1];
+          VM_DISPATCH();
+        }
+        VM_CASE(SET) : {
+          const uint32_t slot = readOperand(ip);
+          const Types::Token& varName = chunk.tokens[readOperand(ip)];
+          environment.assign(slot, varName, std::move(sp[-1]));
+          sp[-1] = environment.get(slot, varName);
+          VM_DISPATCH();
+        }
+        VM_CASE(APPEND) : {
+          const uint32_t slot = readOperand(ip);
+          const Types::Token& op = chunk.tokens[readOperand(ip)];
+          --sp;
+          if (!environment.append(slot, sp[-1], *sp)) {
+            try {
+              // The variable was defined when its operand was pushed.
+              environment.assign(slot, op,
+                                 Evaluator::applyBinary(op, sp[-1], *sp));
+            } catch (const OperatorError& error) {
+              operatorError(op, error);
+            }
+          }
+          sp[-1] = environment.get(slot, op);
+          VM_DISPATCH();
+        }
+        VM_CASE(DEFINE) : {
+          const uint32_t slot = readOperand(ip);
+          --sp;
+          environment.define(
+              slot, std::move(*sp),
+              static_cast<Evaluator::DeclaredType>(readOperand(ip)));
+          VM_DISPATCH();
+        }
+        VM_CASE(READ) : {
+          const uint32_t slot = readOperand(ip);
+          environment.read(slot, chunk.tokens[readOperand(ip)]);
+          VM_DISPATCH();
+        }
+        VM_BINARY(ADD, true, lhs + rhs, true, wrappingAdd(lhs, rhs))
+        VM_BINARY(SUBTRACT, true, lhs - rhs, true, wrappingSubtract(lhs, rhs))
+        VM_BINARY(MULTIPLY, true, lhs * rhs, true, wrappingMultiply(lhs, rhs))
+        VM_BINARY(DIVIDE, rhs != 0.0, lhs / rhs, rhs != 0, intDivide(lhs, rhs))
+        VM_BINARY(MODULO, truncateToInt(rhs) != 0, realModulo(lhs, rhs),
+                  rhs != 0, intModulo(lhs, rhs))
+        VM_BINARY(LESS, true, lhs < rhs, true, lhs < rhs)
+        VM_BINARY(LESS_EQUAL, true, lhs <= rhs, true, lhs <= rhs)
+        VM_BINARY(GREATER, true, lhs > rhs, true, lhs > rhs)
+        VM_BINARY(GREATER_EQUAL, true, lhs >= rhs, true, lhs >= rhs)
+        VM_CASE(BINARY) : {
+          const Types::Token& op = chunk.tokens[readOperand(ip)];
+          try {
+            sp[-2] = Evaluator::applyBinary(op, sp[-2], sp[-1]);
+          } catch (const OperatorError& error) {
+            operatorError(op, error);
+          }
+          --sp;
+          VM_DISPATCH();
+        }
+        VM_CASE(EQUAL) : {
+          sp[-2] = Evaluator::areEqual(sp[-2], sp[-1]);
+          --sp;
+          VM_DISPATCH();
+        }
+        VM_CASE(NOT_EQUAL) : {
+          sp[-2] = !Evaluator::areEqual(sp[-2], sp[-1]);
+          --sp;
+          VM_DISPATCH();
+        }
+        VM_CASE(NEGATE) : {
+          const Types::Token& op = chunk.tokens[readOperand(ip)];
+          if (EXPECT_TRUE(sp[-1].isNumber()))
+            sp[-1] = -sp[-1].asNumber();
+          else if (sp[-1].isSmallInt())
+            sp[-1] = wrappingNegate(sp[-1].asSmallInt());
+          else
+            try {
+              sp[-1] = Evaluator::applyUnary(op, sp[-1]);
+            } catch (const OperatorError& error) {
+              operatorError(op, error);
+            }
+          VM_DISPATCH();
+        }
+        VM_CASE(NOT) : {
+          sp[-1] = !Evaluator::isTrue(sp[-1]);
+          VM_DISPATCH();
+        }
+        VM_CASE(UNARY) : {
+          const Types::Token& op = chunk.tokens[readOperand(ip)];
+          try {
+            sp[-1] = Evaluator::applyUnary(op, sp[-1]);
+          } catch (const OperatorError& error) {
+            operatorError(op, error);
+          }
+          VM_DISPATCH();
+        }
+        VM_TYPED(ADD_INT, asInt, wrappingAdd(lhs, rhs))
+        VM_TYPED(SUBTRACT_INT, asInt, wrappingSubtract(lhs, rhs))
+        VM_TYPED(MULTIPLY_INT, asInt, wrappingMultiply(lhs, rhs))
+        VM_TYPED_DIVISION(DIVIDE_INT, asInt, rhs != 0, intDivide(lhs, rhs))
+        VM_TYPED_DIVISION(MODULO_INT, asInt, rhs != 0, intModulo(lhs, rhs))
+        VM_TYPED(LESS_INT, asInt, lhs < rhs)
+        VM_TYPED(LESS_EQUAL_INT, asInt, lhs <= rhs)
+        VM_TYPED(GREATER_INT, asInt, lhs > rhs)
+        VM_TYPED(GREATER_EQUAL_INT, asInt, lhs >= rhs)
+        VM_TYPED(EQUAL_INT, asInt, lhs == rhs)
+        VM_TYPED(NOT_EQUAL_INT, asInt, lhs != rhs)
+        VM_CASE(NEGATE_INT) : {
+          sp[-1] = wrappingNegate(sp[-1].asInt());
+          VM_DISPATCH();
+        }
+        VM_TYPED(ADD_REAL, asNumber, lhs + rhs)
+        VM_TYPED(SUBTRACT_REAL, asNumber, lhs - rhs)
+        VM_TYPED(MULTIPLY_REAL, asNumber, lhs * rhs)
+        VM_TYPED_DIVISION(DIVIDE_REAL, asNumber, rhs != 0.0, lhs / rhs)
+        VM_TYPED_DIVISION(MODULO_REAL, asNumber, truncateToInt(rhs) != 0,
+                          realModulo(lhs, rhs))
+        VM_TYPED(LESS_REAL, asNumber, lhs < rhs)
+        VM_TYPED(LESS_EQUAL_REAL, asNumber, lhs <= rhs)
+        VM_TYPED(GREATER_REAL, asNumber, lhs > rhs)
+        VM_TYPED(GREATER_EQUAL_REAL, asNumber, lhs >= rhs)
+        VM_TYPED(EQUAL_REAL, asNumber, lhs == rhs)
+        VM_TYPED(NOT_EQUAL_REAL, asNumber, lhs != rhs)
+        VM_CASE(NEGATE_REAL) : {
+          sp[-1] = -sp[-1].asNumber();
+          VM_DISPATCH();
+        }
+        VM_CASE(WRITE) : {
+          --sp;
+          std::cout << *sp << " ";
+          VM_DISPATCH();
+        }
+        VM_CASE(WRITE_END) : {
+          std::cout << std::endl;
+          VM_DISPATCH();
+        }
+        VM_CASE(JUMP) : {
+          ip = code + readOperand(ip);
+          VM_DISPATCH();
+        }
+        VM_CASE(JUMP_IF_FALSE) : {
+          const uint32_t target = readOperand(ip);
+          --sp;
+          if (!Evaluator::isTrue(*sp)) ip = code + target;
+          VM_DISPATCH();
+        }
+        VM_CASE(JUMP_IF_FALSE_OR_POP) : {
+          const uint32_t target = readOperand(ip);
+          if (!Evaluator::isTrue(sp[-1]))
+            ip = code + target;
+          else
+            --sp;
+          VM_DISPATCH();
+        }
+        VM_CASE(JUMP_IF_TRUE_OR_POP) : {
+          const uint32_t target = readOperand(ip);
+          if (Evaluator::isTrue(sp[-1]))
+            ip = code + target;
+          else
+            --sp;
+          VM_DISPATCH();
+        }
+        VM_CASE(STRAY_BREAK) : {
+          throw BreakException(chunk.tokens[readOperand(ip)].getOffset());
+        }
+        VM_CASE(HALT) : { return; }
+#ifndef CPPLOX_THREADED_DISPATCH
+      }
+#endif  // CPPLOX_THREADED_DISPATCH
+    } catch (const RuntimeError& error) {
+      // Every statement starts with an empty stack.
+      ip = code + recover(chunk, ip - code - 1, error);
+      sp = stackBase;
+    }
+  }
+
+#undef VM_TYPED
+#undef VM_TYPED_DIVISION
+#undef VM_BINARY
+#undef VM_DISPATCH
+#undef VM_CASE
+}
+
+}  // namespace cpplox::VM
@@ -0,0 +1,46 @@
+#ifndef CPPLOX_VM_STACKVM_H
+#define CPPLOX_VM_STACKVM_H
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "Backend.h"
+#include "Bytecode.h"
+#include "Environment.h"
+#include "ErrorReporter.h"
+#include "NodeTypes.h"
+#include "Objects.h"
+#include "RuntimeError.h"
+
+namespace cpplox::VM {
+
+// The bytecode backend: compiles each program into a Chunk and runs it on an
+// operand stack. Variables live in an Environment, the same as the
+// Evaluator's, and the operators are the ones the Evaluator applies; the
+// common cases of arithmetic and comparison on numbers are done inline.
+class StackVM final : public Evaluator::Backend {
+ public:
+  StackVM(ErrorsAndDebug::ErrorReporter& eReporter,
+          Evaluator::ConstantPool& constants);
+  void run(const AST::Program& program) override;
+
+ private:
+  void execute(const Chunk& chunk);
+  // Where to carry on after a runtime error in the instruction at `pc`: past
+  // the statement it abandons. Rethrows the error if there is none.
+  auto recover(const Chunk& chunk, size_t pc,
+               const ErrorsAndDebug::RuntimeError& error) -> size_t;
+
+  [[noreturn]] void operatorError(const Types::Token& op,
+                                  const Evaluator::OperatorError& error);
+
+  ErrorsAndDebug::ErrorReporter& eReporter;
+  Evaluator::ConstantPool& constants;
+  Evaluator::Environment environment;
+  std::vector<LoxObject> stack;
+};
+
+}  // namespace cpplox::VM
+
+#endif  // CPPLOX_VM_STACKVM_H
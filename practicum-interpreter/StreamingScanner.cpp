@@ -0,0 +1,277 @@
+#include "StreamingScanner.h"
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+#include "Keywords.h"
+
+namespace cpplox {
+
+using ScanKernels::isAlpha;
+using ScanKernels::isDigit;
+
+// ================= //
+// class LexemeStore
+// ================= //
+auto LexemeStore::intern(std::string_view lexeme) -> std::string_view {
+  auto iter = lexemes.find(lexeme);
+  if (iter == lexemes.end()) iter = lexemes.emplace(lexeme).first;
+  return *iter;
+}
+
+// ====================== //
+// class StreamingScanner
+// ====================== //
+StreamingScanner::StreamingScanner(int p_fd, LexemeStore& p_lexemes,
+                                   LineIndex& p_lines,
+                                   ErrorReporter& p_eReporter,
+                                   size_t p_chunkSize)
+    : fd(p_fd),
+      lexemes(p_lexemes),
+      lines(p_lines),
+      eReporter(p_eReporter),
+      kernels(ScanKernels::kernels()),
+      chunkSize(p_chunkSize) {}
+
+auto StreamingScanner::bufferAt(size_t pos) const -> const char* {
+  return window.data() + pos;
+}
+
+auto StreamingScanner::offsetOf(size_t pos) const -> size_t {
+  return windowOffset + pos;
+}
+
+// Counts the lines up to window[pos]; has to run before those bytes are
+// discarded.
+void StreamingScanner::countLines(size_t pos) {
+  if (offsetOf(pos) <= counted) return;
+  const char* from = bufferAt(counted - windowOffset);
+  const char* to = bufferAt(pos);
+  while (const void* newline = std::memchr(from, '\n', to - from)) {
+    from = static_cast<const char*>(newline) + 1;
+    ++line;
+    lineStart = offsetOf(from - bufferAt(0));
+  }
+  counted = offsetOf(pos);
+}
+
+// Adds the line window[pos] is on to `lines`, and returns pos's offset.
+auto StreamingScanner::markLine(size_t pos) -> size_t {
+  countLines(pos);
+  if (line != markedLine) {
+    lines.addLine(line, lineStart);
+    markedLine = line;
+  }
+  return offsetOf(pos);
+}
+
+// Drops everything before `start` and reads the next chunk behind whatever is
+// left. Returns false once the input is exhausted.
+auto StreamingScanner::refill() -> bool {
+  if (atEOF) return false;
+
+  if (start > 0) {
+    countLines(start);
+    std::memmove(window.data(), window.data() + start, filled - start);
+    windowOffset += start;
+    current -= start;
+    filled -= start;
+    start = 0;
+  }
+  // Only grows past two chunks for a token longer than a chunk.
+  if (window.size() - filled < chunkSize) window.resize(filled + chunkSize);
+
+  while (true) {
+    ssize_t got = ::read(fd, window.data() + filled, chunkSize);
+    if (got > 0) {
+      filled += static_cast<size_t>(got);
+      return true;
+    }
+    if (got < 0 && errno == EINTR) continue;
+    if (got < 0)
+      eReporter.setError(markLine(filled), "Failed to read the program.");
+    atEOF = true;
+    return false;
+  }
+}
+
+// Makes sure `count` bytes starting at `current` are buffered.
+auto StreamingScanner::available(size_t count) -> bool {
+  while (filled - current < count)
+    if (!refill()) return false;
+  return true;
+}
+
+void StreamingScanner::advance() { ++current; }
+
+auto StreamingScanner::matchNext(char expected) -> bool {
+  bool nextMatches = (peek() == expected);
+  if (nextMatches) advance();
+  return nextMatches;
+}
+
+auto StreamingScanner::peek() -> char {
+  if (!available(1)) return '\0';
+  return window[current];
+}
+
+auto StreamingScanner::peekNext() -> char {
+  if (!available(2)) return '\0';
+  return window[current + 1];
+}
+
+void StreamingScanner::skipWhitespace() {
+  do {
+    start = current;  // whitespace is never part of a token
+    current = kernels.skipWhitespace(bufferAt(current), bufferAt(filled))
+              - bufferAt(0);
+  } while (current == filled && refill());
+}
+
+void StreamingScanner::skipComment() {
+  do {
+    start = current;
+    current = kernels.skipLineComment(bufferAt(current), bufferAt(filled))
+              - bufferAt(0);
+  } while (current == filled && refill());
+}
+
+void StreamingScanner::skipBlockComment() {
+  int nesting = 1;
+  while (nesting > 0) {
+    start = current;
+    current = kernels.skipBlockCommentBody(bufferAt(current), bufferAt(filled))
+              - bufferAt(0);
+    if (current == filled) {
+      if (!refill()) {
+        eReporter.setError(markLine(current), "Block comment not closed?");
+        return;
+      }
+      continue;
+    }
+
+    start = current;  // keep the '/' or '*' buffered for peekNext()
+    if (peek() == '/' && peekNext() == '*') {
+      advance();
+      ++nesting;
+    } else if (peek() == '*' && peekNext() == '/') {
+      advance();
+      --nesting;
+    }
+
+    advance();
+  }
+  start = current;
+}
+
+void StreamingScanner::eatIdentifier() {
+  do {
+    current = kernels.skipIdentifier(bufferAt(current), bufferAt(filled))
+              - bufferAt(0);
+  } while (current == filled && refill());
+}
+
+void StreamingScanner::eatNumber() {
+  while (isDigit(peek())) advance();
+
+  if (peek() == '.' && isDigit(peekNext())) {
+    advance();
+    while (isDigit(peek())) advance();
+  }
+}
+
+void StreamingScanner::eatString() {
+  do {
+    current = kernels.skipStringBody(bufferAt(current), bufferAt(filled))
+              - bufferAt(0);
+  } while (current == filled && refill());
+
+  if (current == filled) {
+    eReporter.setError(markLine(current), "Unterminated String!");
+  } else {
+    advance();  // consume the closing quote '"'
+  }
+}
+
+auto StreamingScanner::makeToken(TokenType t) -> Token {
+  std::string_view lexeme
+      = lexemes.intern(std::string_view(bufferAt(start), current - start));
+  return Token(t, lexeme, Types::makeOptionalLiteral(t, lexeme),
+               markLine(start));
+}
+
+auto StreamingScanner::scanToken() -> Token {
+  while (true) {
+    skipWhitespace();
+    start = current;
+    if (!available(1))
+      return Token(TokenType::LOX_EOF, "", std::nullopt, markLine(current));
+
+    char c = peek();
+    advance();
+    switch (c) {
+      case '(': return makeToken(TokenType::LEFT_PAREN);
+      case ')': return makeToken(TokenType::RIGHT_PAREN);
+      case '{': return makeToken(TokenType::LEFT_BRACE);
+      case '}': return makeToken(TokenType::RIGHT_BRACE);
+      case ',': return makeToken(TokenType::COMMA);
+      case ':': return makeToken(TokenType::COLON);
+      case '.': return makeToken(TokenType::DOT);
+      case '?': return makeToken(TokenType::QUESTION);
+      case ';': return makeToken(TokenType::SEMICOLON);
+      case '*': return makeToken(TokenType::STAR);
+      case '%': return makeToken(TokenType::MOD);
+      case '!':
+        return makeToken(matchNext('=') ? TokenType::BANG_EQUAL
+                                        : TokenType::BANG);
+      case '=':
+        return makeToken(matchNext('=') ? TokenType::EQUAL_EQUAL
+                                        : TokenType::EQUAL);
+      case '>':
+        return makeToken(matchNext('=') ? TokenType::GREATER_EQUAL
+                                        : TokenType::GREATER);
+      case '<':
+        return makeToken(matchNext('=') ? TokenType::LESS_EQUAL
+                                        : TokenType::LESS);
+      case '-':
+        return makeToken(matchNext('-') ? TokenType::MINUS_MINUS
+                                        : TokenType::MINUS);
+      case '+':
+        return makeToken(matchNext('+') ? TokenType::PLUS_PLUS
+                                        : TokenType::PLUS);
+      case '/':
+        if (matchNext('/')) {
+          skipComment();
+          break;
+        }
+        if (matchNext('*')) {
+          skipBlockComment();
+          break;
+        }
+        return makeToken(TokenType::SLASH);
+      case '"':
+        markLine(start);  // before an unterminated string's error at EOF
+        eatString();
+        return makeToken(TokenType::STRING);
+      default:
+        if (isDigit(c)) {
+          eatNumber();
+          return makeToken(TokenType::NUMBER);
+        }
+        if (isAlpha(c)) {
+          eatIdentifier();
+          return makeToken(Keywords::reservedOrIdentifier(
+              std::string_view(bufferAt(start), current - start)));
+        }
+        std::string message = "Unexpected character: ";
+        message.append(1, static_cast<char>(c));
+        eReporter.setError(markLine(start), message);
+        break;
+    }
+  }
+}
+
+}  // namespace cpplox
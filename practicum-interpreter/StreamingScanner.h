@@ -0,0 +1,117 @@
+#ifndef CPPLOX_SCANNER_STREAMINGSCANNER_H
+#define CPPLOX_SCANNER_STREAMINGSCANNER_H
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include "ErrorReporter.h"
+#include "LineIndex.h"
+#include "ScanKernels.h"
+#include "Token.h"
+
+namespace cpplox {
+
+using ErrorsAndDebug::ErrorReporter;
+using ErrorsAndDebug::LineIndex;
+using Types::Token;
+using Types::TokenType;
+
+// Owns the lexemes of a streamed program.
+//
+// A streamed source is never resident as a whole, so tokens can't be views
+// into it. Instead every lexeme is interned here, and tokens view the interned
+// copy. Identifiers, operators and repeated literals are stored once, so the
+// store grows with the number of distinct lexemes rather than with the size
+// of the source. It has to outlive the tokens and the AST, just like a
+// SourceBuffer.
+class LexemeStore {
+ public:
+  auto intern(std::string_view lexeme) -> std::string_view;
+
+ private:
+  struct Hash {
+    using is_transparent = void;
+    auto operator()(std::string_view str) const -> size_t {
+      return std::hash<std::string_view>{}(str);
+    }
+  };
+  // unordered_set nodes never move, so the views handed out stay valid.
+  std::unordered_set<std::string, Hash, std::equal_to<>> lexemes;
+};
+
+// Scans a program from a file descriptor in fixed-size chunks and hands out
+// one token at a time.
+//
+// Only the unconsumed tail of the current chunk is buffered: whitespace and
+// comments are dropped as soon as they are skipped, and a token, string or
+// block comment that straddles a chunk boundary is carried over into the next
+// read. Memory use is therefore bounded by the chunk size (or the longest
+// single token), independent of the size of the program.
+//
+// Produces exactly the tokens Scanner::tokenize() produces for the same text,
+// and reports errors the same way. Since the source is gone by the time an
+// error is printed, the scanner counts lines as it discards bytes, and adds the
+// line of every token and error to a LineIndex.
+class StreamingScanner {
+ public:
+  static const size_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+  StreamingScanner(int p_fd, LexemeStore &p_lexemes, LineIndex &p_lines,
+                   ErrorReporter &p_eReporter,
+                   size_t p_chunkSize = DEFAULT_CHUNK_SIZE);
+
+  // Returns the next token; LOX_EOF once the input is exhausted.
+  auto scanToken() -> Token;
+
+ private:
+  auto refill() -> bool;
+  auto available(size_t count) -> bool;
+  void advance();
+  auto matchNext(char expected) -> bool;
+  auto peek() -> char;
+  auto peekNext() -> char;
+  void skipWhitespace();
+  void skipComment();
+  void skipBlockComment();
+  void eatIdentifier();
+  void eatNumber();
+  void eatString();
+  auto makeToken(TokenType t) -> Token;
+  [[nodiscard]] auto bufferAt(size_t pos) const -> const char *;
+  // Offset in the stream of window[pos].
+  [[nodiscard]] auto offsetOf(size_t pos) const -> size_t;
+  void countLines(size_t pos);
+  auto markLine(size_t pos) -> size_t;
+
+  int fd;
+  LexemeStore &lexemes;
+  LineIndex &lines;
+  ErrorReporter &eReporter;
+  const ScanKernels::Kernels &kernels;
+  const size_t chunkSize;
+
+  // window[start, filled) holds the bytes read but not yet discarded;
+  // `start` is the beginning of the token being scanned.
+  std::vector<char> window;
+  size_t start = 0;
+  size_t current = 0;
+  size_t filled = 0;
+  size_t windowOffset = 0;
+  bool atEOF = false;
+
+  // Every '\n' before offset `counted` has been counted: `line` is the line
+  // that offset is on, and starts at `lineStart`.
+  size_t counted = 0;
+  int line = 1;
+  size_t lineStart = 0;
+  int markedLine = 0;  // the last line added to `lines`
+};
+
+}  // namespace cpplox
+
+#endif  // CPPLOX_SCANNER_STREAMINGSCANNER_H
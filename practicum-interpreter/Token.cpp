@@ -1,6 +1,8 @@
 #include "Token.h"
 #include "Literal.h"
 
+#include <charconv>
+#include <limits>
 #include <map>
 #include <string>
 #include <type_traits>
@@ -22,6 +24,7 @@ auto TokenTypeString(const TokenType value) -> const std::string& {
       {TokenType::SEMICOLON, "SEMICOLON"},
       {TokenType::SLASH, "SLASH"},
       {TokenType::STAR, "STAR"},
+      {TokenType::MOD, "MOD"},
       {TokenType::BANG, "BANG"},
       {TokenType::BANG_EQUAL, "BANG_EQUAL"},
       {TokenType::EQUAL, "EQUAL"},
@@ -67,28 +70,38 @@ auto TokenTypeString(const TokenType value) -> const std::string& {
   return lookUpTable.find(value)->second;
 }
 
-}  // namespace
+// Parses a NUMBER lexeme ([0-9]+ or [0-9]+.[0-9]+) in place. std::from_chars
+// neither allocates nor looks at the locale, unlike std::stod.
+auto parseNumber(std::string_view lexeme) -> OptionalLiteral {
+  const char* first = lexeme.data();
+  const char* last = first + lexeme.size();
+
+  if (lexeme.find('.') == std::string_view::npos) {
+    int64_t iVal = 0;
+    auto [ptr, ec] = std::from_chars(first, last, iVal);
+    if (ec == std::errc() && ptr == last) return makeOptionalLiteral(iVal);
+    // Too large for an int64_t; fall through and keep it as a real.
+  }
 
-Token::Token(TokenType p_type, std::string p_lexeme, OptionalLiteral p_literal,
-             int p_line)
-    : type(p_type),
-      lexeme(std::move(p_lexeme)),
-      literal(std::move(p_literal)),
-      line(p_line) {}
+  double dVal = 0;
+  auto [ptr, ec] = std::from_chars(first, last, dVal);
+  if (ec == std::errc::result_out_of_range)
+    dVal = std::numeric_limits<double>::infinity();
+  return makeOptionalLiteral(dVal);
+}
 
-Token::Token(TokenType p_type, const char* p_lexeme, OptionalLiteral p_literal,
-             int p_line)
-    : type(p_type),
-      lexeme(p_lexeme),
-      literal(std::move(p_literal)),
-      line(p_line) {}
+}  // namespace
 
-Token::Token(TokenType p_type, const char* p_lexeme)
+Token::Token(TokenType p_type, std::string_view p_lexeme,
+             OptionalLiteral p_literal, size_t p_offset)
+    : type(p_type), lexeme(p_lexeme), literal(p_literal), offset(p_offset) {}
+
+Token::Token(TokenType p_type, std::string_view p_lexeme)
     : type(p_type), lexeme(p_lexeme) {}
 
 auto Token::toString() const -> std::string {
-  std::string result
-      = std::to_string(line) + " " + TokenTypeString(type) + " " + lexeme + " ";
+  std::string result = "@" + std::to_string(offset) + " " + TokenTypeString(type) + " "
+                       + std::string(lexeme) + " ";
   result
       += literal.has_value() ? getLiteralString(literal.value()) : "No Literal";
   return result;
@@ -98,10 +111,21 @@ auto Token::getType() const -> TokenType { return this->type; }
 auto Token::getTypeString() const -> const std::string& {
   return TokenTypeString(this->type);
 }
-auto Token::getLexeme() const -> const std::string& { return this->lexeme; };
+auto Token::getLexeme() const -> std::string_view { return this->lexeme; };
 auto Token::getOptionalLiteral() const -> const OptionalLiteral& {
   return this->literal;
 }
-auto Token::getLine() const -> int { return this->line; }
+auto Token::getOffset() const -> size_t { return this->offset; }
+
+auto makeOptionalLiteral(TokenType t, std::string_view lexeme)
+    -> OptionalLiteral {
+  switch (t) {
+    case TokenType::NUMBER:
+      return parseNumber(lexeme);
+    case TokenType::STRING:
+      return makeOptionalLiteral(lexeme.substr(1, lexeme.size() - 2));
+    default: return std::nullopt;
+  }
+}
 
 }  // namespace cpplox::Types
@@ -2,7 +2,9 @@
 #define TYPES_TOKEN_H
 #pragma once
 
+#include <cstddef>
 #include <string>
+#include <string_view>
 
 #include "Literal.h"
 
@@ -71,29 +73,39 @@ enum class TokenType {
   LOX_EOF
 };
 
+// A Token does not own its lexeme: it is a view into the source buffer the
+// Scanner ran over (or into static storage for synthesized tokens). Whoever
+// owns the source must keep it alive for as long as any Token or AST node
+// built from it is reachable; see InterpreterDriver::sources.
+//
+// Where the token is is kept as the byte offset of its first character; a
+// LineIndex turns that into a line and column when one is needed.
 class Token {
  public:
-  Token(TokenType p_type, std::string p_lexeme, OptionalLiteral p_literal,
-        int p_line);
+  Token(TokenType p_type, std::string_view p_lexeme, OptionalLiteral p_literal,
+        size_t p_offset);
 
-  Token(TokenType p_type, const char* p_lexeme, OptionalLiteral p_literal,
-        int p_line);
-
-  Token(TokenType p_type, const char* p_lexeme);
+  Token(TokenType p_type, std::string_view p_lexeme);
 
   [[nodiscard]] auto toString() const -> std::string;
   [[nodiscard]] auto getType() const -> TokenType;
   [[nodiscard]] auto getTypeString() const -> const std::string&;
-  [[nodiscard]] auto getLine() const -> int;
-  [[nodiscard]] auto getLexeme() const -> const std::string&;
+  [[nodiscard]] auto getOffset() const -> size_t;
+  [[nodiscard]] auto getLexeme() const -> std::string_view;
   [[nodiscard]] auto getOptionalLiteral() const -> const OptionalLiteral&;
 
  private:
   const TokenType type;
-  const std::string lexeme;
+  const std::string_view lexeme;
   OptionalLiteral literal = std::nullopt;
-  const int line = -1;
+  const size_t offset = 0;
 };  // class Token
 
+// The literal value a scanned token of type t carries: the number for NUMBER
+// (an int64_t if it has no fractional part and fits, a double otherwise), the
+// text between the quotes for STRING, nothing otherwise.
+auto makeOptionalLiteral(TokenType t, std::string_view lexeme)
+    -> OptionalLiteral;
+
 }  // namespace cpplox::Types
 #endif  // TYPES_TOKEN_H
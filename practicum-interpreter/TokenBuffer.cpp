@@ -0,0 +1,58 @@
+#include "TokenBuffer.h"
+
+namespace cpplox::Types {
+
+static_assert(static_cast<int>(TokenType::LOX_EOF) <= UINT8_MAX,
+              "TokenType no longer fits the packed type array");
+
+TokenBuffer::TokenBuffer(std::string_view p_source) : source(p_source) {}
+
+void TokenBuffer::push(TokenType type, size_t offset, size_t length,
+                       const OptionalLiteral& literal) {
+  types.push_back(static_cast<uint8_t>(type));
+  offsets.push_back(static_cast<Index>(offset));
+  lengths.push_back(static_cast<Index>(length));
+  if (literal.has_value()) {
+    literalIndices.push_back(static_cast<Index>(literals.size()));
+    literals.push_back(literal.value());
+  } else {
+    literalIndices.push_back(NO_LITERAL);
+  }
+}
+
+void TokenBuffer::append(const TokenBuffer& other) {
+  const auto literalBase = static_cast<Index>(literals.size());
+  types.insert(types.end(), other.types.begin(), other.types.end());
+  offsets.insert(offsets.end(), other.offsets.begin(), other.offsets.end());
+  lengths.insert(lengths.end(), other.lengths.begin(), other.lengths.end());
+  for (Index index : other.literalIndices)
+    literalIndices.push_back(index == NO_LITERAL ? NO_LITERAL
+                                                 : literalBase + index);
+  literals.insert(literals.end(), other.literals.begin(), other.literals.end());
+}
+
+void TokenBuffer::reserve(size_t count) {
+  types.reserve(count);
+  offsets.reserve(count);
+  lengths.reserve(count);
+  literalIndices.reserve(count);
+}
+
+auto TokenBuffer::literal(size_t i) const -> OptionalLiteral {
+  if (literalIndices[i] == NO_LITERAL) return std::nullopt;
+  return literals[literalIndices[i]];
+}
+
+auto TokenBuffer::token(size_t i) const -> Token {
+  return Token(type(i), lexeme(i), literal(i), offset(i));
+}
+
+auto TokenBuffer::memoryUsage() const -> size_t {
+  return types.capacity() * sizeof(uint8_t)
+         + (offsets.capacity() + lengths.capacity()
+            + literalIndices.capacity())
+               * sizeof(Index)
+         + literals.capacity() * sizeof(Literal);
+}
+
+}  // namespace cpplox::Types
@@ -0,0 +1,68 @@
+#ifndef CPPLOX_TYPES_TOKENBUFFER_H
+#define CPPLOX_TYPES_TOKENBUFFER_H
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+#include <vector>
+
+#include "Literal.h"
+#include "Token.h"
+
+namespace cpplox::Types {
+
+// The tokens of a scanned source, stored column-wise.
+//
+// A Token is a type, a lexeme view, an optional literal and an offset: around
+// 64 bytes, even for a ';'. Here each token costs 13 bytes spread over
+// parallel arrays (type, offset, length, literal index), and the few literals
+// a program has live in a side table. The parser mostly looks at types, which
+// are now packed one byte apart.
+//
+// Offsets are relative to the source the buffer was built for; like a Token,
+// the buffer doesn't own that source.
+class TokenBuffer {
+ public:
+  using Index = uint32_t;
+  static constexpr Index NO_LITERAL = std::numeric_limits<Index>::max();
+  // Offsets and lengths are 32 bits wide.
+  static constexpr size_t MAX_SOURCE_SIZE = std::numeric_limits<Index>::max();
+
+  explicit TokenBuffer(std::string_view p_source);
+
+  void push(TokenType type, size_t offset, size_t length,
+            const OptionalLiteral& literal);
+  // Appends the tokens of a buffer over the same source.
+  void append(const TokenBuffer& other);
+  void reserve(size_t count);
+
+  [[nodiscard]] auto size() const -> size_t { return types.size(); }
+  [[nodiscard]] auto type(size_t i) const -> TokenType {
+    return static_cast<TokenType>(types[i]);
+  }
+  [[nodiscard]] auto lexeme(size_t i) const -> std::string_view {
+    return source.substr(offsets[i], lengths[i]);
+  }
+  [[nodiscard]] auto offset(size_t i) const -> size_t { return offsets[i]; }
+  [[nodiscard]] auto literal(size_t i) const -> OptionalLiteral;
+
+  // Materializes token i; AST nodes still hold whole Tokens.
+  [[nodiscard]] auto token(size_t i) const -> Token;
+
+  // Bytes held by the arrays, for PERF_DEBUG output.
+  [[nodiscard]] auto memoryUsage() const -> size_t;
+
+ private:
+  std::string_view source;
+  std::vector<uint8_t> types;
+  std::vector<Index> offsets;
+  std::vector<Index> lengths;
+  std::vector<Index> literalIndices;
+  std::vector<Literal> literals;
+};
+
+}  // namespace cpplox::Types
+
+#endif  // CPPLOX_TYPES_TOKENBUFFER_H
@@ -0,0 +1,63 @@
+#include "TokenSource.h"
+
+#include <algorithm>
+
+namespace cpplox::Parser {
+
+using Types::Token;
+using Types::TokenType;
+
+// ======================= //
+// class BufferTokenSource
+// ======================= //
+BufferTokenSource::BufferTokenSource(const Types::TokenBuffer& p_tokens)
+    : tokens(p_tokens) {}
+
+auto BufferTokenSource::type(size_t ahead) -> TokenType {
+  return tokens.type(std::min(current + ahead, tokens.size() - 1));
+}
+
+auto BufferTokenSource::lexeme() -> std::string_view {
+  return tokens.lexeme(current);
+}
+
+auto BufferTokenSource::offset() -> size_t { return tokens.offset(current); }
+
+auto BufferTokenSource::token() -> Token { return tokens.token(current); }
+
+void BufferTokenSource::advance() {
+  if (current + 1 < tokens.size()) ++current;
+}
+
+// ======================== //
+// class ScannerTokenSource
+// ======================== //
+ScannerTokenSource::ScannerTokenSource(StreamingScanner& p_scanner)
+    : scanner(p_scanner) {}
+
+auto ScannerTokenSource::peek(size_t ahead) -> const Token& {
+  while (lookahead.size() <= ahead) {
+    if (!lookahead.empty() && lookahead.back().getType() == TokenType::LOX_EOF)
+      return lookahead.back();
+    lookahead.push_back(scanner.scanToken());
+  }
+  return lookahead[ahead];
+}
+
+auto ScannerTokenSource::type(size_t ahead) -> TokenType {
+  return peek(ahead).getType();
+}
+
+auto ScannerTokenSource::lexeme() -> std::string_view {
+  return peek().getLexeme();
+}
+
+auto ScannerTokenSource::offset() -> size_t { return peek().getOffset(); }
+
+auto ScannerTokenSource::token() -> Token { return peek(); }
+
+void ScannerTokenSource::advance() {
+  if (peek().getType() != TokenType::LOX_EOF) lookahead.pop_front();
+}
+
+}  // namespace cpplox::Parser
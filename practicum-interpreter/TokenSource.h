@@ -0,0 +1,78 @@
+#ifndef CPPLOX_PARSER_TOKENSOURCE_H
+#define CPPLOX_PARSER_TOKENSOURCE_H
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <string_view>
+
+#include "StreamingScanner.h"
+#include "Token.h"
+#include "TokenBuffer.h"
+
+namespace cpplox::Parser {
+
+// Where RDParser pulls its tokens from.
+//
+// The parser only ever looks a couple of tokens ahead, so a source doesn't
+// need to hold the whole program: BufferTokenSource walks an already scanned
+// TokenBuffer, ScannerTokenSource scans on demand and buffers just the
+// lookahead.
+//
+// Most of the time the parser only needs a token's type, so that is what the
+// interface hands out; a whole Token is only materialized when it goes into
+// the AST or into an error message.
+class TokenSource {
+ public:
+  virtual ~TokenSource() = default;
+
+  // The type of the token `ahead` positions past the current one (0 is the
+  // current token). Looking past the end yields LOX_EOF.
+  virtual auto type(size_t ahead = 0) -> Types::TokenType = 0;
+  // The lexeme and byte offset of the current token.
+  virtual auto lexeme() -> std::string_view = 0;
+  virtual auto offset() -> size_t = 0;
+  // The current token as a whole.
+  virtual auto token() -> Types::Token = 0;
+  // Moves past the current token; a no-op once LOX_EOF is current.
+  virtual void advance() = 0;
+};
+
+class BufferTokenSource final : public TokenSource {
+ public:
+  // tokens must end with a LOX_EOF token.
+  explicit BufferTokenSource(const Types::TokenBuffer& p_tokens);
+
+  auto type(size_t ahead = 0) -> Types::TokenType override;
+  auto lexeme() -> std::string_view override;
+  auto offset() -> size_t override;
+  auto token() -> Types::Token override;
+  void advance() override;
+
+ private:
+  const Types::TokenBuffer& tokens;
+  size_t current = 0;
+};
+
+class ScannerTokenSource final : public TokenSource {
+ public:
+  explicit ScannerTokenSource(StreamingScanner& p_scanner);
+
+  auto type(size_t ahead = 0) -> Types::TokenType override;
+  auto lexeme() -> std::string_view override;
+  auto offset() -> size_t override;
+  auto token() -> Types::Token override;
+  void advance() override;
+
+ private:
+  auto peek(size_t ahead = 0) -> const Types::Token&;
+
+  StreamingScanner& scanner;
+  // Tokens scanned but not consumed yet; front() is the current token.
+  // A deque keeps references to its elements valid across push_back().
+  std::deque<Types::Token> lookahead;
+};
+
+}  // namespace cpplox::Parser
+
+#endif  // CPPLOX_PARSER_TOKENSOURCE_H
@@ -0,0 +1,608 @@
+#include "TypeChecker.h"
+
+#include <array>
+#include <utility>
+#include <variant>
+
+namespace cpplox::AST {
+
+using Evaluator::LoxObject;
+using Types::TokenType;
+
+namespace {
+constexpr auto bit(StaticType type) -> uint8_t {
+  return static_cast<uint8_t>(1U << static_cast<unsigned>(type));
+}
+
+constexpr uint8_t NUMBERS = bit(StaticType::REAL) | bit(StaticType::INT);
+constexpr uint8_t ANYTHING = bit(StaticType::UNKNOWN);
+
+auto isNumber(StaticType type) -> bool {
+  return type == StaticType::REAL || type == StaticType::INT;
+}
+
+auto nameOf(StaticType type) -> const char* {
+  static constexpr std::array<const char*, 6> NAMES
+      = {"string", "real", "bool", "nil", "int", "anything"};
+  return NAMES[static_cast<size_t>(type)];
+}
+
+// "int or string"
+auto describe(uint8_t types) -> std::string {
+  std::string description;
+  for (unsigned type = 0; type <= static_cast<unsigned>(StaticType::UNKNOWN);
+       ++type) {
+    if ((types & (1U << type)) == 0) continue;
+    if (!description.empty()) description += " or ";
+    description += nameOf(static_cast<StaticType>(type));
+  }
+  return description;
+}
+
+// What a binary operator gives for operands of these types; nullopt if it
+// fails for them, UNKNOWN if it isn't one the pass knows.
+auto binaryResult(TokenType op, StaticType left, StaticType right)
+    -> std::optional<StaticType> {
+  const bool numbers = isNumber(left) && isNumber(right);
+  const StaticType number
+      = left == StaticType::INT && right == StaticType::INT ? StaticType::INT
+                                                            : StaticType::REAL;
+  switch (op) {
+    case TokenType::PLUS:
+      if (left == StaticType::STRING || right == StaticType::STRING)
+        return StaticType::STRING;
+      [[fallthrough]];
+    case TokenType::MINUS:
+    case TokenType::STAR:
+    case TokenType::SLASH:
+    case TokenType::MOD:
+      if (numbers) return number;
+      return std::nullopt;
+    case TokenType::LESS:
+    case TokenType::LESS_EQUAL:
+    case TokenType::GREATER:
+    case TokenType::GREATER_EQUAL:
+      if (numbers) return StaticType::BOOL;
+      return std::nullopt;
+    case TokenType::EQUAL_EQUAL:
+    case TokenType::BANG_EQUAL: return StaticType::BOOL;
+    default: return StaticType::UNKNOWN;
+  }
+}
+
+// The operators whose int operands are promoted when the other is a real.
+auto promotes(TokenType op) -> bool {
+  switch (op) {
+    case TokenType::PLUS:
+    case TokenType::MINUS:
+    case TokenType::STAR:
+    case TokenType::SLASH:
+    case TokenType::MOD:
+    case TokenType::LESS:
+    case TokenType::LESS_EQUAL:
+    case TokenType::GREATER:
+    case TokenType::GREATER_EQUAL:
+    case TokenType::EQUAL_EQUAL:
+    case TokenType::BANG_EQUAL: return true;
+    default: return false;
+  }
+}
+
+void intersect(std::vector<bool>& into, const std::vector<bool>& other) {
+  for (size_t slot = 0; slot < into.size(); ++slot)
+    into[slot] = into[slot] && other[slot];
+}
+}  // namespace
+
+auto typeOf(const ExprPtrVariant& expr) -> StaticType {
+  return std::visit([](const auto* node) { return node->type; }, expr);
+}
+
+auto numericOperands(const BinaryExpr& expr) -> StaticType {
+  const StaticType left = typeOf(expr.left);
+  if (isNumber(left) && typeOf(expr.right) == left) return left;
+  return StaticType::UNKNOWN;
+}
+
+// ================= //
+// class TypeChecker
+// ================= //
+TypeChecker::TypeChecker(Evaluator::ConstantPool& p_constants)
+    : constants(p_constants) {}
+
+auto TypeChecker::check(const Program& program, size_t numSlots,
+                        ErrorsAndDebug::ErrorReporter& p_eReporter) -> bool {
+  eReporter = &p_eReporter;
+  if (declared.size() < numSlots) declared.resize(numSlots, StaticType::UNKNOWN);
+  // A program that isn't run doesn't declare anything.
+  const std::vector<StaticType> session = declared;
+  defined.assign(numSlots, StaticType::UNKNOWN);
+  assigned.assign(numSlots, false);
+  failure.reset();
+  breaks.clear();
+  quiet = false;
+
+  checkStmts(program.statements);
+  if (eReporter->getStatus() != ErrorsAndDebug::LoxStatus::OK) {
+    declared = session;
+    return false;
+  }
+  for (const StmtPtrVariant& stmt : program.statements) promoteStmt(stmt);
+  return true;
+}
+
+void TypeChecker::error(const Types::Token& token, const std::string& message) {
+  if (!quiet)
+    eReporter->setError(token.getOffset(),
+                        std::string(token.getLexeme()) + ": " + message);
+}
+
+void TypeChecker::mayFail() {
+  if (failure.has_value())
+    intersect(failure.value(), assigned);
+  else
+    failure = assigned;
+}
+
+// ============ //
+// Statements
+// ============ //
+void TypeChecker::checkStmts(StmtList stmts) {
+  for (const StmtPtrVariant& stmt : stmts) {
+    // The statement list carries on after a statement a runtime error
+    // abandons, with what was assigned by then.
+    std::optional<Assigned> outer = std::exchange(failure, std::nullopt);
+    checkStmt(stmt);
+    if (failure.has_value()) intersect(assigned, failure.value());
+    failure = std::move(outer);
+  }
+}
+
+void TypeChecker::checkStmt(const StmtPtrVariant& stmt) {
+  switch (stmt.index()) {
+    case 0:  // ExprStmtPtr
+      checkExpr(std::get<0>(stmt)->expression);
+      return;
+    case 1:  // WriteStmtPtr
+      for (const ExprPtrVariant& expr : std::get<1>(stmt)->expressions)
+        checkExpr(expr);
+      return;
+    case 2:  // ReadStmtPtr
+      return checkRead(std::get<2>(stmt));
+    case 3:  // BlockStmtPtr
+      return checkStmts(std::get<3>(stmt)->statements);
+    case 4:  // IntStmtPtr
+      return checkDeclaration(std::get<4>(stmt)->varName,
+                              std::get<4>(stmt)->slot,
+                              std::get<4>(stmt)->initializer, StaticType::INT);
+    case 5:  // RealStmtPtr
+      return checkDeclaration(std::get<5>(stmt)->varName,
+                              std::get<5>(stmt)->slot,
+                              std::get<5>(stmt)->initializer, StaticType::REAL);
+    case 6:  // StrStmtPtr
+      return checkDeclaration(std::get<6>(stmt)->varName,
+                              std::get<6>(stmt)->slot,
+                              std::get<6>(stmt)->initializer,
+                              StaticType::STRING);
+    case 7: {  // IfStmtPtr
+      const IfStmtPtr& ifStmt = std::get<7>(stmt);
+      checkExpr(ifStmt->condition);
+      Assigned otherwise = assigned;
+      checkStmt(ifStmt->thenBranch);
+      std::swap(assigned, otherwise);
+      if (ifStmt->elseBranch.has_value())
+        checkStmt(ifStmt->elseBranch.value());
+      intersect(assigned, otherwise);
+      return;
+    }
+    case 8:  // WhileStmtPtr
+      return checkWhile(std::get<8>(stmt));
+    case 9:  // ForStmtPtr
+      return checkFor(std::get<9>(stmt));
+    case 10:  // BreakStmtPtr
+      // A break outside of any loop ends the program.
+      if (!breaks.empty()) {
+        if (breaks.back().has_value())
+          intersect(breaks.back().value(), assigned);
+        else
+          breaks.back() = assigned;
+      }
+      return;
+    default:
+      static_assert(std::variant_size_v<StmtPtrVariant> == 11,
+                    "Looks like you forgot to update the cases in "
+                    "TypeChecker::checkStmt()!");
+      return;
+  }
+}
+
+void TypeChecker::checkDeclaration(
+    const Types::Token& varName, uint32_t slot,
+    const std::optional<ExprPtrVariant>& initializer, StaticType type) {
+  if (initializer.has_value())
+    checkStorable(varName, type, checkExpr(initializer.value()));
+  declared[slot] = type;
+  if (failure.has_value()) {
+    // The variable may not have been (re)defined.
+    defined[slot] = StaticType::UNKNOWN;
+    assigned[slot] = false;
+  } else {
+    defined[slot] = type;
+    assigned[slot] = initializer.has_value()
+                     && assigns(type, typeOf(initializer.value()));
+  }
+}
+
+void TypeChecker::checkRead(const ReadStmtPtr& stmt) {
+  // What is read is parsed as the variable's type.
+  if (defined[stmt->slot] == StaticType::UNKNOWN) mayFail();
+  assigned[stmt->slot] = defined[stmt->slot] != StaticType::UNKNOWN;
+}
+
+void TypeChecker::checkWhile(const WhileStmtPtr& stmt) {
+  checkLoop(stmt->condition, stmt->loopBody, std::nullopt);
+}
+
+void TypeChecker::checkFor(const ForStmtPtr& stmt) {
+  if (stmt->initializer.has_value()) checkStmt(stmt->initializer.value());
+  checkLoop(stmt->condition, stmt->loopBody, stmt->increment);
+}
+
+void TypeChecker::checkLoop(const std::optional<ExprPtrVariant>& condition,
+                            const StmtPtrVariant& body,
+                            const std::optional<ExprPtrVariant>& increment) {
+  const bool wasQuiet = quiet;
+  for (;;) {
+    const Assigned top = assigned;
+    if (condition.has_value()) checkExpr(condition.value());
+    Assigned exit = assigned;
+    breaks.emplace_back();
+    checkStmt(body);
+    if (increment.has_value()) checkExpr(increment.value());
+    const std::optional<Assigned> atBreaks = std::move(breaks.back());
+    breaks.pop_back();
+
+    // What is sure to be assigned the next time round.
+    intersect(assigned, top);
+    if (assigned == top) {
+      // Only a break leaves a loop without a condition.
+      if (!condition.has_value() && atBreaks.has_value())
+        exit = atBreaks.value();
+      else if (atBreaks.has_value())
+        intersect(exit, atBreaks.value());
+      assigned = std::move(exit);
+      break;
+    }
+    quiet = true;
+  }
+  quiet = wasQuiet;
+}
+
+// ============ //
+// Expressions
+// ============ //
+auto TypeChecker::checkExpr(const ExprPtrVariant& expr) -> TypeSet {
+  switch (expr.index()) {
+    case 0:  // BinaryExprPtr
+      return checkBinary(std::get<0>(expr));
+    case 1: {  // GroupingExprPtr
+      const GroupingExprPtr& grouping = std::get<1>(expr);
+      const TypeSet types = checkExpr(grouping->expression);
+      grouping->type = typeOf(grouping->expression);
+      return types;
+    }
+    case 2:  // LiteralExprPtr
+      return checkLiteral(std::get<2>(expr));
+    case 3:  // UnaryExprPtr
+      return checkUnary(std::get<3>(expr));
+    case 4:  // ConditionalExprPtr
+      return checkConditional(std::get<4>(expr));
+    case 5:  // VariableExprPtr
+      return checkVariable(std::get<5>(expr));
+    case 6:  // AssignmentExprPtr
+      return checkAssignment(std::get<6>(expr));
+    case 7:  // LogicalExprPtr
+      return checkLogical(std::get<7>(expr));
+    default:
+      static_assert(std::variant_size_v<ExprPtrVariant> == 8,
+                    "Looks like you forgot to update the cases in "
+                    "TypeChecker::checkExpr()!");
+      return ANYTHING;
+  }
+}
+
+auto TypeChecker::checkBinary(const BinaryExprPtr& expr) -> TypeSet {
+  const TokenType op = expr->op.getType();
+  if (op == TokenType::COMMA) {
+    checkExpr(expr->left);
+    const TypeSet types = checkExpr(expr->right);
+    expr->type = typeOf(expr->right);
+    return types;
+  }
+  const TypeSet left = checkExpr(expr->left);
+  const TypeSet right = checkExpr(expr->right);
+
+  // The types of the result, from those the operands may have.
+  TypeSet types = 0;
+  bool fails = false;
+  if (((left | right) & ANYTHING) != 0) {
+    types = ANYTHING;
+  } else {
+    for (unsigned l = 0; l < static_cast<unsigned>(StaticType::UNKNOWN); ++l) {
+      if ((left & (1U << l)) == 0) continue;
+      for (unsigned r = 0; r < static_cast<unsigned>(StaticType::UNKNOWN);
+           ++r) {
+        if ((right & (1U << r)) == 0) continue;
+        const std::optional<StaticType> result = binaryResult(
+            op, static_cast<StaticType>(l), static_cast<StaticType>(r));
+        if (result.has_value())
+          types |= bit(result.value());
+        else
+          fails = true;
+      }
+    }
+  }
+  if (fails) {
+    error(expr->op, std::string(op == TokenType::PLUS
+                                    ? "Operands must be numbers or strings"
+                                    : "Operands must be numbers")
+                        + "; got " + describe(left) + " and "
+                        + describe(right) + ".");
+    types = ANYTHING;
+  }
+
+  // The type of the result, from those the operands are sure to have.
+  const StaticType leftType = typeOf(expr->left);
+  const StaticType rightType = typeOf(expr->right);
+  const StaticType result
+      = leftType != StaticType::UNKNOWN && rightType != StaticType::UNKNOWN
+            ? binaryResult(op, leftType, rightType).value_or(StaticType::UNKNOWN)
+            : StaticType::UNKNOWN;
+  if (op == TokenType::EQUAL_EQUAL || op == TokenType::BANG_EQUAL
+      || (op == TokenType::PLUS
+          && (leftType == StaticType::STRING
+              || rightType == StaticType::STRING))) {
+    // Never fail.
+    expr->type = op == TokenType::PLUS ? StaticType::STRING : StaticType::BOOL;
+    return types;
+  }
+  if (result == StaticType::UNKNOWN) mayFail();
+  if ((op == TokenType::SLASH || op == TokenType::MOD)
+      && !hasNonzeroValue(expr->right, op == TokenType::MOD))
+    mayFail();
+  // A comparison that doesn't fail gives a bool, whatever its operands.
+  expr->type = types == bit(StaticType::BOOL) ? StaticType::BOOL : result;
+  return types;
+}
+
+auto TypeChecker::hasNonzeroValue(const ExprPtrVariant& divisor,
+                                  bool truncated) const -> bool {
+  if (!std::holds_alternative<LiteralExprPtr>(divisor)) return false;
+  const LiteralExprPtr& literal = std::get<LiteralExprPtr>(divisor);
+  const LoxObject value = valueOf(literal);
+  if (value.isInt()) return value.asInt() != 0;
+  if (value.isNumber())
+    return truncated ? Evaluator::truncateToInt(value.asNumber()) != 0
+                     : value.asNumber() != 0.0;
+  return false;
+}
+
+auto TypeChecker::valueOf(const LiteralExprPtr& literal) const -> LoxObject {
+  if (literal->constant != LiteralExpr::NO_CONSTANT)
+    return constants[literal->constant];
+  return Evaluator::toLoxObject(literal->literalVal);
+}
+
+auto TypeChecker::checkUnary(const UnaryExprPtr& expr) -> TypeSet {
+  const TypeSet right = checkExpr(expr->right);
+  const StaticType rightType = typeOf(expr->right);
+  switch (expr->op.getType()) {
+    case TokenType::BANG:
+      expr->type = StaticType::BOOL;
+      return bit(StaticType::BOOL);
+    case TokenType::MINUS:
+      if (isNumber(rightType)) {
+        expr->type = rightType;
+      } else {
+        mayFail();
+        expr->type = StaticType::UNKNOWN;
+      }
+      if ((right & ANYTHING) != 0) return ANYTHING;
+      if ((right & ~NUMBERS) != 0) {
+        error(expr->op,
+              "Operand must be a number; got " + describe(right) + ".");
+        return ANYTHING;
+      }
+      return right;
+    default:
+      mayFail();
+      expr->type = StaticType::UNKNOWN;
+      return ANYTHING;
+  }
+}
+
+auto TypeChecker::checkLiteral(const LiteralExprPtr& expr) -> TypeSet {
+  const LoxObject value = valueOf(expr);
+  expr->type = static_cast<StaticType>(value.index());
+  return bit(expr->type);
+}
+
+auto TypeChecker::checkVariable(const VariableExprPtr& expr) -> TypeSet {
+  // Reading a variable that doesn't hold a value fails.
+  if (assigned[expr->slot]) {
+    expr->type = defined[expr->slot];
+  } else {
+    mayFail();
+    expr->type = StaticType::UNKNOWN;
+  }
+  const StaticType type = declared[expr->slot];
+  return type != StaticType::UNKNOWN ? bit(type) : ANYTHING;
+}
+
+auto TypeChecker::checkAssignment(const AssignmentExprPtr& expr) -> TypeSet {
+  const TypeSet value = checkExpr(expr->right);
+  const StaticType type = declared[expr->slot];
+  if (type != StaticType::UNKNOWN) checkStorable(expr->varName, type, value);
+  // Assigning to an undefined variable fails, and so does reading back nil.
+  if (defined[expr->slot] == StaticType::UNKNOWN
+      || (value & (bit(StaticType::NIL) | ANYTHING)) != 0)
+    mayFail();
+  store(expr->slot, typeOf(expr->right));
+  expr->type
+      = assigned[expr->slot] ? defined[expr->slot] : StaticType::UNKNOWN;
+  if (type == StaticType::UNKNOWN || (value & ANYTHING) != 0) return value;
+  return bit(type);
+}
+
+auto TypeChecker::checkConditional(const ConditionalExprPtr& expr)
+    -> TypeSet {
+  checkExpr(expr->condition);
+  Assigned otherwise = assigned;
+  const TypeSet thenTypes = checkExpr(expr->thenBranch);
+  std::swap(assigned, otherwise);
+  const TypeSet elseTypes = checkExpr(expr->elseBranch);
+  intersect(assigned, otherwise);
+  const StaticType thenType = typeOf(expr->thenBranch);
+  expr->type = thenType == typeOf(expr->elseBranch) ? thenType
+                                                    : StaticType::UNKNOWN;
+  return thenTypes | elseTypes;
+}
+
+auto TypeChecker::checkLogical(const LogicalExprPtr& expr) -> TypeSet {
+  // The value of either operand; the right one may not be evaluated.
+  const TypeSet left = checkExpr(expr->left);
+  const Assigned afterLeft = assigned;
+  const TypeSet right = checkExpr(expr->right);
+  intersect(assigned, afterLeft);
+  const StaticType leftType = typeOf(expr->left);
+  expr->type
+      = leftType == typeOf(expr->right) ? leftType : StaticType::UNKNOWN;
+  return left | right;
+}
+
+void TypeChecker::checkStorable(const Types::Token& varName, StaticType type,
+                                TypeSet value) {
+  if ((value & ANYTHING) != 0) return;
+  const TypeSet storable
+      = type == StaticType::STRING ? bit(StaticType::STRING) : NUMBERS;
+  if ((value & ~storable) != 0)
+    error(varName, "Can't store " + describe(value & ~storable)
+                       + " in a variable declared " + nameOf(type) + ".");
+}
+
+auto TypeChecker::assigns(StaticType type, StaticType value) -> bool {
+  if (type == StaticType::STRING) return value == StaticType::STRING;
+  return isNumber(type) && isNumber(value);
+}
+
+void TypeChecker::store(uint32_t slot, StaticType value) {
+  assigned[slot] = defined[slot] != StaticType::UNKNOWN
+                   && assigns(defined[slot], value);
+}
+
+// =================== //
+// Literal promotion
+// =================== //
+void TypeChecker::promoteStmt(const StmtPtrVariant& stmt) {
+  switch (stmt.index()) {
+    case 0:  // ExprStmtPtr
+      return promoteExpr(std::get<0>(stmt)->expression);
+    case 1:  // WriteStmtPtr
+      for (const ExprPtrVariant& expr : std::get<1>(stmt)->expressions)
+        promoteExpr(expr);
+      return;
+    case 3:  // BlockStmtPtr
+      for (const StmtPtrVariant& inner : std::get<3>(stmt)->statements)
+        promoteStmt(inner);
+      return;
+    case 4:  // IntStmtPtr
+      if (std::get<4>(stmt)->initializer.has_value())
+        promoteExpr(std::get<4>(stmt)->initializer.value());
+      return;
+    case 5:  // RealStmtPtr
+      if (std::get<5>(stmt)->initializer.has_value())
+        promoteExpr(std::get<5>(stmt)->initializer.value());
+      return;
+    case 6:  // StrStmtPtr
+      if (std::get<6>(stmt)->initializer.has_value())
+        promoteExpr(std::get<6>(stmt)->initializer.value());
+      return;
+    case 7: {  // IfStmtPtr
+      const IfStmtPtr& ifStmt = std::get<7>(stmt);
+      promoteExpr(ifStmt->condition);
+      promoteStmt(ifStmt->thenBranch);
+      if (ifStmt->elseBranch.has_value())
+        promoteStmt(ifStmt->elseBranch.value());
+      return;
+    }
+    case 8:  // WhileStmtPtr
+      promoteExpr(std::get<8>(stmt)->condition);
+      return promoteStmt(std::get<8>(stmt)->loopBody);
+    case 9: {  // ForStmtPtr
+      const ForStmtPtr& forStmt = std::get<9>(stmt);
+      if (forStmt->initializer.has_value())
+        promoteStmt(forStmt->initializer.value());
+      if (forStmt->condition.has_value())
+        promoteExpr(forStmt->condition.value());
+      if (forStmt->increment.has_value())
+        promoteExpr(forStmt->increment.value());
+      return promoteStmt(forStmt->loopBody);
+    }
+    default:  // ReadStmtPtr, BreakStmtPtr
+      static_assert(std::variant_size_v<StmtPtrVariant> == 11,
+                    "Looks like you forgot to update the cases in "
+                    "TypeChecker::promoteStmt()!");
+      return;
+  }
+}
+
+void TypeChecker::promoteExpr(const ExprPtrVariant& expr) {
+  switch (expr.index()) {
+    case 0: {  // BinaryExprPtr
+      const BinaryExprPtr& binary = std::get<0>(expr);
+      promoteExpr(binary->left);
+      promoteExpr(binary->right);
+      if (promotes(binary->op.getType())) {
+        promoteOperand(binary->left, binary->right);
+        promoteOperand(binary->right, binary->left);
+      }
+      return;
+    }
+    case 1:  // GroupingExprPtr
+      return promoteExpr(std::get<1>(expr)->expression);
+    case 3:  // UnaryExprPtr
+      return promoteExpr(std::get<3>(expr)->right);
+    case 4: {  // ConditionalExprPtr
+      const ConditionalExprPtr& conditional = std::get<4>(expr);
+      promoteExpr(conditional->condition);
+      promoteExpr(conditional->thenBranch);
+      return promoteExpr(conditional->elseBranch);
+    }
+    case 6:  // AssignmentExprPtr
+      return promoteExpr(std::get<6>(expr)->right);
+    case 7:  // LogicalExprPtr
+      promoteExpr(std::get<7>(expr)->left);
+      return promoteExpr(std::get<7>(expr)->right);
+    default:  // LiteralExprPtr, VariableExprPtr
+      static_assert(std::variant_size_v<ExprPtrVariant> == 8,
+                    "Looks like you forgot to update the cases in "
+                    "TypeChecker::promoteExpr()!");
+      return;
+  }
+}
+
+void TypeChecker::promoteOperand(const ExprPtrVariant& operand,
+                                 const ExprPtrVariant& other) {
+  if (typeOf(other) != StaticType::REAL
+      || !std::holds_alternative<LiteralExprPtr>(operand))
+    return;
+  const LiteralExprPtr& literal = std::get<LiteralExprPtr>(operand);
+  if (literal->type != StaticType::INT) return;
+  const LoxObject value = valueOf(literal);
+  const auto real = static_cast<double>(value.asInt());
+  literal->literalVal = Types::makeOptionalLiteral(real);
+  literal->constant = constants.add(real);
+  literal->type = StaticType::REAL;
+}
+
+}  // namespace cpplox::AST
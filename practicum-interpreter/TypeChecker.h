@@ -0,0 +1,131 @@
+#ifndef CPPLOX_AST_TYPECHECKER_H
+#define CPPLOX_AST_TYPECHECKER_H
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "ErrorReporter.h"
+#include "NodeTypes.h"
+#include "Objects.h"
+#include "Token.h"
+
+namespace cpplox::AST {
+
+// An AST pass, run after the Resolver, that works out the types of a
+// program's expressions from the types its variables are declared with.
+//
+// Type errors are reported before the program runs, which it then doesn't:
+// arithmetic, comparisons or a `-` on anything but numbers, a `+` of
+// something that is neither a number nor a string, and storing in a
+// variable a value its type can't hold. A variable no declaration in the
+// session has typed yet can be anything, and so can an expression using it;
+// those are left to be checked at run time, as before.
+//
+// Every expression is also given the StaticType it is sure to evaluate to,
+// which lets the backends apply operators to operands of known types
+// without checking them. A declared type alone doesn't make a variable sure
+// to hold a value of it: it holds nil until it is assigned, and a runtime
+// error abandons the statement it happens in, assignments still to come
+// included. So the pass follows which variables are sure to hold a value of
+// their type (are "assigned") at each point of the program, statement by
+// statement, and only reading those counts as being of its type.
+//
+// Last, an int literal operand of an operator whose other operand is sure
+// to be a real is made a real literal, as the operator would promote it.
+class TypeChecker {
+ public:
+  // Literals made reals are added to `constants`.
+  explicit TypeChecker(Evaluator::ConstantPool& constants);
+
+  // The Resolver must have numbered the program's variables, `numSlots` of
+  // them so far. Returns false if the program has type errors, which are
+  // reported to `eReporter`.
+  auto check(const Program& program, size_t numSlots,
+             ErrorsAndDebug::ErrorReporter& eReporter) -> bool;
+
+ private:
+  // The types a value may have: a bit, 1 << the StaticType, for each. One
+  // with the UNKNOWN bit could be anything and is never an error.
+  using TypeSet = uint8_t;
+  // Whether each variable is sure to hold a value of its type, by slot.
+  using Assigned = std::vector<bool>;
+
+  void checkStmts(StmtList stmts);
+  void checkStmt(const StmtPtrVariant& stmt);
+  void checkDeclaration(const Types::Token& varName, uint32_t slot,
+                        const std::optional<ExprPtrVariant>& initializer,
+                        StaticType type);
+  void checkRead(const ReadStmtPtr& stmt);
+  void checkWhile(const WhileStmtPtr& stmt);
+  void checkFor(const ForStmtPtr& stmt);
+  // Checks a loop's condition and body (and increment) until what is
+  // assigned at the top of the loop is the same each time round.
+  void checkLoop(const std::optional<ExprPtrVariant>& condition,
+                 const StmtPtrVariant& body,
+                 const std::optional<ExprPtrVariant>& increment);
+
+  auto checkExpr(const ExprPtrVariant& expr) -> TypeSet;
+  auto checkBinary(const BinaryExprPtr& expr) -> TypeSet;
+  auto checkUnary(const UnaryExprPtr& expr) -> TypeSet;
+  auto checkLiteral(const LiteralExprPtr& expr) -> TypeSet;
+  auto checkVariable(const VariableExprPtr& expr) -> TypeSet;
+  auto checkAssignment(const AssignmentExprPtr& expr) -> TypeSet;
+  auto checkConditional(const ConditionalExprPtr& expr) -> TypeSet;
+  auto checkLogical(const LogicalExprPtr& expr) -> TypeSet;
+  // Reports an error unless a variable declared `type` can hold `value`.
+  void checkStorable(const Types::Token& varName, StaticType type,
+                     TypeSet value);
+  // Whether storing a value sure to be of `value` in a variable sure to be
+  // declared `type` leaves it holding a value of its type.
+  [[nodiscard]] static auto assigns(StaticType type, StaticType value)
+      -> bool;
+  void store(uint32_t slot, StaticType value);
+  // Whether `divisor` is a literal that isn't zero (once truncated, if it is
+  // `truncated`), which a division by it can't fail on.
+  [[nodiscard]] auto hasNonzeroValue(const ExprPtrVariant& divisor,
+                                     bool truncated) const -> bool;
+  [[nodiscard]] auto valueOf(const LiteralExprPtr& literal) const
+      -> Evaluator::LoxObject;
+
+  // A runtime error may abandon the current statement here.
+  void mayFail();
+  void error(const Types::Token& token, const std::string& message);
+
+  // The int literals to make reals, once every type is known.
+  void promoteStmt(const StmtPtrVariant& stmt);
+  void promoteExpr(const ExprPtrVariant& expr);
+  void promoteOperand(const ExprPtrVariant& operand,
+                      const ExprPtrVariant& other);
+
+  Evaluator::ConstantPool& constants;
+  // The type each variable was last declared with in the session, for the
+  // errors; UNKNOWN if it hasn't been.
+  std::vector<StaticType> declared;
+
+  // The rest is for the program being checked. A variable's type as of its
+  // last declaration that is sure to have run, or UNKNOWN.
+  std::vector<StaticType> defined;
+  Assigned assigned;
+  // What is assigned at every point a runtime error may abandon the current
+  // statement at, all together, if there is one.
+  std::optional<Assigned> failure;
+  // The same at the `break`s of each loop being checked.
+  std::vector<std::optional<Assigned>> breaks;
+  ErrorsAndDebug::ErrorReporter* eReporter = nullptr;
+  // Set while a loop is checked again, which reports nothing new.
+  bool quiet = false;
+};
+
+// The StaticType the TypeChecker gave `expr`.
+auto typeOf(const ExprPtrVariant& expr) -> StaticType;
+// REAL or INT if the TypeChecker proved both operands of `expr` to be of
+// that type, UNKNOWN otherwise.
+auto numericOperands(const BinaryExpr& expr) -> StaticType;
+
+}  // namespace cpplox::AST
+
+#endif  // CPPLOX_AST_TYPECHECKER_H
@@ -0,0 +1,210 @@
+// Execution speed of the backends on loop-heavy programs: the tree-walking
+// Evaluator against the closure compiler and the stack and register VMs. Each program is scanned,
+// parsed, folded, resolved and type checked afresh for every run, but only the backend's
+// run() is timed (compilation included, for the VMs). What the backends
+// print is compared before any timing is reported. Built with make JIT=1, the
+// register VM is also timed with its loop JIT.
+//
+// Build & run: make bench_backends && ./bench_backends [iterations] [rounds]
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../ClosureEvaluator.h"
+#include "../ConstantFolder.h"
+#include "../ErrorReporter.h"
+#include "../Evaluator.h"
+#include "../Jit.h"
+#include "../NodeTypes.h"
+#include "../Parser.h"
+#include "../RegisterVM.h"
+#include "../Resolver.h"
+#include "../Scanner.h"
+#include "../StackVM.h"
+#include "../TokenBuffer.h"
+#include "../TokenSource.h"
+#include "../TypeChecker.h"
+
+namespace {
+
+using cpplox::Scanner;
+using cpplox::ErrorsAndDebug::ErrorReporter;
+using cpplox::Evaluator::Backend;
+using cpplox::Evaluator::ConstantPool;
+using cpplox::Parser::BufferTokenSource;
+using cpplox::Parser::RDParser;
+
+struct Script {
+  const char* name;
+  std::string source;
+};
+
+auto makeScripts(size_t iterations) -> std::vector<Script> {
+  const std::string n = std::to_string(iterations);
+  const std::string root = std::to_string(static_cast<size_t>(
+      std::sqrt(static_cast<double>(iterations))));
+  return {
+      {"counting loop",
+       "program {\n  int i = 0, total = 0;\n"
+       "  while (i < " + n + ") { total = total + i % 7; i = i + 1; }\n"
+       "  write(total);\n}\n"},
+      {"nested for",
+       "program {\n  int i, j, total = 0;\n"
+       "  for (i = 0; i < " + root + "; i = i + 1)\n"
+       "    for (j = 0; j < " + root + "; j = j + 1)\n"
+       "      total = total + i * j - (i + j) / 2;\n"
+       "  write(total);\n}\n"},
+      {"branches",
+       "program {\n  int i = 0, evens = 0, odds = 0;\n  real r = 1.0;\n"
+       "  for (i = 0; i < " + n + "; i = i + 1) {\n"
+       "    if (i % 2 == 0 and i > 3) evens = evens + 1;\n"
+       "    else { odds = odds + 1; r = r * 1.0000001; }\n"
+       "    if (evens < 0 or !(odds != -1)) break;\n"
+       "  }\n"
+       "  write(evens, odds, r);\n}\n"},
+      {"collatz",
+       "program {\n  int start, n, steps = 0;\n"
+       "  for (start = 1; steps < " + n + "; start = start + 1) {\n"
+       "    n = start;\n"
+       "    while (n != 1) {\n"
+       "      n = n % 2 == 0 ? n / 2 : 3 * n + 1;\n"
+       "      steps = steps + 1;\n"
+       "    }\n"
+       "  }\n"
+       "  write(start, steps);\n}\n"},
+      {"string copies",
+       "program {\n  int i = 0, same = 0;\n"
+       "  string s = \"a string too long to be stored inline\", t;\n"
+       "  while (i < " + n + ") {\n"
+       "    t = s;\n"
+       "    if (t == s) same = same + 1;\n"
+       "    i = i + 1;\n"
+       "  }\n"
+       "  write(same, t);\n}\n"},
+      {"string compares",
+       "program {\n  int i = 0, hits = 0;\n"
+       "  string key = \"colour\", other = \"color\";\n"
+       "  key = key + \"ed\";\n"
+       "  while (i < " + n + ") {\n"
+       "    if (key == \"coloured\") hits = hits + 1;\n"
+       "    if (key != other) hits = hits + 1;\n"
+       "    i = i + 1;\n"
+       "  }\n"
+       "  write(hits);\n}\n"},
+      // One piece per iteration: 10^6 of them by default.
+      {"string appends",
+       "program {\n  int i = 0;\n  string s = \"\", t;\n"
+       "  while (i < " + n + ") { s = s + \"step\"; i = i + 1; }\n"
+       "  t = s + \".\";\n"
+       "  write(i, t == s + \".\");\n}\n"},
+  };
+}
+
+enum class Kind { TREE_WALKER, CLOSURES, STACK_VM, REGISTER_VM, JIT };
+
+auto makeBackend(Kind kind, ErrorReporter& eReporter, ConstantPool& constants)
+    -> std::unique_ptr<Backend> {
+  switch (kind) {
+    case Kind::CLOSURES:
+      return std::make_unique<cpplox::Evaluator::ClosureEvaluator>(eReporter,
+                                                                   constants);
+    case Kind::STACK_VM:
+      return std::make_unique<cpplox::VM::StackVM>(eReporter, constants);
+    case Kind::REGISTER_VM:
+      return std::make_unique<cpplox::VM::RegisterVM>(eReporter, constants);
+    case Kind::JIT:
+      return std::make_unique<cpplox::VM::RegisterVM>(eReporter, constants,
+                                                      true);
+    case Kind::TREE_WALKER: break;
+  }
+  return std::make_unique<cpplox::Evaluator::Evaluator>(eReporter, constants);
+}
+
+struct Result {
+  std::string output;
+  double ms = 0;
+};
+
+auto runRounds(const std::string& source, Kind kind, int rounds) -> Result {
+  Result result;
+  for (int round = 0; round < rounds; ++round) {
+    ErrorReporter eReporter;
+    const cpplox::Types::TokenBuffer tokens
+        = Scanner(source, eReporter).tokenize();
+    BufferTokenSource tokenSource(tokens);
+    cpplox::AST::Program program;
+    program.statements
+        = RDParser(tokenSource, program.arena, eReporter).parse();
+    ConstantPool constants;
+    cpplox::Evaluator::ConstantFolder(program.arena, constants).fold(program);
+    cpplox::AST::Resolver resolver;
+    resolver.resolve(program);
+    cpplox::AST::TypeChecker(constants).check(program, resolver.numSlots(),
+                                              eReporter);
+    const std::unique_ptr<Backend> backend
+        = makeBackend(kind, eReporter, constants);
+
+    std::ostringstream output;
+    std::streambuf* const stdoutBuf = std::cout.rdbuf(output.rdbuf());
+    auto startTime = std::chrono::steady_clock::now();
+    backend->run(program);
+    result.ms += std::chrono::duration<double, std::milli>(
+                     std::chrono::steady_clock::now() - startTime)
+                     .count();
+    std::cout.rdbuf(stdoutBuf);
+    if (round == 0) result.output = output.str();
+  }
+  result.ms /= rounds;
+  return result;
+}
+
+}  // namespace
+
+auto main(int argc, char** argv) -> int {
+  const size_t iterations
+      = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+  const int rounds = argc > 2 ? std::atoi(argv[2]) : 3;
+
+  std::cout << std::fixed << std::setprecision(1) << "Mean of " << rounds
+            << " rounds, " << iterations << " iterations per script\n";
+  for (const Script& script : makeScripts(iterations)) {
+    const Result tree = runRounds(script.source, Kind::TREE_WALKER, rounds);
+    const Result closures = runRounds(script.source, Kind::CLOSURES, rounds);
+    const Result stack = runRounds(script.source, Kind::STACK_VM, rounds);
+    const Result registers
+        = runRounds(script.source, Kind::REGISTER_VM, rounds);
+    if (closures.output != tree.output || stack.output != tree.output
+        || registers.output != tree.output) {
+      std::cerr << "The backends disagree on '" << script.name << "'!"
+                << std::endl;
+      return 1;
+    }
+    std::cout << "  " << std::left << std::setw(14) << script.name
+              << std::right << " tree " << std::setw(8) << tree.ms
+              << " ms   closure " << std::setw(8) << closures.ms << " ms ("
+              << tree.ms / closures.ms << "x)   stack " << std::setw(8)
+              << stack.ms
+              << " ms (" << tree.ms / stack.ms << "x)   register "
+              << std::setw(8) << registers.ms << " ms ("
+              << tree.ms / registers.ms << "x)";
+#ifdef CPPLOX_JIT
+    const Result jit = runRounds(script.source, Kind::JIT, rounds);
+    if (jit.output != tree.output) {
+      std::cerr << "The JIT disagrees on '" << script.name << "'!"
+                << std::endl;
+      return 1;
+    }
+    std::cout << "   jit " << std::setw(8) << jit.ms << " ms ("
+              << tree.ms / jit.ms << "x)";
+#endif
+    std::cout << '\n';
+  }
+  return 0;
+}
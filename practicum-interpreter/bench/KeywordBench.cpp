@@ -0,0 +1,88 @@
+// Identifier throughput of keyword recognition: the std::map lookup the
+// Scanner used to do (kept here as the baseline) against the compile-time
+// perfect hash in Keywords.h.
+//
+// Build & run: make bench_keywords && ./bench_keywords
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../Keywords.h"
+#include "../Token.h"
+
+namespace {
+
+using cpplox::Types::TokenType;
+
+auto mapLookup(std::string_view str) -> TokenType {
+  static const std::map<std::string, TokenType> lookUpTable{
+      {"and", TokenType::AND},       {"class", TokenType::CLASS},
+      {"else", TokenType::ELSE},     {"false", TokenType::LOX_FALSE},
+      {"fun", TokenType::FUN},       {"for", TokenType::FOR},
+      {"if", TokenType::IF},         {"nil", TokenType::NIL},
+      {"or", TokenType::OR},         {"print", TokenType::PRINT},
+      {"return", TokenType::RETURN}, {"super", TokenType::SUPER},
+      {"this", TokenType::THIS},     {"true", TokenType::LOX_TRUE},
+      {"var", TokenType::VAR},       {"while", TokenType::WHILE},
+      {"int", TokenType::INTW},      {"string", TokenType::STRINGW},
+      {"break", TokenType::BREAK},   {"continue", TokenType::CONTINUE},
+      {"real", TokenType::REALW},    {"program", TokenType::PROGRAM},
+      {"write", TokenType::WRITE},   {"read", TokenType::READ}};
+
+  // The old Scanner built a std::string for every identifier first.
+  auto iter = lookUpTable.find(std::string(str));
+  if (iter == lookUpTable.end()) return TokenType::IDENTIFIER;
+  return iter->second;
+}
+
+// Roughly what generated scripts look like: mostly user identifiers, some of
+// them keyword prefixes, and about a third keywords.
+auto makeIdentifiers(size_t count) -> std::vector<std::string> {
+  const std::vector<std::string> names{
+      "i",     "j",       "counter", "total", "x1",     "value", "fo",
+      "forx",  "whilst",  "writer",  "rea",   "result", "tmp",   "acc",
+      "index", "program", "while",   "write", "int",    "if",    "real"};
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<size_t> pick(0, names.size() - 1);
+  std::vector<std::string> identifiers;
+  identifiers.reserve(count);
+  for (size_t i = 0; i < count; ++i) identifiers.push_back(names[pick(rng)]);
+  return identifiers;
+}
+
+template <typename Fn>
+auto measure(const char* name, const std::vector<std::string>& identifiers,
+             int rounds, Fn lookup) -> double {
+  size_t keywords = 0;
+  auto startTime = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; ++r)
+    for (const auto& identifier : identifiers)
+      keywords += (lookup(identifier) != TokenType::IDENTIFIER);
+  auto endTime = std::chrono::steady_clock::now();
+
+  double seconds = std::chrono::duration<double>(endTime - startTime).count();
+  double perSecond
+      = static_cast<double>(identifiers.size()) * rounds / seconds / 1e6;
+  std::cout << name << ": " << perSecond << " M identifiers/s (" << keywords
+            << " keywords)" << std::endl;
+  return perSecond;
+}
+
+}  // namespace
+
+auto main() -> int {
+  const auto identifiers = makeIdentifiers(1 << 20);
+  const int rounds = 10;
+
+  double before = measure("std::map      ", identifiers, rounds, mapLookup);
+  double after = measure("perfect hash  ", identifiers, rounds,
+                         cpplox::Keywords::reservedOrIdentifier);
+  std::cout << "speedup: " << after / before << "x" << std::endl;
+  return 0;
+}
@@ -0,0 +1,123 @@
+// Parsing throughput on a large generated program: the table-driven Pratt
+// expression parser against the recursive descent chain it replaced. The
+// program is scanned once; both parsers then run over the same tokens, and
+// their ASTs are compared before any timing is reported.
+//
+// Build & run: make bench_parse && ./bench_parse [megabytes] [rounds]
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../Arena.h"
+#include "../ErrorReporter.h"
+#include "../NodeTypes.h"
+#include "../Parser.h"
+#include "../PrettyPrinter.h"
+#include "../Scanner.h"
+#include "../TokenBuffer.h"
+#include "../TokenSource.h"
+
+namespace {
+
+using cpplox::Scanner;
+using cpplox::ErrorsAndDebug::ErrorReporter;
+using cpplox::Parser::BufferTokenSource;
+using cpplox::Parser::RDParser;
+using cpplox::Types::TokenBuffer;
+
+// Expression heavy code touching every precedence level, with plenty of
+// lone literals and variables (the case the descent chain is slowest at).
+auto makeProgram(size_t bytes) -> std::string {
+  std::mt19937 rng(42);
+  auto num = [&rng]() { return std::to_string(rng() % 1000); };
+  std::string program = "program {\n  int i = 0, total = 0, flag = 1;\n"
+                        "  real r = 1.5;\n  string s = \"x\";\n";
+  while (program.size() < bytes) {
+    switch (rng() % 6) {
+      case 0: program += "  i = " + num() + ";\n"; break;
+      case 1: program += "  write(i, total, s, \"label\", " + num() + ");\n";
+        break;
+      case 2:
+        program += "  flag = i < " + num() + " and !(total == 0) or flag;\n";
+        break;
+      case 3:
+        program += "  total = flag ? total + i * " + num()
+                   + " % 7 : -total - r / 2.25;\n";
+        break;
+      case 4:
+        program += "  if (total >= " + num() + ") total = 0; else i = i + 1;\n";
+        break;
+      default:
+        program += "  for (i = 0; i <= " + num() + "; i = i + 1) { total = "
+                   "total + (i - 1) * (i + 1), r = r * 1.01; }\n";
+    }
+  }
+  program += "}\n";
+  return program;
+}
+
+struct Result {
+  std::vector<std::string> ast;
+  std::vector<ErrorReporter::Error> errors;
+  double ms = 0;
+};
+
+auto parseRounds(const TokenBuffer& tokens, RDParser::ExprParser exprParser,
+                 int rounds) -> Result {
+  Result result;
+  for (int round = 0; round < rounds; ++round) {
+    ErrorReporter eReporter;
+    cpplox::AST::Program program;
+    BufferTokenSource tokenSource(tokens);
+    auto startTime = std::chrono::steady_clock::now();
+    program.statements
+        = RDParser(tokenSource, program.arena, eReporter, exprParser).parse();
+    result.ms += std::chrono::duration<double, std::milli>(
+                     std::chrono::steady_clock::now() - startTime)
+                     .count();
+    if (round == 0) {
+      result.ast = cpplox::AST::PrettyPrinter::toString(program.statements);
+      result.errors = eReporter.getErrors();
+    }
+  }
+  result.ms /= rounds;
+  return result;
+}
+
+}  // namespace
+
+auto main(int argc, char** argv) -> int {
+  const size_t megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 16;
+  const int rounds = argc > 2 ? std::atoi(argv[2]) : 5;
+  const std::string program = makeProgram(megabytes * 1024 * 1024);
+
+  ErrorReporter scanErrors;
+  const TokenBuffer tokens = Scanner(program, scanErrors).tokenize();
+
+  const Result descent
+      = parseRounds(tokens, RDParser::ExprParser::DESCENT, rounds);
+  const Result pratt = parseRounds(tokens, RDParser::ExprParser::PRATT, rounds);
+
+  if (descent.ast != pratt.ast || descent.errors != pratt.errors) {
+    std::cerr << "Pratt parser output differs from the descent parser's!"
+              << std::endl;
+    return 1;
+  }
+  if (!pratt.errors.empty()) {
+    std::cerr << "The generated program doesn't parse!" << std::endl;
+    return 1;
+  }
+
+  const double mTokens = static_cast<double>(tokens.size()) / 1e6;
+  std::cout << "Parsed " << tokens.size() << " tokens, " << pratt.ast.size()
+            << " statements (mean of " << rounds << " rounds)\n";
+  std::cout << "  Recursive descent: " << descent.ms << " ms ("
+            << mTokens / descent.ms * 1000 << " Mtokens/s)\n";
+  std::cout << "  Pratt:             " << pratt.ms << " ms ("
+            << mTokens / pratt.ms * 1000 << " Mtokens/s)\n";
+  return 0;
+}
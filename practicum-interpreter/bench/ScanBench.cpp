@@ -0,0 +1,92 @@
+// Scanning throughput on a large generated program: a single Scanner against
+// the ParallelScanner. The two token buffers (and error lists) are compared
+// before any timing is reported; a mismatch is a bug, not a slow run.
+//
+// Build & run: make bench_scan && ./bench_scan [megabytes] [threads]
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "../ErrorReporter.h"
+#include "../ParallelScanner.h"
+#include "../Scanner.h"
+#include "../TokenBuffer.h"
+
+namespace {
+
+using cpplox::ParallelScanner;
+using cpplox::Scanner;
+using cpplox::ErrorsAndDebug::ErrorReporter;
+using cpplox::Types::TokenBuffer;
+
+// Machine-generated looking code, with the occasional string or block
+// comment running over a line break so chunk boundaries land inside them.
+auto makeProgram(size_t bytes) -> std::string {
+  std::mt19937 rng(42);
+  std::string program = "program {\n  int i = 0, total = 0;\n  real r = 1.5;\n";
+  while (program.size() < bytes) {
+    switch (rng() % 8) {
+      case 0: program += "  /* generated\n     block */\n"; break;
+      case 1: program += "  write(\"multi\nline\", total);\n"; break;
+      case 2: program += "  // counter update\n"; break;
+      default:
+        program += "  total = total + i * " + std::to_string(rng() % 1000)
+                   + " - (r / 2.25);\n";
+        program += "  if (total >= 100000) { total = 0; } else i = i + 1;\n";
+    }
+  }
+  program += "}\n";
+  return program;
+}
+
+auto sameTokens(const TokenBuffer& a, const TokenBuffer& b) -> bool {
+  if (a.size() != b.size()) return false;
+  for (size_t i = 0; i < a.size(); ++i)
+    if (a.token(i).toString() != b.token(i).toString()) return false;
+  return true;
+}
+
+template <typename F>
+auto timeMs(F&& f) -> double {
+  auto startTime = std::chrono::steady_clock::now();
+  f();
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - startTime)
+      .count();
+}
+
+}  // namespace
+
+auto main(int argc, char** argv) -> int {
+  const size_t megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 256;
+  const auto threads
+      = static_cast<unsigned>(argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 0);
+  const std::string program = makeProgram(megabytes * 1024 * 1024);
+
+  ErrorReporter serialErrors;
+  ErrorReporter parallelErrors;
+  TokenBuffer serial(program);
+  TokenBuffer parallel(program);
+  const double serialMs = timeMs(
+      [&]() { serial = Scanner(program, serialErrors).tokenize(); });
+  const double parallelMs = timeMs([&]() {
+    parallel = ParallelScanner(program, parallelErrors, threads).tokenize();
+  });
+
+  if (!sameTokens(serial, parallel)
+      || serialErrors.getErrors() != parallelErrors.getErrors()) {
+    std::cerr << "ParallelScanner output differs from Scanner's!" << std::endl;
+    return 1;
+  }
+
+  const double mb = static_cast<double>(program.size()) / (1024 * 1024);
+  std::cout << "Scanned " << mb << " MB, " << serial.size() << " tokens\n";
+  std::cout << "  Scanner:         " << serialMs << " ms ("
+            << mb / serialMs * 1000 << " MB/s)\n";
+  std::cout << "  ParallelScanner: " << parallelMs << " ms ("
+            << mb / parallelMs * 1000 << " MB/s)\n";
+  return 0;
+}
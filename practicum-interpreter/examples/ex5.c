@@ -0,0 +1,23 @@
+program {
+    int n, i, total = 0;
+    real r, scale = 0.5;
+    string s, line = "";
+
+    read(n);
+    read(r);
+    read(s);
+
+    for (i = 1; i <= n; i = i + 1) {
+        if (i % 3 == 0) total = total + i / 3; else total = total - 1;
+        line = line + s;
+        if (i > 5) break;
+    }
+    write(n, total, r * scale, line);
+    write(total > 0 ? "up" : "down", -r, n / 4, n % 4);
+
+    while (n > 0) {
+        n = n - 4;
+        write(100 / n);
+    }
+    write("done");
+}
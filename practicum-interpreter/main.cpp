@@ -1,20 +1,100 @@
 #include <iostream>
+#include <string_view>
 
 #include "InterpreterDriver.h"
+#include "Jit.h"
+
+namespace {
+
+void printUsage() {
+  std::cout << "Usage: ./langc <script.lox> to execute a script or \
+                  just ./langc to drop into a REPL\n"
+               "Options:\n"
+               "  --stream   scan the script in chunks as it is read \
+(pass - to read the program from stdin)\n"
+               "  --backend=tree    walk the AST (the default)\n"
+               "  --backend=closure   compile the AST to bound function pointers\n"
+               "  --backend=stack   compile to bytecode and run it on a stack VM\n"
+               "  --backend=register   compile to register code and run that\n"
+               "  --jit   compile the register VM's hot loops to machine code \
+(implies --backend=register; needs a make JIT=1 build)\n"
+               "  --emit-c   compile the script to a C program on stdout \
+(build it with cc -O2)"
+            << std::endl;
+}
+
+}  // namespace
 
 // We are using SYSEXITS exit codes
 auto main(int argc, char const *argv[]) -> int {
-  if (argc > 2) {
-    std::cout << "Usage: ./langc <script.lox> to execute a script or \
-                  just ./langc to drop into a REPL"
+  bool stream = false;
+  bool jit = false;
+  bool emitC = false;
+  bool backendGiven = false;
+  cpplox::BackendKind backend = cpplox::BackendKind::TREE_WALKER;
+  const char *script = nullptr;
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg(argv[i]);
+    if (arg == "--stream") {
+      stream = true;
+    } else if (arg == "--jit") {
+      jit = true;
+    } else if (arg == "--emit-c") {
+      emitC = true;
+    } else if (arg == "--backend=tree") {
+      backend = cpplox::BackendKind::TREE_WALKER;
+      backendGiven = true;
+    } else if (arg == "--backend=closure") {
+      backend = cpplox::BackendKind::CLOSURES;
+      backendGiven = true;
+    } else if (arg == "--backend=stack") {
+      backend = cpplox::BackendKind::STACK_VM;
+      backendGiven = true;
+    } else if (arg == "--backend=register") {
+      backend = cpplox::BackendKind::REGISTER_VM;
+      backendGiven = true;
+    } else if (script == nullptr && (arg == "-" || arg.substr(0, 2) != "--")) {
+      script = argv[i];
+    } else {
+      printUsage();
+      std::exit(64);
+    }
+  }
+
+  // Streaming reads a script; the REPL reads lines on its own.
+  if (stream && script == nullptr) {
+    printUsage();
+    std::exit(64);
+  }
+
+  // A C program is compiled from a whole script, which nothing runs.
+  if (emitC && (script == nullptr || stream || jit || backendGiven)) {
+    printUsage();
+    std::exit(64);
+  }
+
+  if (jit) {
+    // The JIT compiles register code, so it only goes with that backend.
+    if (backendGiven && backend != cpplox::BackendKind::REGISTER_VM) {
+      printUsage();
+      std::exit(64);
+    }
+    backend = cpplox::BackendKind::REGISTER_VM;
+#ifndef CPPLOX_JIT
+    std::cerr << "This build has no JIT: rebuild with make JIT=1 (x86-64 "
+                 "Linux only)"
               << std::endl;
     std::exit(64);
+#endif
   }
 
-  cpplox::InterpreterDriver interpreter;
+  cpplox::InterpreterDriver interpreter(backend, jit);
+
+  if (emitC) return interpreter.emitC(script);
 
-  if (2 == argc) {
-    return interpreter.runScript(argv[1]);
+  if (script != nullptr) {
+    return stream ? interpreter.runStream(script)
+                  : interpreter.runScript(script);
   }
 
   interpreter.runREPL();
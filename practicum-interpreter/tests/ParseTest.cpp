@@ -0,0 +1,145 @@
+// Differential test: the Pratt expression parser has to build the same AST
+// and report the same errors as the recursive descent chain. Besides
+// examples/*.c it parses malformed expressions (missing operands, stray binary
+// operators, bad assignment targets, unterminated conditionals) and random
+// token soup, so the error productions and the recovery after them are
+// compared too, not just well-formed code.
+//
+// Build & run: make test_parse
+
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../Arena.h"
+#include "../ErrorReporter.h"
+#include "../NodeTypes.h"
+#include "../Parser.h"
+#include "../PrettyPrinter.h"
+#include "../Scanner.h"
+#include "../TokenBuffer.h"
+#include "../TokenSource.h"
+
+namespace {
+
+using cpplox::Scanner;
+using cpplox::ErrorsAndDebug::ErrorReporter;
+using cpplox::Parser::BufferTokenSource;
+using cpplox::Parser::RDParser;
+using cpplox::Types::TokenBuffer;
+
+const char* const MALFORMED[] = {
+    // Missing operands.
+    "x = ;", "x = 1 + ;", "x = (1 * );", "x = !;", "x = -;", "write(1, );",
+    "x = 1 < ;", "x = (a and );", "x = ();", "x = 1 +;\n y = 2;",
+    // Stray binary operators.
+    "* 3;", "/ x;", "== x;", "!= 1;", "> 2;", ">= a;", "< b;", "<= c;",
+    "+ 1;", "% 4;", "and y;", "or y;", "x = * 2;", "x = 1 * * 2;",
+    "x = a == == b;", "x = (, 1);", "x = a or or b;",
+    // Bad assignment targets.
+    "1 = 2;", "(x) = 1;", "x + y = 3;", "-x = 1;", "a ? b : c = 1;",
+    "\"s\" = x;", "x = y + 1 = 2;", "(a, b) = 1;",
+    // Unterminated conditionals.
+    "x = a ? b;", "x = a ? b :;", "x = a ?;", "x = a ? : c;",
+    "x = a ? b ? c;", "x = (a ? b);", "x = a ? b : c ? d;",
+    // Unbalanced and otherwise broken.
+    "x = (1 + 2;", "x = 1 + 2);", "x = 1 2;", "x = a b c;", "x = 1 +",
+    "write(;", "if (x = ) y = 1; else y = 2;", "while (a ?) x = 1;",
+    "for (i = ; i < ; i = i +) x = 1;", "x = a, , b;", "x = ++;",
+    "x = --a;", "x = a++ + 1;"};
+
+// Tokens that can appear in an expression, good and bad.
+const char* const EXPR_TOKENS[] = {
+    "a", "b", "x", "1", "2.5", "\"s\"", "true", "false", "nil", "(", ")",
+    "+", "-", "*", "/", "%", "!", "==", "!=", "<", "<=", ">", ">=",
+    "and", "or", "?", ":", "=", ",", "++", "--", ";"};
+
+auto wrap(const std::string& operators) -> std::string {
+  return "program {\n  int a, b, x, y, i;\n  real c, d;\n" + operators
+         + "\n  write(a);\n}\n";
+}
+
+auto randomOperators(std::mt19937& rng) -> std::string {
+  const size_t count = sizeof(EXPR_TOKENS) / sizeof(EXPR_TOKENS[0]);
+  std::string operators;
+  const size_t statements = 1 + rng() % 4;
+  for (size_t s = 0; s < statements; ++s) {
+    operators += "  x = ";
+    const size_t tokens = 1 + rng() % 12;
+    for (size_t t = 0; t < tokens; ++t)
+      operators += std::string(EXPR_TOKENS[rng() % count]) + " ";
+    operators += ";\n";
+  }
+  return operators;
+}
+
+auto parse(const TokenBuffer& tokens, RDParser::ExprParser exprParser)
+    -> std::string {
+  ErrorReporter eReporter;
+  cpplox::AST::Program program;
+  BufferTokenSource tokenSource(tokens);
+  program.statements
+      = RDParser(tokenSource, program.arena, eReporter, exprParser).parse();
+  std::string result;
+  for (const auto& statement :
+       cpplox::AST::PrettyPrinter::toString(program.statements))
+    result += statement + "\n";
+  for (const auto& error : eReporter.getErrors())
+    result += "error @" + std::to_string(error.offset) + " " + error.message
+              + "\n";
+  return result;
+}
+
+// Returns false (and says why) if the two parsers disagree on `source`.
+auto checkSource(const std::string& name, const std::string& source) -> bool {
+  ErrorReporter scanErrors;
+  const TokenBuffer tokens = Scanner(source, scanErrors).tokenize();
+  const std::string descent = parse(tokens, RDParser::ExprParser::DESCENT);
+  const std::string pratt = parse(tokens, RDParser::ExprParser::PRATT);
+  if (pratt != descent) {
+    std::cerr << name << ": PRATT differs from DESCENT on\n"
+              << source << "--- DESCENT\n"
+              << descent << "--- PRATT\n"
+              << pratt;
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+auto main(int argc, char** argv) -> int {
+  size_t sources = 0;
+  for (int i = 1; i < argc; ++i, ++sources) {
+    std::ifstream file(argv[i]);
+    if (!file) {
+      std::cerr << "Can't open " << argv[i] << std::endl;
+      return 1;
+    }
+    std::stringstream contents;
+    contents << file.rdbuf();
+    if (!checkSource(argv[i], contents.str())) return 1;
+  }
+
+  for (const char* operators : MALFORMED) {
+    // Alone, and followed by valid statements the parser has to recover to.
+    if (!checkSource(operators, wrap(operators))
+        || !checkSource(operators, wrap(std::string(operators)
+                                        + "\n  a = b + 1;\n  x = a ? b : c;")))
+      return 1;
+    sources += 2;
+  }
+
+  std::mt19937 rng(2024);
+  for (int seed = 0; seed < 2000; ++seed, ++sources)
+    if (!checkSource("random #" + std::to_string(seed),
+                     wrap(randomOperators(rng))))
+      return 1;
+
+  std::cout << "PRATT and DESCENT agree on " << sources << " sources"
+            << std::endl;
+  return 0;
+}
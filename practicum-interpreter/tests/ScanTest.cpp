@@ -0,0 +1,113 @@
+// Differential test: the ParallelScanner has to produce exactly the tokens and
+// errors a single Scanner does. Each source is scanned with tiny chunks and
+// several thread counts, so chunk boundaries land inside strings, nested block
+// comments and line comments, which MIN_CHUNK_SIZE never lets small files do.
+//
+// Build & run: make test_scan (scans examples/*.c and random fragments)
+
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+
+#include "../ErrorReporter.h"
+#include "../ParallelScanner.h"
+#include "../Scanner.h"
+#include "../TokenBuffer.h"
+
+namespace {
+
+using cpplox::ParallelScanner;
+using cpplox::Scanner;
+using cpplox::ErrorsAndDebug::ErrorReporter;
+using cpplox::Types::TokenBuffer;
+
+const unsigned THREAD_COUNTS[] = {1, 2, 3, 4, 8};
+const size_t CHUNK_SIZES[] = {1, 7, 64};
+
+// Bits of source, good and bad, that a chunk boundary may split.
+const char* const FRAGMENTS[] = {
+    "program {", "}", "int i = 0;", "real r = 1.5;", "i = i + 1;", "x",
+    "abc_9", "42", "3.25", "1.", "==", "!=", "<=", ">=", "=", "!", "?", ":",
+    ",", "(", ")", "-", "*", "/", "%", "and", "or", "while", "for", "if",
+    " ", "\t", "\r", "\n", "\n\n", "@", "#", "$",
+    // Strings, including unterminated ones and ones spanning lines.
+    "\"str\"", "\"a\nb\"", "\"\n\n\"", "\"open", "\"",
+    // Comments, including nested and unterminated ones.
+    "// line\n", "//", "/* c */", "/* a\n b */", "/* /* nest */ */",
+    "/* /*\n*/\n*/", "/*", "*/", "/* \" */", "\" /* \""};
+
+auto randomSource(std::mt19937& rng) -> std::string {
+  const size_t count = sizeof(FRAGMENTS) / sizeof(FRAGMENTS[0]);
+  std::string source;
+  const size_t pieces = 1 + rng() % 200;
+  for (size_t i = 0; i < pieces; ++i) {
+    source += FRAGMENTS[rng() % count];
+    if (rng() % 3 == 0) source += rng() % 2 == 0 ? " " : "\n";
+  }
+  return source;
+}
+
+auto describe(const TokenBuffer& tokens, const ErrorReporter& errors)
+    -> std::string {
+  std::string result;
+  for (size_t i = 0; i < tokens.size(); ++i)
+    result += tokens.token(i).toString() + "\n";
+  for (const auto& error : errors.getErrors())
+    result += "error @" + std::to_string(error.offset) + " " + error.message
+              + "\n";
+  return result;
+}
+
+// Returns false (and says why) if any ParallelScanner setup disagrees.
+auto checkSource(const std::string& name, const std::string& source) -> bool {
+  ErrorReporter serialErrors;
+  const TokenBuffer serial = Scanner(source, serialErrors).tokenize();
+  const std::string expected = describe(serial, serialErrors);
+
+  for (unsigned threads : THREAD_COUNTS) {
+    for (size_t chunkSize : CHUNK_SIZES) {
+      ErrorReporter parallelErrors;
+      const TokenBuffer parallel
+          = ParallelScanner(source, parallelErrors, threads, chunkSize)
+                .tokenize();
+      const std::string actual = describe(parallel, parallelErrors);
+      if (actual != expected) {
+        std::cerr << name << ": ParallelScanner (" << threads << " threads, "
+                  << chunkSize << " byte chunks) differs from Scanner\n"
+                  << "--- Scanner\n"
+                  << expected << "--- ParallelScanner\n"
+                  << actual;
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+auto main(int argc, char** argv) -> int {
+  size_t sources = 0;
+  for (int i = 1; i < argc; ++i) {
+    std::ifstream file(argv[i]);
+    if (!file) {
+      std::cerr << "Can't open " << argv[i] << std::endl;
+      return 1;
+    }
+    std::stringstream contents;
+    contents << file.rdbuf();
+    if (!checkSource(argv[i], contents.str())) return 1;
+    ++sources;
+  }
+
+  std::mt19937 rng(2024);
+  for (int seed = 0; seed < 500; ++seed, ++sources)
+    if (!checkSource("random #" + std::to_string(seed), randomSource(rng)))
+      return 1;
+
+  std::cout << "Scanner and ParallelScanner agree on " << sources
+            << " sources" << std::endl;
+  return 0;
+}
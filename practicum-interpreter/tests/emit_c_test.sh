@@ -0,0 +1,47 @@
+#!/bin/sh
+# Compiles every script given with `langc --emit-c` and `cc -O2`, runs the
+# native binary, and diffs its stdout, stderr and exit status against langc
+# interpreting the same script. A script's stdin comes from the .in file next
+# to it (examples/ex1.c reads examples/ex1.in), or /dev/null if there is none.
+# Scripts langc --emit-c rejects have to be rejected the same way by langc.
+#
+# Usage: tests/emit_c_test.sh path/to/langc script.c...
+
+LANGC=$1
+shift
+CC=${CC:-cc}
+WORK=$(mktemp -d) || exit 1
+trap 'rm -rf "$WORK"' EXIT
+
+failed=0
+for script in "$@"; do
+  input=${script%.c}.in
+  [ -f "$input" ] || input=/dev/null
+
+  "$LANGC" "$script" < "$input" > "$WORK/expected.out" 2> "$WORK/expected.err"
+  echo "exit $?" >> "$WORK/expected.out"
+
+  if "$LANGC" --emit-c "$script" > "$WORK/native.c" 2> "$WORK/actual.err"; then
+    if ! $CC -O2 -o "$WORK/native" "$WORK/native.c" -lm; then
+      echo "FAIL $script: the emitted C doesn't compile"
+      failed=1
+      continue
+    fi
+    "$WORK/native" < "$input" > "$WORK/actual.out" 2> "$WORK/actual.err"
+    echo "exit $?" >> "$WORK/actual.out"
+  else
+    # Only compile errors make --emit-c fail, and langc reports them before
+    # running anything.
+    echo "exit 65" > "$WORK/actual.out"
+  fi
+
+  if diff -u "$WORK/expected.out" "$WORK/actual.out" > "$WORK/diff" \
+      && diff -u "$WORK/expected.err" "$WORK/actual.err" >> "$WORK/diff"; then
+    echo "ok   $script"
+  else
+    echo "FAIL $script: the native binary differs from langc"
+    cat "$WORK/diff"
+    failed=1
+  fi
+done
+exit $failed